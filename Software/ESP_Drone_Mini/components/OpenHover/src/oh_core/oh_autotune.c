@@ -0,0 +1,127 @@
+#include "oh_autotune.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI	(3.14159265358979323846)
+#endif
+
+//Kp / Ku, Ti / Tu, Td / Tu of oh_autotune_rule_t.
+static const float rules[][3] =
+{
+	{ 0.6f,  0.5f, 0.125f },
+	{ 0.33f, 0.5f, 0.33f },
+	{ 0.2f,  0.5f, 0.33f },
+};
+
+static void __oh_autotune_finish(oh_autotune_t *at)
+{
+	float period = at -> _sum_period / at -> cycles;
+	float amplitude = at -> _sum_amplitude / at -> cycles;
+
+	//The relay must dominate the hysteresis, otherwise Ku is not defined.
+	if(!(amplitude > at -> hysteresis) || !(period > 0))
+	{
+		at -> state = OH_AUTOTUNE_FAILED;
+		return;
+	}
+
+	at -> ku = 4 * at -> amplitude / ((float)M_PI * sqrtf(amplitude * amplitude - at -> hysteresis * at -> hysteresis));
+	at -> tu = period / at -> sample_hz;
+
+	const float *rule = rules[at -> rule];
+	float dt = 1.0f / at -> sample_hz;
+	float ti = rule[1] * at -> tu;
+	float td = rule[2] * at -> tu;
+	at -> proportion = rule[0] * at -> ku;
+	at -> integration = at -> proportion * dt / ti;
+	at -> differention = at -> proportion * td / dt;
+	at -> state = OH_AUTOTUNE_DONE;
+}
+
+/**
+ * @brief: Start a tuning.
+ * @param:
+ * 		float bias: Output the relay switches around, such as the integral output of the replaced pid.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_autotune_start(oh_autotune_t *at, float bias)
+{
+	if(!(at -> amplitude > 0) || at -> hysteresis < 0 || !(at -> sample_hz > 0)
+		|| at -> cycles == 0 || at -> max_ticks == 0 || (unsigned)at -> rule > OH_AUTOTUNE_RULE_NO_OVERSHOOT)
+	{
+		at -> state = OH_AUTOTUNE_FAILED;
+		return -1;
+	}
+
+	at -> _bias = bias;
+	at -> _relay = 1;
+	at -> _ticks = 0;
+	at -> _cycle_start = 0;
+	at -> _cycles_seen = 0;
+	at -> _max = -INFINITY;
+	at -> _min = INFINITY;
+	at -> _sum_period = 0;
+	at -> _sum_amplitude = 0;
+	at -> state = OH_AUTOTUNE_RUNNING;
+	return 0;
+}
+
+/**
+ * @brief: Run a tick of the relay.
+ * @param:
+ * 		float error: Target - measurement of the tuned loop.
+ * @return:
+ * 		Output replacing the pid output, the bias when not running.
+ */
+float oh_autotune_update(oh_autotune_t *at, float error)
+{
+	if(at -> state != OH_AUTOTUNE_RUNNING)
+		return at -> _bias;
+
+	if(++ at -> _ticks > at -> max_ticks || !isfinite(error))
+	{
+		at -> state = OH_AUTOTUNE_FAILED;
+		return at -> _bias;
+	}
+
+	if(error > at -> _max)
+		at -> _max = error;
+	if(error < at -> _min)
+		at -> _min = error;
+
+	if(at -> _relay < 0 && error > at -> hysteresis)
+	{
+		//A cycle ends at each switch to the positive output.
+		at -> _relay = 1;
+		if(at -> _cycles_seen >= at -> settle_cycles + 1)
+		{
+			at -> _sum_period += at -> _ticks - at -> _cycle_start;
+			at -> _sum_amplitude += 0.5f * (at -> _max - at -> _min);
+		}
+		at -> _cycles_seen ++;
+		at -> _cycle_start = at -> _ticks;
+		at -> _max = error;
+		at -> _min = error;
+
+		if(at -> _cycles_seen >= at -> settle_cycles + 1 + at -> cycles)
+		{
+			__oh_autotune_finish(at);
+			return at -> _bias;
+		}
+	} else if(at -> _relay > 0 && error < - at -> hysteresis)
+	{
+		at -> _relay = -1;
+	}
+
+	return at -> _bias + at -> _relay * at -> amplitude;
+}
+
+/**
+ * @brief: Abort a running tuning, the state becomes OH_AUTOTUNE_IDLE.
+ */
+void oh_autotune_stop(oh_autotune_t *at)
+{
+	at -> state = OH_AUTOTUNE_IDLE;
+}
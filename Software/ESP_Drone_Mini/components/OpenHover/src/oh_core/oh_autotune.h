@@ -0,0 +1,113 @@
+#ifndef _OH_AUTOTUNE_H_
+#define _OH_AUTOTUNE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: Relay feedback autotuner.
+ * @note:  Replaces a pid by a relay with hysteresis: output = bias +- amplitude, switched by the sign
+ * 		of the error. The loop settles into a limit cycle, whose period is the ultimate period Tu and
+ * 		whose error amplitude a gives the ultimate gain Ku = 4 * amplitude / (pi * sqrt(a^2 - hysteresis^2)).
+ * 		The pid gains are derived from (Ku, Tu) by a Ziegler-Nichols type rule and are scaled per tick
+ * 		for oh_pos_pid_t, which sums and differences the error without the period.
+ */
+typedef enum
+{
+	OH_AUTOTUNE_IDLE    = 0,
+	OH_AUTOTUNE_RUNNING = 1,
+	OH_AUTOTUNE_DONE    = 2,
+	OH_AUTOTUNE_FAILED  = 3,
+} oh_autotune_state_t;
+
+/**
+ * @brief: Tuning rules, Kp / Ku, Ti / Tu and Td / Tu are:
+ * 		OH_AUTOTUNE_RULE_CLASSIC:        0.6,  0.5, 0.125
+ * 		OH_AUTOTUNE_RULE_SOME_OVERSHOOT: 0.33, 0.5, 0.33
+ * 		OH_AUTOTUNE_RULE_NO_OVERSHOOT:   0.2,  0.5, 0.33
+ */
+typedef enum
+{
+	OH_AUTOTUNE_RULE_CLASSIC        = 0,
+	OH_AUTOTUNE_RULE_SOME_OVERSHOOT = 1,
+	OH_AUTOTUNE_RULE_NO_OVERSHOOT   = 2,
+} oh_autotune_rule_t;
+
+/**
+ * @brief: Relay feedback autotuner typedef struct.
+ * @param:
+ * 		@configs:
+ * 			float amplitude:        Relay amplitude, in the output unit of the tuned pid.
+ * 			float hysteresis:       Error band without switching, above the noise of the measurement.
+ * 			float sample_hz:        Rate of `oh_autotune_update`.
+ * 			uint8_t settle_cycles:  Cycles skipped before measuring.
+ * 			uint8_t cycles:         Cycles averaged.
+ * 			uint32_t max_ticks:     The tuning fails when it is not done in max_ticks.
+ * 			oh_autotune_rule_t rule: Rule of the gains.
+ * 		@status:
+ * 			oh_autotune_state_t state: State of the tuning.
+ * 			float ku, tu:              Ultimate gain and period(s) when done.
+ * 			float proportion, integration, differention: Tuned per tick gains when done.
+ */
+typedef struct
+{
+	//configs
+	float amplitude;
+	float hysteresis;
+	float sample_hz;
+	uint8_t settle_cycles;
+	uint8_t cycles;
+	uint32_t max_ticks;
+	oh_autotune_rule_t rule;
+
+	//status
+	oh_autotune_state_t state;
+	float ku;
+	float tu;
+	float proportion;
+	float integration;
+	float differention;
+
+	//private realizations.
+	float _bias;
+	int8_t _relay;
+	uint32_t _ticks;
+	uint32_t _cycle_start;
+	uint8_t _cycles_seen;
+	float _max;
+	float _min;
+	float _sum_period;
+	float _sum_amplitude;
+} oh_autotune_t;
+
+/**
+ * @brief: Start a tuning.
+ * @param:
+ * 		float bias: Output the relay switches around, such as the integral output of the replaced pid.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_autotune_start(oh_autotune_t *at, float bias);
+
+/**
+ * @brief: Run a tick of the relay.
+ * @param:
+ * 		float error: Target - measurement of the tuned loop.
+ * @return:
+ * 		Output replacing the pid output, the bias when not running.
+ */
+float oh_autotune_update(oh_autotune_t *at, float error);
+
+/**
+ * @brief: Abort a running tuning, the state becomes OH_AUTOTUNE_IDLE.
+ */
+void oh_autotune_stop(oh_autotune_t *at);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
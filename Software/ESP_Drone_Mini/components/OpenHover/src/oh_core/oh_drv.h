@@ -12,6 +12,11 @@ typedef struct {
     float gx;
     float gy;
     float gz;
+    // attitude quaternion(body to world, q0 is the scalar part), used by OH_QUAD_ATTITUDE_QUAT.
+    float q0;
+    float q1;
+    float q2;
+    float q3;
 
 } oh_drv_status_t;
 
@@ -0,0 +1,220 @@
+#include "oh_dyn_notch.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI	(3.14159265358979323846)
+#endif
+
+/**
+ * @brief: In place radix-2 complex FFT of n points, twiddle k is (cos, sin)[k * stride].
+ */
+static void __oh_fft(float *re, float *im, int n, const float *cs, const float *sn, int stride)
+{
+	//Bit reversal permutation.
+	for(int i = 1, j = 0; i < n; i++)
+	{
+		int bit = n >> 1;
+		for( ; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if(i < j)
+		{
+			float t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	//Butterflies.
+	for(int len = 2; len <= n; len <<= 1)
+	{
+		int half = len >> 1;
+		int step = (n / len) * stride;
+		for(int i = 0; i < n; i += len)
+		{
+			for(int k = 0; k < half; k++)
+			{
+				float wr = cs[k * step];
+				float wi = - sn[k * step];
+				int a = i + k;
+				int b = a + half;
+				float tr = re[b] * wr - im[b] * wi;
+				float ti = re[b] * wi + im[b] * wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+}
+
+/**
+ * @brief: Add the power spectrum of a windowed real signal of n points to power[0 ~ n/2].
+ * @note:
+ * 		The n points are packed into an n/2 points complex FFT and split afterwards.
+ */
+static void __oh_dyn_notch_add_power(oh_dyn_notch_t *dn, const float *x, int bin_min, int bin_max)
+{
+	int n = dn -> fft_size;
+	int half = n / 2;
+
+	for(int i = 0; i < half; i++)
+	{
+		dn -> _re[i] = x[2 * i] * dn -> _window[2 * i];
+		dn -> _im[i] = x[2 * i + 1] * dn -> _window[2 * i + 1];
+	}
+
+	__oh_fft(dn -> _re, dn -> _im, half, dn -> _cos, dn -> _sin, 2);
+
+	//X[k] = (Z[k] + conj(Z[n/2-k])) / 2 - i * W^k * (Z[k] - conj(Z[n/2-k])) / 2, W = e^(-2 pi i / n)
+	for(int k = bin_min; k <= bin_max; k++)
+	{
+		int a = k % half;
+		int b = (half - k) % half;
+		float even_r = (dn -> _re[a] + dn -> _re[b]) / 2;
+		float even_i = (dn -> _im[a] - dn -> _im[b]) / 2;
+		float odd_r = (dn -> _im[a] + dn -> _im[b]) / 2;
+		float odd_i = - (dn -> _re[a] - dn -> _re[b]) / 2;
+		float wr = (k < half) ? dn -> _cos[k] : -1.0f;
+		float wi = (k < half) ? - dn -> _sin[k] : 0.0f;
+		float xr = even_r + odd_r * wr - odd_i * wi;
+		float xi = even_i + odd_r * wi + odd_i * wr;
+		dn -> _power[k] += xr * xr + xi * xi;
+	}
+}
+
+/**
+ * @brief: Validate configs and precompute the window and twiddles.
+ * @param:
+ * 		float sample_hz: Sample rate of the pushed samples.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_dyn_notch_init(oh_dyn_notch_t *dn, float sample_hz)
+{
+	int n = dn -> fft_size;
+	if(n < 16 || n > OH_DYN_NOTCH_MAX_FFT_SIZE || (n & (n - 1)))
+		return -1;
+	if(dn -> axes < 1 || dn -> axes > OH_FILTER_MAX_AXES || dn -> peaks > OH_DYN_NOTCH_MAX_PEAKS)
+		return -1;
+	if(!(sample_hz > 0) || !(dn -> min_hz > 0) || !(dn -> max_hz > dn -> min_hz) || !(dn -> max_hz < sample_hz / 2) || !(dn -> q > 0))
+		return -1;
+
+	dn -> _sample_hz = sample_hz;
+	dn -> _count = 0;
+
+	for(int i = 0; i < n; i++)
+		dn -> _window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / n);
+
+	for(int i = 0; i < n / 2; i++)
+	{
+		dn -> _cos[i] = cosf(2.0f * (float)M_PI * i / n);
+		dn -> _sin[i] = sinf(2.0f * (float)M_PI * i / n);
+	}
+	return 0;
+}
+
+/**
+ * @brief: Append a sample of all axes.
+ * @return:
+ * 		1 if fft_size samples are buffered and `oh_dyn_notch_analyze` should be called, otherwise 0.
+ */
+int oh_dyn_notch_push(oh_dyn_notch_t *dn, const float *sample)
+{
+	if(dn -> _count >= dn -> fft_size)
+		return 1;
+
+	for(int axis = 0; axis < dn -> axes; axis++)
+		dn -> _samples[axis][dn -> _count] = sample[axis];
+
+	return ++ dn -> _count >= dn -> fft_size;
+}
+
+/**
+ * @brief: Analyze the buffered samples and restart buffering.
+ * @param:
+ * 		oh_dyn_notch_result_t *result: Found peaks and their notches, strongest first.
+ */
+void oh_dyn_notch_analyze(oh_dyn_notch_t *dn, oh_dyn_notch_result_t *result)
+{
+	float resolution = dn -> _sample_hz / dn -> fft_size;
+	int bin_min = (int)ceilf(dn -> min_hz / resolution);
+	int bin_max = (int)floorf(dn -> max_hz / resolution);
+	if(bin_min < 1)
+		bin_min = 1;
+
+	result -> peaks = 0;
+	dn -> _count = 0;
+	if(bin_max - bin_min < 2)
+		return;
+
+	//Sum the power spectra of all axes, one bin around the band is kept for the interpolation.
+	memset(dn -> _power, 0x00, sizeof(dn -> _power));
+	for(int axis = 0; axis < dn -> axes; axis++)
+		__oh_dyn_notch_add_power(dn, dn -> _samples[axis], bin_min - 1, bin_max + 1);
+
+	float mean = 0;
+	for(int k = bin_min; k <= bin_max; k++)
+		mean += dn -> _power[k];
+	mean /= (bin_max - bin_min + 1);
+
+	//Pick the strongest local maxima, a picked peak and its neighbours are excluded from the next search.
+	uint8_t used[OH_DYN_NOTCH_MAX_FFT_SIZE / 2 + 1] = { 0 };
+	while(result -> peaks < dn -> peaks)
+	{
+		int peak = -1;
+		for(int k = bin_min; k <= bin_max; k++)
+		{
+			if(used[k] || dn -> _power[k] < dn -> _power[k - 1] || dn -> _power[k] < dn -> _power[k + 1])
+				continue;
+			if(peak < 0 || dn -> _power[k] > dn -> _power[peak])
+				peak = k;
+		}
+		if(peak < 0 || !(dn -> _power[peak] > dn -> threshold * mean))
+			break;
+
+		used[peak - 1] = used[peak] = used[peak + 1] = 1;
+
+		//Parabolic interpolation of the peak on the power of the 3 bins.
+		float l = dn -> _power[peak - 1];
+		float c = dn -> _power[peak];
+		float r = dn -> _power[peak + 1];
+		float denom = l - 2 * c + r;
+		float offset = (denom != 0) ? 0.5f * (l - r) / denom : 0;
+		float center_hz = (peak + offset) * resolution;
+		if(center_hz < dn -> min_hz)
+			center_hz = dn -> min_hz;
+		else if(center_hz > dn -> max_hz)
+			center_hz = dn -> max_hz;
+
+		oh_biquad_config_t config = { .type = OH_BIQUAD_NOTCH, .center_hz = center_hz, .q = dn -> q };
+		if(oh_biquad_init(&result -> notch[result -> peaks], dn -> _sample_hz, &config))
+			break;
+		result -> center_hz[result -> peaks] = center_hz;
+		result -> peaks ++;
+	}
+}
+
+/**
+ * @brief: Load the notches of result into chain and keep the states of the stages already in use.
+ * @note:
+ * 		The chain must be initialized, it becomes a passthrough when no peak is found.
+ */
+void oh_dyn_notch_load(oh_filter_chain_t *chain, const oh_dyn_notch_result_t *result)
+{
+	for(int i = 0; i < result -> peaks; i++)
+	{
+		oh_biquad_t *stage = &chain -> stage[i];
+		if(i >= chain -> stages)
+			oh_biquad_reset(stage);
+		stage -> b0 = result -> notch[i].b0;
+		stage -> b1 = result -> notch[i].b1;
+		stage -> b2 = result -> notch[i].b2;
+		stage -> a1 = result -> notch[i].a1;
+		stage -> a2 = result -> notch[i].a2;
+	}
+	chain -> stages = result -> peaks;
+}
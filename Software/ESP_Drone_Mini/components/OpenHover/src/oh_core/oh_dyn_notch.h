@@ -0,0 +1,106 @@
+#ifndef _OH_DYN_NOTCH_H_
+#define _OH_DYN_NOTCH_H_
+
+#include <stdint.h>
+
+#include "oh_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: Dynamic notch.
+ * @note:  Tracks the strongest vibration peaks of the gyro and retunes notch filters to them.
+ * 		The analysis(Hann window, real FFT, peak search and notch coefficients) is expensive
+ * 		and is designed to run in a low priority task, the control loop only pushes samples
+ * 		and loads the finished coefficients with `oh_dyn_notch_load`.
+ * 		Peaks are searched in the magnitude spectrum summed over all axes, so one notch serves all axes.
+ */
+#define OH_DYN_NOTCH_MAX_FFT_SIZE	(256)
+#define OH_DYN_NOTCH_MAX_PEAKS		(OH_FILTER_MAX_STAGES)
+
+/**
+ * @brief: Result of an analysis.
+ * @param:
+ * 		uint8_t peaks:           Number of valid notches.
+ * 		float center_hz[]:       Center frequencies of notches.
+ * 		oh_biquad_t notch[]:     Notches with coefficients calculated, states are unused.
+ */
+typedef struct
+{
+	uint8_t peaks;
+	float center_hz[OH_DYN_NOTCH_MAX_PEAKS];
+	oh_biquad_t notch[OH_DYN_NOTCH_MAX_PEAKS];
+} oh_dyn_notch_result_t;
+
+/**
+ * @brief: Dynamic notch typedef struct.
+ * @param:
+ * 		@configs:
+ * 			uint16_t fft_size: Power of 2 in [16, OH_DYN_NOTCH_MAX_FFT_SIZE], frequency resolution is sample_hz / fft_size.
+ * 			uint8_t axes:      Number of axes of a sample, up to OH_FILTER_MAX_AXES.
+ * 			uint8_t peaks:     Max number of notches, up to OH_DYN_NOTCH_MAX_PEAKS.
+ * 			float min_hz:      Lower bound of the searched band.
+ * 			float max_hz:      Upper bound of the searched band, below sample_hz / 2.
+ * 			float q:           Quality factor of notches.
+ * 			float threshold:   A peak must be threshold times above the mean of the band.
+ */
+typedef struct
+{
+	//configs
+	uint16_t fft_size;
+	uint8_t axes;
+	uint8_t peaks;
+	float min_hz;
+	float max_hz;
+	float q;
+	float threshold;
+
+	//private realizations.
+	float _sample_hz;
+	uint16_t _count;
+	float _samples[OH_FILTER_MAX_AXES][OH_DYN_NOTCH_MAX_FFT_SIZE];
+	float _window[OH_DYN_NOTCH_MAX_FFT_SIZE];
+	float _cos[OH_DYN_NOTCH_MAX_FFT_SIZE / 2];
+	float _sin[OH_DYN_NOTCH_MAX_FFT_SIZE / 2];
+	float _re[OH_DYN_NOTCH_MAX_FFT_SIZE / 2];
+	float _im[OH_DYN_NOTCH_MAX_FFT_SIZE / 2];
+	float _power[OH_DYN_NOTCH_MAX_FFT_SIZE / 2 + 1];
+} oh_dyn_notch_t;
+
+/**
+ * @brief: Validate configs and precompute the window and twiddles.
+ * @param:
+ * 		float sample_hz: Sample rate of the pushed samples.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_dyn_notch_init(oh_dyn_notch_t *dn, float sample_hz);
+
+/**
+ * @brief: Append a sample of all axes.
+ * @return:
+ * 		1 if fft_size samples are buffered and `oh_dyn_notch_analyze` should be called, otherwise 0.
+ */
+int oh_dyn_notch_push(oh_dyn_notch_t *dn, const float *sample);
+
+/**
+ * @brief: Analyze the buffered samples and restart buffering.
+ * @param:
+ * 		oh_dyn_notch_result_t *result: Found peaks and their notches, strongest first.
+ */
+void oh_dyn_notch_analyze(oh_dyn_notch_t *dn, oh_dyn_notch_result_t *result);
+
+/**
+ * @brief: Load the notches of result into chain and keep the states of the stages already in use.
+ * @note:
+ * 		The chain must be initialized, it becomes a passthrough when no peak is found.
+ */
+void oh_dyn_notch_load(oh_filter_chain_t *chain, const oh_dyn_notch_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#include "oh_filter.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI	(3.14159265358979323846)
+#endif
+
+/**
+ * @brief: Recalculate the coefficients and keep the states.
+ * @note:
+ * 		This function is suitable for moving a notch at run time without a transient.
+ */
+int oh_biquad_update(oh_biquad_t *biquad, float sample_hz, const oh_biquad_config_t *config)
+{
+	if(!(sample_hz > 0) || !(config -> center_hz > 0) || !(config -> center_hz < sample_hz / 2) || !(config -> q > 0))
+		return -1;
+
+	float omega = 2.0f * (float)M_PI * config -> center_hz / sample_hz;
+	float sn = sinf(omega);
+	float cs = cosf(omega);
+	float alpha = sn / (2.0f * config -> q);
+	float a0 = 1.0f + alpha;
+
+	switch(config -> type)
+	{
+	case OH_BIQUAD_LOWPASS:
+		biquad -> b0 = (1.0f - cs) / 2.0f / a0;
+		biquad -> b1 = (1.0f - cs) / a0;
+		biquad -> b2 = biquad -> b0;
+		break;
+
+	case OH_BIQUAD_NOTCH:
+		biquad -> b0 = 1.0f / a0;
+		biquad -> b1 = -2.0f * cs / a0;
+		biquad -> b2 = biquad -> b0;
+		break;
+
+	default:
+		return -1;
+	}
+
+	biquad -> a1 = -2.0f * cs / a0;
+	biquad -> a2 = (1.0f - alpha) / a0;
+	return 0;
+}
+
+/**
+ * @brief: Calculate the coefficients and clear the states.
+ * @param:
+ * 		oh_biquad_t *biquad:              Biquad struct.
+ * 		float sample_hz:                  Sample rate.
+ * 		const oh_biquad_config_t *config: Filter configuration.
+ * @return:
+ * 		0 if success, -1 if the configuration is invalid.
+ */
+int oh_biquad_init(oh_biquad_t *biquad, float sample_hz, const oh_biquad_config_t *config)
+{
+	oh_biquad_reset(biquad);
+	return oh_biquad_update(biquad, sample_hz, config);
+}
+
+/**
+ * @brief: Clear the states of all axes.
+ */
+void oh_biquad_reset(oh_biquad_t *biquad)
+{
+	memset(biquad -> _z1, 0x00, sizeof(biquad -> _z1));
+	memset(biquad -> _z2, 0x00, sizeof(biquad -> _z2));
+}
+
+/**
+ * @brief: Filter one sample of an axis.
+ */
+float oh_biquad_apply(oh_biquad_t *biquad, int axis, float x)
+{
+	float y = biquad -> b0 * x + biquad -> _z1[axis];
+
+	//A NaN or inf sample would stay in the states forever, restart from the input instead.
+	if(!isfinite(y))
+	{
+		biquad -> _z1[axis] = 0;
+		biquad -> _z2[axis] = 0;
+		return x;
+	}
+
+	biquad -> _z1[axis] = biquad -> b1 * x - biquad -> a1 * y + biquad -> _z2[axis];
+	biquad -> _z2[axis] = biquad -> b2 * x - biquad -> a2 * y;
+	return y;
+}
+
+/**
+ * @brief: Configure a filter chain.
+ * @param:
+ * 		oh_filter_chain_t *chain:          Filter chain struct.
+ * 		int axes:                          Number of axes, up to OH_FILTER_MAX_AXES.
+ * 		float sample_hz:                   Sample rate.
+ * 		const oh_biquad_config_t *configs: Configurations of stages.
+ * 		int stages:                        Number of stages, up to OH_FILTER_MAX_STAGES.
+ * @return:
+ * 		0 if success, -1 if any configuration is invalid, then the chain is a passthrough.
+ */
+int oh_filter_chain_init(oh_filter_chain_t *chain, int axes, float sample_hz, const oh_biquad_config_t *configs, int stages)
+{
+	chain -> stages = 0;
+	chain -> axes = 0;
+	if(axes < 0 || axes > OH_FILTER_MAX_AXES || stages < 0 || stages > OH_FILTER_MAX_STAGES)
+		return -1;
+
+	for(int i = 0; i < stages; i++)
+	{
+		if(oh_biquad_init(&chain -> stage[i], sample_hz, &configs[i]))
+			return -1;
+	}
+
+	chain -> stages = stages;
+	chain -> axes = axes;
+	return 0;
+}
+
+/**
+ * @brief: Filter one sample of all axes in place.
+ * @param:
+ * 		float *x: chain -> axes samples.
+ */
+void oh_filter_chain_apply(oh_filter_chain_t *chain, float *x)
+{
+	for(int i = 0; i < chain -> stages; i++)
+	{
+		for(int axis = 0; axis < chain -> axes; axis++)
+		{
+			x[axis] = oh_biquad_apply(&chain -> stage[i], axis, x[axis]);
+		}
+	}
+}
+
+/**
+ * @brief: Filter one sample of an axis.
+ */
+float oh_filter_chain_apply_axis(oh_filter_chain_t *chain, int axis, float x)
+{
+	for(int i = 0; i < chain -> stages; i++)
+	{
+		x = oh_biquad_apply(&chain -> stage[i], axis, x);
+	}
+	return x;
+}
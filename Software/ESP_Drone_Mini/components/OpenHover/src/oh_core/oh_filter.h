@@ -0,0 +1,132 @@
+#ifndef _OH_FILTER_H_
+#define _OH_FILTER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: Biquad filter.
+ * @note:  Coefficients are calculated once at configuration time(RBJ cookbook, bilinear transform),
+ * 		the filter itself is a Direct Form II Transposed section.
+ * 		The states of all axes are laid out side by side, so one section processes
+ * 		all axes with the same coefficients in one pass.
+ */
+#define OH_FILTER_MAX_AXES		(3)
+#define OH_FILTER_MAX_STAGES	(4)
+
+typedef enum
+{
+	OH_BIQUAD_LOWPASS = 0,
+	OH_BIQUAD_NOTCH   = 1,
+} oh_biquad_type_t;
+
+/**
+ * @brief: Biquad configuration.
+ * @param:
+ * 		oh_biquad_type_t type: Low-pass or notch.
+ * 		float center_hz:       Cutoff frequency of low-pass or center frequency of notch, in (0, sample_hz / 2).
+ * 		float q:               Quality factor, 0.7071 for a Butterworth low-pass.
+ */
+typedef struct
+{
+	oh_biquad_type_t type;
+	float center_hz;
+	float q;
+} oh_biquad_config_t;
+
+/**
+ * @brief: Biquad typedef struct.
+ * @param:
+ * 		float b0, b1, b2, a1, a2: Coefficients normalized by a0.
+ */
+typedef struct
+{
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+
+	//private realizations.
+	float _z1[OH_FILTER_MAX_AXES];
+	float _z2[OH_FILTER_MAX_AXES];
+} oh_biquad_t;
+
+/**
+ * @brief: Calculate the coefficients and clear the states.
+ * @param:
+ * 		oh_biquad_t *biquad:              Biquad struct.
+ * 		float sample_hz:                  Sample rate.
+ * 		const oh_biquad_config_t *config: Filter configuration.
+ * @return:
+ * 		0 if success, -1 if the configuration is invalid.
+ */
+int oh_biquad_init(oh_biquad_t *biquad, float sample_hz, const oh_biquad_config_t *config);
+
+/**
+ * @brief: Recalculate the coefficients and keep the states.
+ * @note:
+ * 		This function is suitable for moving a notch at run time without a transient.
+ */
+int oh_biquad_update(oh_biquad_t *biquad, float sample_hz, const oh_biquad_config_t *config);
+
+/**
+ * @brief: Clear the states of all axes.
+ */
+void oh_biquad_reset(oh_biquad_t *biquad);
+
+/**
+ * @brief: Filter one sample of an axis.
+ */
+float oh_biquad_apply(oh_biquad_t *biquad, int axis, float x);
+
+/**
+ * @group: Cascaded biquad filter.
+ */
+
+/**
+ * @brief: Filter chain typedef struct.
+ * @param:
+ * 		uint8_t stages: Number of biquad stages, 0 makes the chain a passthrough.
+ * 		uint8_t axes:   Number of axes processed by `oh_filter_chain_apply`.
+ */
+typedef struct
+{
+	uint8_t stages;
+	uint8_t axes;
+	oh_biquad_t stage[OH_FILTER_MAX_STAGES];
+} oh_filter_chain_t;
+
+/**
+ * @brief: Configure a filter chain.
+ * @param:
+ * 		oh_filter_chain_t *chain:          Filter chain struct.
+ * 		int axes:                          Number of axes, up to OH_FILTER_MAX_AXES.
+ * 		float sample_hz:                   Sample rate.
+ * 		const oh_biquad_config_t *configs: Configurations of stages.
+ * 		int stages:                        Number of stages, up to OH_FILTER_MAX_STAGES.
+ * @return:
+ * 		0 if success, -1 if any configuration is invalid, then the chain is a passthrough.
+ */
+int oh_filter_chain_init(oh_filter_chain_t *chain, int axes, float sample_hz, const oh_biquad_config_t *configs, int stages);
+
+/**
+ * @brief: Filter one sample of all axes in place.
+ * @param:
+ * 		float *x: chain -> axes samples.
+ */
+void oh_filter_chain_apply(oh_filter_chain_t *chain, float *x);
+
+/**
+ * @brief: Filter one sample of an axis.
+ */
+float oh_filter_chain_apply_axis(oh_filter_chain_t *chain, int axis, float x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
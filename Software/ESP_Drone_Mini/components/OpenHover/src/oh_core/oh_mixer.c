@@ -0,0 +1,214 @@
+#include "oh_mixer.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI	(3.14159265358979323846)
+#endif
+
+/**
+ * @brief: Fill an X frame of n motors evenly spaced, see OH_MIXER_HEX_X.
+ */
+static void __oh_mixer_fill_x(oh_mixer_t *mixer, int n)
+{
+	float max_roll = 0, max_pitch = 0;
+	for(int i = 0; i < n; i++)
+	{
+		//Angle clockwise from the nose, the roll factor follows the offset across the roll axis and the pitch
+		//factor the offset along it with the signs of the quad table: M1 at 45 degree has +roll, -pitch.
+		float angle = (i + 0.5f) * 2.0f * (float)M_PI / n;
+		mixer -> _roll[i] = sinf(angle);
+		mixer -> _pitch[i] = - cosf(angle);
+		mixer -> _yaw[i] = (i % 2) ? 0.5f : -0.5f;
+		if(fabsf(mixer -> _roll[i]) > max_roll) max_roll = fabsf(mixer -> _roll[i]);
+		if(fabsf(mixer -> _pitch[i]) > max_pitch) max_pitch = fabsf(mixer -> _pitch[i]);
+	}
+
+	//The farthest motor of each axis takes half of the correction, as the quad does.
+	for(int i = 0; i < n; i++)
+	{
+		mixer -> _roll[i] *= 0.5f / max_roll;
+		mixer -> _pitch[i] *= 0.5f / max_pitch;
+	}
+	mixer -> _motors = n;
+}
+
+/**
+ * @brief: Fill the mixing matrix of mixer -> geometry.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_mixer_init(oh_mixer_t *mixer)
+{
+	//                                 M1     M2     M3     M4
+	static const float quad_roll[]  = { 0.5f, -0.5f,  0.5f, -0.5f };
+	static const float quad_pitch[] = {-0.5f,  0.5f,  0.5f, -0.5f };
+	static const float quad_yaw[]   = {-0.5f, -0.5f,  0.5f,  0.5f };
+
+	mixer -> _motors = 0;
+	if(!(mixer -> output_max > mixer -> output_min))
+		return -1;
+
+	switch(mixer -> geometry)
+	{
+	case OH_MIXER_QUAD_X:
+		for(int i = 0; i < 4; i++)
+		{
+			mixer -> _roll[i] = quad_roll[i];
+			mixer -> _pitch[i] = quad_pitch[i];
+			mixer -> _yaw[i] = quad_yaw[i];
+		}
+		mixer -> _motors = 4;
+		break;
+
+	case OH_MIXER_HEX_X:
+		__oh_mixer_fill_x(mixer, 6);
+		break;
+
+	case OH_MIXER_OCTO_X:
+		__oh_mixer_fill_x(mixer, 8);
+		break;
+
+	default:
+		return -1;
+	}
+
+	//Fixed-point matrix, the coefficients are in [-0.5, 0.5].
+	for(int i = 0; i < mixer -> _motors; i++)
+	{
+		mixer -> _roll_q[i] = oh_q15_from_float(mixer -> _roll[i], 0);
+		mixer -> _pitch_q[i] = oh_q15_from_float(mixer -> _pitch[i], 0);
+		mixer -> _yaw_q[i] = oh_q15_from_float(mixer -> _yaw[i], 0);
+	}
+	mixer -> _output_min_q = 0;
+	mixer -> _output_max_q = 0;
+	if(mixer -> full_scale > 0)
+	{
+		mixer -> _output_min_q = oh_q31_from_float(mixer -> output_min, mixer -> full_scale);
+		mixer -> _output_max_q = oh_q31_from_float(mixer -> output_max, mixer -> full_scale);
+	}
+	return 0;
+}
+
+/**
+ * @brief: Get the number of outputs of `oh_mixer_mix`.
+ */
+int oh_mixer_motors(const oh_mixer_t *mixer)
+{
+	return mixer -> _motors;
+}
+
+/**
+ * @brief: Mix throttle and attitude corrections into motor outputs.
+ * @param:
+ * 		float *outputs: `oh_mixer_motors` outputs in [output_min, output_max].
+ */
+void oh_mixer_mix(const oh_mixer_t *mixer, float throttle, float roll, float pitch, float yaw, float *outputs)
+{
+	int n = mixer -> _motors;
+	float mix_min = 0, mix_max = 0;
+
+	//Attitude mix.
+	for(int i = 0; i < n; i++)
+	{
+		float mix = roll * mixer -> _roll[i] + pitch * mixer -> _pitch[i] + yaw * mixer -> _yaw[i];
+		outputs[i] = mix;
+		if(mix < mix_min) mix_min = mix;
+		if(mix > mix_max) mix_max = mix;
+	}
+
+	if(!isfinite(throttle) || !isfinite(mix_min) || !isfinite(mix_max))
+	{
+		for(int i = 0; i < n; i++)
+			outputs[i] = mixer -> output_min;
+		return;
+	}
+
+	if(mixer -> airmode)
+	{
+		//Scale the mix into the output range, then move the throttle so that no output saturates.
+		float range = mixer -> output_max - mixer -> output_min;
+		float span = mix_max - mix_min;
+		float scale = 1;
+		if(span > range)
+		{
+			scale = range / span;
+			mix_min *= scale;
+			mix_max *= scale;
+		}
+
+		if(throttle < mixer -> output_min - mix_min)
+			throttle = mixer -> output_min - mix_min;
+		else if(throttle > mixer -> output_max - mix_max)
+			throttle = mixer -> output_max - mix_max;
+
+		for(int i = 0; i < n; i++)
+			outputs[i] = throttle + outputs[i] * scale;
+	} else {
+		for(int i = 0; i < n; i++)
+		{
+			float output = throttle + outputs[i];
+			if(output < mixer -> output_min) output = mixer -> output_min;
+			if(output > mixer -> output_max) output = mixer -> output_max;
+			outputs[i] = output;
+		}
+	}
+}
+
+/**
+ * @brief: Fixed-point `oh_mixer_mix`, inputs and outputs are Q31 of mixer -> full_scale.
+ * @param:
+ * 		oh_q31_t *outputs: `oh_mixer_motors` outputs in [output_min, output_max].
+ * @note:
+ * 		The matrix is Q15, every product is rounded to nearest and the sums saturate.
+ * 		The airmode scale of the mix rounds toward zero, so the scaled mix keeps its order.
+ */
+void oh_mixer_mix_q(const oh_mixer_t *mixer, oh_q31_t throttle, oh_q31_t roll, oh_q31_t pitch, oh_q31_t yaw, oh_q31_t *outputs)
+{
+	int n = mixer -> _motors;
+	oh_q31_t mix_min = 0, mix_max = 0;
+
+	//Attitude mix.
+	for(int i = 0; i < n; i++)
+	{
+		oh_q31_t mix = oh_q31_sat(
+			(int64_t)oh_q31_mul_q15(roll, mixer -> _roll_q[i], 0) +
+			oh_q31_mul_q15(pitch, mixer -> _pitch_q[i], 0) +
+			oh_q31_mul_q15(yaw, mixer -> _yaw_q[i], 0));
+		outputs[i] = mix;
+		if(mix < mix_min) mix_min = mix;
+		if(mix > mix_max) mix_max = mix;
+	}
+
+	if(mixer -> airmode)
+	{
+		//Scale the mix into the output range, |mix| <= 2^31 and range < 2^32, so the products fit in 64 bits.
+		int64_t range = (int64_t)mixer -> _output_max_q - mixer -> _output_min_q;
+		int64_t span = (int64_t)mix_max - mix_min;
+		if(span > range)
+		{
+			for(int i = 0; i < n; i++)
+				outputs[i] = (oh_q31_t)(outputs[i] * range / span);
+			mix_min = (oh_q31_t)(mix_min * range / span);
+			mix_max = (oh_q31_t)(mix_max * range / span);
+		}
+
+		//Then move the throttle so that no output saturates.
+		int64_t base = throttle;
+		if(base < (int64_t)mixer -> _output_min_q - mix_min)
+			base = (int64_t)mixer -> _output_min_q - mix_min;
+		else if(base > (int64_t)mixer -> _output_max_q - mix_max)
+			base = (int64_t)mixer -> _output_max_q - mix_max;
+
+		for(int i = 0; i < n; i++)
+			outputs[i] = oh_q31_sat(base + outputs[i]);
+	} else {
+		for(int i = 0; i < n; i++)
+		{
+			int64_t output = (int64_t)throttle + outputs[i];
+			if(output < mixer -> _output_min_q) output = mixer -> _output_min_q;
+			if(output > mixer -> _output_max_q) output = mixer -> _output_max_q;
+			outputs[i] = (oh_q31_t)output;
+		}
+	}
+}
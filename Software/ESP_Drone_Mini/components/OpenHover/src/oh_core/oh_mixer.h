@@ -0,0 +1,101 @@
+#ifndef _OH_MIXER_H_
+#define _OH_MIXER_H_
+
+#include <stdint.h>
+
+#include "oh_pid_q.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: Multirotor mixer.
+ * @note:  outputs[i] = throttle + roll * R[i] + pitch * P[i] + yaw * Y[i], with the matrix
+ * 		filled from a geometry preset at initialization. Clockwise motors take +yaw.
+ */
+#define OH_MIXER_MAX_MOTORS		(8)
+
+/**
+ * @brief: Geometry presets.
+ * @note:
+ * 		OH_MIXER_QUAD_X: the layout of oh_quadrotor_pid.h, outputs are in the order M1, M2, M3, M4.
+ * 		OH_MIXER_HEX_X, OH_MIXER_OCTO_X: motor i sits at (i + 0.5) * 360 / n degree clockwise from the nose,
+ * 			even motors spin anti-clockwise. The nose is the roll axis x of oh_quadrotor_pid.h and clockwise is
+ * 			the order M1, M3, M2, M4 of the quad, so motor 0 is in the quadrant of M1 and takes its signs.
+ */
+typedef enum
+{
+	OH_MIXER_QUAD_X = 0,
+	OH_MIXER_HEX_X  = 1,
+	OH_MIXER_OCTO_X = 2,
+} oh_mixer_geometry_t;
+
+/**
+ * @brief: Mixer typedef struct.
+ * @param:
+ * 		@configs:
+ * 			oh_mixer_geometry_t geometry: Frame geometry.
+ * 			uint8_t airmode:              Keep the full attitude authority by moving the throttle, scale the
+ * 			                              attitude mix down only when it spans more than the output range.
+ * 			                              Otherwise each output is clamped alone.
+ * 			float output_min:             Minimum of outputs.
+ * 			float output_max:             Maximum of outputs.
+ * 			float full_scale:             Float value of Q31 1.0 in `oh_mixer_mix_q`, the output range must be in
+ * 			                              [-full_scale, full_scale]. 0 if the fixed-point mix is not used.
+ */
+typedef struct
+{
+	//configs
+	oh_mixer_geometry_t geometry;
+	uint8_t airmode;
+	float output_min;
+	float output_max;
+	float full_scale;
+
+	//private realizations.
+	uint8_t _motors;
+	float _roll[OH_MIXER_MAX_MOTORS];
+	float _pitch[OH_MIXER_MAX_MOTORS];
+	float _yaw[OH_MIXER_MAX_MOTORS];
+	oh_q15_t _roll_q[OH_MIXER_MAX_MOTORS];
+	oh_q15_t _pitch_q[OH_MIXER_MAX_MOTORS];
+	oh_q15_t _yaw_q[OH_MIXER_MAX_MOTORS];
+	oh_q31_t _output_min_q;
+	oh_q31_t _output_max_q;
+} oh_mixer_t;
+
+/**
+ * @brief: Fill the mixing matrix of mixer -> geometry.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_mixer_init(oh_mixer_t *mixer);
+
+/**
+ * @brief: Get the number of outputs of `oh_mixer_mix`.
+ */
+int oh_mixer_motors(const oh_mixer_t *mixer);
+
+/**
+ * @brief: Mix throttle and attitude corrections into motor outputs.
+ * @param:
+ * 		float *outputs: `oh_mixer_motors` outputs in [output_min, output_max].
+ */
+void oh_mixer_mix(const oh_mixer_t *mixer, float throttle, float roll, float pitch, float yaw, float *outputs);
+
+/**
+ * @brief: Fixed-point `oh_mixer_mix`, inputs and outputs are Q31 of mixer -> full_scale.
+ * @param:
+ * 		oh_q31_t *outputs: `oh_mixer_motors` outputs in [output_min, output_max].
+ * @note:
+ * 		The matrix is Q15, every product is rounded to nearest and the sums saturate.
+ * 		The airmode scale of the mix rounds toward zero, so the scaled mix keeps its order.
+ */
+void oh_mixer_mix_q(const oh_mixer_t *mixer, oh_q31_t throttle, oh_q31_t roll, oh_q31_t pitch, oh_q31_t yaw, oh_q31_t *outputs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -384,6 +384,26 @@ float oh_pos_pid_calc_with_err_diff(oh_pos_pid_t *pid, float curr_err, float cur
 	return result;
 }
 
+/**
+ * @brief: Copy the tunable parameters of src to dst and keep the private realizations of dst.
+ * @param:
+ * 		oh_pos_pid_t *dst:       Position PID struct in use.
+ * 		const oh_pos_pid_t *src: Position PID struct with the new parameters.
+ * @note:
+ * 		Copied: gains, output limits and configs switches.
+ * 		The target is kept, it belongs to the loop feeding the pid.
+ */
+void oh_pos_pid_load_gains(oh_pos_pid_t *dst, const oh_pos_pid_t *src)
+{
+	dst -> proportion = src -> proportion;
+	dst -> integration = src -> integration;
+	dst -> differention = src -> differention;
+	dst -> max_abs_output = src -> max_abs_output;
+	dst -> max_abs_int_output = src -> max_abs_int_output;
+	dst -> configs.limitIntegration = src -> configs.limitIntegration;
+	dst -> configs.autoResetIntegration = src -> configs.autoResetIntegration;
+}
+
 /**
  * @brief: Incremental PID calculate.
  * @param:
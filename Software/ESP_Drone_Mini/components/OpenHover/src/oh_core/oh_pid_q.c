@@ -0,0 +1,103 @@
+#include "oh_pid_q.h"
+
+#include <math.h>
+
+/**
+ * @brief: Conversions with saturation, full_scale is the float value mapped to 1.0.
+ */
+oh_q31_t oh_q31_from_float(float x, float full_scale)
+{
+	double scaled = (double)x / full_scale * 2147483648.0;
+	if(isnan(scaled))
+		return 0;
+	if(scaled >= 2147483647.0)
+		return OH_Q31_MAX;
+	if(scaled <= -2147483648.0)
+		return OH_Q31_MIN;
+	return (oh_q31_t)lrint(scaled);
+}
+
+float oh_q31_to_float(oh_q31_t x, float full_scale)
+{
+	return (float)((double)x / 2147483648.0 * full_scale);
+}
+
+oh_q15_t oh_q15_from_float(float x, uint8_t shift)
+{
+	float scaled = ldexpf(x, 15 - shift);
+	if(isnan(scaled))
+		return 0;
+	if(scaled >= OH_Q15_MAX)
+		return OH_Q15_MAX;
+	if(scaled <= OH_Q15_MIN)
+		return OH_Q15_MIN;
+	return (oh_q15_t)lrintf(scaled);
+}
+
+/**
+ * @brief: Fixed-point position PID calculate with customed error and differention.
+ */
+oh_q31_t oh_pos_pid_q_calc_with_err_diff(oh_pos_pid_q_t *pid, oh_q31_t curr_err, oh_q31_t curr_diff)
+{
+	//Integral output.
+	pid -> _intOutput = oh_q31_add(pid -> _intOutput, oh_q31_mul_q15(curr_err, pid -> integration, pid -> gain_shift));
+	if(pid -> limit_integration)
+		pid -> _intOutput = oh_q31_clamp(pid -> _intOutput, pid -> max_abs_int_output);
+
+	//Calculate Output, the sum is done in 64 bits and saturated once.
+	int64_t result =
+		//proportion * error +
+		(int64_t)oh_q31_mul_q15(curr_err, pid -> proportion, pid -> gain_shift) +
+		//integral output +
+		pid -> _intOutput +
+		//differention * error'
+		oh_q31_mul_q15(curr_diff, pid -> differention, pid -> gain_shift);
+
+	//Update error.
+	pid -> _error = curr_err;
+
+	return oh_q31_clamp(oh_q31_sat(result), pid -> max_abs_output);
+}
+
+/**
+ * @brief: Fixed-point position PID calculate.
+ * @param:
+ * 		oh_pos_pid_q_t *pid: Position PID struct.
+ * 		oh_q31_t curr_point: Current system status.
+ * @return:
+ * 		Calculation result.
+ */
+oh_q31_t oh_pos_pid_q_calc(oh_pos_pid_q_t *pid, oh_q31_t curr_point)
+{
+	oh_q31_t error = oh_q31_sub(pid -> target, curr_point);
+	return oh_pos_pid_q_calc_with_err_diff(pid, error, oh_q31_sub(error, pid -> _error));
+}
+
+/**
+ * @brief: Fixed-point incremental PID calculate.
+ * @param:
+ * 		oh_inc_pid_q_t *pid: Incremental PID struct.
+ * 		oh_q31_t curr_point: Current system status.
+ * @return:
+ * 		Calculation results.
+ * @note:
+ * 		You need to integrate and limit the output.
+ */
+oh_q31_t oh_inc_pid_q_calc(oh_inc_pid_q_t *pid, oh_q31_t curr_point)
+{
+	oh_q31_t error = oh_q31_sub(pid -> target, curr_point);
+
+	int64_t result =
+		//proportion * errpr' -> proportion * (error - _lastError) +
+		(int64_t)oh_q31_mul_q15(oh_q31_sub(error, pid -> _lastError), pid -> proportion, pid -> gain_shift) +
+		//integration * error -> I * error +
+		oh_q31_mul_q15(error, pid -> integration, pid -> gain_shift) +
+		//differention * error'' -> differention * [(error + _previousError) - 2 * _lastError]
+		oh_q31_mul_q15(oh_q31_sat((int64_t)error + pid -> _previousError - 2 * (int64_t)pid -> _lastError), pid -> differention, pid -> gain_shift);
+
+	//Update errors.
+	pid -> _previousError = pid -> _lastError;
+	pid -> _lastError = error;
+
+	return oh_q31_clamp(oh_q31_sat(result), pid -> max_abs_output);
+}
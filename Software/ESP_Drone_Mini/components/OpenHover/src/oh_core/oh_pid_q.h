@@ -0,0 +1,162 @@
+#ifndef _OH_PID_Q_H_
+#define _OH_PID_Q_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: Fixed-point arithmetic.
+ * @note:  Signals are Q31 values in [-1, 1), gains are Q15 values scaled by 2^gain_shift.
+ * 		All operations saturate instead of wrapping, and take the same time for any input.
+ */
+typedef int32_t oh_q31_t;
+typedef int16_t oh_q15_t;
+
+#define OH_Q31_MAX		(INT32_MAX)
+#define OH_Q31_MIN		(INT32_MIN)
+#define OH_Q15_MAX		(INT16_MAX)
+#define OH_Q15_MIN		(INT16_MIN)
+
+static inline oh_q31_t oh_q31_sat(int64_t x)
+{
+	if(x > OH_Q31_MAX)
+		return OH_Q31_MAX;
+	if(x < OH_Q31_MIN)
+		return OH_Q31_MIN;
+	return (oh_q31_t)x;
+}
+
+static inline oh_q31_t oh_q31_add(oh_q31_t a, oh_q31_t b)
+{
+	return oh_q31_sat((int64_t)a + b);
+}
+
+static inline oh_q31_t oh_q31_sub(oh_q31_t a, oh_q31_t b)
+{
+	return oh_q31_sat((int64_t)a - b);
+}
+
+static inline oh_q31_t oh_q31_clamp(oh_q31_t x, oh_q31_t max_abs)
+{
+	if(x > max_abs)
+		return max_abs;
+	if(x < - max_abs)
+		return - max_abs;
+	return x;
+}
+
+/**
+ * @brief: x * (gain / 2^15) * 2^shift, rounded to nearest, shift in [0, 15].
+ */
+static inline oh_q31_t oh_q31_mul_q15(oh_q31_t x, oh_q15_t gain, uint8_t shift)
+{
+	int64_t product = (int64_t)x * gain;
+	int bits = 15 - shift;
+	return oh_q31_sat((product + ((int64_t)1 << bits >> 1)) >> bits);
+}
+
+/**
+ * @brief: Conversions with saturation, full_scale is the float value mapped to 1.0.
+ */
+oh_q31_t oh_q31_from_float(float x, float full_scale);
+float oh_q31_to_float(oh_q31_t x, float full_scale);
+oh_q15_t oh_q15_from_float(float x, uint8_t shift);
+
+/**
+ * @group: Fixed-point position PID.
+ */
+
+/**
+ * @brief: Fixed-point position PID typedef struct.
+ * @param:
+ * 		oh_q31_t target:             Target value of PID control system.
+ * 		oh_q15_t proportion:         PID proportional coefficient.
+ * 		oh_q15_t integration:        PID integral coefficient.
+ * 		oh_q15_t differention:       PID differential coefficient.
+ * 		uint8_t gain_shift:          All gains are scaled by 2^gain_shift, in [0, 15].
+ * 		uint8_t limit_integration:   Limit integral output to max_abs_int_output.
+ * 		oh_q31_t max_abs_output:     Maximum absolute value of output.
+ * 		oh_q31_t max_abs_int_output: Integration term output limit.
+ * @note:
+ * 		The integral term accumulates integration * error instead of error, so the limit needs no division.
+ */
+typedef struct
+{
+	//Basic parameters of PID
+	oh_q31_t target;
+
+	oh_q15_t proportion;
+	oh_q15_t integration;
+	oh_q15_t differention;
+	uint8_t gain_shift;
+	uint8_t limit_integration;
+
+	oh_q31_t max_abs_output;
+	oh_q31_t max_abs_int_output;
+
+	//private realizations.
+	oh_q31_t _intOutput;
+	oh_q31_t _error;
+} oh_pos_pid_q_t;
+
+/**
+ * @brief: Fixed-point position PID calculate.
+ * @param:
+ * 		oh_pos_pid_q_t *pid: Position PID struct.
+ * 		oh_q31_t curr_point: Current system status.
+ * @return:
+ * 		Calculation result.
+ */
+oh_q31_t oh_pos_pid_q_calc(oh_pos_pid_q_t *pid, oh_q31_t curr_point);
+
+/**
+ * @brief: Fixed-point position PID calculate with customed error and differention.
+ */
+oh_q31_t oh_pos_pid_q_calc_with_err_diff(oh_pos_pid_q_t *pid, oh_q31_t curr_err, oh_q31_t curr_diff);
+
+/**
+ * @group: Fixed-point incremental PID.
+ */
+
+/**
+ * @brief: Fixed-point incremental PID typedef struct.
+ * @param:
+ * 		@Basic parameters are same as fixed-point position PID.
+ */
+typedef struct
+{
+	//Basic parameters of PID
+	oh_q31_t target;
+
+	oh_q15_t proportion;
+	oh_q15_t integration;
+	oh_q15_t differention;
+	uint8_t gain_shift;
+
+	oh_q31_t max_abs_output;
+
+	//private realizations.
+	oh_q31_t _previousError;
+	oh_q31_t _lastError;
+} oh_inc_pid_q_t;
+
+/**
+ * @brief: Fixed-point incremental PID calculate.
+ * @param:
+ * 		oh_inc_pid_q_t *pid: Incremental PID struct.
+ * 		oh_q31_t curr_point: Current system status.
+ * @return:
+ * 		Calculation results.
+ * @note:
+ * 		You need to integrate and limit the output.
+ */
+oh_q31_t oh_inc_pid_q_calc(oh_inc_pid_q_t *pid, oh_q31_t curr_point);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#include "oh_quat.h"
+
+#include <math.h>
+
+#define OH_DEG_TO_RAD	(0.017453292519943295f)
+#define OH_RAD_TO_DEG	(57.29577951308232f)
+
+/**
+ * @brief: a * b.
+ */
+oh_quat_t oh_quat_mul(oh_quat_t a, oh_quat_t b)
+{
+	oh_quat_t q = {
+		.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+		.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+	};
+	return q;
+}
+
+/**
+ * @brief: Conjugate, the inverse of a unit quaternion.
+ */
+oh_quat_t oh_quat_conj(oh_quat_t q)
+{
+	oh_quat_t c = { .w = q.w, .x = - q.x, .y = - q.y, .z = - q.z };
+	return c;
+}
+
+/**
+ * @brief: Convert Euler angles to quaternion.
+ */
+oh_quat_t oh_quat_from_eular(float pitch, float roll, float yaw)
+{
+	float cp = cosf(pitch * OH_DEG_TO_RAD / 2), sp = sinf(pitch * OH_DEG_TO_RAD / 2);
+	float cr = cosf(roll * OH_DEG_TO_RAD / 2), sr = sinf(roll * OH_DEG_TO_RAD / 2);
+	float cy = cosf(yaw * OH_DEG_TO_RAD / 2), sy = sinf(yaw * OH_DEG_TO_RAD / 2);
+
+	oh_quat_t q = {
+		.w = cr * cp * cy + sr * sp * sy,
+		.x = sr * cp * cy - cr * sp * sy,
+		.y = cr * sp * cy + sr * cp * sy,
+		.z = cr * cp * sy - sr * sp * cy,
+	};
+	return q;
+}
+
+/**
+ * @brief: Convert quaternion to Euler angles.
+ */
+void oh_quat_to_eular(oh_quat_t q, float *pitch, float *roll, float *yaw)
+{
+	float sin_pitch = 2 * (q.w * q.y - q.x * q.z);
+	if(sin_pitch > 1) sin_pitch = 1;
+	if(sin_pitch < -1) sin_pitch = -1;
+
+	*pitch = asinf(sin_pitch) * OH_RAD_TO_DEG;
+	*roll = atan2f(2 * (q.y * q.z + q.w * q.x), 1 - 2 * (q.x * q.x + q.y * q.y)) * OH_RAD_TO_DEG;
+	*yaw = atan2f(2 * (q.x * q.y + q.w * q.z), q.w * q.w + q.x * q.x - q.y * q.y - q.z * q.z) * OH_RAD_TO_DEG;
+}
+
+/**
+ * @brief: Body z axis expressed in the world frame, the third column of the rotation matrix.
+ */
+void oh_quat_body_z(oh_quat_t q, float *z)
+{
+	z[0] = 2 * (q.x * q.z + q.w * q.y);
+	z[1] = 2 * (q.y * q.z - q.w * q.x);
+	z[2] = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+}
@@ -0,0 +1,50 @@
+#ifndef _OH_QUAT_H_
+#define _OH_QUAT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: Quaternion.
+ * @note:  Unit quaternions rotating the body frame to the world frame, w is the scalar part.
+ * 		Euler angles are in degree with the convention of the imu: yaw(z), then pitch(y), then roll(x).
+ */
+typedef struct
+{
+	float w;
+	float x;
+	float y;
+	float z;
+} oh_quat_t;
+
+/**
+ * @brief: a * b.
+ */
+oh_quat_t oh_quat_mul(oh_quat_t a, oh_quat_t b);
+
+/**
+ * @brief: Conjugate, the inverse of a unit quaternion.
+ */
+oh_quat_t oh_quat_conj(oh_quat_t q);
+
+/**
+ * @brief: Convert Euler angles to quaternion.
+ */
+oh_quat_t oh_quat_from_eular(float pitch, float roll, float yaw);
+
+/**
+ * @brief: Convert quaternion to Euler angles.
+ */
+void oh_quat_to_eular(oh_quat_t q, float *pitch, float *roll, float *yaw);
+
+/**
+ * @brief: Body z axis expressed in the world frame, the third column of the rotation matrix.
+ */
+void oh_quat_body_z(oh_quat_t q, float *z);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
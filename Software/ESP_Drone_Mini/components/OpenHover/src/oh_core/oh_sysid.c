@@ -0,0 +1,199 @@
+#include "oh_sysid.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI	(3.14159265358979323846)
+#endif
+
+static float __oh_sysid_grid_tau(const oh_sysid_t *id, float step)
+{
+	return id -> tau_min * powf(id -> tau_max / id -> tau_min, step / (OH_SYSID_TAU_STEPS - 1));
+}
+
+//b of a candidate minimizing J, and J.
+static float __oh_sysid_fit(const oh_sysid_t *id, int d, int t, float *b)
+{
+	const float *szm = id -> _szm[d][t];
+	float sgg = 0, sgh = 0, shh = 0;
+	for(int j = 0; j < OH_SYSID_TAU_STEPS; j++)
+	{
+		sgg += id -> _szy[j] * id -> _szy[j];
+		sgh += id -> _szy[j] * szm[j];
+		shh += szm[j] * szm[j];
+	}
+	*b = (shh > 0) ? sgh / shh : 0;
+	return sgg - *b * sgh;
+}
+
+static void __oh_sysid_finish(oh_sysid_t *id)
+{
+	int best_d = 0, best_t = 0;
+	float best = INFINITY;
+	for(int d = 0; d <= id -> max_delay; d++)
+	{
+		for(int t = 0; t < OH_SYSID_TAU_STEPS; t++)
+		{
+			float b;
+			float residual = __oh_sysid_fit(id, d, t, &b);
+			if(residual < best)
+			{
+				best = residual;
+				best_d = d;
+				best_t = t;
+			}
+		}
+	}
+
+	float b, energy = 0;
+	__oh_sysid_fit(id, best_d, best_t, &b);
+	for(int j = 0; j < OH_SYSID_TAU_STEPS; j++)
+		energy += id -> _szy[j] * id -> _szy[j];
+	if(!(b > 0) || !(energy > 0))
+	{
+		id -> state = OH_SYSID_FAILED;
+		return;
+	}
+
+	//Parabolic refinement of tau in the grid steps.
+	float step = best_t;
+	if(best_t > 0 && best_t < OH_SYSID_TAU_STEPS - 1)
+	{
+		float b_side;
+		float r0 = __oh_sysid_fit(id, best_d, best_t - 1, &b_side);
+		float r2 = __oh_sysid_fit(id, best_d, best_t + 1, &b_side);
+		float den = r0 - 2 * best + r2;
+		if(den > 0)
+			step += 0.5f * (r0 - r2) / den;
+	}
+
+	id -> gain = b * id -> sample_hz;
+	id -> tau = __oh_sysid_grid_tau(id, step);
+	id -> delay = best_d / id -> sample_hz;
+	id -> fit = best / energy;
+	id -> state = OH_SYSID_DONE;
+}
+
+/**
+ * @brief: Start an identification.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_sysid_start(oh_sysid_t *id)
+{
+	if(!(id -> amplitude > 0) || !(id -> sample_hz > 0) || !(id -> duration > 0)
+		|| !(id -> f0_hz > 0) || !(id -> f1_hz > id -> f0_hz) || !(id -> f1_hz < id -> sample_hz / 2)
+		|| !(id -> tau_min > 0) || !(id -> tau_max > id -> tau_min) || id -> max_delay > OH_SYSID_MAX_DELAY
+		|| oh_filter_chain_init(&id -> _filter, 2, id -> sample_hz, id -> filter, id -> filter_stages))
+	{
+		id -> state = OH_SYSID_FAILED;
+		return -1;
+	}
+
+	//Exact discretization with the command held: the state decays by a in a tick, and its mean over
+	//the tick is c * m + (1 - c) * u.
+	for(int t = 0; t < OH_SYSID_TAU_STEPS; t++)
+	{
+		float tau_ticks = __oh_sysid_grid_tau(id, t) * id -> sample_hz;
+		id -> _a[t] = expf(-1.0f / tau_ticks);
+		id -> _c[t] = tau_ticks * (1 - id -> _a[t]);
+	}
+	memset(id -> _u, 0x00, sizeof(id -> _u));
+	memset(id -> _z, 0x00, sizeof(id -> _z));
+	memset(id -> _szy, 0x00, sizeof(id -> _szy));
+	memset(id -> _m, 0x00, sizeof(id -> _m));
+	memset(id -> _m_mean, 0x00, sizeof(id -> _m_mean));
+	memset(id -> _szm, 0x00, sizeof(id -> _szm));
+	id -> _chirp = 0;
+	id -> _ticks = 0;
+	id -> _total_ticks = (uint32_t)(id -> duration * id -> sample_hz);
+	id -> _phase = 0;
+	id -> _has_rate = 0;
+	id -> state = OH_SYSID_RUNNING;
+	return 0;
+}
+
+/**
+ * @brief: Get the chirp sample of this tick and advance it, 0 when not running.
+ */
+float oh_sysid_excitation(oh_sysid_t *id)
+{
+	if(id -> state != OH_SYSID_RUNNING)
+		return 0;
+
+	//Logarithmic sweep, the instantaneous frequency is f0 * (f1 / f0)^(t / duration).
+	float t = id -> _ticks / id -> sample_hz;
+	float f = id -> f0_hz * powf(id -> f1_hz / id -> f0_hz, t / id -> duration);
+	float out = id -> amplitude * sinf(id -> _phase);
+	id -> _chirp = out;
+	id -> _phase += 2 * (float)M_PI * f / id -> sample_hz;
+	if(id -> _phase > 2 * (float)M_PI)
+		id -> _phase -= 2 * (float)M_PI;
+	return out;
+}
+
+/**
+ * @brief: Add the sample of this tick.
+ * @param:
+ * 		float rate:    Measured angular velocity of this tick.
+ * 		float command: Total command of this tick, including the chirp.
+ */
+void oh_sysid_update(oh_sysid_t *id, float rate, float command)
+{
+	if(id -> state != OH_SYSID_RUNNING)
+		return;
+	if(!isfinite(rate) || !isfinite(command))
+	{
+		id -> state = OH_SYSID_FAILED;
+		return;
+	}
+
+	//Sums of z[j] * dw[k] and z[j] * the mean of m over the last tick.
+	if(id -> _has_rate)
+	{
+		float y = rate - id -> _last_rate;
+		for(int j = 0; j < OH_SYSID_TAU_STEPS; j++)
+			id -> _szy[j] += id -> _z[j] * y;
+		for(int d = 0; d <= id -> max_delay; d++)
+		{
+			for(int t = 0; t < OH_SYSID_TAU_STEPS; t++)
+			{
+				float m = id -> _m_mean[d][t];
+				float *szm = id -> _szm[d][t];
+				for(int j = 0; j < OH_SYSID_TAU_STEPS; j++)
+					szm[j] += id -> _z[j] * m;
+			}
+		}
+	}
+	id -> _last_rate = rate;
+	id -> _has_rate = 1;
+
+	//Motor states of the candidates and instruments, driven by the filtered command and chirp.
+	memmove(id -> _u + 1, id -> _u, sizeof(id -> _u[0]) * OH_SYSID_MAX_DELAY);
+	id -> _u[0][0] = command;
+	id -> _u[0][1] = id -> _chirp;
+	oh_filter_chain_apply(&id -> _filter, id -> _u[0]);
+	for(int t = 0; t < OH_SYSID_TAU_STEPS; t++)
+	{
+		float a = id -> _a[t];
+		float c = id -> _c[t];
+		id -> _z[t] = a * id -> _z[t] + (1 - a) * id -> _u[0][1];
+		for(int d = 0; d <= id -> max_delay; d++)
+		{
+			id -> _m_mean[d][t] = c * id -> _m[d][t] + (1 - c) * id -> _u[d][0];
+			id -> _m[d][t] = a * id -> _m[d][t] + (1 - a) * id -> _u[d][0];
+		}
+	}
+
+	if(++ id -> _ticks >= id -> _total_ticks)
+		__oh_sysid_finish(id);
+}
+
+/**
+ * @brief: Abort a running identification, the state becomes OH_SYSID_IDLE.
+ */
+void oh_sysid_stop(oh_sysid_t *id)
+{
+	id -> state = OH_SYSID_IDLE;
+}
@@ -0,0 +1,127 @@
+#ifndef _OH_SYSID_H_
+#define _OH_SYSID_H_
+
+#include <stdint.h>
+
+#include "oh_filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: System identification of an angular velocity loop.
+ * @note:  A logarithmic chirp is added to the command u of an axis, and the response of the rate w
+ * 		is fitted to the model:
+ * 			dm/dt = (u(t - delay) - m) / tau                      (motor, u held between ticks)
+ * 			w[k] = w[k - 1] + b * mean of m over the last tick    (rigid body)
+ * 		For every candidate (tau, delay) of a grid, m is simulated from u and b is estimated with
+ * 		instrumental variables: z[j] is the chirp alone through the motor model of the grid tau j.
+ * 		The chirp is not correlated with the gyro noise, which the pid feeds back into u, while any
+ * 		residual of a wrong candidate is, so the candidate and b are those which best decorrelate
+ * 		the residual dw - b * m from all z[j]:
+ * 			J = sum_j (sum z[j] * dw - b * sum z[j] * m)^2
+ * 		A plain least squares fit would instead find the inverse of the pid under a strong feedback.
+ * 		The state of a candidate is m and its sums with z[j], nothing is buffered.
+ * 		The candidate with the lowest J gives the result, tau is refined between grid points.
+ * 		When the measured rate is filtered, the same filter should be configured, it is applied to u
+ * 		and to the chirp so that the model sees the filter as the measurement does.
+ */
+#define OH_SYSID_MAX_DELAY	(4)
+#define OH_SYSID_TAU_STEPS	(12)
+
+typedef enum
+{
+	OH_SYSID_IDLE    = 0,
+	OH_SYSID_RUNNING = 1,
+	OH_SYSID_DONE    = 2,
+	OH_SYSID_FAILED  = 3,
+} oh_sysid_state_t;
+
+/**
+ * @brief: System identification typedef struct.
+ * @param:
+ * 		@configs:
+ * 			float amplitude:     Chirp amplitude, in the command unit.
+ * 			float f0_hz, f1_hz:  Start and end frequencies of the chirp, below sample_hz / 2.
+ * 			float duration:      Chirp duration in s.
+ * 			float sample_hz:     Rate of `oh_sysid_update`.
+ * 			float tau_min, tau_max: Range of the motor time constant in s, log spaced by OH_SYSID_TAU_STEPS.
+ * 			uint8_t max_delay:   Largest delay candidate in ticks, up to OH_SYSID_MAX_DELAY.
+ * 			oh_biquad_config_t filter[]: Filter of the measured rate, filter_stages may be 0.
+ * 		@status:
+ * 			oh_sysid_state_t state: State of the identification.
+ * 			float gain:             b * sample_hz, angular acceleration per command unit(rate unit / s).
+ * 			float tau:              Motor time constant in s.
+ * 			float delay:            Delay in s, whole ticks.
+ * 			float fit:              J / sum_j (sum z[j] * dw)^2 of the result, lower is better.
+ */
+typedef struct
+{
+	//configs
+	float amplitude;
+	float f0_hz;
+	float f1_hz;
+	float duration;
+	float sample_hz;
+	float tau_min;
+	float tau_max;
+	uint8_t max_delay;
+	uint8_t filter_stages;
+	oh_biquad_config_t filter[OH_FILTER_MAX_STAGES];
+
+	//status
+	oh_sysid_state_t state;
+	float gain;
+	float tau;
+	float delay;
+	float fit;
+
+	//private realizations.
+	uint32_t _ticks;
+	uint32_t _total_ticks;
+	float _phase;
+	float _last_rate;
+	uint8_t _has_rate;
+	float _chirp;
+	float _a[OH_SYSID_TAU_STEPS];
+	float _c[OH_SYSID_TAU_STEPS];
+	float _u[OH_SYSID_MAX_DELAY + 1][2];
+	float _z[OH_SYSID_TAU_STEPS];
+	float _szy[OH_SYSID_TAU_STEPS];
+	float _m[OH_SYSID_MAX_DELAY + 1][OH_SYSID_TAU_STEPS];
+	float _m_mean[OH_SYSID_MAX_DELAY + 1][OH_SYSID_TAU_STEPS];
+	float _szm[OH_SYSID_MAX_DELAY + 1][OH_SYSID_TAU_STEPS][OH_SYSID_TAU_STEPS];
+	oh_filter_chain_t _filter;
+} oh_sysid_t;
+
+/**
+ * @brief: Start an identification.
+ * @return:
+ * 		0 if success, -1 if the configs are invalid.
+ */
+int oh_sysid_start(oh_sysid_t *id);
+
+/**
+ * @brief: Get the chirp sample of this tick and advance it, 0 when not running.
+ */
+float oh_sysid_excitation(oh_sysid_t *id);
+
+/**
+ * @brief: Add the sample of this tick.
+ * @param:
+ * 		float rate:    Measured angular velocity of this tick.
+ * 		float command: Total command of this tick, including the chirp.
+ */
+void oh_sysid_update(oh_sysid_t *id, float rate, float command);
+
+/**
+ * @brief: Abort a running identification, the state becomes OH_SYSID_IDLE.
+ */
+void oh_sysid_stop(oh_sysid_t *id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,7 +1,16 @@
 #include "oh_quadrotor_pid.h"
 
+#include <math.h>
+#include <stddef.h>
+
 #include "oh_pid.h"
 
+#ifndef M_PI
+#define M_PI    (3.14159265358979323846)
+#endif
+
+#define OH_QUAD_RAD_TO_DEG      (57.29577951308232f)
+
 /**
  *       +------+         +------+
  *       |      |         |      |
@@ -23,55 +32,291 @@
  * yaw          x                 
  */
 
-void oh_quad_pid_control_realize(oh_drv_status_t *status, oh_quad_pid_t *pid, oh_drv_quadrotor_output_t *output)
+static float __oh_quad_rate_pid_calc(oh_pos_pid_t *pid, oh_filter_chain_t *dterm_filter, int axis, float curr_point)
+{
+    float error = pid->target - curr_point;
+    float diff = oh_filter_chain_apply_axis(dterm_filter, axis, error - pid->_error);
+    return oh_pos_pid_calc_with_err_diff(pid, error, diff);
+}
+
+static void __oh_quad_lerp_gains(oh_pos_pid_t *pid, const oh_pid_gains_t *a, const oh_pid_gains_t *b, float frac)
+{
+    pid->proportion = a->proportion + (b->proportion - a->proportion) * frac;
+    pid->integration = a->integration + (b->integration - a->integration) * frac;
+    pid->differention = a->differention + (b->differention - a->differention) * frac;
+}
+
+static void __oh_quad_apply_schedule(oh_quad_pid_t *pid, float thrust)
+{
+    const oh_quad_gain_schedule_t *schedule = &pid->schedule;
+    int points = schedule->points;
+    if(points < 2 || points > OH_QUAD_SCHEDULE_MAX_POINTS || !(schedule->thrust_max > schedule->thrust_min))
+        return;
+
+    // uniform breakpoints, so the segment is found without a search.
+    float pos = (thrust - schedule->thrust_min) / (schedule->thrust_max - schedule->thrust_min) * (points - 1);
+    if(!(pos > 0)) pos = 0;
+    if(pos > points - 1) pos = points - 1;
+    int index = (int)pos;
+    if(index >= points - 1) index = points - 2;
+    float frac = pos - index;
+
+    const oh_quad_rate_gains_t *a = &schedule->gains[index];
+    const oh_quad_rate_gains_t *b = &schedule->gains[index + 1];
+    __oh_quad_lerp_gains(&pid->veloc_pitch, &a->veloc_pitch, &b->veloc_pitch, frac);
+    __oh_quad_lerp_gains(&pid->veloc_roll, &a->veloc_roll, &b->veloc_roll, frac);
+    __oh_quad_lerp_gains(&pid->veloc_yaw, &a->veloc_yaw, &b->veloc_yaw, frac);
+}
+
+static void __oh_quad_store_gains(oh_pid_gains_t *gains, const oh_pos_pid_t *pid)
+{
+    gains->proportion = pid->proportion;
+    gains->integration = pid->integration;
+    gains->differention = pid->differention;
+}
+
+static oh_pos_pid_t *__oh_quad_rate_pid(oh_quad_pid_t *pid, int axis)
+{
+    switch(axis)
+    {
+    case OH_QUAD_AXIS_PITCH:
+        return &pid->veloc_pitch;
+    case OH_QUAD_AXIS_ROLL:
+        return &pid->veloc_roll;
+    case OH_QUAD_AXIS_YAW:
+        return &pid->veloc_yaw;
+    default:
+        return NULL;
+    }
+}
+
+static oh_pos_pid_t *__oh_quad_angle_pid(oh_quad_pid_t *pid, int axis)
+{
+    switch(axis)
+    {
+    case OH_QUAD_AXIS_PITCH:
+        return &pid->angle_pitch;
+    case OH_QUAD_AXIS_ROLL:
+        return &pid->angle_roll;
+    default:
+        return NULL;
+    }
+}
+
+static oh_pid_gains_t *__oh_quad_schedule_gains(oh_quad_rate_gains_t *gains, int axis)
+{
+    switch(axis)
+    {
+    case OH_QUAD_AXIS_PITCH:
+        return &gains->veloc_pitch;
+    case OH_QUAD_AXIS_ROLL:
+        return &gains->veloc_roll;
+    default:
+        return &gains->veloc_yaw;
+    }
+}
+
+// write the tuned gains back, the integrator restarts from the trim the relay was centered on.
+static void __oh_quad_autotune_apply(oh_quad_pid_t *pid)
+{
+    const oh_autotune_t *at = pid->autotune;
+    oh_pos_pid_t *rate = __oh_quad_rate_pid(pid, pid->autotune_axis);
+    oh_pos_pid_t *angle = __oh_quad_angle_pid(pid, pid->autotune_axis);
+
+    // the bandwidth of the angle loop of the axis is set below the ultimate frequency of its rate loop.
+    if(angle && at->tu > 0)
+        angle->proportion = 2 * (float)M_PI / (at->tu * OH_QUAD_AUTOTUNE_ANGLE_RATIO);
+
+    rate->proportion = at->proportion;
+    rate->integration = at->integration;
+    rate->differention = at->differention;
+    rate->_sumError = (at->integration > 0) ? at->_bias / at->integration : 0;
+    for(int i = 0; i < OH_QUAD_SCHEDULE_MAX_POINTS; i++)
+        __oh_quad_store_gains(__oh_quad_schedule_gains(&pid->schedule.gains[i], pid->autotune_axis), rate);
+}
+
+static void __oh_quad_quat_attitude_realize(oh_drv_status_t *status, oh_quad_pid_t *pid)
+{
+    // the setpoint is converted only when the targets change.
+    if(!pid->_sp_valid || pid->_sp_eular[0] != pid->angle_pitch.target
+        || pid->_sp_eular[1] != pid->angle_roll.target || pid->_sp_eular[2] != pid->angle_yaw.target)
+    {
+        pid->_sp_eular[0] = pid->angle_pitch.target;
+        pid->_sp_eular[1] = pid->angle_roll.target;
+        pid->_sp_eular[2] = pid->angle_yaw.target;
+        pid->_sp_quat = oh_quat_from_eular(pid->_sp_eular[0], pid->_sp_eular[1], pid->_sp_eular[2]);
+        oh_quat_body_z(pid->_sp_quat, pid->_sp_body_z);
+        pid->_sp_valid = 1;
+    }
+
+    oh_quat_t q = { .w = status->q0, .x = status->q1, .y = status->q2, .z = status->q3 };
+
+    // shortest rotation(in world) bringing the body z axis onto the setpoint z axis.
+    float z[3];
+    oh_quat_body_z(q, z);
+    const float *zd = pid->_sp_body_z;
+    oh_quat_t tilt = {
+        .w = 1 + z[0] * zd[0] + z[1] * zd[1] + z[2] * zd[2],
+        .x = z[1] * zd[2] - z[2] * zd[1],
+        .y = z[2] * zd[0] - z[0] * zd[2],
+        .z = z[0] * zd[1] - z[1] * zd[0],
+    };
+    float norm = tilt.w * tilt.w + tilt.x * tilt.x + tilt.y * tilt.y + tilt.z * tilt.z;
+    if(tilt.w < 1e-6f || !(norm > 0))
+    {
+        // upside down to the setpoint, any axis normal to the body z axis is the shortest: the body x axis.
+        tilt = (oh_quat_t){
+            .w = 0,
+            .x = 1 - 2 * (q.y * q.y + q.z * q.z),
+            .y = 2 * (q.x * q.y + q.w * q.z),
+            .z = 2 * (q.x * q.z - q.w * q.y),
+        };
+    } else {
+        norm = 1.0f / sqrtf(norm);
+        tilt.w *= norm; tilt.x *= norm; tilt.y *= norm; tilt.z *= norm;
+    }
+
+    // tilt error in body frame, then the remaining heading error around the body z axis.
+    oh_quat_t tilt_sp = oh_quat_mul(tilt, q);
+    oh_quat_t tilt_err = oh_quat_mul(oh_quat_conj(q), tilt_sp);
+    oh_quat_t yaw_err = oh_quat_mul(oh_quat_conj(tilt_sp), pid->_sp_quat);
+    float tilt_sign = (tilt_err.w < 0) ? -2 * OH_QUAD_RAD_TO_DEG : 2 * OH_QUAD_RAD_TO_DEG;
+    float yaw_sign = (yaw_err.w < 0) ? -2 * OH_QUAD_RAD_TO_DEG : 2 * OH_QUAD_RAD_TO_DEG;
+
+    // calc angle pids with the small-angle rotation vector, in degree.
+    pid->veloc_roll.target = oh_pos_pid_calc_with_err_diff(&pid->angle_roll, tilt_err.x * tilt_sign, status->gx);
+    pid->veloc_pitch.target = oh_pos_pid_calc_with_err_diff(&pid->angle_pitch, tilt_err.y * tilt_sign, status->gy);
+    pid->veloc_yaw.target = oh_pos_pid_calc_with_err_diff(&pid->angle_yaw, yaw_err.z * yaw_sign, status->gz);
+}
+
+int oh_quad_pid_init(oh_quad_pid_t *pid)
+{
+    if(pid->mixer.geometry != OH_MIXER_QUAD_X)
+        return -1;
+    if(pid->torque_scale == 0)
+        pid->torque_scale = 1;
+    return oh_mixer_init(&pid->mixer);
+}
+
+void oh_quad_pid_control_realize(oh_drv_status_t *status, oh_quad_pid_t *pid, float throttle, oh_drv_quadrotor_output_t *output)
 {
-    static float base_rps = 0;
+    oh_quad_pid_attitude_realize(status, pid);
+    oh_quad_pid_rate_realize(status, pid, throttle, output);
+}
 
-    static float pitch_diff = 0;
-    static float roll_diff = 0;
-    static float yaw_diff = 0;
+void oh_quad_pid_attitude_realize(oh_drv_status_t *status, oh_quad_pid_t *pid)
+{
+    if(pid->attitude_mode == OH_QUAD_ATTITUDE_QUAT)
+    {
+        __oh_quad_quat_attitude_realize(status, pid);
+        return;
+    }
 
     // calc angle pids
     pid->veloc_pitch.target = oh_pos_pid_calc_with_diff(&pid->angle_pitch, status->pitch, status->gy);
     pid->veloc_roll.target = oh_pos_pid_calc_with_diff(&pid->angle_roll, status->roll, status->gx);
+}
+
+void oh_quad_pid_rate_realize(oh_drv_status_t *status, oh_quad_pid_t *pid, float throttle, oh_drv_quadrotor_output_t *output)
+{
+    float outputs[4];
+
+    // scheduled gains.
+    __oh_quad_apply_schedule(pid, throttle);
+
+    // the integrator of the axis under the relay is frozen, the relay output does not feed it back.
+    oh_pos_pid_t *tuned = (pid->autotune && pid->autotune->state == OH_AUTOTUNE_RUNNING) ? __oh_quad_rate_pid(pid, pid->autotune_axis) : NULL;
+    float tuned_sum_error = tuned ? tuned->_sumError : 0;
 
     // calc angular velocity pids
-    pitch_diff = oh_pos_pid_calc(&pid->veloc_pitch, status->gy);
-    roll_diff = oh_pos_pid_calc(&pid->veloc_roll, status->gx);
-    yaw_diff = oh_pos_pid_calc(&pid->veloc_yaw, status->gz);
+    float pitch_diff = __oh_quad_rate_pid_calc(&pid->veloc_pitch, &pid->dterm_filter, OH_QUAD_AXIS_PITCH, status->gy);
+    float roll_diff = __oh_quad_rate_pid_calc(&pid->veloc_roll, &pid->dterm_filter, OH_QUAD_AXIS_ROLL, status->gx);
+    float yaw_diff = __oh_quad_rate_pid_calc(&pid->veloc_yaw, &pid->dterm_filter, OH_QUAD_AXIS_YAW, status->gz);
+    if(tuned)
+        tuned->_sumError = tuned_sum_error;
+
+    // the relay replaces the pid of the tuned axis.
+    if(pid->autotune)
+    {
+        if(pid->autotune->state == OH_AUTOTUNE_RUNNING)
+        {
+            float *diffs[] = { &pitch_diff, &roll_diff, &yaw_diff };
+            float gyro[] = { status->gy, status->gx, status->gz };
+            *diffs[pid->autotune_axis] = oh_autotune_update(pid->autotune, - gyro[pid->autotune_axis]);
+        }
+        if(pid->autotune->state == OH_AUTOTUNE_DONE)
+            __oh_quad_autotune_apply(pid);
+        if(pid->autotune->state != OH_AUTOTUNE_RUNNING)
+            pid->autotune = NULL;
+    }
+
+    // the chirp is added to the command of the identified axis.
+    if(pid->sysid)
+    {
+        if(pid->sysid->state == OH_SYSID_RUNNING)
+        {
+            float *diffs[] = { &pitch_diff, &roll_diff, &yaw_diff };
+            float gyro[] = { status->gy, status->gx, status->gz };
+            *diffs[pid->sysid_axis] += oh_sysid_excitation(pid->sysid);
+            oh_sysid_update(pid->sysid, gyro[pid->sysid_axis], *diffs[pid->sysid_axis]);
+        }
+        if(pid->sysid->state != OH_SYSID_RUNNING)
+            pid->sysid = NULL;
+    }
 
     // calculate output
-    // output base_rps
-    output->m1 = base_rps;
-    output->m4 = base_rps;
-    output->m2 = base_rps;
-    output->m3 = base_rps;
-
-    // output pitch_diff
-    output->m1 += - pitch_diff / 2;
-    output->m4 += - pitch_diff / 2;
-    output->m2 += pitch_diff / 2;
-    output->m3 += pitch_diff / 2;
-
-    // output roll_diff
-    output->m2 += - roll_diff / 2;
-    output->m4 += - roll_diff / 2;
-    output->m1 += roll_diff / 2;
-    output->m3 += roll_diff / 2;
-
-    // Offset output to ensure differential value is achieved.
-    // Find the minimum output value
-    float minimun_rps = output->m1;
-    if(output->m2 < minimun_rps) minimun_rps = output->m2;
-    if(output->m3 < minimun_rps) minimun_rps = output->m3;
-    if(output->m4 < minimun_rps) minimun_rps = output->m4;
-    // outputs += fabs(minimun_rps)
-    if(minimun_rps < 0)
+    oh_mixer_mix(&pid->mixer, throttle, roll_diff * pid->torque_scale, pitch_diff * pid->torque_scale, yaw_diff * pid->torque_scale, outputs);
+    output->m1 = outputs[0];
+    output->m2 = outputs[1];
+    output->m3 = outputs[2];
+    output->m4 = outputs[3];
+}
+
+void oh_quad_pid_schedule_from_gains(oh_quad_pid_t *pid)
+{
+    for(int i = 0; i < OH_QUAD_SCHEDULE_MAX_POINTS; i++)
     {
-        output->m1 -= minimun_rps;
-        output->m2 -= minimun_rps;
-        output->m3 -= minimun_rps;
-        output->m4 -= minimun_rps;
+        __oh_quad_store_gains(&pid->schedule.gains[i].veloc_pitch, &pid->veloc_pitch);
+        __oh_quad_store_gains(&pid->schedule.gains[i].veloc_roll, &pid->veloc_roll);
+        __oh_quad_store_gains(&pid->schedule.gains[i].veloc_yaw, &pid->veloc_yaw);
     }
 }
 
+int oh_quad_pid_autotune_start(oh_quad_pid_t *pid, oh_autotune_t *at, int axis)
+{
+    oh_pos_pid_t *rate = __oh_quad_rate_pid(pid, axis);
+    if(rate == NULL)
+        return -1;
+
+    // the relay switches around the current integral output, which holds the trim of the axis.
+    if(oh_autotune_start(at, rate->integration * rate->_sumError))
+        return -1;
+    pid->autotune_axis = axis;
+    pid->autotune = at;
+    return 0;
+}
+
+int oh_quad_pid_sysid_start(oh_quad_pid_t *pid, oh_sysid_t *id, int axis)
+{
+    if(__oh_quad_rate_pid(pid, axis) == NULL || oh_sysid_start(id))
+        return -1;
+    pid->sysid_axis = axis;
+    pid->sysid = id;
+    return 0;
+}
+
+void oh_quad_pid_load_gains(oh_quad_pid_t *dst, const oh_quad_pid_t *src)
+{
+    oh_pos_pid_load_gains(&dst->veloc_pitch, &src->veloc_pitch);
+    oh_pos_pid_load_gains(&dst->veloc_roll, &src->veloc_roll);
+    oh_pos_pid_load_gains(&dst->veloc_yaw, &src->veloc_yaw);
+    oh_pos_pid_load_gains(&dst->angle_pitch, &src->angle_pitch);
+    oh_pos_pid_load_gains(&dst->angle_roll, &src->angle_roll);
+    oh_pos_pid_load_gains(&dst->angle_yaw, &src->angle_yaw);
+    // the attitude setpoints are tunable, the angular velocity targets are set by the attitude loop.
+    dst->angle_pitch.target = src->angle_pitch.target;
+    dst->angle_roll.target = src->angle_roll.target;
+    dst->angle_yaw.target = src->angle_yaw.target;
+    dst->schedule = src->schedule;
+    dst->torque_scale = src->torque_scale;
+}
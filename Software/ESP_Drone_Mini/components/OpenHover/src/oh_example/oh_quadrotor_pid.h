@@ -1,13 +1,64 @@
 #ifndef __OH_QUADROTOR_PID_H__
 #define __OH_QUADROTOR_PID_H__
 
+#include "oh_autotune.h"
 #include "oh_drv.h"
+#include "oh_filter.h"
+#include "oh_mixer.h"
 #include "oh_pid.h"
+#include "oh_quat.h"
+#include "oh_sysid.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// gains of a pid.
+typedef struct {
+    float proportion;
+    float integration;
+    float differention;
+} oh_pid_gains_t;
+
+// gains of the angular velocity pids at a schedule point.
+typedef struct {
+    oh_pid_gains_t veloc_pitch;
+    oh_pid_gains_t veloc_roll;
+    oh_pid_gains_t veloc_yaw;
+} oh_quad_rate_gains_t;
+
+#define OH_QUAD_SCHEDULE_MAX_POINTS     (5)
+
+/**
+ * @brief: Thrust-indexed gains of the angular velocity pids.
+ * @param:
+ *      uint8_t points   : number of points in use, less than 2 disables the schedule.
+ *      float thrust_min : collective thrust of gains[0].
+ *      float thrust_max : collective thrust of gains[points - 1], the points are evenly spaced in between.
+ * @note: the gains are linearly interpolated by the collective of `oh_quad_pid_rate_realize` and override
+ *          the gains of the angular velocity pids, collectives out of range use the end points. The collective
+ *          is in the units of the mixer, ESP_Drone passes the normalized thrust (rps / max_rps)^2, so the
+ *          points are not in the linear throttle.
+ */
+typedef struct {
+    uint8_t points;
+    float thrust_min;
+    float thrust_max;
+    oh_quad_rate_gains_t gains[OH_QUAD_SCHEDULE_MAX_POINTS];
+} oh_quad_gain_schedule_t;
+
+/**
+ * @brief: Attitude input of the angle pids.
+ * @note:
+ *      OH_QUAD_ATTITUDE_EULER: pitch, roll and yaw of oh_drv_status_t, yaw is not controlled.
+ *      OH_QUAD_ATTITUDE_QUAT:  q0~q3 of oh_drv_status_t, the error quaternion is mapped to the angle pids,
+ *                              the tilt is corrected before the heading. Free of the gimbal lock and the yaw wrap.
+ */
+typedef enum {
+    OH_QUAD_ATTITUDE_EULER = 0,
+    OH_QUAD_ATTITUDE_QUAT  = 1,
+} oh_quad_attitude_mode_t;
+
 typedef struct {
     // angular velocity pid.
     oh_pos_pid_t veloc_pitch;
@@ -18,8 +69,50 @@ typedef struct {
     oh_pos_pid_t angle_pitch;
     oh_pos_pid_t angle_roll;
     oh_pos_pid_t angle_yaw;
+
+    // D-term filter of angular velocity pids, axes are OH_QUAD_AXIS_*, 0 stages for unfiltered D-term.
+    oh_filter_chain_t dterm_filter;
+
+    // motor mixer, the geometry must be OH_MIXER_QUAD_X.
+    oh_mixer_t mixer;
+
+    // gain schedule of angular velocity pids.
+    oh_quad_gain_schedule_t schedule;
+
+    // scale from the angular velocity pid outputs to the mixer units(e.g. normalized thrust), 0 is treated as 1.
+    float torque_scale;
+
+    // attitude input of the angle pids.
+    oh_quad_attitude_mode_t attitude_mode;
+
+    // relay autotune replacing an angular velocity pid, NULL when not tuning. See `oh_quad_pid_autotune_start`.
+    oh_autotune_t *autotune;
+    uint8_t autotune_axis;
+
+    // chirp identification of an angular velocity loop, NULL when not identifying. See `oh_quad_pid_sysid_start`.
+    oh_sysid_t *sysid;
+    uint8_t sysid_axis;
+
+    // private realizations: setpoint of OH_QUAD_ATTITUDE_QUAT, rebuilt when the angle targets change.
+    float _sp_eular[3];
+    oh_quat_t _sp_quat;
+    float _sp_body_z[3];
+    uint8_t _sp_valid;
 } oh_quad_pid_t;
 
+#define OH_QUAD_AXIS_PITCH  (0)
+#define OH_QUAD_AXIS_ROLL   (1)
+#define OH_QUAD_AXIS_YAW    (2)
+
+// an autotuned pitch or roll axis gets an angle loop bandwidth of its rate loop ultimate frequency / ratio.
+#define OH_QUAD_AUTOTUNE_ANGLE_RATIO    (8)
+
+/**
+ * @brief: Initialize the mixer of pid, call it once before the first realize.
+ * @return: 0 if success.
+ */
+int oh_quad_pid_init(oh_quad_pid_t *pid);
+
 /**
  *        clock          anti-clock
  *       +------+         +------+ 
@@ -41,7 +134,61 @@ typedef struct {
  *    +----------> roll            
  * yaw          x                  
  */
-void oh_quad_pid_control_realize(oh_drv_status_t *status, oh_quad_pid_t *pid, oh_drv_quadrotor_output_t *output);
+void oh_quad_pid_control_realize(oh_drv_status_t *status, oh_quad_pid_t *pid, float throttle, oh_drv_quadrotor_output_t *output);
+
+/**
+ * @brief: Outer loop of `oh_quad_pid_control_realize`, updates the angular velocity targets from the attitude.
+ * @note: the outer loop may be called less often than the rate loop, the last targets are held in between.
+ */
+void oh_quad_pid_attitude_realize(oh_drv_status_t *status, oh_quad_pid_t *pid);
+
+/**
+ * @brief: Inner loop of `oh_quad_pid_control_realize`, calculates the angular velocity pids and mixes the outputs.
+ * @param:
+ *      - float throttle : collective output, the attitude corrections are mixed around it.
+ */
+void oh_quad_pid_rate_realize(oh_drv_status_t *status, oh_quad_pid_t *pid, float throttle, oh_drv_quadrotor_output_t *output);
+
+/**
+ * @brief: Fill all points of the gain schedule with the current gains of the angular velocity pids.
+ * @note: the schedule is left disabled, enabling it does not change the behavior until the points are tuned.
+ */
+void oh_quad_pid_schedule_from_gains(oh_quad_pid_t *pid);
+
+/**
+ * @brief: Start the relay autotune of an angular velocity pid.
+ * @param:
+ *      - oh_autotune_t *at : configured autotuner, it must live until the tuning ends.
+ *      - int axis          : OH_QUAD_AXIS_*.
+ * @return: 0 if success, -1 if the axis or the configs of at are invalid.
+ * @note: while at is running, `oh_quad_pid_rate_realize` drives the axis by the relay around the
+ *          integral output of its pid, against a zero angular velocity target, and the integrator of the
+ *          pid is frozen. When at is done, the tuned gains are written to the pid and to all points of the
+ *          gain schedule of the axis, the integrator restarts from the relay center and pid->autotune is
+ *          cleared. The angle pid of a pitch or roll axis gets the proportion of OH_QUAD_AUTOTUNE_ANGLE_RATIO,
+ *          the faster rate loop carries a faster angle loop. A failed or stopped tuning only clears pid->autotune.
+ */
+int oh_quad_pid_autotune_start(oh_quad_pid_t *pid, oh_autotune_t *at, int axis);
+
+/**
+ * @brief: Start the identification of an angular velocity loop.
+ * @param:
+ *      - oh_sysid_t *id : configured identification, it must live until it ends.
+ *      - int axis       : OH_QUAD_AXIS_*.
+ * @return: 0 if success, -1 if the axis or the configs of id are invalid.
+ * @note: while id is running, `oh_quad_pid_rate_realize` adds the chirp to the pid output of the axis
+ *          and feeds the total command and the angular velocity to id. The pid keeps the loop closed.
+ *          pid->sysid is cleared when id ends.
+ */
+int oh_quad_pid_sysid_start(oh_quad_pid_t *pid, oh_sysid_t *id, int axis);
+
+/**
+ * @brief: Copy the tunable parameters of all pids in src to dst, the pid states of dst are kept.
+ * @note: the attitude setpoints(angle_*.target) are copied, the angular velocity targets are not, since
+ *          the attitude loop may only set them every few ticks.
+ *          Call it between two `oh_quad_pid_control_realize` to switch to a new gain set atomically.
+ */
+void oh_quad_pid_load_gains(oh_quad_pid_t *dst, const oh_quad_pid_t *src);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,243 @@
+#include "ed_blackbox.h"
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_sys.h"
+
+#include "ed_sync.h"
+
+static const char* tag = "ed_blackbox";
+
+static ed_bb_log_t bb_log;
+static TaskHandle_t writer_handle = NULL;
+static uint32_t cycles_per_unit = 1;
+static uint32_t erase_ahead = 0;
+
+// staging buffers, a full buffer belongs to the writer task until its flag is cleared.
+static ed_bb_record_t stage[2][ED_BLACKBOX_STAGE_RECORDS];
+static uint32_t stage_count[2] = { 0, 0 };
+static ed_sync_flag_t stage_full[2] = { ED_SYNC_FLAG_INIT(false), ED_SYNC_FLAG_INIT(false) };
+static int stage_active = 0;
+static bool drop_pending = false;
+static ed_sync_int_t dropped = ED_SYNC_INT_INIT(0);
+static ed_sync_flag_t clear_requested = ED_SYNC_FLAG_INIT(false);
+
+// while armed the writer never erases, the records beyond the blank run are discarded.
+static ed_sync_flag_t armed = ED_SYNC_FLAG_INIT(false);
+static ed_sync_int_t discarded = ED_SYNC_INT_INIT(0);
+
+static int __ed_blackbox_read(void* ctx, uint32_t offset, void* data, uint32_t size)
+{
+    return esp_partition_read((const esp_partition_t*)ctx, offset, data, size) == ESP_OK ? 0 : -1;
+}
+
+static int __ed_blackbox_write(void* ctx, uint32_t offset, const void* data, uint32_t size)
+{
+    return esp_partition_write((const esp_partition_t*)ctx, offset, data, size) == ESP_OK ? 0 : -1;
+}
+
+static int __ed_blackbox_erase(void* ctx, uint32_t offset, uint32_t size)
+{
+    return esp_partition_erase_range((const esp_partition_t*)ctx, offset, size) == ESP_OK ? 0 : -1;
+}
+
+static void __ed_blackbox_hand_over(void)
+{
+    ed_sync_flag_set(&stage_full[stage_active], true);
+    stage_active ^= 1;
+    xTaskNotifyGive(writer_handle);
+}
+
+// write a full staging buffer, within the blank run while armed.
+static void __ed_blackbox_write_stage(int index, bool* discarding)
+{
+    uint32_t n = stage_count[index];
+    if(ed_sync_flag_get(&armed))
+    {
+        uint32_t room = ed_bb_log_room(&bb_log);
+        if(n > room)
+        {
+            if(!*discarding)
+                ESP_LOGW(tag, "the erased sectors are used up, logging stops until disarmed.");
+            ed_sync_int_set(&discarded, ed_sync_int_get(&discarded) + n - room);
+            *discarding = true;
+            n = room;
+        }
+    }
+    if(n > 0 && *discarding && !ed_sync_flag_get(&armed))
+    {
+        stage[index][0].flags |= ED_BB_FLAG_DROPPED;
+        *discarding = false;
+    }
+    if(n > 0 && ed_bb_log_append(&bb_log, stage[index], n))
+        ESP_LOGW(tag, "flash write failed, %lu records are lost.", (unsigned long)n);
+}
+
+// erase ahead while disarmed, the arming is checked between sectors.
+static void __ed_blackbox_erase_ahead(void)
+{
+    while(!ed_sync_flag_get(&armed) && bb_log.erased < erase_ahead)
+    {
+        if(ed_bb_log_prepare(&bb_log, erase_ahead))
+        {
+            ESP_LOGE(tag, "erase failed.");
+            break;
+        }
+    }
+}
+
+static void __ed_blackbox_writer_task(void* arg)
+{
+    int next = 0;
+    bool discarding = false;
+    __ed_blackbox_erase_ahead();
+    for( ;; )
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if(ed_sync_flag_get(&clear_requested))
+        {
+            // the arming may have come after the request.
+            if(ed_sync_flag_get(&armed))
+                ESP_LOGW(tag, "armed, clear is refused.");
+            else if(ed_bb_log_clear(&bb_log))
+                ESP_LOGE(tag, "erase failed.");
+            else
+                ESP_LOGI(tag, "cleared, session %lu.", (unsigned long)bb_log.session);
+            ed_sync_flag_set(&clear_requested, false);
+        }
+
+        // the buffers are handed over alternately.
+        while(ed_sync_flag_get(&stage_full[next]))
+        {
+            __ed_blackbox_write_stage(next, &discarding);
+            stage_count[next] = 0;
+            ed_sync_flag_set(&stage_full[next], false);
+            next ^= 1;
+        }
+
+        // erase ahead while disarmed, so that a flight only costs header writes.
+        __ed_blackbox_erase_ahead();
+    }
+    vTaskDelete( NULL );
+}
+
+/**
+ * @brief: Open the partition, start a new session and create the writer task.
+ * @return: 0 if success, -1 if the partition is not found or too small.
+ */
+int ed_blackbox_init(const ed_blackbox_config_t* config)
+{
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, config->partition_label);
+    if(partition == NULL)
+    {
+        ESP_LOGE(tag, "partition %s is not found.", config->partition_label);
+        return -1;
+    }
+
+    bb_log.flash = (ed_bb_flash_t){
+        .read = __ed_blackbox_read,
+        .write = __ed_blackbox_write,
+        .erase = __ed_blackbox_erase,
+        .ctx = (void*)partition,
+        .size = partition->size - partition->size % ED_BB_SECTOR_SIZE,
+    };
+    bb_log.sample_hz = config->sample_hz;
+    if(ed_bb_log_open(&bb_log))
+    {
+        ESP_LOGE(tag, "partition %s is too small.", config->partition_label);
+        return -1;
+    }
+    cycles_per_unit = esp_rom_get_cpu_ticks_per_us() * ED_BB_LOOP_UNIT_US;
+    erase_ahead = ((uint32_t)config->erase_ahead_s * config->sample_hz + ED_BB_RECORDS_PER_SECTOR - 1) / ED_BB_RECORDS_PER_SECTOR;
+    if(erase_ahead > bb_log.flash.size / ED_BB_SECTOR_SIZE - 1)
+        erase_ahead = bb_log.flash.size / ED_BB_SECTOR_SIZE - 1;
+
+    if(ed_task_create(__ed_blackbox_writer_task, "blackbox", NULL, &(config->writer_task), &writer_handle))
+        return -1;
+    ESP_LOGI(tag, "session %lu, %lu sectors, %lu erased ahead.", (unsigned long)bb_log.session,
+        (unsigned long)(bb_log.flash.size / ED_BB_SECTOR_SIZE), (unsigned long)erase_ahead);
+    return 0;
+}
+
+/**
+ * @brief: Stage a record, never blocks.
+ * @return: false if the record is dropped.
+ */
+bool ed_blackbox_log(const ed_bb_record_t* record)
+{
+    if(writer_handle == NULL)
+        return false;
+
+    // both buffers are full, the writer is behind.
+    if(ed_sync_flag_get(&stage_full[stage_active]))
+    {
+        drop_pending = true;
+        ed_sync_int_set(&dropped, ed_sync_int_get(&dropped) + 1);
+        return false;
+    }
+
+    uint32_t n = stage_count[stage_active];
+    stage[stage_active][n] = *record;
+    if(drop_pending)
+    {
+        stage[stage_active][n].flags |= ED_BB_FLAG_DROPPED;
+        drop_pending = false;
+    }
+    stage_count[stage_active] = n + 1;
+    if(n + 1 == ED_BLACKBOX_STAGE_RECORDS)
+        __ed_blackbox_hand_over();
+    return true;
+}
+
+/**
+ * @brief: Hand the partially filled staging buffer to the writer, e.g. when the motors are stopped.
+ */
+void ed_blackbox_flush(void)
+{
+    if(writer_handle == NULL || stage_count[stage_active] == 0 || ed_sync_flag_get(&stage_full[stage_active]))
+        return;
+    __ed_blackbox_hand_over();
+}
+
+/**
+ * @brief: Tell the writer whether the motors run, nothing is erased while armed.
+ * @note: call it from the control task at the arming and the disarming, before the records of the tick.
+ */
+void ed_blackbox_set_armed(bool is_armed)
+{
+    ed_sync_flag_set(&armed, is_armed);
+    if(!is_armed && writer_handle != NULL)
+        xTaskNotifyGive(writer_handle);
+}
+
+/**
+ * @brief: Request the writer task to erase the partition and start a new session.
+ * @return: 0 if requested, -1 if armed(the erase of the partition would stall the control loop for seconds).
+ */
+int ed_blackbox_clear(void)
+{
+    if(writer_handle == NULL || ed_sync_flag_get(&armed))
+        return -1;
+    ed_sync_flag_set(&clear_requested, true);
+    xTaskNotifyGive(writer_handle);
+    return 0;
+}
+
+/**
+ * @brief: Convert the execution time of a tick to the unit of ed_bb_record_t.loop, saturated.
+ */
+uint8_t ed_blackbox_loop_units(uint32_t cycles)
+{
+    uint32_t units = (cycles + cycles_per_unit / 2) / cycles_per_unit;
+    return units > UINT8_MAX ? UINT8_MAX : units;
+}
+
+/**
+ * @brief: Get the number of dropped records since boot, including the records discarded when the erased sectors
+ *          are used up in flight.
+ */
+uint32_t ed_blackbox_dropped(void)
+{
+    return ed_sync_int_get(&dropped) + ed_sync_int_get(&discarded);
+}
@@ -0,0 +1,86 @@
+#ifndef __ED_BLACKBOX_H__
+#define __ED_BLACKBOX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ed_blackbox_format.h"
+#include "ed_blackbox_log.h"
+#include "ed_task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// records of a staging buffer, 64 records are 0.64s at 100Hz which covers a sector change of the writer.
+#define ED_BLACKBOX_STAGE_RECORDS       (64)
+
+/**
+ * @brief: Flight recorder on a data partition, see ed_blackbox_format.h for the layout.
+ * @param:
+ *      const char* partition_label : label of the partition in partitions.csv.
+ *      uint16_t sample_hz          : rate of `ed_blackbox_log`, saved in the sector headers.
+ *      uint16_t erase_ahead_s      : seconds of records kept erased ahead while disarmed, the longest flight
+ *                                    which is logged completely. Limited to the partition.
+ *      ed_task_config_t writer_task: placement of the task which writes the flash.
+ * @note:
+ *          The control task fills one of two staging buffers without blocking, the writer task
+ *          writes the other one to the flash. When the writer is too slow both buffers are full
+ *          and the records are dropped, the next logged record carries ED_BB_FLAG_DROPPED.
+ *          A flash operation disables the cache of both cores, only code and data in internal RAM
+ *          run during it. A sector erase takes tens of ms, so the writer erases only while disarmed
+ *          (see `ed_blackbox_set_armed`); in flight a sector change costs a header write, and the
+ *          records beyond the erased sectors are discarded until the disarming.
+ */
+typedef struct {
+    const char* partition_label;
+    uint16_t sample_hz;
+    uint16_t erase_ahead_s;
+    ed_task_config_t writer_task;
+} ed_blackbox_config_t;
+
+/**
+ * @brief: Open the partition, start a new session and create the writer task.
+ * @return: 0 if success, -1 if the partition is not found or too small.
+ */
+int ed_blackbox_init(const ed_blackbox_config_t* config);
+
+/**
+ * @brief: Stage a record, never blocks.
+ * @return: false if the record is dropped.
+ */
+bool ed_blackbox_log(const ed_bb_record_t* record);
+
+/**
+ * @brief: Hand the partially filled staging buffer to the writer, e.g. when the motors are stopped.
+ */
+void ed_blackbox_flush(void);
+
+/**
+ * @brief: Tell the writer whether the motors run, nothing is erased while armed.
+ * @note: call it from the control task at the arming and the disarming, before the records of the tick.
+ */
+void ed_blackbox_set_armed(bool is_armed);
+
+/**
+ * @brief: Request the writer task to erase the partition and start a new session.
+ * @return: 0 if requested, -1 if armed(the erase of the partition would stall the control loop for seconds).
+ */
+int ed_blackbox_clear(void);
+
+/**
+ * @brief: Convert the execution time of a tick to the unit of ed_bb_record_t.loop, saturated.
+ */
+uint8_t ed_blackbox_loop_units(uint32_t cycles);
+
+/**
+ * @brief: Get the number of dropped records since boot, including the records discarded when the erased sectors
+ *          are used up in flight.
+ */
+uint32_t ed_blackbox_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
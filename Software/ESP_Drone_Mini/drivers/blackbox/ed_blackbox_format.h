@@ -0,0 +1,82 @@
+#ifndef __ED_BLACKBOX_FORMAT_H__
+#define __ED_BLACKBOX_FORMAT_H__
+
+#include <stdint.h>
+
+/**
+ * @note: Flash layout of the blackbox partition.
+ *          This header has no platform dependencies and is shared with the host tools.
+ *
+ *          The partition is a ring of ED_BB_SECTOR_SIZE sectors written in order, all fields are
+ *          little-endian. A sector holds ED_BB_SLOTS_PER_SECTOR slots of ED_BB_RECORD_SIZE bytes:
+ *              | ed_bb_sector_header_t | ed_bb_record_t | ed_bb_record_t | ... |
+ *          A sector is erased right before it is reused, so a sector is erased at most once per lap
+ *          of the ring and the wear is even.
+ *          sequence of the header increases by one per started sector, the ring is read from the
+ *          lowest valid sequence. session increases by one per boot, it separates the flights.
+ *          Records are appended after the header, the first slot whose tick is ED_BB_ERASED_TICK
+ *          ends the sector. flags is the last byte of a record and ED_BB_FLAG_PENDING is never set by
+ *          the writer, so a record torn by a power cut still has it and also ends the sector.
+ *          A header with a bad magic, version or checksum marks a free sector.
+ */
+
+#define ED_BB_MAGIC                     (0x42424445)    // "EDBB"
+#define ED_BB_VERSION                   (1)
+#define ED_BB_SECTOR_SIZE               (4096)
+#define ED_BB_RECORD_SIZE               (32)
+#define ED_BB_SLOTS_PER_SECTOR          (ED_BB_SECTOR_SIZE / ED_BB_RECORD_SIZE)
+#define ED_BB_RECORDS_PER_SECTOR        (ED_BB_SLOTS_PER_SECTOR - 1)
+#define ED_BB_ERASED_TICK               (0xFFFFFFFF)
+
+// fixed point scales of the record fields.
+#define ED_BB_GYRO_SCALE                (10)        // 0.1 deg/s.
+#define ED_BB_ANGLE_SCALE               (100)       // 0.01 deg.
+#define ED_BB_QUAT_SCALE                (23169)     // quaternion component in [-1/sqrt(2), 1/sqrt(2)], 15 bits.
+#define ED_BB_MOTOR_SCALE               (65535)     // thrust in [0, 1].
+#define ED_BB_LOOP_UNIT_US              (50)
+
+#define ED_BB_FLAG_IMU_VALID            (0x01)
+#define ED_BB_FLAG_ARMED                (0x02)
+#define ED_BB_FLAG_DEGRADED             (0x04)
+#define ED_BB_FLAG_AUTOTUNE             (0x08)
+#define ED_BB_FLAG_SYSID                (0x10)
+#define ED_BB_FLAG_QUAT                 (0x20)      // angle holds the attitude quaternion, see ed_bb_record_t.
+#define ED_BB_FLAG_PENDING              (0x40)      // erased value, cleared when the record is complete.
+#define ED_BB_FLAG_DROPPED              (0x80)      // records were dropped right before this one.
+
+/**
+ * @brief: Header of a sector, in the first slot.
+ * @note: checksum is the 8-bit sum of all the bytes before it.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t session;
+    uint16_t version;
+    uint16_t record_size;
+    uint16_t sample_hz;
+    uint8_t reserved[13];
+    uint8_t checksum;
+} ed_bb_sector_header_t;
+
+/**
+ * @brief: A control tick.
+ * @note: With ED_BB_FLAG_QUAT, angle holds the unit quaternion { w, x, y, z } of the attitude as its three
+ *          smallest components: the largest one is dropped, its index is (angle[0] & 1) | (angle[1] & 1) << 1,
+ *          and it is positive(q and -q are the same attitude) = sqrt(1 - sum of the squares of the others).
+ *          The others follow in order as (angle[i] & ~1) / 2 = component * ED_BB_QUAT_SCALE.
+ */
+typedef struct {
+    uint32_t tick;          // control tick since boot.
+    int16_t gyro[3];        // filtered angular velocity x, y, z, deg/s * ED_BB_GYRO_SCALE.
+    int16_t angle[3];       // pitch, roll, yaw, deg * ED_BB_ANGLE_SCALE, or the quaternion with ED_BB_FLAG_QUAT.
+    int16_t target[3];      // angular velocity targets of pitch, roll, yaw, deg/s * ED_BB_GYRO_SCALE.
+    uint16_t motor[4];      // thrust of M1~M4 * ED_BB_MOTOR_SCALE.
+    uint8_t loop;           // execution time of the tick, in ED_BB_LOOP_UNIT_US.
+    uint8_t flags;          // ED_BB_FLAG_*.
+} ed_bb_record_t;
+
+_Static_assert(sizeof(ed_bb_sector_header_t) == ED_BB_RECORD_SIZE, "the header must fill a slot");
+_Static_assert(sizeof(ed_bb_record_t) == ED_BB_RECORD_SIZE, "unexpected padding in ed_bb_record_t");
+
+#endif
@@ -0,0 +1,303 @@
+#include "ed_blackbox_log.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef M_SQRT1_2
+#define M_SQRT1_2                       (0.70710678118654752440)
+#endif
+
+static uint8_t __ed_bb_checksum(const ed_bb_sector_header_t* header)
+{
+    const uint8_t* bytes = (const uint8_t*)header;
+    uint8_t sum = 0;
+    for(int i = 0; i < (int)offsetof(ed_bb_sector_header_t, checksum); i++)
+        sum += bytes[i];
+    return sum;
+}
+
+static uint32_t __ed_bb_offset(uint32_t sector, uint32_t slot)
+{
+    return sector * ED_BB_SECTOR_SIZE + slot * ED_BB_RECORD_SIZE;
+}
+
+static int __ed_bb_erase(ed_bb_log_t* log, uint32_t sector)
+{
+    if(log->flash.erase(log->flash.ctx, __ed_bb_offset(sector, 0), ED_BB_SECTOR_SIZE))
+    {
+        log->errors ++;
+        return -1;
+    }
+    log->erases ++;
+    return 0;
+}
+
+// whether a sector is blank, e.g. erased ahead by the previous boot.
+static bool __ed_bb_is_erased(ed_bb_log_t* log, uint32_t sector)
+{
+    uint32_t words[64];
+    for(uint32_t offset = 0; offset < ED_BB_SECTOR_SIZE; offset += sizeof(words))
+    {
+        if(log->flash.read(log->flash.ctx, __ed_bb_offset(sector, 0) + offset, words, sizeof(words)))
+            return false;
+        for(int i = 0; i < 64; i++)
+        {
+            if(words[i] != 0xFFFFFFFF)
+                return false;
+        }
+    }
+    return true;
+}
+
+// erase(if no blank sector is left) and write the header of the next sector.
+// the sector is taken even if it fails, so that a bad sector is skipped at the next call.
+static int __ed_bb_start_sector(ed_bb_log_t* log)
+{
+    uint32_t sector = (log->_sector + 1) % log->_sectors;
+    bool erased = log->erased > 0;
+    log->_sector = sector;
+    log->_slot = ED_BB_SLOTS_PER_SECTOR;
+    if(erased)
+        log->erased --;
+    else if(__ed_bb_erase(log, sector))
+        return -1;
+
+    ed_bb_sector_header_t header;
+    memset(&header, 0xFF, sizeof(header));
+    header.magic = ED_BB_MAGIC;
+    header.sequence = log->_sequence;
+    header.session = log->session;
+    header.version = ED_BB_VERSION;
+    header.record_size = ED_BB_RECORD_SIZE;
+    header.sample_hz = log->sample_hz;
+    header.checksum = __ed_bb_checksum(&header);
+
+    log->_sequence ++;
+    if(log->flash.write(log->flash.ctx, __ed_bb_offset(sector, 0), &header, sizeof(header)))
+    {
+        log->errors ++;
+        return -1;
+    }
+    log->_slot = 1;
+    return 0;
+}
+
+/**
+ * @brief: Read the header of a sector.
+ * @return: true if the sector holds a valid header.
+ */
+bool ed_bb_read_header(const ed_bb_flash_t* flash, uint32_t sector, ed_bb_sector_header_t* header)
+{
+    if(flash->read(flash->ctx, __ed_bb_offset(sector, 0), header, sizeof(ed_bb_sector_header_t)))
+        return false;
+    return header->magic == ED_BB_MAGIC && header->version == ED_BB_VERSION
+        && header->record_size == ED_BB_RECORD_SIZE && header->checksum == __ed_bb_checksum(header);
+}
+
+/**
+ * @brief: Read the records of a sector with a valid header.
+ * @param:
+ *      - ed_bb_record_t* records : room for ED_BB_RECORDS_PER_SECTOR records.
+ * @return: number of records, -1 if the read failed.
+ */
+int ed_bb_read_records(const ed_bb_flash_t* flash, uint32_t sector, ed_bb_record_t* records)
+{
+    if(flash->read(flash->ctx, __ed_bb_offset(sector, 1), records, ED_BB_RECORDS_PER_SECTOR * ED_BB_RECORD_SIZE))
+        return -1;
+
+    int n = 0;
+    while(n < ED_BB_RECORDS_PER_SECTOR && records[n].tick != ED_BB_ERASED_TICK && !(records[n].flags & ED_BB_FLAG_PENDING))
+        n ++;
+    return n;
+}
+
+/**
+ * @brief: Scan the ring and start a new session after the newest sector.
+ * @return: 0 if success, -1 if the region is too small.
+ * @note: the blank sectors following the newest one, e.g. erased ahead by the previous boot, are counted in `erased`.
+ */
+int ed_bb_log_open(ed_bb_log_t* log)
+{
+    log->_sectors = log->flash.size / ED_BB_SECTOR_SIZE;
+    if(log->_sectors < 2)
+        return -1;
+
+    // the newest sector has the highest sequence, sequences are compared with wrap-around.
+    bool found = false;
+    uint32_t newest = 0;
+    ed_bb_sector_header_t header, newest_header = { 0 };
+    for(uint32_t sector = 0; sector < log->_sectors; sector++)
+    {
+        if(!ed_bb_read_header(&(log->flash), sector, &header))
+            continue;
+        if(!found || (int32_t)(header.sequence - newest_header.sequence) > 0)
+        {
+            newest = sector;
+            newest_header = header;
+            found = true;
+        }
+    }
+
+    log->session = found ? newest_header.session + 1 : 0;
+    log->records = 0;
+    log->erases = 0;
+    log->errors = 0;
+    log->_sequence = found ? newest_header.sequence + 1 : 0;
+    log->_sector = found ? newest : log->_sectors - 1;
+    log->_slot = ED_BB_SLOTS_PER_SECTOR;
+    log->erased = 0;
+    while(log->erased < log->_sectors - 1 && __ed_bb_is_erased(log, (log->_sector + 1 + log->erased) % log->_sectors))
+        log->erased ++;
+    return 0;
+}
+
+/**
+ * @brief: Append n records, starting new sectors as needed.
+ * @return: 0 if success, -1 if a flash operation failed(the records not written are dropped).
+ * @note: a new sector is erased only when no blank sector is left, append at most `ed_bb_log_room` records
+ *          where an erase is not allowed.
+ */
+int ed_bb_log_append(ed_bb_log_t* log, const ed_bb_record_t* records, uint32_t n)
+{
+    int ret = 0;
+    while(n > 0)
+    {
+        if(log->_slot >= ED_BB_SLOTS_PER_SECTOR && __ed_bb_start_sector(log))
+            return -1;
+
+        uint32_t count = ED_BB_SLOTS_PER_SECTOR - log->_slot;
+        if(count > n)
+            count = n;
+        if(log->flash.write(log->flash.ctx, __ed_bb_offset(log->_sector, log->_slot), records, count * ED_BB_RECORD_SIZE))
+        {
+            log->errors ++;
+            ret = -1;
+        } else {
+            log->records += count;
+        }
+        log->_slot += count;
+        records += count;
+        n -= count;
+    }
+    return ret;
+}
+
+/**
+ * @brief: Get the number of records that can be appended without an erase.
+ */
+uint32_t ed_bb_log_room(const ed_bb_log_t* log)
+{
+    uint32_t room = log->_slot < ED_BB_SLOTS_PER_SECTOR ? ED_BB_SLOTS_PER_SECTOR - log->_slot : 0;
+    return room + log->erased * ED_BB_RECORDS_PER_SECTOR;
+}
+
+/**
+ * @brief: Erase the sector after the blank run ahead, unless `sectors` sectors ahead are blank already.
+ * @param:
+ *      - uint32_t sectors : length of the blank run to reach, limited to all the other sectors of the ring.
+ * @return: 0 if success, -1 if the erase failed.
+ * @note: one sector is erased per call, so that the caller can stop between sectors. The run overwrites the
+ *          oldest sectors of the ring.
+ */
+int ed_bb_log_prepare(ed_bb_log_t* log, uint32_t sectors)
+{
+    if(sectors > log->_sectors - 1)
+        sectors = log->_sectors - 1;
+    if(log->erased >= sectors)
+        return 0;
+    if(__ed_bb_erase(log, (log->_sector + 1 + log->erased) % log->_sectors))
+        return -1;
+    log->erased ++;
+    return 0;
+}
+
+/**
+ * @brief: Erase the whole region and start a new session.
+ */
+int ed_bb_log_clear(ed_bb_log_t* log)
+{
+    int ret = 0;
+    for(uint32_t sector = 0; sector < log->_sectors; sector++)
+        ret |= __ed_bb_erase(log, sector);
+
+    log->session ++;
+    log->_sector = log->_sectors - 1;
+    log->_slot = ED_BB_SLOTS_PER_SECTOR;
+    log->erased = log->_sectors - 1;
+    return ret;
+}
+
+/**
+ * @brief: Convert value to the fixed point of scale, saturated to int16_t.
+ */
+int16_t ed_bb_fixed16(float value, float scale)
+{
+    float v = value * scale;
+    if(isnan(v))
+        return 0;
+    if(v < INT16_MIN)
+        return INT16_MIN;
+    if(v > INT16_MAX)
+        return INT16_MAX;
+    return (int16_t)(v + (v >= 0 ? 0.5f : -0.5f));
+}
+
+/**
+ * @brief: Convert value in [0, 1] to the fixed point of ED_BB_MOTOR_SCALE, saturated.
+ */
+uint16_t ed_bb_unorm16(float value)
+{
+    if(!(value > 0))
+        return 0;
+    if(value >= 1)
+        return ED_BB_MOTOR_SCALE;
+    return (uint16_t)(value * ED_BB_MOTOR_SCALE + 0.5f);
+}
+
+/**
+ * @brief: Pack a unit quaternion { w, x, y, z } into the angle field of a record with ED_BB_FLAG_QUAT.
+ */
+void ed_bb_quat_pack(const float q[4], int16_t packed[3])
+{
+    int largest = 0;
+    for(int i = 1; i < 4; i++)
+    {
+        if(fabsf(q[i]) > fabsf(q[largest]))
+            largest = i;
+    }
+    // the others are within 1/sqrt(2) of a unit quaternion, so they take 15 bits and leave one for the index.
+    float sign = q[largest] < 0 ? -1 : 1;
+    for(int i = 0, j = 0; i < 4; i++)
+    {
+        if(i == largest)
+            continue;
+        float component = sign * q[i];
+        if(component > (float)M_SQRT1_2)
+            component = (float)M_SQRT1_2;
+        else if(!(component >= -(float)M_SQRT1_2))
+            component = -(float)M_SQRT1_2;
+        packed[j] = (int16_t)(ed_bb_fixed16(component, ED_BB_QUAT_SCALE) * 2);
+        if(j < 2)
+            packed[j] |= (largest >> j) & 1;
+        j ++;
+    }
+}
+
+/**
+ * @brief: Unpack the angle field of a record with ED_BB_FLAG_QUAT into a unit quaternion { w, x, y, z }.
+ */
+void ed_bb_quat_unpack(const int16_t packed[3], float q[4])
+{
+    int largest = (packed[0] & 1) | (packed[1] & 1) << 1;
+    float sum = 0;
+    for(int i = 0, j = 0; i < 4; i++)
+    {
+        if(i == largest)
+            continue;
+        q[i] = (float)((packed[j] & ~1) / 2) / ED_BB_QUAT_SCALE;
+        sum += q[i] * q[i];
+        j ++;
+    }
+    q[largest] = sqrtf(fmaxf(1 - sum, 0));
+}
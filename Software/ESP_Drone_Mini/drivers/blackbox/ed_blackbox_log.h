@@ -0,0 +1,137 @@
+#ifndef __ED_BLACKBOX_LOG_H__
+#define __ED_BLACKBOX_LOG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ed_blackbox_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief: Access to the flash region of the blackbox, with NOR semantics: erase sets the bytes of whole
+ *          sectors to 0xFF, write only clears bits.
+ * @param:
+ *      int (*read)(ctx, offset, data, size)  : 0 if success.
+ *      int (*write)(ctx, offset, data, size) : 0 if success.
+ *      int (*erase)(ctx, offset, size)       : offset and size are multiples of ED_BB_SECTOR_SIZE, 0 if success.
+ *      uint32_t size                         : bytes of the region, a multiple of ED_BB_SECTOR_SIZE.
+ * @note: This layer has no platform dependencies, the firmware binds it to an esp_partition and the host
+ *          tools to an emulator or a dump.
+ */
+typedef struct {
+    int (*read)(void* ctx, uint32_t offset, void* data, uint32_t size);
+    int (*write)(void* ctx, uint32_t offset, const void* data, uint32_t size);
+    int (*erase)(void* ctx, uint32_t offset, uint32_t size);
+    void* ctx;
+    uint32_t size;
+} ed_bb_flash_t;
+
+/**
+ * @brief: Writer of the sector ring, see ed_blackbox_format.h.
+ * @param:
+ *      @configs:
+ *          ed_bb_flash_t flash     : the region, at least 2 sectors.
+ *          uint16_t sample_hz      : rate of the records, saved in the headers.
+ *      @status(read only):
+ *          uint32_t session        : session of this boot.
+ *          uint32_t records        : records written since `ed_bb_log_open`.
+ *          uint32_t erases         : sectors erased since `ed_bb_log_open`.
+ *          uint32_t errors         : failed flash operations.
+ *          uint32_t erased         : blank sectors ahead of the current one, used before anything is erased.
+ */
+typedef struct {
+    // configs
+    ed_bb_flash_t flash;
+    uint16_t sample_hz;
+
+    // status
+    uint32_t session;
+    uint32_t records;
+    uint32_t erases;
+    uint32_t errors;
+    uint32_t erased;
+
+    // private realizations.
+    uint32_t _sectors;
+    uint32_t _sector;
+    uint32_t _slot;
+    uint32_t _sequence;
+} ed_bb_log_t;
+
+/**
+ * @brief: Scan the ring and start a new session after the newest sector.
+ * @return: 0 if success, -1 if the region is too small.
+ * @note: the blank sectors following the newest one, e.g. erased ahead by the previous boot, are counted in `erased`.
+ */
+int ed_bb_log_open(ed_bb_log_t* log);
+
+/**
+ * @brief: Append n records, starting new sectors as needed.
+ * @return: 0 if success, -1 if a flash operation failed(the records not written are dropped).
+ * @note: a new sector is erased only when no blank sector is left, append at most `ed_bb_log_room` records
+ *          where an erase is not allowed.
+ */
+int ed_bb_log_append(ed_bb_log_t* log, const ed_bb_record_t* records, uint32_t n);
+
+/**
+ * @brief: Get the number of records that can be appended without an erase.
+ */
+uint32_t ed_bb_log_room(const ed_bb_log_t* log);
+
+/**
+ * @brief: Erase the sector after the blank run ahead, unless `sectors` sectors ahead are blank already.
+ * @param:
+ *      - uint32_t sectors : length of the blank run to reach, limited to all the other sectors of the ring.
+ * @return: 0 if success, -1 if the erase failed.
+ * @note: one sector is erased per call, so that the caller can stop between sectors. The run overwrites the
+ *          oldest sectors of the ring.
+ */
+int ed_bb_log_prepare(ed_bb_log_t* log, uint32_t sectors);
+
+/**
+ * @brief: Erase the whole region and start a new session.
+ */
+int ed_bb_log_clear(ed_bb_log_t* log);
+
+/**
+ * @brief: Read the header of a sector.
+ * @return: true if the sector holds a valid header.
+ */
+bool ed_bb_read_header(const ed_bb_flash_t* flash, uint32_t sector, ed_bb_sector_header_t* header);
+
+/**
+ * @brief: Read the records of a sector with a valid header.
+ * @param:
+ *      - ed_bb_record_t* records : room for ED_BB_RECORDS_PER_SECTOR records.
+ * @return: number of records, -1 if the read failed.
+ */
+int ed_bb_read_records(const ed_bb_flash_t* flash, uint32_t sector, ed_bb_record_t* records);
+
+/**
+ * @brief: Convert value to the fixed point of scale, saturated to int16_t.
+ */
+int16_t ed_bb_fixed16(float value, float scale);
+
+/**
+ * @brief: Convert value in [0, 1] to the fixed point of ED_BB_MOTOR_SCALE, saturated.
+ */
+uint16_t ed_bb_unorm16(float value);
+
+/**
+ * @brief: Pack a unit quaternion { w, x, y, z } into the angle field of a record with ED_BB_FLAG_QUAT.
+ */
+void ed_bb_quat_pack(const float q[4], int16_t packed[3]);
+
+/**
+ * @brief: Unpack the angle field of a record with ED_BB_FLAG_QUAT into a unit quaternion { w, x, y, z }.
+ */
+void ed_bb_quat_unpack(const int16_t packed[3], float q[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
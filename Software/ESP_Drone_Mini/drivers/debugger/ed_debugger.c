@@ -1,153 +1,482 @@
 #include "ed_debugger.h"
 
 #include <stdarg.h>
+#include <float.h>
 
 #include "esp_log.h"
+#include "esp_rom_sys.h"
 #include "lwip/sockets.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
+#include "ed_debugger_parser.h"
+#include "ed_debugger_protocol.h"
+#include "ed_param.h"
+#include "ed_profiler.h"
+#include "ed_sync.h"
+#include "ed_tlm_codec.h"
+
 static int socket_server = -1;
-static int socket_connect = -1;
 static const char* tag = "ed_debugger";
 
 uint8_t const tail[] = { 0x00, 0x00, 0x80, 0x7f };
 float const *__vofa_package_tail__ = (float*)tail;
 
-static bool connected = false;
-static int connected_flag_seq_lock = 0;
-
-#define ED_DEBUGGER_FLOAT_NUM       (32)
-#define ED_DEBUGGER_RX_BUFFER_SIZE  (65)
-static float* float_params[ED_DEBUGGER_FLOAT_NUM] = { NULL };
-
-// sender
-#define ED_DEBUGGER_TX_FLOAT_BUFFER_SIZE  (13)
+static ed_sync_flag_t connected = ED_SYNC_FLAG_INIT(false);
+
+static SemaphoreHandle_t socket_tx_mutex;
+
+// clients, each socket counts against CONFIG_LWIP_MAX_SOCKETS.
+#define ED_DEBUGGER_MAX_CLIENTS     (4)
+// responses of a client waiting for its socket, the requests are not read until they are sent.
+#define ED_DEBUGGER_REPLY_SIZE      (2 * ED_DBG_MAX_FRAME)
+typedef struct {
+    int sock;                       // -1 if the slot is free.
+    bool closing;                   // shut down as a slow consumer, the listener closes it.
+    uint32_t cursor;                // position of the next telemetry byte to send in tx_ring.
+    uint32_t reply_at;              // position in tx_ring where the pending responses are inserted.
+    uint16_t reply_len;             // bytes of the pending responses, 0 if none.
+    uint16_t reply_sent;            // bytes of the pending responses already sent.
+    uint8_t reply[ED_DEBUGGER_REPLY_SIZE];
+    ed_dbg_parser_t parser;
+} ed_debugger_client_t;
+static ed_debugger_client_t clients[ED_DEBUGGER_MAX_CLIENTS];
+
+// receive buffer of the listener, the parsers keep no bytes of it between two reads.
+#define ED_DEBUGGER_RX_BUFFER_SIZE  (1460)
+static uint8_t rx_buffer[ED_DEBUGGER_RX_BUFFER_SIZE];
+
+// telemetry ring shared by the clients, positions run freely and wrap at the ring size.
+// A byte is kept until the cursors of all the clients have passed it.
+#define ED_DEBUGGER_TX_RING_SIZE    (8192)
+static uint8_t tx_ring[ED_DEBUGGER_TX_RING_SIZE];
+static uint32_t tx_head = 0;
+
+// sender, the buffer holds the channels without the JustFloat tail.
+#define ED_DEBUGGER_TX_FLOAT_BUFFER_SIZE  (ED_TLM_MAX_CHANNELS)
 static float float_tx_buffer[ED_DEBUGGER_TX_FLOAT_BUFFER_SIZE] = { 0.0f };
 static int float_tx_buffer_nums = 0;
 static SemaphoreHandle_t float_tx_buffer_mutex;
+// compact telemetry, a key frame every second at 100 Hz.
+#define ED_DEBUGGER_TLM_KEY_INTERVAL      (100)
+static ed_sync_int_t tlm_mode = ED_SYNC_INT_INIT(ED_DEBUGGER_TLM_JUSTFLOAT);
+static ed_sync_flag_t tlm_key_request = ED_SYNC_FLAG_INIT(true);
+static ed_tlm_encoder_t tlm_encoder = { .key_interval = ED_DEBUGGER_TLM_KEY_INTERVAL };
 // Sender task handle
 static TaskHandle_t debugger_sender_task_handle = NULL;
 static const UBaseType_t debugger_sender_ready_index = 0;
 
 static void __ed_debugger_set_connected_flag(bool status)
 {
-    connected_flag_seq_lock ++;
-    connected = status;
-    connected_flag_seq_lock ++;
+    ed_sync_flag_set(&connected, status);
 }
 
 static bool __ed_debugger_get_connected_flag(void)
 {
-    // read debugger status with seq lock.
-    int connected_flag_seq_lock_old = 0;
-    bool debugger_connected_flag = false;
-
-    // waiting to enter the critical zone..
-    while(connected_flag_seq_lock %2);
-
-    do {
-        if(connected_flag_seq_lock_old != connected_flag_seq_lock)
-            connected_flag_seq_lock_old = connected_flag_seq_lock;
-        debugger_connected_flag = connected;
-    } while(connected_flag_seq_lock_old != connected_flag_seq_lock);
-    return debugger_connected_flag;
+    return ed_sync_flag_get(&connected);
 }
 
 /**
- * @note:
- *          Packet structure:
- *              ${int id in raw}=${float in raw}${tail = { 0x00, 0x00, 0x80, 0x78 }}
- *          Packet length = 13 byte.
- *          such as:
- *              0x01 0x00 0x00 0x00 `=` 0xC3 0xF5 0x48 0x40 0x00 0x00 0x80 0x78
- * @return: Quantity of remaining data(offset).
+ * @brief: Shut a client down, the listener closes the socket when it sees the end of the stream.
+ * @note: call it with socket_tx_mutex taken.
+ */
+static void __ed_debugger_drop_client(ed_debugger_client_t *client, const char *reason)
+{
+    if(client->closing)
+        return;
+    ESP_LOGW(tag, "client %d is closed: %s", (int)(client - clients), reason);
+    client->closing = true;
+    shutdown(client->sock, SHUT_RDWR);
+}
+
+/**
+ * @brief: Whether the client has telemetry or responses which are not sent yet.
+ * @note: call it with socket_tx_mutex taken.
  */
-static int __ed_match_float_param(uint8_t *data, int len)
+static bool __ed_debugger_client_pending(const ed_debugger_client_t *client)
 {
-    int id = 0;
-    if(len < 13)
-        return len; // skip
+    return !client->closing && (client->cursor != tx_head || client->reply_len);
+}
 
-    // try to find character '='
-    int offset = 4;
-    while(offset + 8 < len)
+/**
+ * @brief: Send what the socket accepts now of the telemetry and the responses the client has not received yet,
+ *          never blocks. The rest stays at the cursor of the client.
+ * @note: the responses are inserted at reply_at, a frame boundary of tx_ring, so the frames stay intact.
+ *          call it with socket_tx_mutex taken.
+ */
+static void __ed_debugger_flush_client(ed_debugger_client_t *client)
+{
+    while(__ed_debugger_client_pending(client))
     {
-        // 1. find the location of character '='
-        if(data[offset] != '=')
+        const uint8_t *data;
+        uint32_t size;
+        bool reply = client->reply_len && client->cursor == client->reply_at;
+        if(reply)
         {
-            offset ++;
-            continue;
+            data = client->reply + client->reply_sent;
+            size = client->reply_len - client->reply_sent;
+        } else {
+            uint32_t offset = client->cursor % ED_DEBUGGER_TX_RING_SIZE;
+            data = tx_ring + offset;
+            size = (client->reply_len ? client->reply_at : tx_head) - client->cursor;
+            if(size > ED_DEBUGGER_TX_RING_SIZE - offset)
+                size = ED_DEBUGGER_TX_RING_SIZE - offset;
         }
-        
-        // 2. try to match package tail(now offset points to characters '=').
-        if(memcmp(data + offset + 5, tail, 4))
+
+        int ret = send(client->sock, data, size, MSG_DONTWAIT);
+        if(ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if(ret <= 0)
         {
-            offset += 9;
-            continue;
+            __ed_debugger_drop_client(client, "send failed");
+            break;
+        }
+        if(!reply)
+        {
+            client->cursor += ret;
+        } else if((client->reply_sent += ret) == client->reply_len) {
+            client->reply_len = 0;
+            client->reply_sent = 0;
+        }
+    }
+}
+
+/**
+ * @brief: Append a whole frame of telemetry to tx_ring and send it to all the clients.
+ * @note: the clients share the bytes of the ring, a client which is so far behind that the frame would
+ *          overwrite its unsent bytes is closed instead of blocking the others.
+ */
+static void __ed_debugger_broadcast(const void *data, uint32_t size)
+{
+    if(size > ED_DEBUGGER_TX_RING_SIZE)
+        return;
+
+    xSemaphoreTake(socket_tx_mutex, portMAX_DELAY);
+    for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS; i++)
+    {
+        ed_debugger_client_t *client = &clients[i];
+        if(client->sock >= 0 && tx_head - client->cursor + size > ED_DEBUGGER_TX_RING_SIZE)
+            __ed_debugger_drop_client(client, "too slow");
+    }
+
+    uint32_t offset = tx_head % ED_DEBUGGER_TX_RING_SIZE;
+    uint32_t first = size < ED_DEBUGGER_TX_RING_SIZE - offset ? size : ED_DEBUGGER_TX_RING_SIZE - offset;
+    memcpy(tx_ring + offset, data, first);
+    memcpy(tx_ring, (const uint8_t *)data + first, size - first);
+    tx_head += size;
+
+    for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS; i++)
+    {
+        if(clients[i].sock >= 0)
+            __ed_debugger_flush_client(&clients[i]);
+    }
+    xSemaphoreGive(socket_tx_mutex);
+}
+
+/**
+ * @brief: Queue raw bytes to a client and send what its socket accepts now, never blocks.
+ * @return: 0 if queued, -1 if the client is closed.
+ * @note: Both the listener(responses) and the sender(telemetry) write to the socket, so the bytes are
+ *          queued after the telemetry frames already in tx_ring, and the listener sends the rest when the
+ *          socket is writable. A client whose responses overflow ED_DEBUGGER_REPLY_SIZE is closed.
+ */
+static int __ed_debugger_send_raw(ed_debugger_client_t *client, const void *data, size_t size)
+{
+    int ret = -1;
+    xSemaphoreTake(socket_tx_mutex, portMAX_DELAY);
+    if(!client->closing && client->reply_len + size > ED_DEBUGGER_REPLY_SIZE)
+    {
+        __ed_debugger_drop_client(client, "responses are not read");
+    } else if(!client->closing) {
+        if(client->reply_len == 0)
+            client->reply_at = tx_head;
+        memcpy(client->reply + client->reply_len, data, size);
+        client->reply_len += size;
+        __ed_debugger_flush_client(client);
+        ret = 0;
+    }
+    xSemaphoreGive(socket_tx_mutex);
+    return ret;
+}
+
+static uint8_t __ed_debugger_checksum(const uint8_t *data, int len)
+{
+    uint8_t sum = 0;
+    for(int i = 0; i < len; i++)
+        sum += data[i];
+    return sum;
+}
+
+/**
+ * @brief: Pack a frame, the payload must already be placed in frame + ED_DBG_HEADER_SIZE.
+ * @return: size of the frame.
+ */
+static int __ed_debugger_pack_frame(uint8_t *frame, uint8_t cmd, uint16_t len)
+{
+    frame[0] = ED_DBG_SYNC0;
+    frame[1] = ED_DBG_SYNC1;
+    frame[2] = cmd;
+    frame[3] = len & 0xff;
+    frame[4] = len >> 8;
+    frame[ED_DBG_HEADER_SIZE + len] = __ed_debugger_checksum(frame + 2, len + 3);
+    return len + ED_DBG_FRAME_OVERHEAD;
+}
+
+/**
+ * @brief: Pack and send a response frame to a client, the payload must already be placed in
+ *          frame + ED_DBG_HEADER_SIZE.
+ */
+static void __ed_debugger_send_frame(ed_debugger_client_t *client, uint8_t *frame, uint8_t cmd, uint16_t len)
+{
+    __ed_debugger_send_raw(client, frame, __ed_debugger_pack_frame(frame, cmd, len));
+}
+
+static void __ed_debugger_send_error(ed_debugger_client_t *client, uint8_t cmd, int8_t code)
+{
+    static uint8_t frame[ED_DBG_FRAME_OVERHEAD + 2];
+    frame[ED_DBG_HEADER_SIZE] = cmd;
+    frame[ED_DBG_HEADER_SIZE + 1] = (uint8_t)code;
+    __ed_debugger_send_frame(client, frame, ED_DBG_CMD_ERROR | ED_DBG_CMD_RESPONSE, 2);
+}
+
+/**
+ * @brief: Append a `id | status | value` item to the response payload.
+ */
+static int __ed_debugger_put_item(uint8_t *payload, int offset, uint16_t id, int8_t status)
+{
+    payload[offset] = id & 0xff;
+    payload[offset + 1] = id >> 8;
+    payload[offset + 2] = (uint8_t)status;
+    if(ed_param_read(id, payload + offset + 3))
+        memset(payload + offset + 3, 0x00, 4);
+    return offset + ED_DBG_RSP_ITEM_SIZE;
+}
+
+/**
+ * @brief: Execute a complete and verified frame.
+ */
+static void __ed_debugger_handle_frame(ed_debugger_client_t *client, uint8_t cmd, const uint8_t *payload, int len)
+{
+    static uint8_t tx_frame[ED_DBG_MAX_FRAME];
+    uint8_t *tx_payload = tx_frame + ED_DBG_HEADER_SIZE;
+    int tx_len = 0;
+
+    switch(cmd)
+    {
+    case ED_DBG_CMD_LIST:
+    {
+        if(len != 2)
+            goto bad_length;
+
+        int total = ed_param_count();
+        tx_payload[0] = total & 0xff;
+        tx_payload[1] = total >> 8;
+        tx_len = 2;
+
+        for(int id = payload[0] | (payload[1] << 8); id < total; id++)
+        {
+            const ed_param_t *param = ed_param_get(id);
+            if(param == NULL)
+                continue;
+
+            int name_len = param->name ? strlen(param->name) : 0;
+            if(tx_len + ED_DBG_LIST_ENTRY_FIXED_SIZE + name_len > ED_DBG_MAX_PAYLOAD)
+                break;
+
+            uint8_t *entry = tx_payload + tx_len;
+            entry[0] = id & 0xff;
+            entry[1] = id >> 8;
+            entry[2] = param->type;
+            memcpy(entry + 3, &param->min, 4);
+            memcpy(entry + 7, &param->max, 4);
+            ed_param_read(id, entry + 11);
+            entry[15] = name_len;
+            memcpy(entry + 16, param->name, name_len);
+            tx_len += ED_DBG_LIST_ENTRY_FIXED_SIZE + name_len;
         }
+        break;
+    }
+
+    case ED_DBG_CMD_GET:
+        if(len % ED_DBG_GET_REQ_ITEM_SIZE || len / ED_DBG_GET_REQ_ITEM_SIZE * ED_DBG_RSP_ITEM_SIZE > ED_DBG_MAX_PAYLOAD)
+            goto bad_length;
 
-        // 3. get and check id.
-        memcpy(&id, data + offset - 4, 4);
-        if(float_params[id] == NULL)
+        for(int offset = 0; offset < len; offset += ED_DBG_GET_REQ_ITEM_SIZE)
         {
-            ESP_LOGE(tag, "the id: %d is not bound to an element", id);
-            offset += 9;
-            continue;
+            uint16_t id = payload[offset] | (payload[offset + 1] << 8);
+            tx_len = __ed_debugger_put_item(tx_payload, tx_len, id, ed_param_get(id) ? ED_PARAM_OK : ED_PARAM_ERR_ID);
         }
+        break;
 
-        // 4. copy data to corresponding elements.
-        memcpy(float_params[id], data + offset + 1, 4);
+    case ED_DBG_CMD_SET:
+        if(len % ED_DBG_SET_REQ_ITEM_SIZE || len / ED_DBG_SET_REQ_ITEM_SIZE * ED_DBG_RSP_ITEM_SIZE > ED_DBG_MAX_PAYLOAD)
+            goto bad_length;
 
-        // 5. finish
-        // 5.1 check if there is a possibility of the next data packet in the subsequent data length.
-        if(len - offset - 1 - 8 >= 13)
+        ed_param_lock();
+        for(int offset = 0; offset < len; offset += ED_DBG_SET_REQ_ITEM_SIZE)
         {
-            // 5.1.1 move offset to the next possible position where the character '=' may appear.
-            offset += 13;
-            continue;
-        } else {
-            // 5.1.2 no more packets left, move offset to the position of the first unprocessed element.
-            //      note: offset may be equal to len.
-            offset += 9;
-            break;
+            uint16_t id = payload[offset] | (payload[offset + 1] << 8);
+            int8_t status = ed_param_write(id, payload + offset + 2);
+            tx_len = __ed_debugger_put_item(tx_payload, tx_len, id, status);
+        }
+        // the accepted values are kept and published with the next batch, the host sees them as busy.
+        int busy = ed_param_commit();
+        ed_param_unlock();
+        if(busy)
+        {
+            for(int offset = 0; offset < tx_len; offset += ED_DBG_RSP_ITEM_SIZE)
+            {
+                if((int8_t)tx_payload[offset + 2] == ED_PARAM_OK)
+                    tx_payload[offset + 2] = (uint8_t)ED_PARAM_ERR_BUSY;
+            }
         }
+        break;
+
+    case ED_DBG_CMD_PROFILE:
+    {
+        if(len != 2)
+            goto bad_length;
+
+        int index = payload[1];
+        uint16_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+        memcpy(tx_payload, &cycles_per_us, 2);
+        tx_payload[2] = ed_profiler_count();
+        tx_len = 3 + ed_profiler_serialize(tx_payload + 3, ED_DBG_MAX_PAYLOAD - 3, &index);
+
+        if(payload[0] & ED_DBG_PROFILE_FLAG_LOG)
+            ed_profiler_log();
+        if(payload[0] & ED_DBG_PROFILE_FLAG_RESET)
+            ed_profiler_reset();
+        break;
     }
 
-    // move remaining data to the head.
-#if(ED_DEBUGGER_RX_BUFFER_SIZE >= 24)
-    if(len - offset > 0)
-        memcpy(data, data + offset, len - offset);
-#else
-    if(len - offset > 0)
-        memmove(data, data + offset, len - offset);
-#endif
-    return len - offset;
+    default:
+        ESP_LOGW(tag, "unknown command: 0x%02x", cmd);
+        __ed_debugger_send_error(client, cmd, ED_DBG_ERR_UNKNOWN_CMD);
+        return;
+    }
+
+    __ed_debugger_send_frame(client, tx_frame, cmd | ED_DBG_CMD_RESPONSE, tx_len);
+    return;
+
+bad_length:
+    ESP_LOGW(tag, "command 0x%02x with bad payload length: %d", cmd, len);
+    __ed_debugger_send_error(client, cmd, ED_DBG_ERR_BAD_LENGTH);
 }
 
-static void __ed_debugger_receive(const int sock)
+static void __ed_debugger_on_frame(void *ctx, uint8_t cmd, const uint8_t *payload, int len)
 {
-    int len;
-    static uint8_t rx_buffer[ED_DEBUGGER_RX_BUFFER_SIZE] = { 0 };
-    static int offset = 0;
-    offset = 0;
-
-    do {
-        len = recv(sock, rx_buffer + offset, ED_DEBUGGER_RX_BUFFER_SIZE - offset, 0);
-        if (len < 0) {
-            ESP_LOGE(tag, "Error occurred during receiving: errno %d", errno);
-        } else if (len == 0) {
-            ESP_LOGW(tag, "Connection closed");
-        } else {
-            offset = __ed_match_float_param(rx_buffer, len + offset);
-        }
-    } while (len > 0);
+    __ed_debugger_handle_frame((ed_debugger_client_t *)ctx, cmd, payload, len);
+}
+
+/**
+ * @brief: Execute a legacy packet.
+ * @note:
+ *          Packet structure:
+ *              ${int id in raw}=${float in raw}${tail = { 0x00, 0x00, 0x80, 0x7f }}
+ *          Packet length = 13 byte.
+ *          such as:
+ *              0x01 0x00 0x00 0x00 `=` 0xC3 0xF5 0x48 0x40 0x00 0x00 0x80 0x7f
+ */
+static void __ed_debugger_on_legacy(void *ctx, int32_t id, const uint8_t value[4])
+{
+    (void)ctx;
+    if(ed_param_get(id) == NULL)
+    {
+        ESP_LOGE(tag, "the id: %ld is not bound to an element", (long)id);
+        return;
+    }
+    ed_param_lock();
+    if(ed_param_write(id, value))
+        ESP_LOGE(tag, "the value of id: %ld is rejected", (long)id);
+    else if(ed_param_commit())
+        ESP_LOGE(tag, "the value of id: %ld is not published", (long)id);
+    ed_param_unlock();
+}
+
+/**
+ * @brief: Receive from a client and execute the complete frames.
+ * @return: false if the connection is closed.
+ */
+static bool __ed_debugger_receive(ed_debugger_client_t *client)
+{
+    int len = recv(client->sock, rx_buffer, ED_DEBUGGER_RX_BUFFER_SIZE, 0);
+    if (len < 0) {
+        ESP_LOGE(tag, "Error occurred during receiving: errno %d", errno);
+        return false;
+    } else if (len == 0) {
+        ESP_LOGW(tag, "Connection closed");
+        return false;
+    }
+
+    uint32_t dropped = client->parser.dropped;
+    ed_dbg_parser_feed(&client->parser, rx_buffer, len);
+    if(client->parser.dropped != dropped)
+        ESP_LOGW(tag, "%lu bad frames dropped", (unsigned long)(client->parser.dropped - dropped));
+    return true;
+}
+
+static void __ed_debugger_accept(void)
+{
+    struct sockaddr_in6 source_addr; // Large enough for both IPv4 or IPv6
+    socklen_t addr_len = sizeof(source_addr);
+    int sock = accept(socket_server, (struct sockaddr *)&source_addr, &addr_len);
+    if (sock < 0) {
+        ESP_LOGE(tag, "Unable to accept connection: errno %d", errno);
+        return;
+    }
+
+    // Convert ip address to string
+    char addr_str[128] = { 0 };
+    inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr.s_addr, addr_str, sizeof(addr_str) - 1);
+
+    ed_debugger_client_t *client = NULL;
+    for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS && client == NULL; i++)
+    {
+        if(clients[i].sock < 0)
+            client = &clients[i];
+    }
+    if(client == NULL)
+    {
+        ESP_LOGW(tag, "Too many clients, %s is refused", addr_str);
+        close(sock);
+        return;
+    }
+
+    // the client starts at the next telemetry frame.
+    xSemaphoreTake(socket_tx_mutex, portMAX_DELAY);
+    client->parser.on_frame = __ed_debugger_on_frame;
+    client->parser.on_legacy = __ed_debugger_on_legacy;
+    client->parser.ctx = client;
+    ed_dbg_parser_reset(&client->parser);
+    client->closing = false;
+    client->cursor = tx_head;
+    client->reply_len = 0;
+    client->reply_sent = 0;
+    client->sock = sock;
+    xSemaphoreGive(socket_tx_mutex);
+
+    __ed_debugger_set_connected_flag(true);
+    // a new client needs a key frame to decode the compact telemetry.
+    ed_sync_flag_set(&tlm_key_request, true);
+    ESP_LOGI(tag, "Socket accepted ip address: %s, client %d", addr_str, (int)(client - clients));
+}
 
-    // clean buffer.
-    memset(rx_buffer, 0x00, 64);
-    offset = 0;
+static void __ed_debugger_close(ed_debugger_client_t *client)
+{
+    int sock = client->sock;
+    xSemaphoreTake(socket_tx_mutex, portMAX_DELAY);
+    client->sock = -1;
+    xSemaphoreGive(socket_tx_mutex);
+    shutdown(sock, 0);
+    close(sock);
+
+    bool connected = false;
+    for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS; i++)
+        connected |= clients[i].sock >= 0;
+    __ed_debugger_set_connected_flag(connected);
 }
 
 
@@ -181,38 +510,59 @@ static void __ed_debugger_server_listener_task(void *pvParameters)
     ESP_LOGI(tag, "Socket bound, port %d", port);
 
     // listen
-    err = listen(socket_server, 1);
+    err = listen(socket_server, ED_DEBUGGER_MAX_CLIENTS);
     if(err != 0) 
     {
         ESP_LOGE(tag, "Error occurred during listen: errno %d", errno);
-        close(socket_server);
+        goto clean_up;
     }
+    ESP_LOGI(tag, "Socket listening");
 
+    // serve the new connections, the requests of all the clients and the data their sockets did not accept.
     for( ; ; )
     {
-        ESP_LOGI(tag, "Socket listening");
-
-        struct sockaddr_in6 source_addr; // Large enough for both IPv4 or IPv6
-        long unsigned int addr_len = sizeof(source_addr);
-        socket_connect = accept(socket_server, (struct sockaddr *)&source_addr, &addr_len);
-        if (socket_connect < 0) {
-            ESP_LOGE(tag, "Unable to accept connection: errno %d", errno);
-            __ed_debugger_set_connected_flag(false);
-            break;
+        fd_set read_fds, write_fds;
+        FD_ZERO(&read_fds);
+        FD_ZERO(&write_fds);
+        FD_SET(socket_server, &read_fds);
+        int max_fd = socket_server;
+        xSemaphoreTake(socket_tx_mutex, portMAX_DELAY);
+        for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS; i++)
+        {
+            if(clients[i].sock < 0)
+                continue;
+            // the requests of a client wait until its responses are sent, a closing client is read to its end.
+            if(clients[i].reply_len == 0 || clients[i].closing)
+                FD_SET(clients[i].sock, &read_fds);
+            if(__ed_debugger_client_pending(&clients[i]))
+                FD_SET(clients[i].sock, &write_fds);
+            if(clients[i].sock > max_fd)
+                max_fd = clients[i].sock;
         }
-        __ed_debugger_set_connected_flag(true);
-
-        // Convert ip address to string
-        char addr_str[128] = { 0 };
-        inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr.s_addr, addr_str, sizeof(addr_str) - 1);
-        ESP_LOGI(tag, "Socket accepted ip address: %s", addr_str);
+        xSemaphoreGive(socket_tx_mutex);
 
-        __ed_debugger_receive(socket_connect);
+        if(select(max_fd + 1, &read_fds, &write_fds, NULL, NULL) < 0)
+        {
+            ESP_LOGE(tag, "Error occurred during select: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
 
-        // disconnect
-        __ed_debugger_set_connected_flag(false);
-        shutdown(socket_connect, 0);
-        close(socket_connect);
+        for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS; i++)
+        {
+            if(clients[i].sock < 0 || !FD_ISSET(clients[i].sock, &write_fds))
+                continue;
+            xSemaphoreTake(socket_tx_mutex, portMAX_DELAY);
+            __ed_debugger_flush_client(&clients[i]);
+            xSemaphoreGive(socket_tx_mutex);
+        }
+        for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS; i++)
+        {
+            if(clients[i].sock >= 0 && FD_ISSET(clients[i].sock, &read_fds) && !__ed_debugger_receive(&clients[i]))
+                __ed_debugger_close(&clients[i]);
+        }
+        if(FD_ISSET(socket_server, &read_fds))
+            __ed_debugger_accept();
     }
 
 clean_up:
@@ -221,13 +571,36 @@ clean_up:
 }
 
 
+/**
+ * @brief: Send a frame of telemetry in the current mode.
+ */
+static void __ed_debugger_send_telemetry(float *buffer, int nums)
+{
+    if(ed_sync_int_get(&tlm_mode) == ED_DEBUGGER_TLM_COMPACT)
+    {
+        static uint8_t frame[ED_DBG_FRAME_OVERHEAD + ED_TLM_MAX_PAYLOAD];
+        if(ed_sync_flag_get(&tlm_key_request))
+        {
+            ed_sync_flag_set(&tlm_key_request, false);
+            ed_tlm_encoder_reset(&tlm_encoder);
+        }
+        int len = ed_tlm_encode(&tlm_encoder, buffer, nums, frame + ED_DBG_HEADER_SIZE);
+        if(len > 0)
+            __ed_debugger_broadcast(frame, __ed_debugger_pack_frame(frame, ED_DBG_CMD_TELEMETRY, len));
+    } else {
+        memcpy(buffer + nums, tail, sizeof(tail));
+        __ed_debugger_broadcast(buffer, sizeof(float) * (nums + 1));
+    }
+}
+
 static void __ed_debugger_server_sender_task(void *pvParameters)
 {
     while(1)
     {
         if(__ed_debugger_get_connected_flag())
         {
-            static float buffer[ED_DEBUGGER_TX_FLOAT_BUFFER_SIZE] = { 0.0f };
+            // one more float for the JustFloat tail.
+            static float buffer[ED_DEBUGGER_TX_FLOAT_BUFFER_SIZE + 1] = { 0.0f };
             int nums = 0;
             
             xSemaphoreTake(float_tx_buffer_mutex, portMAX_DELAY);
@@ -237,12 +610,7 @@ static void __ed_debugger_server_sender_task(void *pvParameters)
             xSemaphoreGive(float_tx_buffer_mutex);
 
             if(nums)
-            {
-                size_t size = sizeof(float) * nums;
-                int ret = send(socket_connect, buffer, size, 0);
-                if(ret != size)
-                    ESP_LOGW(tag, "%d bytes should be sent, but %d bytes were actually sent.", size, ret);
-            }
+                __ed_debugger_send_telemetry(buffer, nums);
                 
         } else {
             //ESP_LOGD(tag, "debugger not connected");
@@ -256,19 +624,28 @@ static void __ed_debugger_server_sender_task(void *pvParameters)
 
 /**
  * @brief: Create a debugger, this debugger will be implemented based on TCP
- * @param: The port of the tcp server.
+ * @note: up to 4 clients are served at once, they share the telemetry and get the responses of their own requests.
+ * @param:
+ *      - int port                          : The port of the tcp server.
+ *      - const ed_task_config_t* listener  : placement of the task receiving parameters.
+ *      - const ed_task_config_t* sender    : placement of the task sending telemetry.
  */
-int ed_debugger_create(int port)
+int ed_debugger_create(int port, const ed_task_config_t* listener, const ed_task_config_t* sender)
 {
     float_tx_buffer_mutex = xSemaphoreCreateMutex();
-    xTaskCreate(__ed_debugger_server_listener_task, "debugger_server_listener", 4096, (void*)port, 5, NULL);
-    xTaskCreate(__ed_debugger_server_sender_task, "debugger_server_sender", 4096, NULL, 5, &debugger_sender_task_handle);
+    socket_tx_mutex = xSemaphoreCreateMutex();
+    for(int i = 0; i < ED_DEBUGGER_MAX_CLIENTS; i++)
+        clients[i].sock = -1;
+    if(ed_task_create(__ed_debugger_server_listener_task, "debugger_server_listener", (void*)port, listener, NULL))
+        return -1;
+    if(ed_task_create(__ed_debugger_server_sender_task, "debugger_server_sender", NULL, sender, &debugger_sender_task_handle))
+        return -2;
 
     return 0;
 }
 
 
-static void __ed_debugger_write_to_float_buffer(int nums, float *data)
+static void __ed_debugger_write_to_float_buffer(int nums, const float *data)
 {
     // write to float_tx_buffer
     xSemaphoreTake(float_tx_buffer_mutex, portMAX_DELAY);
@@ -298,22 +675,60 @@ void ed_debugger_send_vofa(int nums, ...)
 			data[index] = va_arg(args, double);
 		}
 
-		__ed_debugger_write_to_float_buffer(nums, data);
-        
-        // Send notify to sender
-        xTaskNotifyGiveIndexed(debugger_sender_task_handle, debugger_sender_ready_index);
+		// the sender appends the tail in the JustFloat mode.
+		if(!memcmp(&data[nums - 1], tail, sizeof(tail)))
+			nums --;
+		ed_debugger_send_floats(nums, data);
 	}
 
 	va_end(args);
 }
 
+/**
+ * @brief: Send nums floating-point numbers, in the current telemetry mode.
+ * @note: nums is at most ED_TLM_MAX_CHANNELS.
+ */
+void ed_debugger_send_floats(int nums, const float* values)
+{
+    if(nums <= 0 || nums > ED_DEBUGGER_TX_FLOAT_BUFFER_SIZE)
+        return;
+
+    __ed_debugger_write_to_float_buffer(nums, values);
+
+    // Send notify to sender
+    xTaskNotifyGiveIndexed(debugger_sender_task_handle, debugger_sender_ready_index);
+}
+
+/**
+ * @brief: Select the encoding of the telemetry, the compact mode starts with a key frame.
+ */
+void ed_debugger_set_tlm_mode(ed_debugger_tlm_mode_t mode)
+{
+    if(ed_sync_int_get(&tlm_mode) == mode)
+        return;
+    ed_sync_flag_set(&tlm_key_request, true);
+    ed_sync_int_set(&tlm_mode, mode);
+}
+
+/**
+ * @brief: Set the quantization steps of the channels in the compact mode, see ed_tlm_codec.h.
+ * @note: call it before the telemetry starts.
+ */
+void ed_debugger_set_tlm_steps(int nums, const float* steps)
+{
+    for(int i = 0; i < nums && i < ED_TLM_MAX_CHANNELS; i++)
+        tlm_encoder.steps[i] = steps[i];
+    ed_sync_flag_set(&tlm_key_request, true);
+}
+
 /**
  * @brief: bind float type to id.
  * @note: the id should be as small as possible
+ *          the parameter is registered unnamed and unbounded, use `ed_param_register` for new code.
  */
 void ed_debugger_bind_float(int id, float* f)
 {
     assert(id >= 0);
-    assert(id < ED_DEBUGGER_FLOAT_NUM - 1);
-    float_params[id] = f;
+    assert(id < ED_PARAM_MAX_NUM);
+    ed_param_bind(id, NULL, ED_PARAM_FLOAT, f, -FLT_MAX, FLT_MAX);
 }
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "ed_task.h"
+
 #ifndef COUNT_ARGS
 #define COUNT_ARGS(X...) __COUNT_ARGS(, ##X, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
 #define __COUNT_ARGS(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _n, X...) _n
@@ -10,12 +12,27 @@
 
 extern const float *__vofa_package_tail__;
 
+/**
+ * @brief: Encoding of the telemetry.
+ *      ED_DEBUGGER_TLM_JUSTFLOAT : raw floats with the JustFloat tail, for "VOFA+".
+ *      ED_DEBUGGER_TLM_COMPACT   : ED_DBG_CMD_TELEMETRY frames of ed_tlm_codec.h, tools/telemetry/ed_tlm_decode
+ *                                  converts them back to JustFloat.
+ */
+typedef enum {
+    ED_DEBUGGER_TLM_JUSTFLOAT = 0,
+    ED_DEBUGGER_TLM_COMPACT,
+} ed_debugger_tlm_mode_t;
+
 
 /**
  * @brief: Create a debugger, this debugger will be implemented based on TCP
- * @param: The port of the tcp server.
+ * @note: up to 4 clients are served at once, they share the telemetry and get the responses of their own requests.
+ * @param:
+ *      - int port                          : The port of the tcp server.
+ *      - const ed_task_config_t* listener  : placement of the task receiving parameters.
+ *      - const ed_task_config_t* sender    : placement of the task sending telemetry.
  */
-int ed_debugger_create(int port);
+int ed_debugger_create(int port, const ed_task_config_t* listener, const ed_task_config_t* sender);
 
 /**
  * @brief: Send several floating-point numbers to the "VOFA+" software.
@@ -27,9 +44,27 @@ void ed_debugger_send_vofa(int nums, ...);
 #define ed_debugger_send_float(...) ed_debugger_send_vofa(COUNT_ARGS(X ##__VA_ARGS__) + 1, ##__VA_ARGS__, *__vofa_package_tail__)
 
 
+/**
+ * @brief: Send nums floating-point numbers, in the current telemetry mode.
+ * @note: nums is at most ED_TLM_MAX_CHANNELS.
+ */
+void ed_debugger_send_floats(int nums, const float* values);
+
+/**
+ * @brief: Select the encoding of the telemetry, the compact mode starts with a key frame.
+ */
+void ed_debugger_set_tlm_mode(ed_debugger_tlm_mode_t mode);
+
+/**
+ * @brief: Set the quantization steps of the channels in the compact mode, see ed_tlm_codec.h.
+ * @note: call it before the telemetry starts.
+ */
+void ed_debugger_set_tlm_steps(int nums, const float* steps);
+
 /**
  * @brief: bind float type to id.
  * @note: the id should be as small as possible.
+ *          the parameter is registered unnamed and unbounded, use `ed_param_register` for new code.
  */
 void ed_debugger_bind_float(int id, float* f);
 
@@ -0,0 +1,272 @@
+#include "ed_debugger_parser.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+enum {
+    __ED_DBG_PARSER_IDLE = 0,
+    __ED_DBG_PARSER_SYNC1,
+    __ED_DBG_PARSER_CMD,
+    __ED_DBG_PARSER_LEN_L,
+    __ED_DBG_PARSER_LEN_H,
+    __ED_DBG_PARSER_PAYLOAD,
+    __ED_DBG_PARSER_CHECKSUM,
+};
+
+// last byte of the JustFloat tail, which ends the legacy packet.
+#define __ED_DBG_PARSER_TAIL_END        (0x7f)
+#define __ED_DBG_PARSER_WINDOW_SIZE     (ED_DBG_LEGACY_PACKET_SIZE - 1)
+
+/**
+ * @brief: Forget a partial frame, e.g. for a new connection.
+ * @note: the configs and the status are kept.
+ */
+void ed_dbg_parser_reset(ed_dbg_parser_t* parser)
+{
+    parser->_state = __ED_DBG_PARSER_IDLE;
+    parser->_clear_at = parser->_position;
+}
+
+/**
+ * @brief: Get the byte k bytes before data[i], from the window if it was fed before.
+ */
+static inline uint8_t __ed_dbg_parser_back(const ed_dbg_parser_t* parser, const uint8_t* data, size_t i, size_t k)
+{
+    return i >= k ? data[i - k] : parser->_window[__ED_DBG_PARSER_WINDOW_SIZE - (k - i)];
+}
+
+/**
+ * @brief: Check if a legacy packet `${int id}=${float}${JustFloat tail}` ends at data[i], which is 0x7f.
+ * @note: a frame which started before the packet keeps its bytes.
+ */
+static bool __ed_dbg_parser_is_legacy(const ed_dbg_parser_t* parser, const uint8_t* data, size_t i)
+{
+    uint32_t position = parser->_position + i;
+    if(position + 1 - parser->_clear_at < ED_DBG_LEGACY_PACKET_SIZE)
+        return false;
+    if(parser->_state != __ED_DBG_PARSER_IDLE && position - parser->_sync_at >= ED_DBG_LEGACY_PACKET_SIZE)
+        return false;
+
+    // the tail is 0x00 0x00 0x80 0x7f, '=' is the 5th byte of the packet.
+    if(i >= 8)
+        return data[i - 1] == 0x80 && data[i - 2] == 0x00 && data[i - 3] == 0x00 && data[i - 8] == '=';
+    return __ed_dbg_parser_back(parser, data, i, 1) == 0x80
+        && __ed_dbg_parser_back(parser, data, i, 2) == 0x00
+        && __ed_dbg_parser_back(parser, data, i, 3) == 0x00
+        && __ed_dbg_parser_back(parser, data, i, 8) == '=';
+}
+
+static void __ed_dbg_parser_report_legacy(ed_dbg_parser_t* parser, const uint8_t* data, size_t i)
+{
+    uint8_t gathered[ED_DBG_LEGACY_PACKET_SIZE];
+    const uint8_t* packet = data + i + 1 - ED_DBG_LEGACY_PACKET_SIZE;
+    if(i + 1 < ED_DBG_LEGACY_PACKET_SIZE)
+    {
+        for(int j = 0; j < ED_DBG_LEGACY_PACKET_SIZE; j++)
+            gathered[j] = __ed_dbg_parser_back(parser, data, i, ED_DBG_LEGACY_PACKET_SIZE - 1 - j);
+        packet = gathered;
+    }
+
+    int32_t id;
+    memcpy(&id, packet, 4);
+    parser->_state = __ED_DBG_PARSER_IDLE;
+    parser->_clear_at = parser->_position + i + 1;
+    parser->legacy ++;
+    if(parser->on_legacy)
+        parser->on_legacy(parser->ctx, id, packet + 5);
+}
+
+/**
+ * @brief: Take the command and the length of a frame.
+ */
+static void __ed_dbg_parser_header(ed_dbg_parser_t* parser, uint8_t cmd, uint16_t len)
+{
+    parser->_cmd = cmd;
+    parser->_len = len;
+    parser->_sum = cmd + (len & 0xff) + (len >> 8);
+    parser->_received = 0;
+    if(len > ED_DBG_MAX_PAYLOAD)
+    {
+        parser->dropped ++;
+        parser->_state = __ED_DBG_PARSER_IDLE;
+    } else {
+        parser->_state = len ? __ED_DBG_PARSER_PAYLOAD : __ED_DBG_PARSER_CHECKSUM;
+    }
+}
+
+/**
+ * @brief: Verify and report a frame.
+ * @param:
+ *      - uint32_t end : stream position after the checksum, the bytes of a frame never belong to a legacy packet.
+ */
+static void __ed_dbg_parser_end_frame(ed_dbg_parser_t* parser, const uint8_t* payload, uint8_t checksum, uint32_t end)
+{
+    parser->_state = __ED_DBG_PARSER_IDLE;
+    parser->_clear_at = end;
+    if(checksum != parser->_sum)
+    {
+        parser->dropped ++;
+        return;
+    }
+    parser->frames ++;
+    if(parser->on_frame)
+        parser->on_frame(parser->ctx, parser->_cmd, payload, parser->_len);
+}
+
+/**
+ * @brief: Finish a frame whose payload and checksum are all in data from data[i].
+ * @return: bytes consumed.
+ */
+static size_t __ed_dbg_parser_in_place(ed_dbg_parser_t* parser, const uint8_t* data, size_t i)
+{
+    size_t size = parser->_len + 1;
+
+    // 1. the first bytes may still end a legacy packet.
+    uint32_t since_sync = parser->_position + i - parser->_sync_at;
+    size_t checked = since_sync < ED_DBG_LEGACY_PACKET_SIZE ? ED_DBG_LEGACY_PACKET_SIZE - since_sync : 0;
+    if(checked > size)
+        checked = size;
+    for(size_t j = 0; j < checked; j++)
+    {
+        if(data[i + j] == __ED_DBG_PARSER_TAIL_END && __ed_dbg_parser_is_legacy(parser, data, i + j))
+        {
+            __ed_dbg_parser_report_legacy(parser, data, i + j);
+            return j + 1;
+        }
+    }
+
+    // 2. verify and report without copying.
+    uint8_t sum = parser->_sum;
+    for(size_t j = 0; j < parser->_len; j++)
+        sum += data[i + j];
+    parser->_sum = sum;
+    __ed_dbg_parser_end_frame(parser, data + i, data[i + parser->_len], parser->_position + i + size);
+    return size;
+}
+
+/**
+ * @brief: Feed received bytes, the complete frames and legacy packets are reported before it returns.
+ */
+void ed_dbg_parser_feed(ed_dbg_parser_t* parser, const uint8_t* data, size_t len)
+{
+    size_t i = 0;
+    while(i < len)
+    {
+        // 1. between frames only the sync byte and the end of a tail matter.
+        if(parser->_state == __ED_DBG_PARSER_IDLE)
+        {
+            while(i < len && data[i] != ED_DBG_SYNC0 && data[i] != __ED_DBG_PARSER_TAIL_END)
+                i++;
+            if(i == len)
+                break;
+
+            if(data[i] == __ED_DBG_PARSER_TAIL_END)
+            {
+                if(__ed_dbg_parser_is_legacy(parser, data, i))
+                    __ed_dbg_parser_report_legacy(parser, data, i);
+                i++;
+                continue;
+            }
+
+            // a header complete in data is taken at once, unless a legacy packet may end in it.
+            parser->_sync_at = parser->_position + i;
+            if(len - i >= ED_DBG_HEADER_SIZE && data[i + 1] == ED_DBG_SYNC1 && data[i + 2] != __ED_DBG_PARSER_TAIL_END
+                && data[i + 3] != __ED_DBG_PARSER_TAIL_END && data[i + 4] != __ED_DBG_PARSER_TAIL_END)
+            {
+                __ed_dbg_parser_header(parser, data[i + 2], data[i + 3] | (data[i + 4] << 8));
+                i += ED_DBG_HEADER_SIZE;
+                if(parser->_state == __ED_DBG_PARSER_PAYLOAD && len - i > parser->_len)
+                    i += __ed_dbg_parser_in_place(parser, data, i);
+            } else {
+                parser->_state = __ED_DBG_PARSER_SYNC1;
+                i++;
+            }
+            continue;
+        }
+
+        // 2. payloads at once.
+        if(parser->_state == __ED_DBG_PARSER_PAYLOAD)
+        {
+            if(parser->_received == 0 && len - i > parser->_len)
+            {
+                i += __ed_dbg_parser_in_place(parser, data, i);
+                continue;
+            }
+            if(parser->_position + i - parser->_sync_at >= ED_DBG_LEGACY_PACKET_SIZE)
+            {
+                size_t n = parser->_len - parser->_received;
+                if(n > len - i)
+                    n = len - i;
+                uint8_t sum = parser->_sum;
+                for(size_t j = 0; j < n; j++)
+                    sum += data[i + j];
+                parser->_sum = sum;
+                memcpy(parser->_payload + parser->_received, data + i, n);
+                parser->_received += n;
+                i += n;
+                if(parser->_received == parser->_len)
+                    parser->_state = __ED_DBG_PARSER_CHECKSUM;
+                continue;
+            }
+        }
+
+        // 3. one byte of a frame split between two feeds.
+        uint8_t byte = data[i];
+        if(byte == __ED_DBG_PARSER_TAIL_END && __ed_dbg_parser_is_legacy(parser, data, i))
+        {
+            __ed_dbg_parser_report_legacy(parser, data, i++);
+            continue;
+        }
+
+        switch(parser->_state)
+        {
+        case __ED_DBG_PARSER_SYNC1:
+            if(byte == ED_DBG_SYNC1)
+                parser->_state = __ED_DBG_PARSER_CMD;
+            else if(byte == ED_DBG_SYNC0)
+                parser->_sync_at = parser->_position + i;
+            else
+                parser->_state = __ED_DBG_PARSER_IDLE;
+            break;
+
+        case __ED_DBG_PARSER_CMD:
+            parser->_cmd = byte;
+            parser->_state = __ED_DBG_PARSER_LEN_L;
+            break;
+
+        case __ED_DBG_PARSER_LEN_L:
+            parser->_len = byte;
+            parser->_state = __ED_DBG_PARSER_LEN_H;
+            break;
+
+        case __ED_DBG_PARSER_LEN_H:
+            __ed_dbg_parser_header(parser, parser->_cmd, parser->_len | (byte << 8));
+            break;
+
+        case __ED_DBG_PARSER_PAYLOAD:
+            parser->_payload[parser->_received++] = byte;
+            parser->_sum += byte;
+            if(parser->_received == parser->_len)
+                parser->_state = __ED_DBG_PARSER_CHECKSUM;
+            break;
+
+        case __ED_DBG_PARSER_CHECKSUM:
+            __ed_dbg_parser_end_frame(parser, parser->_payload, byte, parser->_position + i + 1);
+            break;
+        }
+        i++;
+    }
+
+    // keep the last bytes for a legacy packet which ends in the next feed.
+    if(len >= __ED_DBG_PARSER_WINDOW_SIZE)
+    {
+        memcpy(parser->_window, data + len - __ED_DBG_PARSER_WINDOW_SIZE, __ED_DBG_PARSER_WINDOW_SIZE);
+    } else {
+        memmove(parser->_window, parser->_window + len, __ED_DBG_PARSER_WINDOW_SIZE - len);
+        memcpy(parser->_window + __ED_DBG_PARSER_WINDOW_SIZE - len, data, len);
+    }
+    parser->_position += len;
+    // the distances are in 32 bits, a long stream without a frame must not wrap them.
+    if(parser->_position - parser->_clear_at > (1u << 30))
+        parser->_clear_at = parser->_position - ED_DBG_LEGACY_PACKET_SIZE;
+}
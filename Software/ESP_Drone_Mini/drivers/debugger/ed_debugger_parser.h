@@ -0,0 +1,78 @@
+#ifndef __ED_DEBUGGER_PARSER_H__
+#define __ED_DEBUGGER_PARSER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ed_debugger_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @note: Streaming parser of the requests of ed_debugger_protocol.h.
+ *          This layer has no platform dependencies and is shared with the host tools.
+ *
+ *          The bytes go through a state machine, so a read of any size can be fed and nothing is moved
+ *          back to the front of a buffer. Headers and payloads complete in the fed data are taken at once
+ *          and such a frame is reported in place, only a frame split between two reads is assembled in the
+ *          parser. The legacy packet has no sync bytes, it is recognized at the last byte of its tail(0x7f),
+ *          from the fed data or the last 12 bytes of the previous feeds, and wins over a frame which
+ *          started inside of it.
+ *          A frame with a bad checksum or a length above ED_DBG_MAX_PAYLOAD is dropped, and the parser
+ *          looks for the next sync bytes after it.
+ */
+
+/**
+ * @brief: Request parser of a client.
+ * @param:
+ *      @configs:
+ *          on_frame  : called for every frame with a valid checksum, payload is valid during the call only.
+ *          on_legacy : called for every legacy packet, with the raw id and value.
+ *          ctx       : first argument of the callbacks.
+ *      @status(read only):
+ *          uint32_t frames  : frames reported.
+ *          uint32_t legacy  : legacy packets reported.
+ *          uint32_t dropped : frames dropped for a bad checksum or length.
+ */
+typedef struct {
+    // configs
+    void (*on_frame)(void* ctx, uint8_t cmd, const uint8_t* payload, int len);
+    void (*on_legacy)(void* ctx, int32_t id, const uint8_t value[4]);
+    void* ctx;
+
+    // status
+    uint32_t frames;
+    uint32_t legacy;
+    uint32_t dropped;
+
+    // private realizations.
+    uint8_t _state;
+    uint8_t _cmd;
+    uint8_t _sum;
+    uint16_t _len;
+    uint16_t _received;
+    uint32_t _position;             // stream position of the first byte of the current feed.
+    uint32_t _sync_at;              // stream position of the current frame.
+    uint32_t _clear_at;             // the bytes before are not part of a legacy packet.
+    uint8_t _window[ED_DBG_LEGACY_PACKET_SIZE - 1];
+    uint8_t _payload[ED_DBG_MAX_PAYLOAD];
+} ed_dbg_parser_t;
+
+/**
+ * @brief: Forget a partial frame, e.g. for a new connection.
+ * @note: the configs and the status are kept.
+ */
+void ed_dbg_parser_reset(ed_dbg_parser_t* parser);
+
+/**
+ * @brief: Feed received bytes, the complete frames and legacy packets are reported before it returns.
+ */
+void ed_dbg_parser_feed(ed_dbg_parser_t* parser, const uint8_t* data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef __ED_DEBUGGER_PROTOCOL_H__
+#define __ED_DEBUGGER_PROTOCOL_H__
+
+/**
+ * @note: Binary parameter protocol of ed_debugger.
+ *          This header has no platform dependencies and is shared with the host tools.
+ *
+ *          Frame structure(all multi-byte fields are little-endian):
+ *              | 0xED | 0x5A | cmd (1) | len (2) | payload (len) | checksum (1) |
+ *          checksum is the 8-bit sum of cmd, len and payload bytes.
+ *          Responses use the command of the request with ED_DBG_CMD_RESPONSE set.
+ *
+ *          ED_DBG_CMD_LIST:
+ *              request:  start id (u16)
+ *              response: total ids (u16), then entries until the frame is full:
+ *                        id (u16) | type (u8) | min (f32) | max (f32) | value (4) | name_len (u8) | name
+ *              The host repeats the request from (last id + 1) until all ids are covered.
+ *          ED_DBG_CMD_GET:
+ *              request:  n * id (u16)
+ *              response: n * | id (u16) | status (s8) | value (4) |
+ *          ED_DBG_CMD_SET:
+ *              request:  n * | id (u16) | value (4) |
+ *              response: same as ED_DBG_CMD_GET, value is read back after the write.
+ *                        status is an ed_param_err_t, ED_PARAM_ERR_BUSY means the value is accepted but
+ *                        not published to the control loop yet, it is published with the next SET.
+ *          ED_DBG_CMD_PROFILE:
+ *              request:  flags (u8, ED_DBG_PROFILE_FLAG_*) | start probe index (u8)
+ *              response: cycles per us (u16) | total probes (u8), then entries until the frame is full:
+ *                        index (u8) | name_len (u8) | name | count (u32) | min (u32) | max (u32) | sum (u64) |
+ *                        nbins (u8) | nbins * | bin (u8) | count (u32) |
+ *              All times are in CPU cycles. Histogram bin b covers cycles in
+ *              [(4 + b % 4) << (b / 4 - 2), (5 + b % 4) << (b / 4 - 2)) for b >= 8.
+ *          ED_DBG_CMD_TELEMETRY(sent by the drone only, without request):
+ *              payload:  a frame of ed_tlm_codec.h, sent instead of JustFloat in the compact telemetry mode.
+ *          ED_DBG_CMD_ERROR(response only):
+ *              payload:  request cmd (u8) | error code (s8)
+ *
+ *          The legacy 13 bytes packet `${int id}=${float}${JustFloat tail}` is still accepted
+ *          and is equivalent to a single item ED_DBG_CMD_SET without response.
+ */
+
+#define ED_DBG_SYNC0                    (0xED)
+#define ED_DBG_SYNC1                    (0x5A)
+#define ED_DBG_HEADER_SIZE              (5)
+#define ED_DBG_FRAME_OVERHEAD           (ED_DBG_HEADER_SIZE + 1)
+#define ED_DBG_MAX_PAYLOAD              (1024)
+#define ED_DBG_MAX_FRAME                (ED_DBG_MAX_PAYLOAD + ED_DBG_FRAME_OVERHEAD)
+
+#define ED_DBG_CMD_LIST                 (0x01)
+#define ED_DBG_CMD_GET                  (0x02)
+#define ED_DBG_CMD_SET                  (0x03)
+#define ED_DBG_CMD_PROFILE              (0x10)
+#define ED_DBG_CMD_TELEMETRY            (0x20)
+#define ED_DBG_CMD_ERROR                (0x7F)
+#define ED_DBG_CMD_RESPONSE             (0x80)
+
+#define ED_DBG_GET_REQ_ITEM_SIZE        (2)
+#define ED_DBG_SET_REQ_ITEM_SIZE        (6)
+#define ED_DBG_RSP_ITEM_SIZE            (7)
+#define ED_DBG_LIST_ENTRY_FIXED_SIZE    (16)
+
+#define ED_DBG_PROFILE_FLAG_RESET       (0x01)
+#define ED_DBG_PROFILE_FLAG_LOG         (0x02)
+
+#define ED_DBG_ERR_UNKNOWN_CMD          (-1)
+#define ED_DBG_ERR_BAD_LENGTH           (-2)
+
+#define ED_DBG_LEGACY_PACKET_SIZE       (13)
+
+#endif
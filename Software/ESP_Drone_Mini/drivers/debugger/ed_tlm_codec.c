@@ -0,0 +1,177 @@
+#include "ed_tlm_codec.h"
+
+#include <math.h>
+#include <string.h>
+
+static int32_t __ed_tlm_quantize(float value, float step)
+{
+    if(!isfinite(value))
+        return 0;
+
+    float q = roundf(value / step);
+    if(q >= 2147483647.0f)
+        return INT32_MAX;
+    if(q <= -2147483647.0f)
+        return -INT32_MAX;
+    return (int32_t)q;
+}
+
+static int __ed_tlm_put_varint(uint8_t* data, int64_t value)
+{
+    // zigzag, small magnitudes of both signs get short codes.
+    uint64_t u = value < 0 ? ((uint64_t)(-(value + 1)) << 1) | 1 : (uint64_t)value << 1;
+    int len = 0;
+    while(u >= 0x80)
+    {
+        data[len++] = (uint8_t)(u | 0x80);
+        u >>= 7;
+    }
+    data[len++] = (uint8_t)u;
+    return len;
+}
+
+static int __ed_tlm_get_varint(const uint8_t* data, int len, int64_t* value)
+{
+    uint64_t u = 0;
+    for(int i = 0; i < len && i < ED_TLM_MAX_VARINT_SIZE; i++)
+    {
+        u |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+        if(!(data[i] & 0x80))
+        {
+            *value = (u & 1) ? -(int64_t)(u >> 1) - 1 : (int64_t)(u >> 1);
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+static float __ed_tlm_step(const ed_tlm_encoder_t* encoder, int channel)
+{
+    return encoder->steps[channel] > 0 ? encoder->steps[channel] : ED_TLM_DEFAULT_STEP;
+}
+
+/**
+ * @brief: Force a key frame, e.g. for a new client.
+ */
+void ed_tlm_encoder_reset(ed_tlm_encoder_t* encoder)
+{
+    encoder->_started = false;
+}
+
+/**
+ * @brief: Encode a frame of n channels.
+ * @param:
+ *      - uint8_t* payload  : room for ED_TLM_MAX_PAYLOAD bytes.
+ * @return: length of the payload, -1 if n is out of [1, ED_TLM_MAX_CHANNELS].
+ * @note: a change of the number of channels starts a key frame.
+ */
+int ed_tlm_encode(ed_tlm_encoder_t* encoder, const float* values, int n, uint8_t* payload)
+{
+    if(n < 1 || n > ED_TLM_MAX_CHANNELS)
+        return -1;
+
+    bool key = !encoder->_started || encoder->_channels != n
+        || (encoder->key_interval && encoder->_since_key >= encoder->key_interval);
+
+    payload[0] = key ? ED_TLM_FLAG_KEY : 0;
+    payload[1] = encoder->_sequence++;
+    payload[2] = n;
+    int len = ED_TLM_HEADER_SIZE;
+
+    if(key)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            float step = __ed_tlm_step(encoder, i);
+            memcpy(payload + len, &step, 4);
+            len += 4;
+        }
+        encoder->_channels = n;
+        encoder->_since_key = 0;
+        encoder->_started = true;
+    }
+
+    for(int i = 0; i < n; i++)
+    {
+        int32_t q = __ed_tlm_quantize(values[i], __ed_tlm_step(encoder, i));
+        len += __ed_tlm_put_varint(payload + len, key ? q : (int64_t)q - encoder->_last[i]);
+        encoder->_last[i] = q;
+    }
+    encoder->_since_key ++;
+    return len;
+}
+
+void ed_tlm_decoder_reset(ed_tlm_decoder_t* decoder)
+{
+    memset(decoder, 0x00, sizeof(ed_tlm_decoder_t));
+}
+
+/**
+ * @brief: Decode a frame.
+ * @param:
+ *      - float* values : room for ED_TLM_MAX_CHANNELS values.
+ * @return: number of channels, 0 if the frame is skipped while waiting for a key frame, -1 if it is malformed.
+ */
+int ed_tlm_decode(ed_tlm_decoder_t* decoder, const uint8_t* payload, int len, float* values)
+{
+    if(len < ED_TLM_HEADER_SIZE || payload[2] < 1 || payload[2] > ED_TLM_MAX_CHANNELS)
+        return -1;
+
+    uint8_t flags = payload[0], sequence = payload[1];
+    int n = payload[2];
+    bool key = flags & ED_TLM_FLAG_KEY;
+    if(!key && (!decoder->_synced || sequence != (uint8_t)(decoder->_sequence + 1) || n != decoder->_channels))
+    {
+        decoder->_synced = false;
+        decoder->skipped ++;
+        return 0;
+    }
+
+    int offset = ED_TLM_HEADER_SIZE;
+    float steps[ED_TLM_MAX_CHANNELS];
+    int32_t q[ED_TLM_MAX_CHANNELS];
+    if(key)
+    {
+        if(len < offset + 4 * n)
+            goto malformed;
+        memcpy(steps, payload + offset, 4 * n);
+        offset += 4 * n;
+    }
+
+    for(int i = 0; i < n; i++)
+    {
+        int64_t value;
+        int size = __ed_tlm_get_varint(payload + offset, len - offset, &value);
+        if(size < 0)
+            goto malformed;
+        offset += size;
+
+        if(!key)
+            value += decoder->_last[i];
+        if(value > INT32_MAX || value < -INT32_MAX)
+            goto malformed;
+        q[i] = (int32_t)value;
+    }
+    if(offset != len)
+        goto malformed;
+
+    // commit only a well-formed frame.
+    if(key)
+    {
+        memcpy(decoder->steps, steps, 4 * n);
+        decoder->_channels = n;
+        decoder->_synced = true;
+    }
+    for(int i = 0; i < n; i++)
+    {
+        decoder->_last[i] = q[i];
+        values[i] = (float)((double)q[i] * decoder->steps[i]);
+    }
+    decoder->_sequence = sequence;
+    decoder->frames ++;
+    return n;
+
+malformed:
+    decoder->_synced = false;
+    return -1;
+}
@@ -0,0 +1,104 @@
+#ifndef __ED_TLM_CODEC_H__
+#define __ED_TLM_CODEC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @note: Compact telemetry codec, the payload of ED_DBG_CMD_TELEMETRY.
+ *          This layer has no platform dependencies and is shared with the host tools.
+ *
+ *          Each channel is quantized to q = round(value / step), and sent as the difference to the
+ *          q of the previous frame, zigzag mapped and varint coded(7 bits per byte, LSB first).
+ *          A channel which moves less than 64 steps per frame costs 1 byte instead of 4.
+ *          Payload structure(all multi-byte fields are little-endian):
+ *              | flags (u8) | sequence (u8) | channels (u8) | [channels * step (f32)] | channels * varint |
+ *          Key frames(ED_TLM_FLAG_KEY) carry the steps and the q themselves instead of differences, so
+ *          a decoder can join at any key frame. sequence increases by one per frame, a gap means the
+ *          decoder has to wait for the next key frame.
+ *          Non-finite values are sent as 0 and q saturates at +-2^31, the quantization error of
+ *          the other values is at most step / 2 and does not accumulate.
+ */
+
+#define ED_TLM_MAX_CHANNELS             (32)
+#define ED_TLM_HEADER_SIZE              (3)
+#define ED_TLM_MAX_VARINT_SIZE          (5)
+#define ED_TLM_MAX_PAYLOAD              (ED_TLM_HEADER_SIZE + ED_TLM_MAX_CHANNELS * (4 + ED_TLM_MAX_VARINT_SIZE))
+#define ED_TLM_DEFAULT_STEP             (0.001f)
+
+#define ED_TLM_FLAG_KEY                 (0x01)
+
+/**
+ * @brief: Encoder of a telemetry stream.
+ * @param:
+ *      @configs:
+ *          float steps[]         : quantization step of each channel, ED_TLM_DEFAULT_STEP if not positive.
+ *          uint16_t key_interval : frames between key frames, 0 for only the first one.
+ */
+typedef struct {
+    // configs
+    float steps[ED_TLM_MAX_CHANNELS];
+    uint16_t key_interval;
+
+    // private realizations.
+    int32_t _last[ED_TLM_MAX_CHANNELS];
+    uint8_t _channels;
+    uint8_t _sequence;
+    uint16_t _since_key;
+    bool _started;
+} ed_tlm_encoder_t;
+
+/**
+ * @brief: Decoder of a telemetry stream.
+ * @param:
+ *      @status(read only):
+ *          float steps[]     : steps of the stream, from the last key frame.
+ *          uint32_t frames   : frames decoded.
+ *          uint32_t skipped  : frames skipped while waiting for a key frame.
+ */
+typedef struct {
+    // status
+    float steps[ED_TLM_MAX_CHANNELS];
+    uint32_t frames;
+    uint32_t skipped;
+
+    // private realizations.
+    int32_t _last[ED_TLM_MAX_CHANNELS];
+    uint8_t _channels;
+    uint8_t _sequence;
+    bool _synced;
+} ed_tlm_decoder_t;
+
+/**
+ * @brief: Force a key frame, e.g. for a new client.
+ */
+void ed_tlm_encoder_reset(ed_tlm_encoder_t* encoder);
+
+/**
+ * @brief: Encode a frame of n channels.
+ * @param:
+ *      - uint8_t* payload  : room for ED_TLM_MAX_PAYLOAD bytes.
+ * @return: length of the payload, -1 if n is out of [1, ED_TLM_MAX_CHANNELS].
+ * @note: a change of the number of channels starts a key frame.
+ */
+int ed_tlm_encode(ed_tlm_encoder_t* encoder, const float* values, int n, uint8_t* payload);
+
+void ed_tlm_decoder_reset(ed_tlm_decoder_t* decoder);
+
+/**
+ * @brief: Decode a frame.
+ * @param:
+ *      - float* values : room for ED_TLM_MAX_CHANNELS values.
+ * @return: number of channels, 0 if the frame is skipped while waiting for a key frame, -1 if it is malformed.
+ */
+int ed_tlm_decode(ed_tlm_decoder_t* decoder, const uint8_t* payload, int len, float* values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -67,7 +67,7 @@ int ed_drivers_init(ed_drivers_config_t *config)
     
 
     // init debugger.
-    ed_debugger_create(config->tcp_port);
+    ed_debugger_create(config->tcp_port, &(config->debugger_listener_task), &(config->debugger_sender_task));
     return 0;
 
 motor_failed:
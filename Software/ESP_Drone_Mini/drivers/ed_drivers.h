@@ -5,6 +5,7 @@
 #include "driver/i2c.h"
 
 #include "ed_motor.h"
+#include "ed_task.h"
 
 typedef struct {
     /** wifi configs **/
@@ -29,6 +30,15 @@ typedef struct {
 
     /** debugger configs **/
     uint16_t tcp_port;
+
+    /** task configs **/
+    // NOTE: the control pipeline should own a core, Wi-Fi, lwIP and telemetry run on the other.
+    ed_task_config_t control_task;
+    ed_task_config_t telemetry_task;
+    ed_task_config_t analysis_task;
+    ed_task_config_t debugger_listener_task;
+    ed_task_config_t debugger_sender_task;
+    ed_task_config_t cache_stress_task;
 } ed_drivers_config_t;
 
 
@@ -0,0 +1,20 @@
+#include "ed_task.h"
+
+#include "esp_log.h"
+
+static const char* tag = "ed_task";
+
+/**
+ * @brief: Create a task with the placement of config.
+ * @return: 0 if success.
+ */
+int ed_task_create(TaskFunction_t func, const char* name, void* param, const ed_task_config_t* config, TaskHandle_t* handle)
+{
+    if(xTaskCreatePinnedToCore(func, name, config->stack_size, param, config->priority, handle, config->core) != pdPASS)
+    {
+        ESP_LOGE(tag, "create task %s failed.", name);
+        return -1;
+    }
+    ESP_LOGI(tag, "task %s created on core %d with priority %d.", name, (int)config->core, (int)config->priority);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef __ED_TASK_H__
+#define __ED_TASK_H__
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * @brief: Placement of a task.
+ * @param:
+ *      BaseType_t core        : 0, 1 or tskNO_AFFINITY.
+ *      UBaseType_t priority   : FreeRTOS priority, larger is higher.
+ *      uint32_t stack_size    : stack depth in bytes.
+ */
+typedef struct {
+    BaseType_t core;
+    UBaseType_t priority;
+    uint32_t stack_size;
+} ed_task_config_t;
+
+/**
+ * @brief: Create a task with the placement of config.
+ * @return: 0 if success.
+ */
+int ed_task_create(TaskFunction_t func, const char* name, void* param, const ed_task_config_t* config, TaskHandle_t* handle);
+
+#endif
@@ -63,6 +63,16 @@ int ed_imu_get_eular(float *pitch, float *roll, float *yaw)
     return ret;
 }
 
+int ed_imu_get_quat(float *q0, float *q1, float *q2, float *q3)
+{
+    int ret = 0;
+#if(IMU_SELECT == IMU_MPU6050)
+    if((ret = mpu_simp_get_quat(q0, q1, q2, q3)))
+        ESP_LOGE(tag, "mpu6050 get quat failed with ret: %d.", ret);
+#endif
+    return ret;
+}
+
 int ed_imu_get_gyro(float *gx, float *gy, float *gz)
 {
     int ret = 0;
@@ -14,6 +14,9 @@ int ed_imu_int_enable(gpio_num_t int_io, gpio_isr_t int_handler);
 
 int ed_imu_get_eular(float *pitch, float *roll, float *yaw);
 
+// body to world quaternion, q0 is the scalar part.
+int ed_imu_get_quat(float *q0, float *q1, float *q2, float *q3);
+
 // degree per sec
 int ed_imu_get_gyro(float *gx, float *gy, float *gz);
 
@@ -2945,9 +2945,8 @@ mpu_err_t mpu_simp_init(i2c_port_t i2c_port, uint16_t frequency)
 	return MPU_OK;
 }
 
-mpu_err_t mpu_simp_get_eular(float *pitch, float *roll, float *yaw)
+mpu_err_t mpu_simp_get_quat(float *q0, float *q1, float *q2, float *q3)
 {
-	float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
 	unsigned long sensor_timestamp;
 	short gyro[3], accel[3], sensors;
 	unsigned char more;
@@ -2956,27 +2955,32 @@ mpu_err_t mpu_simp_get_eular(float *pitch, float *roll, float *yaw)
 	/* Gyro and accel data are written to the FIFO by the DMP in chip frame and hardware units.
 	 * This behavior is convenient because it keeps the gyro and accel outputs of dmp_read_fifo and mpu_read_fifo consistent.
 	**/
-	/*if (sensors & INV_XYZ_GYRO )
-	send_packet(PACKET_TYPE_GYRO, gyro);
-	if (sensors & INV_XYZ_ACCEL)
-	send_packet(PACKET_TYPE_ACCEL, accel); */
 	/* Unlike gyro and accel, quaternions are written to the FIFO in the body frame, q30.
 	 * The orientation is set by the scalar passed to dmp_set_orientation during initialization. 
 	**/
 	if(sensors&INV_WXYZ_QUAT) 
 	{
-		q0 = quat[0] / q30;
-		q1 = quat[1] / q30;
-		q2 = quat[2] / q30;
-		q3 = quat[3] / q30; 
-		// quaternion solving
-		*pitch = asin(-2 * q1 * q3 + 2 * q0* q2)* 57.3;	                                // pitch
-		*roll  = atan2(2 * q2 * q3 + 2 * q0 * q1, -2 * q1 * q1 - 2 * q2* q2 + 1)* 57.3;	// roll
-		*yaw   = atan2(2*(q1*q2 + q0*q3),q0*q0+q1*q1-q2*q2-q3*q3) * 57.3;	            //yaw
+		*q0 = quat[0] / q30;
+		*q1 = quat[1] / q30;
+		*q2 = quat[2] / q30;
+		*q3 = quat[3] / q30; 
 	}else return MPU_AccessTooFast;
 	return MPU_OK;
 }
 
+mpu_err_t mpu_simp_get_eular(float *pitch, float *roll, float *yaw)
+{
+	float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
+	mpu_err_t ret = mpu_simp_get_quat(&q0, &q1, &q2, &q3);
+	if(ret) return ret;
+
+	// quaternion solving
+	*pitch = asin(-2 * q1 * q3 + 2 * q0* q2)* 57.3;	                                // pitch
+	*roll  = atan2(2 * q2 * q3 + 2 * q0 * q1, -2 * q1 * q1 - 2 * q2* q2 + 1)* 57.3;	// roll
+	*yaw   = atan2(2*(q1*q2 + q0*q3),q0*q0+q1*q1-q2*q2-q3*q3) * 57.3;	            //yaw
+	return MPU_OK;
+}
+
 mpu_err_t mpu_simp_get_gyro(float *gx, float *gy, float *gz)
 {
     float sens = 0;
@@ -164,6 +164,8 @@ typedef enum
 
 mpu_err_t mpu_simp_init(i2c_port_t i2c_port, uint16_t frequency);
 
+mpu_err_t mpu_simp_get_quat(float *q0, float *q1, float *q2, float *q3);
+
 mpu_err_t mpu_simp_get_eular(float *pitch, float *roll, float *yaw);
 
 mpu_err_t mpu_simp_get_gyro(float *gx, float *gy, float *gz);
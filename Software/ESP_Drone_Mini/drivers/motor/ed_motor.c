@@ -7,6 +7,15 @@
 
 static const char* tag = "ed_motor";
 
+static float __ed_motor_rps_to_duty(ed_motor_t* motor, float rps)
+{
+    if(rps < motor->min_rps)
+        return 0;
+
+    float duty_cycle = exp((rps - motor->c) / motor->k);
+    return duty_cycle > 100 ? 100 : duty_cycle;
+}
+
 /**
  * @brief: initialize the motor and its peripherals.
  * @param: handle of the motor
@@ -41,6 +50,16 @@ int ed_motor_init(ed_motor_t* motor)
         tag,
         "execute ledc_channel_config failed, ret: %s,", esp_err_to_name(ret)
     );
+
+    // thrust to duty table, thrust = (rps / max_rps)^2.
+    ESP_RETURN_ON_FALSE(motor->max_rps > 0, -3, tag, "invalid max_rps: %f", motor->max_rps);
+    for(int i = 0; i < ED_MOTOR_THRUST_LUT_SIZE; i++)
+    {
+        float thrust = (float)i / (ED_MOTOR_THRUST_LUT_SIZE - 1);
+        motor->_thrust_lut[i] = __ed_motor_rps_to_duty(motor, motor->max_rps * sqrtf(thrust));
+    }
+    if(__ed_motor_rps_to_duty(motor, motor->max_rps) >= 100)
+        ESP_LOGW(tag, "max_rps %f can not be reached by the motor on gpio %d.", motor->max_rps, motor->gpio_num);
     return 0;
 }
 
@@ -84,11 +103,33 @@ int ed_motor_set_duty(ed_motor_t* motor, float duty)
  */
 int ed_motor_set_rps(ed_motor_t* motor, float rps)
 {
-    if(rps < motor->min_rps)
+    return ed_motor_set_duty(motor, __ed_motor_rps_to_duty(motor, rps));
+}
+
+
+/**
+ * @brief: set the normalized thrust of the motor.
+ * @param:
+ *      - ed_motor_t* motor : handle of the motor
+ *      - float thrust      : range: [0, 1]
+ * @return: 0 if success.
+ * @note: the duty is interpolated in a table built by `ed_motor_init` from the calibration.
+ */
+int ed_motor_set_thrust(ed_motor_t* motor, float thrust)
+{
+    if(!(thrust > 0))
         return ed_motor_set_duty(motor, 0);
+    if(thrust > 1)
+        thrust = 1;
 
-    float duty_cycle = exp((rps - motor->c) / motor->k);
-    return ed_motor_set_duty(motor, duty_cycle);
+    float pos = thrust * (ED_MOTOR_THRUST_LUT_SIZE - 1);
+    int index = (int)pos;
+    if(index >= ED_MOTOR_THRUST_LUT_SIZE - 1)
+        return ed_motor_set_duty(motor, motor->_thrust_lut[ED_MOTOR_THRUST_LUT_SIZE - 1]);
+
+    float frac = pos - index;
+    float duty = motor->_thrust_lut[index] + (motor->_thrust_lut[index + 1] - motor->_thrust_lut[index]) * frac;
+    return ed_motor_set_duty(motor, duty);
 }
 
 
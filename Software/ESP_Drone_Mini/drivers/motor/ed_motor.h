@@ -3,6 +3,9 @@
 
 #include "driver/ledc.h"
 
+// entries of the thrust to duty table, thrust is sampled uniformly in [0, 1].
+#define ED_MOTOR_THRUST_LUT_SIZE        (33)
+
 typedef struct {
     // peripherals
     int gpio_num;
@@ -15,6 +18,11 @@ typedef struct {
     float k;
     float c;
     float min_rps;
+    // rps of the full thrust, thrust = (rps / max_rps)^2. It must be reachable by all motors of a frame.
+    float max_rps;
+
+    // private realizations.
+    float _thrust_lut[ED_MOTOR_THRUST_LUT_SIZE];
 } ed_motor_t;
 
 
@@ -46,6 +54,17 @@ int ed_motor_set_duty(ed_motor_t* motor, float duty);
 int ed_motor_set_rps(ed_motor_t* motor, float rps);
 
 
+/**
+ * @brief: set the normalized thrust of the motor.
+ * @param:
+ *      - ed_motor_t* motor : handle of the motor
+ *      - float thrust      : range: [0, 1]
+ * @return: 0 if success.
+ * @note: the duty is interpolated in a table built by `ed_motor_init` from the calibration.
+ */
+int ed_motor_set_thrust(ed_motor_t* motor, float thrust);
+
+
 /**
  * @brief: release and reset the peripherals of motor.
  * @param: ed_motor_t* motor : handle of the motor
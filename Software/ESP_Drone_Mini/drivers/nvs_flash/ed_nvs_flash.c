@@ -1,8 +1,13 @@
 #include "ed_nvs_flash.h"
 
 #include "esp_err.h"
+#include "esp_log.h"
+#include "nvs.h"
 #include "nvs_flash.h"
 
+static const char* tag = "ed_nvs_flash";
+static const char* ed_namespace = "esp_drone";
+
 int ed_nvs_flash_init(void)
 {
     esp_err_t err = nvs_flash_init();
@@ -15,3 +20,51 @@ int ed_nvs_flash_init(void)
     return 0;
 }
 
+/**
+ * @brief: Save a blob under key in the namespace of the drone.
+ * @return: 0 if success.
+ */
+int ed_nvs_flash_save_blob(const char* key, const void* data, size_t size)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ed_namespace, NVS_READWRITE, &handle);
+    if(err != ESP_OK)
+    {
+        ESP_LOGE(tag, "nvs_open failed: %s", esp_err_to_name(err));
+        return -1;
+    }
+
+    err = nvs_set_blob(handle, key, data, size);
+    if(err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+
+    if(err != ESP_OK)
+    {
+        ESP_LOGE(tag, "saving %s failed: %s", key, esp_err_to_name(err));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief: Load the blob of key into data.
+ * @return: 0 if success, -1 if not found or its size is not size(e.g. saved by another firmware).
+ */
+int ed_nvs_flash_load_blob(const char* key, void* data, size_t size)
+{
+    nvs_handle_t handle;
+    if(nvs_open(ed_namespace, NVS_READONLY, &handle) != ESP_OK)
+        return -1;
+
+    // check the size first, a blob of another layout is ignored.
+    size_t stored = 0;
+    esp_err_t err = nvs_get_blob(handle, key, NULL, &stored);
+    if(err == ESP_OK && stored == size)
+        err = nvs_get_blob(handle, key, data, &stored);
+    else if(err == ESP_OK)
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    nvs_close(handle);
+
+    return err == ESP_OK ? 0 : -1;
+}
@@ -1,6 +1,20 @@
 #ifndef __ED_NVS_FLASH_H__
 #define __ED_NVS_FLASH_H__
 
+#include <stddef.h>
+
 int ed_nvs_flash_init(void);
 
+/**
+ * @brief: Save a blob under key in the namespace of the drone.
+ * @return: 0 if success.
+ */
+int ed_nvs_flash_save_blob(const char* key, const void* data, size_t size);
+
+/**
+ * @brief: Load the blob of key into data.
+ * @return: 0 if success, -1 if not found or its size is not size(e.g. saved by another firmware).
+ */
+int ed_nvs_flash_load_blob(const char* key, void* data, size_t size);
+
 #endif
@@ -0,0 +1,225 @@
+#include "ed_param.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "ed_sync.h"
+
+static const char* tag = "ed_param";
+
+static ed_param_t params[ED_PARAM_MAX_NUM] = { 0 };
+// published with release semantics after the entry is filled, so readers never see a partial entry.
+static ed_sync_int_t params_nums = ED_SYNC_INT_INIT(0);
+
+static int (*commit_callback)(void* arg) = NULL;
+static void* commit_callback_arg = NULL;
+
+// held by the writers of registered variables around a batch and its commit, created by the first binding.
+static StaticSemaphore_t lock_buffer;
+static SemaphoreHandle_t lock = NULL;
+
+/**
+ * @brief: Register a parameter at a fixed id.
+ * @return: id of the parameter if success, or a negative ed_param_err_t.
+ * @note: used by the legacy `ed_debugger_bind_float` interface.
+ */
+int ed_param_bind(int id, const char* name, ed_param_type_t type, void* ptr, float min, float max)
+{
+    if(id < 0 || id >= ED_PARAM_MAX_NUM)
+    {
+        ESP_LOGE(tag, "id: %d out of range", id);
+        return ED_PARAM_ERR_ID;
+    }
+
+    if(ptr == NULL || min > max || (name && strlen(name) > ED_PARAM_MAX_NAME_LEN))
+        return ED_PARAM_ERR_ARG;
+
+    if(lock == NULL)
+        lock = xSemaphoreCreateMutexStatic(&lock_buffer);
+
+    params[id].name = name;
+    params[id].type = type;
+    params[id].min = min;
+    params[id].max = max;
+    params[id].ptr = ptr;
+
+    if(id >= ed_sync_int_get(&params_nums))
+        ed_sync_int_set(&params_nums, id + 1);
+    return id;
+}
+
+/**
+ * @brief: Register a parameter at the next free id.
+ * @return: id of the parameter if success, or a negative ed_param_err_t.
+ * @note: the name is not copied, it must remain valid forever (string literals are fine).
+ */
+int ed_param_register(const char* name, ed_param_type_t type, void* ptr, float min, float max)
+{
+    int nums = ed_sync_int_get(&params_nums);
+    if(nums >= ED_PARAM_MAX_NUM)
+    {
+        ESP_LOGE(tag, "registry is full, %s is not registered", name ? name : "(null)");
+        return ED_PARAM_ERR_FULL;
+    }
+
+    if(name && ed_param_find(name) >= 0)
+    {
+        ESP_LOGE(tag, "%s is already registered", name);
+        return ED_PARAM_ERR_ARG;
+    }
+
+    return ed_param_bind(nums, name, type, ptr, min, max);
+}
+
+/**
+ * @brief: Get the number of ids in use(the highest registered id + 1).
+ */
+int ed_param_count(void)
+{
+    return ed_sync_int_get(&params_nums);
+}
+
+/**
+ * @brief: Get the descriptor of id.
+ * @return: NULL if the id is not bound to a parameter.
+ */
+const ed_param_t* ed_param_get(int id)
+{
+    if(id < 0 || id >= ed_sync_int_get(&params_nums) || params[id].ptr == NULL)
+        return NULL;
+    return &params[id];
+}
+
+/**
+ * @brief: Find the id of a parameter by its name.
+ * @return: id if found, otherwise ED_PARAM_ERR_ID.
+ */
+int ed_param_find(const char* name)
+{
+    int nums = ed_sync_int_get(&params_nums);
+    for(int id = 0; id < nums; id++)
+    {
+        if(params[id].name && strcmp(params[id].name, name) == 0)
+            return id;
+    }
+    return ED_PARAM_ERR_ID;
+}
+
+/**
+ * @brief: Read the value of id as 4 raw little-endian bytes.
+ * @note: UINT8 parameters are widened to 4 bytes.
+ */
+int ed_param_read(int id, uint8_t raw[4])
+{
+    const ed_param_t* param = ed_param_get(id);
+    if(param == NULL)
+        return ED_PARAM_ERR_ID;
+
+    switch(param->type)
+    {
+    case ED_PARAM_FLOAT:
+    case ED_PARAM_INT32:
+        memcpy(raw, param->ptr, 4);
+        break;
+    case ED_PARAM_UINT8:
+        raw[0] = *(uint8_t*)param->ptr;
+        raw[1] = raw[2] = raw[3] = 0;
+        break;
+    default:
+        return ED_PARAM_ERR_ID;
+    }
+    return ED_PARAM_OK;
+}
+
+/**
+ * @brief: Write 4 raw little-endian bytes to id.
+ * @return: ED_PARAM_OK if success, ED_PARAM_ERR_RANGE if the value is out of [min, max] or not a number.
+ */
+int ed_param_write(int id, const uint8_t raw[4])
+{
+    const ed_param_t* param = ed_param_get(id);
+    if(param == NULL)
+        return ED_PARAM_ERR_ID;
+
+    switch(param->type)
+    {
+    case ED_PARAM_FLOAT:
+    {
+        float value;
+        memcpy(&value, raw, 4);
+        // NaN fails both comparisons.
+        if(!(value >= param->min && value <= param->max))
+            return ED_PARAM_ERR_RANGE;
+        *(float*)param->ptr = value;
+        break;
+    }
+    case ED_PARAM_INT32:
+    {
+        int32_t value;
+        memcpy(&value, raw, 4);
+        if(value < param->min || value > param->max)
+            return ED_PARAM_ERR_RANGE;
+        *(int32_t*)param->ptr = value;
+        break;
+    }
+    case ED_PARAM_UINT8:
+    {
+        int32_t value;
+        memcpy(&value, raw, 4);
+        if(value < param->min || value > param->max || value < 0 || value > UINT8_MAX)
+            return ED_PARAM_ERR_RANGE;
+        *(uint8_t*)param->ptr = (uint8_t)value;
+        break;
+    }
+    default:
+        return ED_PARAM_ERR_ID;
+    }
+    return ED_PARAM_OK;
+}
+
+/**
+ * @brief: Set the callback invoked by `ed_param_commit`.
+ * @note: used to publish a batch of writes atomically, such as through an ed_param_block_t.
+ *          The callback returns 0 if the batch is published.
+ */
+void ed_param_set_commit_callback(int (*callback)(void* arg), void* arg)
+{
+    commit_callback_arg = arg;
+    commit_callback = callback;
+}
+
+/**
+ * @brief: Notify that a batch of writes is complete.
+ * @return: ED_PARAM_OK if success, ED_PARAM_ERR_BUSY if the batch is not published.
+ * @note: the debugger calls it once per received SET frame or legacy packet.
+ */
+int ed_param_commit(void)
+{
+    if(commit_callback && commit_callback(commit_callback_arg))
+        return ED_PARAM_ERR_BUSY;
+    return ED_PARAM_OK;
+}
+
+/**
+ * @brief: Take the lock of the registered variables.
+ * @note: held around a batch of writes and its commit, by the debugger for a SET frame or a legacy packet
+ *          and by any task which writes registered variables itself, so that batches do not interleave.
+ *          Do not block on anything else than the commit while holding it.
+ */
+void ed_param_lock(void)
+{
+    if(lock)
+        xSemaphoreTake(lock, portMAX_DELAY);
+}
+
+/**
+ * @brief: Give the lock taken by `ed_param_lock`.
+ */
+void ed_param_unlock(void)
+{
+    if(lock)
+        xSemaphoreGive(lock);
+}
@@ -0,0 +1,121 @@
+#ifndef __ED_PARAM_H__
+#define __ED_PARAM_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ED_PARAM_MAX_NUM            (128)
+#define ED_PARAM_MAX_NAME_LEN       (31)
+
+typedef enum {
+    ED_PARAM_FLOAT = 0,
+    ED_PARAM_INT32 = 1,
+    ED_PARAM_UINT8 = 2,
+} ed_param_type_t;
+
+typedef enum {
+    ED_PARAM_OK = 0,
+    ED_PARAM_ERR_ID = -1,
+    ED_PARAM_ERR_RANGE = -2,
+    ED_PARAM_ERR_FULL = -3,
+    ED_PARAM_ERR_ARG = -4,
+    ED_PARAM_ERR_BUSY = -5,
+} ed_param_err_t;
+
+/**
+ * @brief: Parameter descriptor.
+ * @param:
+ *      const char* name     : unique name, such as "veloc_roll.p". May be NULL for legacy bindings.
+ *      ed_param_type_t type : type of the variable pointed to by ptr.
+ *      void* ptr            : address of the variable.
+ *      float min, max       : accepted range of the value, writes outside of it are rejected.
+ */
+typedef struct {
+    const char* name;
+    ed_param_type_t type;
+    void* ptr;
+    float min;
+    float max;
+} ed_param_t;
+
+/**
+ * @brief: Register a parameter at the next free id.
+ * @return: id of the parameter if success, or a negative ed_param_err_t.
+ * @note: the name is not copied, it must remain valid forever (string literals are fine).
+ */
+int ed_param_register(const char* name, ed_param_type_t type, void* ptr, float min, float max);
+#define ed_param_register_float(name, ptr, min, max)    ed_param_register(name, ED_PARAM_FLOAT, ptr, min, max)
+#define ed_param_register_int32(name, ptr, min, max)    ed_param_register(name, ED_PARAM_INT32, ptr, min, max)
+#define ed_param_register_uint8(name, ptr, min, max)    ed_param_register(name, ED_PARAM_UINT8, ptr, min, max)
+
+/**
+ * @brief: Register a parameter at a fixed id.
+ * @return: id of the parameter if success, or a negative ed_param_err_t.
+ * @note: used by the legacy `ed_debugger_bind_float` interface.
+ */
+int ed_param_bind(int id, const char* name, ed_param_type_t type, void* ptr, float min, float max);
+
+/**
+ * @brief: Get the number of ids in use(the highest registered id + 1).
+ */
+int ed_param_count(void);
+
+/**
+ * @brief: Get the descriptor of id.
+ * @return: NULL if the id is not bound to a parameter.
+ */
+const ed_param_t* ed_param_get(int id);
+
+/**
+ * @brief: Find the id of a parameter by its name.
+ * @return: id if found, otherwise ED_PARAM_ERR_ID.
+ */
+int ed_param_find(const char* name);
+
+/**
+ * @brief: Read the value of id as 4 raw little-endian bytes.
+ * @note: UINT8 parameters are widened to 4 bytes.
+ */
+int ed_param_read(int id, uint8_t raw[4]);
+
+/**
+ * @brief: Write 4 raw little-endian bytes to id.
+ * @return: ED_PARAM_OK if success, ED_PARAM_ERR_RANGE if the value is out of [min, max] or not a number.
+ */
+int ed_param_write(int id, const uint8_t raw[4]);
+
+/**
+ * @brief: Set the callback invoked by `ed_param_commit`.
+ * @note: used to publish a batch of writes atomically, such as through an ed_param_block_t.
+ *          The callback returns 0 if the batch is published.
+ */
+void ed_param_set_commit_callback(int (*callback)(void* arg), void* arg);
+
+/**
+ * @brief: Notify that a batch of writes is complete.
+ * @return: ED_PARAM_OK if success, ED_PARAM_ERR_BUSY if the batch is not published.
+ * @note: the debugger calls it once per received SET frame or legacy packet.
+ */
+int ed_param_commit(void);
+
+/**
+ * @brief: Take the lock of the registered variables.
+ * @note: held around a batch of writes and its commit, by the debugger for a SET frame or a legacy packet
+ *          and by any task which writes registered variables itself, so that batches do not interleave.
+ *          Do not block on anything else than the commit while holding it.
+ */
+void ed_param_lock(void);
+
+/**
+ * @brief: Give the lock taken by `ed_param_lock`.
+ */
+void ed_param_unlock(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+#include "ed_param_block.h"
+
+#include <string.h>
+
+#include "freertos/task.h"
+
+/**
+ * @brief: Initialize the block with two buffers of size bytes.
+ * @param:
+ *      - const void* initial : initial parameter set, copied to the active buffer. May be NULL.
+ */
+void ed_param_block_init(ed_param_block_t* block, void* buffer0, void* buffer1, size_t size, const void* initial)
+{
+    block->buffers[0] = buffer0;
+    block->buffers[1] = buffer1;
+    block->size = size;
+    block->_active = 0;
+    if(initial)
+        memcpy(buffer0, initial, size);
+    ed_sync_flag_set(&block->_pending, false);
+}
+
+/**
+ * @brief: Wait until the reader has consumed the previous set (writer side).
+ * @return: 0 if the next publish does not wait, -1 if timeout.
+ * @note: used to publish several blocks all or none: wait for all of them, then publish each with no timeout.
+ */
+int ed_param_block_wait(ed_param_block_t* block, TickType_t timeout)
+{
+    // only the reader clears _pending, so a free block stays free until the writer publishes.
+    while(ed_sync_flag_get(&block->_pending))
+    {
+        if(timeout == 0)
+            return -1;
+        vTaskDelay(1);
+        if(timeout != portMAX_DELAY)
+            timeout --;
+    }
+    return 0;
+}
+
+/**
+ * @brief: Stage and publish a full parameter set (writer side).
+ * @param:
+ *      - const void* data   : the new set, block->size bytes.
+ *      - TickType_t timeout : max time waiting for the reader to consume the previous set.
+ * @return: 0 if success, -1 if timeout.
+ */
+int ed_param_block_publish(ed_param_block_t* block, const void* data, TickType_t timeout)
+{
+    // wait until the reader swapped to the previous set, then the inactive buffer is free.
+    if(ed_param_block_wait(block, timeout))
+        return -1;
+
+    // _active is only changed by the reader while _pending is set, so it is stable here.
+    memcpy(block->buffers[block->_active ^ 1], data, block->size);
+    ed_sync_flag_set(&block->_pending, true);
+    return 0;
+}
+
+/**
+ * @brief: Swap to the newest published set at a tick boundary (reader side).
+ * @return: the new set if one was published since the last call, otherwise NULL.
+ * @note: the returned set stays valid until the next call.
+ */
+const void* ed_param_block_acquire(ed_param_block_t* block)
+{
+    if(!ed_sync_flag_get(&block->_pending))
+        return NULL;
+
+    block->_active ^= 1;
+    const void* set = block->buffers[block->_active];
+    ed_sync_flag_set(&block->_pending, false);
+    return set;
+}
@@ -0,0 +1,68 @@
+#ifndef __ED_PARAM_BLOCK_H__
+#define __ED_PARAM_BLOCK_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "ed_sync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief: Double-buffered parameter block with a single writer and a single reader.
+ * @note:
+ *          The writer stages a full copy of the parameter set into the inactive buffer and
+ *          publishes it, the reader swaps to it at its own tick boundary. So the reader never
+ *          observes a half-updated set, and when nothing is published the reader only pays
+ *          one atomic load.
+ *          The writer waits for the previous publication to be consumed before reusing the
+ *          inactive buffer, the reader never waits.
+ */
+typedef struct {
+    void* buffers[2];
+    size_t size;
+
+    // private realizations.
+    int _active;
+    ed_sync_flag_t _pending;
+} ed_param_block_t;
+
+/**
+ * @brief: Initialize the block with two buffers of size bytes.
+ * @param:
+ *      - const void* initial : initial parameter set, copied to the active buffer. May be NULL.
+ */
+void ed_param_block_init(ed_param_block_t* block, void* buffer0, void* buffer1, size_t size, const void* initial);
+
+/**
+ * @brief: Wait until the reader has consumed the previous set (writer side).
+ * @return: 0 if the next publish does not wait, -1 if timeout.
+ * @note: used to publish several blocks all or none: wait for all of them, then publish each with no timeout.
+ */
+int ed_param_block_wait(ed_param_block_t* block, TickType_t timeout);
+
+/**
+ * @brief: Stage and publish a full parameter set (writer side).
+ * @param:
+ *      - const void* data   : the new set, block->size bytes.
+ *      - TickType_t timeout : max time waiting for the reader to consume the previous set.
+ * @return: 0 if success, -1 if timeout.
+ */
+int ed_param_block_publish(ed_param_block_t* block, const void* data, TickType_t timeout);
+
+/**
+ * @brief: Swap to the newest published set at a tick boundary (reader side).
+ * @return: the new set if one was published since the last call, otherwise NULL.
+ * @note: the returned set stays valid until the next call.
+ */
+const void* ed_param_block_acquire(ed_param_block_t* block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,11 @@
 
 static const char* tag = "idf_i2c";
 
+// the command links are built in a buffer on the stack of the caller, the sensor path never uses the heap.
+// a register read is 2 transactions(select the register, then read), a register write is 1.
+#define ED_IDF_I2C_READ_LINK_SIZE       (I2C_LINK_RECOMMENDED_SIZE(2))
+#define ED_IDF_I2C_WRITE_LINK_SIZE      (I2C_LINK_RECOMMENDED_SIZE(1))
+
 int ed_idf_i2c_init(i2c_port_t i2c_num, gpio_num_t sda_io_num, gpio_num_t scl_io_num)
 {
     i2c_config_t conf = {
@@ -37,7 +42,8 @@ int ed_idf_i2c_init(i2c_port_t i2c_num, gpio_num_t sda_io_num, gpio_num_t scl_io
 int ed_idf_i2c_read_reg(i2c_port_t i2c_num, uint8_t address, uint8_t reg, uint8_t len, uint8_t *buf)
 {
     esp_err_t ret = ESP_OK;
-    i2c_cmd_handle_t handle = i2c_cmd_link_create();
+    uint8_t link[ED_IDF_I2C_READ_LINK_SIZE] __attribute__((aligned(4)));
+    i2c_cmd_handle_t handle = i2c_cmd_link_create_static(link, sizeof(link));
     assert (handle != NULL);
     // send start signal.
 	if((ret = i2c_master_start(handle)) != ESP_OK)
@@ -82,20 +88,21 @@ int ed_idf_i2c_read_reg(i2c_port_t i2c_num, uint8_t address, uint8_t reg, uint8_
         goto end;
     }
     // exec.
-    if((ret = i2c_master_cmd_begin(i2c_num, handle, 500 / portTICK_PERIOD_MS) != ESP_OK))
+    if((ret = i2c_master_cmd_begin(i2c_num, handle, 500 / portTICK_PERIOD_MS)) != ESP_OK)
     {
         ESP_LOGE(tag, "i2c_master_cmd_begin failed with ret: %d", ret);
         goto end;
     }
 end:
-    i2c_cmd_link_delete(handle);
+    i2c_cmd_link_delete_static(handle);
     return ret;
 }
 
 int ed_idf_i2c_write_reg(i2c_port_t i2c_num, uint8_t address, uint8_t reg, uint8_t len, uint8_t *buf)
 {
     esp_err_t ret = ESP_OK;
-    i2c_cmd_handle_t handle = i2c_cmd_link_create();
+    uint8_t link[ED_IDF_I2C_WRITE_LINK_SIZE] __attribute__((aligned(4)));
+    i2c_cmd_handle_t handle = i2c_cmd_link_create_static(link, sizeof(link));
     assert (handle != NULL);
     // send start signal.
 	if((ret = i2c_master_start(handle)) != ESP_OK)
@@ -104,7 +111,7 @@ int ed_idf_i2c_write_reg(i2c_port_t i2c_num, uint8_t address, uint8_t reg, uint8
         goto end;
     } 
     // write address.
-   	if((ret = i2c_master_write_byte(handle, (address << 1) | I2C_MASTER_WRITE, true) != ESP_OK))
+   	if((ret = i2c_master_write_byte(handle, (address << 1) | I2C_MASTER_WRITE, true)) != ESP_OK)
     {
         ESP_LOGE(tag, "i2c_master_write_byte failed with ret: %d", ret);
         goto end;
@@ -128,13 +135,13 @@ int ed_idf_i2c_write_reg(i2c_port_t i2c_num, uint8_t address, uint8_t reg, uint8
         goto end;
     }
     // exec.
-    if((ret = i2c_master_cmd_begin(i2c_num, handle, 500 / portTICK_PERIOD_MS) != ESP_OK))
+    if((ret = i2c_master_cmd_begin(i2c_num, handle, 500 / portTICK_PERIOD_MS)) != ESP_OK)
     {
         ESP_LOGE(tag, "i2c_master_cmd_begin failed with ret: %d", ret);
         goto end;
     }
 end:
-    i2c_cmd_link_delete(handle);
+    i2c_cmd_link_delete_static(handle);
     return ret;
 }
 
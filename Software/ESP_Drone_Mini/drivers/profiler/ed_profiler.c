@@ -0,0 +1,256 @@
+#include "ed_profiler.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char* tag = "ed_profiler";
+
+static ed_profiler_probe_t* probes[ED_PROFILER_MAX_PROBES] = { NULL };
+static ed_sync_int_t probes_nums = ED_SYNC_INT_INIT(0);
+
+// incremented by `ed_profiler_reset`, a probe clears itself when its generation is behind.
+static ed_sync_int_t generation = ED_SYNC_INT_INIT(0);
+
+// heap allocations of the watched task, counted by the hooks of the heap.
+#if(CONFIG_HEAP_USE_HOOKS)
+static TaskHandle_t heap_watched_task = NULL;
+#endif
+static atomic_uint heap_allocs = 0;
+
+static int __ed_profiler_hist_bin(uint32_t cycles)
+{
+    if(cycles < (1u << ED_PROFILER_HIST_SUB_BITS))
+        return cycles;
+
+    int msb = 31 - __builtin_clz(cycles);
+    uint32_t sub = (cycles >> (msb - ED_PROFILER_HIST_SUB_BITS)) & ((1u << ED_PROFILER_HIST_SUB_BITS) - 1);
+    return (msb << ED_PROFILER_HIST_SUB_BITS) | sub;
+}
+
+/**
+ * @brief: Register a probe so that it can be dumped.
+ * @return: 0 if success.
+ */
+int ed_profiler_register(ed_profiler_probe_t* probe)
+{
+    int nums = ed_sync_int_get(&probes_nums);
+    if(nums >= ED_PROFILER_MAX_PROBES)
+    {
+        ESP_LOGE(tag, "too many probes, %s is not registered", probe->name);
+        return -1;
+    }
+
+    probe->_generation = ed_sync_int_get(&generation);
+    probes[nums] = probe;
+    ed_sync_int_set(&probes_nums, nums + 1);
+    return 0;
+}
+
+/**
+ * @brief: Get the current CPU cycle count.
+ */
+uint32_t ed_profiler_now(void)
+{
+#if(ED_PROFILER_ENABLE)
+    return esp_cpu_get_cycle_count();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief: Add a sample of cycles to probe.
+ */
+void ed_profiler_record(ed_profiler_probe_t* probe, uint32_t cycles)
+{
+#if(ED_PROFILER_ENABLE)
+    int current_generation = ed_sync_int_get(&generation);
+
+    ed_seqlock_write_begin(&probe->_lock);
+    if(probe->_generation != current_generation)
+    {
+        probe->count = 0;
+        probe->min = UINT32_MAX;
+        probe->max = 0;
+        probe->sum = 0;
+        memset(probe->hist, 0x00, sizeof(probe->hist));
+        probe->_generation = current_generation;
+    }
+
+    probe->count ++;
+    probe->sum += cycles;
+    if(cycles < probe->min)
+        probe->min = cycles;
+    if(cycles > probe->max)
+        probe->max = cycles;
+    probe->hist[__ed_profiler_hist_bin(cycles)] ++;
+    ed_seqlock_write_end(&probe->_lock);
+#endif
+}
+
+/**
+ * @brief: Add a sample of (now - start) to probe.
+ * @return: now, so that consecutive sections can be chained.
+ */
+uint32_t ed_profiler_record_since(ed_profiler_probe_t* probe, uint32_t start)
+{
+    uint32_t now = ed_profiler_now();
+    ed_profiler_record(probe, now - start);
+    return now;
+}
+
+/**
+ * @brief: Take a consistent copy of probe.
+ */
+void ed_profiler_read(ed_profiler_probe_t* probe, ed_profiler_probe_t* copy)
+{
+    ed_seqlock_read(&probe->_lock, copy, probe, sizeof(ed_profiler_probe_t));
+    if(copy->_generation != ed_sync_int_get(&generation))
+    {
+        // reset requested but not applied by the writer yet.
+        copy->count = 0;
+        copy->min = UINT32_MAX;
+        copy->max = 0;
+        copy->sum = 0;
+        memset(copy->hist, 0x00, sizeof(copy->hist));
+    }
+}
+
+/**
+ * @brief: Clear all probes.
+ * @note: the clearing is done by the writer of each probe at its next sample.
+ */
+void ed_profiler_reset(void)
+{
+    ed_sync_int_set(&generation, ed_sync_int_get(&generation) + 1);
+}
+
+/**
+ * @brief: Get the number of registered probes.
+ */
+int ed_profiler_count(void)
+{
+    return ed_sync_int_get(&probes_nums);
+}
+
+/**
+ * @brief: Serialize probes from *index into buf, see ED_DBG_CMD_PROFILE.
+ * @return: bytes written, *index is moved to the first probe not serialized.
+ */
+int ed_profiler_serialize(uint8_t* buf, int size, int* index)
+{
+    static ed_profiler_probe_t copy;
+    int nums = ed_sync_int_get(&probes_nums);
+    int len = 0;
+
+    for( ; *index < nums; (*index) ++)
+    {
+        ed_profiler_read(probes[*index], &copy);
+
+        int name_len = strnlen(copy.name, ED_PROFILER_MAX_NAME_LEN);
+        int bins = 0;
+        for(int i = 0; i < ED_PROFILER_HIST_BINS; i++)
+            bins += copy.hist[i] != 0;
+
+        // index | name_len | name | count | min | max | sum | nbins | nbins * (bin | count)
+        int entry_len = 2 + name_len + 20 + 1 + bins * 5;
+        if(len + entry_len > size)
+            break;
+
+        uint8_t *entry = buf + len;
+        entry[0] = *index;
+        entry[1] = name_len;
+        memcpy(entry + 2, copy.name, name_len);
+        entry += 2 + name_len;
+        memcpy(entry, &copy.count, 4);
+        memcpy(entry + 4, &copy.min, 4);
+        memcpy(entry + 8, &copy.max, 4);
+        memcpy(entry + 12, &copy.sum, 8);
+        entry[20] = bins;
+        entry += 21;
+        for(int i = 0; i < ED_PROFILER_HIST_BINS; i++)
+        {
+            if(copy.hist[i] == 0)
+                continue;
+            entry[0] = i;
+            memcpy(entry + 1, &copy.hist[i], 4);
+            entry += 5;
+        }
+        len += entry_len;
+    }
+    return len;
+}
+
+/**
+ * @brief: Print all probes to the console in microseconds.
+ */
+void ed_profiler_log(void)
+{
+    static ed_profiler_probe_t copy;
+    float cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    int nums = ed_sync_int_get(&probes_nums);
+
+    for(int i = 0; i < nums; i++)
+    {
+        ed_profiler_read(probes[i], &copy);
+        if(copy.count == 0)
+        {
+            ESP_LOGI(tag, "%-16s no samples", copy.name);
+            continue;
+        }
+        ESP_LOGI(tag, "%-16s count: %lu, min: %.2fus, avg: %.2fus, max: %.2fus",
+            copy.name, (unsigned long)copy.count,
+            copy.min / cycles_per_us, (float)copy.sum / copy.count / cycles_per_us, copy.max / cycles_per_us);
+    }
+}
+
+#if(CONFIG_HEAP_USE_HOOKS)
+/**
+ * @brief: Hooks of the heap, called after each successful allocation and free.
+ * @note: the heap functions are in IRAM, so are the hooks.
+ */
+void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps)
+{
+    (void)ptr;
+    (void)size;
+    (void)caps;
+    if(heap_watched_task != NULL && xTaskGetCurrentTaskHandle() == heap_watched_task)
+        atomic_fetch_add_explicit(&heap_allocs, 1, memory_order_relaxed);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void* ptr)
+{
+    (void)ptr;
+}
+#endif
+
+/**
+ * @brief: Count the heap allocations of the calling task from now on, e.g. of the control loop.
+ * @return: 0 if success, -1 if CONFIG_HEAP_USE_HOOKS is disabled.
+ * @note: one task is watched at a time.
+ */
+int ed_profiler_heap_watch(void)
+{
+#if(CONFIG_HEAP_USE_HOOKS)
+    heap_watched_task = xTaskGetCurrentTaskHandle();
+    return 0;
+#else
+    ESP_LOGW(tag, "heap allocations are not counted without CONFIG_HEAP_USE_HOOKS");
+    return -1;
+#endif
+}
+
+/**
+ * @brief: Get the number of heap allocations of the watched task.
+ * @note: the difference around a section is the number of its allocations.
+ */
+uint32_t ed_profiler_heap_allocs(void)
+{
+    return atomic_load_explicit(&heap_allocs, memory_order_relaxed);
+}
@@ -0,0 +1,109 @@
+#ifndef __ED_PROFILER_H__
+#define __ED_PROFILER_H__
+
+#include <stdint.h>
+
+#include "ed_sync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ED_PROFILER_ENABLE
+#define ED_PROFILER_ENABLE              (1)
+#endif
+
+#define ED_PROFILER_MAX_PROBES          (16)
+#define ED_PROFILER_MAX_NAME_LEN        (15)
+
+// 4 bins per octave of cycles: bin = 4 * msb + the 2 bits below msb.
+#define ED_PROFILER_HIST_SUB_BITS       (2)
+#define ED_PROFILER_HIST_BINS           (32 << ED_PROFILER_HIST_SUB_BITS)
+
+/**
+ * @brief: Statistics of a measured section, in CPU cycles.
+ * @note: A probe has a single writer(the task executing the section), readers take
+ *          consistent copies through `ed_profiler_read`.
+ */
+typedef struct {
+    const char* name;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[ED_PROFILER_HIST_BINS];
+
+    // private realizations.
+    ed_seqlock_t _lock;
+    int _generation;
+} ed_profiler_probe_t;
+
+#define ED_PROFILER_PROBE_INIT(probe_name)  { .name = (probe_name), .min = UINT32_MAX, ._lock = ED_SEQLOCK_INIT }
+
+/**
+ * @brief: Register a probe so that it can be dumped.
+ * @return: 0 if success.
+ */
+int ed_profiler_register(ed_profiler_probe_t* probe);
+
+/**
+ * @brief: Get the current CPU cycle count.
+ */
+uint32_t ed_profiler_now(void);
+
+/**
+ * @brief: Add a sample of cycles to probe.
+ */
+void ed_profiler_record(ed_profiler_probe_t* probe, uint32_t cycles);
+
+/**
+ * @brief: Add a sample of (now - start) to probe.
+ * @return: now, so that consecutive sections can be chained.
+ */
+uint32_t ed_profiler_record_since(ed_profiler_probe_t* probe, uint32_t start);
+
+/**
+ * @brief: Take a consistent copy of probe.
+ */
+void ed_profiler_read(ed_profiler_probe_t* probe, ed_profiler_probe_t* copy);
+
+/**
+ * @brief: Clear all probes.
+ * @note: the clearing is done by the writer of each probe at its next sample.
+ */
+void ed_profiler_reset(void);
+
+/**
+ * @brief: Get the number of registered probes.
+ */
+int ed_profiler_count(void);
+
+/**
+ * @brief: Serialize probes from *index into buf, see ED_DBG_CMD_PROFILE.
+ * @return: bytes written, *index is moved to the first probe not serialized.
+ */
+int ed_profiler_serialize(uint8_t* buf, int size, int* index);
+
+/**
+ * @brief: Print all probes to the console in microseconds.
+ */
+void ed_profiler_log(void);
+
+/**
+ * @brief: Count the heap allocations of the calling task from now on, e.g. of the control loop.
+ * @return: 0 if success, -1 if CONFIG_HEAP_USE_HOOKS is disabled.
+ * @note: one task is watched at a time.
+ */
+int ed_profiler_heap_watch(void);
+
+/**
+ * @brief: Get the number of heap allocations of the watched task.
+ * @note: the difference around a section is the number of its allocations.
+ */
+uint32_t ed_profiler_heap_allocs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,144 @@
+#include "ed_sync.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * @group: Atomic flag and value.
+ */
+void ed_sync_flag_set(ed_sync_flag_t* flag, bool value)
+{
+    atomic_store_explicit(&flag->value, value, memory_order_release);
+}
+
+bool ed_sync_flag_get(ed_sync_flag_t* flag)
+{
+    return atomic_load_explicit(&flag->value, memory_order_acquire);
+}
+
+void ed_sync_int_set(ed_sync_int_t* var, int value)
+{
+    atomic_store_explicit(&var->value, value, memory_order_release);
+}
+
+int ed_sync_int_get(ed_sync_int_t* var)
+{
+    return atomic_load_explicit(&var->value, memory_order_acquire);
+}
+
+
+/**
+ * @group: Sequence lock.
+ */
+void ed_seqlock_write_begin(ed_seqlock_t* lock)
+{
+    uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_relaxed);
+    // the odd sequence must be visible before any of the data stores.
+    atomic_thread_fence(memory_order_release);
+}
+
+void ed_seqlock_write_end(ed_seqlock_t* lock)
+{
+    uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * @brief: Start a read section.
+ * @return: the sequence to be passed to `ed_seqlock_read_retry`.
+ */
+uint32_t ed_seqlock_read_begin(ed_seqlock_t* lock)
+{
+    return atomic_load_explicit(&lock->seq, memory_order_acquire);
+}
+
+/**
+ * @brief: Finish a read section.
+ * @return: true if the data read since `ed_seqlock_read_begin` may be torn and must be read again.
+ */
+bool ed_seqlock_read_retry(ed_seqlock_t* lock, uint32_t seq)
+{
+    // the data loads must complete before the sequence is checked again.
+    atomic_thread_fence(memory_order_acquire);
+    return (seq & 1) || seq != atomic_load_explicit(&lock->seq, memory_order_relaxed);
+}
+
+/**
+ * @brief: Copy size bytes from the protected src to dst consistently.
+ */
+void ed_seqlock_read(ed_seqlock_t* lock, void* dst, const void* src, size_t size)
+{
+    int retry_times = 0;
+    uint32_t seq;
+    do {
+        if(retry_times++ >= ED_SEQLOCK_SPIN_LIMIT)
+        {
+            // the writer may be preempted in the middle of a write, let it finish.
+            vTaskDelay(1);
+            retry_times = 0;
+        }
+        seq = ed_seqlock_read_begin(lock);
+        memcpy(dst, src, size);
+    } while(ed_seqlock_read_retry(lock, seq));
+}
+
+/**
+ * @brief: Copy size bytes from src to the protected dst.
+ */
+void ed_seqlock_write(ed_seqlock_t* lock, void* dst, const void* src, size_t size)
+{
+    ed_seqlock_write_begin(lock);
+    memcpy(dst, src, size);
+    ed_seqlock_write_end(lock);
+}
+
+
+/**
+ * @group: Lock-free single producer single consumer queue.
+ */
+int ed_spsc_queue_init(ed_spsc_queue_t* queue, void* buffer, size_t item_size, uint32_t capacity)
+{
+    if(buffer == NULL || item_size == 0 || capacity == 0 || (capacity & (capacity - 1)))
+        return -1;
+
+    queue->buffer = buffer;
+    queue->item_size = item_size;
+    queue->capacity = capacity;
+    atomic_init(&queue->_head, 0);
+    atomic_init(&queue->_tail, 0);
+    return 0;
+}
+
+bool ed_spsc_queue_push(ed_spsc_queue_t* queue, const void* item)
+{
+    uint32_t head = atomic_load_explicit(&queue->_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&queue->_tail, memory_order_acquire);
+    if(head - tail >= queue->capacity)
+        return false;
+
+    memcpy(queue->buffer + (head & (queue->capacity - 1)) * queue->item_size, item, queue->item_size);
+    atomic_store_explicit(&queue->_head, head + 1, memory_order_release);
+    return true;
+}
+
+bool ed_spsc_queue_pop(ed_spsc_queue_t* queue, void* item)
+{
+    uint32_t tail = atomic_load_explicit(&queue->_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&queue->_head, memory_order_acquire);
+    if(head == tail)
+        return false;
+
+    memcpy(item, queue->buffer + (tail & (queue->capacity - 1)) * queue->item_size, queue->item_size);
+    atomic_store_explicit(&queue->_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+uint32_t ed_spsc_queue_size(ed_spsc_queue_t* queue)
+{
+    uint32_t head = atomic_load_explicit(&queue->_head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&queue->_tail, memory_order_acquire);
+    return head - tail;
+}
@@ -0,0 +1,123 @@
+#ifndef __ED_SYNC_H__
+#define __ED_SYNC_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @group: Atomic flag and value.
+ * @note:  Stores have release semantics and loads have acquire semantics, so the data written
+ *          before `set` is visible to the task which observes the new value by `get`.
+ */
+typedef struct {
+    atomic_bool value;
+} ed_sync_flag_t;
+
+typedef struct {
+    atomic_int value;
+} ed_sync_int_t;
+
+#define ED_SYNC_FLAG_INIT(v)    { .value = (v) }
+#define ED_SYNC_INT_INIT(v)     { .value = (v) }
+
+void ed_sync_flag_set(ed_sync_flag_t* flag, bool value);
+
+bool ed_sync_flag_get(ed_sync_flag_t* flag);
+
+void ed_sync_int_set(ed_sync_int_t* var, int value);
+
+int ed_sync_int_get(ed_sync_int_t* var);
+
+
+/**
+ * @group: Sequence lock.
+ * @note:  Single writer, multiple readers. Writers never wait, readers retry when the data changed
+ *          while being read. A reader must not have a higher priority than the writer on the same
+ *          core, otherwise it may spin on an interrupted write; `ed_seqlock_read` sleeps one tick
+ *          after ED_SEQLOCK_SPIN_LIMIT retries to let the writer finish.
+ */
+typedef struct {
+    atomic_uint seq;
+} ed_seqlock_t;
+
+#define ED_SEQLOCK_INIT         { .seq = 0 }
+#define ED_SEQLOCK_SPIN_LIMIT   (16)
+
+void ed_seqlock_write_begin(ed_seqlock_t* lock);
+
+void ed_seqlock_write_end(ed_seqlock_t* lock);
+
+/**
+ * @brief: Start a read section.
+ * @return: the sequence to be passed to `ed_seqlock_read_retry`.
+ */
+uint32_t ed_seqlock_read_begin(ed_seqlock_t* lock);
+
+/**
+ * @brief: Finish a read section.
+ * @return: true if the data read since `ed_seqlock_read_begin` may be torn and must be read again.
+ */
+bool ed_seqlock_read_retry(ed_seqlock_t* lock, uint32_t seq);
+
+/**
+ * @brief: Copy size bytes from the protected src to dst consistently.
+ */
+void ed_seqlock_read(ed_seqlock_t* lock, void* dst, const void* src, size_t size);
+
+/**
+ * @brief: Copy size bytes from src to the protected dst.
+ */
+void ed_seqlock_write(ed_seqlock_t* lock, void* dst, const void* src, size_t size);
+
+
+/**
+ * @group: Lock-free single producer single consumer queue.
+ * @note:  Fixed size items are copied in and out. The capacity must be a power of two.
+ */
+typedef struct {
+    uint8_t* buffer;
+    size_t item_size;
+    uint32_t capacity;
+
+    // private realizations.
+    atomic_uint _head;  // written by the producer only.
+    atomic_uint _tail;  // written by the consumer only.
+} ed_spsc_queue_t;
+
+/**
+ * @brief: Initialize the queue over buffer.
+ * @param:
+ *      - void* buffer       : storage of capacity * item_size bytes.
+ *      - uint32_t capacity  : number of items, must be a power of two.
+ * @return: 0 if success.
+ */
+int ed_spsc_queue_init(ed_spsc_queue_t* queue, void* buffer, size_t item_size, uint32_t capacity);
+
+/**
+ * @brief: Push an item (producer side).
+ * @return: false if the queue is full.
+ */
+bool ed_spsc_queue_push(ed_spsc_queue_t* queue, const void* item);
+
+/**
+ * @brief: Pop an item (consumer side).
+ * @return: false if the queue is empty.
+ */
+bool ed_spsc_queue_pop(ed_spsc_queue_t* queue, void* item);
+
+/**
+ * @brief: Get the number of items in the queue.
+ */
+uint32_t ed_spsc_queue_size(ed_spsc_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+#include "ed_deadline.h"
+
+#include "esp_log.h"
+#include "esp_task_wdt.h"
+#include "esp_rom_sys.h"
+
+static const char* tag = "ed_deadline";
+
+/**
+ * @brief: Initialize the deadline accounting, must be called by the monitored task.
+ * @return: 0 if success.
+ */
+int ed_deadline_init(ed_deadline_t* deadline)
+{
+    esp_err_t ret = ESP_OK;
+
+    deadline->ticks = 0;
+    deadline->overruns = 0;
+    deadline->degraded_times = 0;
+    deadline->max_lateness_us = 0;
+    deadline->mode = ED_DEADLINE_NORMAL;
+    deadline->_cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    deadline->_period_cycles = deadline->period_us * deadline->_cycles_per_us;
+    deadline->_budget_cycles = deadline->budget_us * deadline->_cycles_per_us;
+    deadline->_last_start = 0;
+    deadline->_window_ticks = 0;
+    deadline->_window_overruns = 0;
+    deadline->_clean_windows = 0;
+
+    if(deadline->subscribe_wdt && (ret = esp_task_wdt_add(NULL)) != ESP_OK)
+    {
+        ESP_LOGE(tag, "esp_task_wdt_add failed, ret: %s", esp_err_to_name(ret));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief: Account a finished tick and feed the watchdog.
+ * @param:
+ *      - uint32_t start : CPU cycle count when the tick was woken up.
+ *      - uint32_t end   : CPU cycle count at the end of the tick.
+ * @return: the mode for the next tick.
+ */
+ed_deadline_mode_t ed_deadline_tick(ed_deadline_t* deadline, uint32_t start, uint32_t end)
+{
+    if(deadline->subscribe_wdt)
+        esp_task_wdt_reset();
+
+    // the tick is released one period after the previous wake up, an early wake up(such as the
+    // interrupt of the imu a bit ahead) is its own release.
+    uint32_t release = start;
+    if(deadline->ticks > 0)
+    {
+        uint32_t expected = deadline->_last_start + deadline->_period_cycles;
+        if((int32_t)(start - expected) > 0)
+            release = expected;
+    }
+    deadline->_last_start = start;
+
+    int32_t lateness_us = (start - release) / deadline->_cycles_per_us;
+    if(lateness_us > deadline->max_lateness_us)
+        deadline->max_lateness_us = lateness_us;
+
+    deadline->ticks ++;
+    if(end - release > deadline->_budget_cycles)
+    {
+        deadline->overruns ++;
+        deadline->_window_overruns ++;
+    }
+
+    if(++ deadline->_window_ticks < deadline->window)
+        return deadline->mode;
+
+    // evaluate the window.
+    if(deadline->mode == ED_DEADLINE_NORMAL)
+    {
+        if(deadline->_window_overruns >= deadline->enter_overruns)
+        {
+            deadline->mode = ED_DEADLINE_DEGRADED;
+            deadline->degraded_times ++;
+            deadline->_clean_windows = 0;
+            ESP_LOGW(tag, "%d overruns in %d ticks, enter degraded mode.", deadline->_window_overruns, deadline->window);
+        }
+    } else {
+        if(deadline->_window_overruns == 0)
+        {
+            if(++ deadline->_clean_windows >= deadline->exit_windows)
+            {
+                deadline->mode = ED_DEADLINE_NORMAL;
+                ESP_LOGI(tag, "back to normal mode.");
+            }
+        } else {
+            deadline->_clean_windows = 0;
+        }
+    }
+
+    deadline->_window_ticks = 0;
+    deadline->_window_overruns = 0;
+    return deadline->mode;
+}
@@ -0,0 +1,80 @@
+#ifndef __ED_DEADLINE_H__
+#define __ED_DEADLINE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ED_DEADLINE_NORMAL = 0,
+    ED_DEADLINE_DEGRADED = 1,
+} ed_deadline_mode_t;
+
+/**
+ * @brief: Deadline accounting of a periodic task.
+ * @param:
+ *      @configs:
+ *          uint32_t period_us       : period of the task, a tick is expected one period after the start of
+ *                                     the previous one.
+ *          uint32_t budget_us       : max time from the expected start of a tick to its end, a longer tick
+ *                                     is an overrun. So a late start counts as well as a long execution.
+ *          uint16_t window          : number of ticks of an evaluation window.
+ *          uint16_t enter_overruns  : overruns in a window to enter the degraded mode.
+ *          uint16_t exit_windows    : consecutive windows without overrun to go back to the normal mode.
+ *          bool subscribe_wdt       : subscribe the calling task to the task watchdog, it is fed every tick.
+ *      @status(read only):
+ *          int32_t ticks            : total ticks.
+ *          int32_t overruns         : total overruns.
+ *          int32_t degraded_times   : times of entering the degraded mode.
+ *          int32_t max_lateness_us  : max delay of a start after its expected time.
+ *          uint8_t mode             : ed_deadline_mode_t.
+ */
+typedef struct {
+    // configs
+    uint32_t period_us;
+    uint32_t budget_us;
+    uint16_t window;
+    uint16_t enter_overruns;
+    uint16_t exit_windows;
+    bool subscribe_wdt;
+
+    // status
+    int32_t ticks;
+    int32_t overruns;
+    int32_t degraded_times;
+    int32_t max_lateness_us;
+    uint8_t mode;
+
+    // private realizations.
+    uint32_t _period_cycles;
+    uint32_t _budget_cycles;
+    uint32_t _cycles_per_us;
+    uint32_t _last_start;
+    uint16_t _window_ticks;
+    uint16_t _window_overruns;
+    uint16_t _clean_windows;
+} ed_deadline_t;
+
+/**
+ * @brief: Initialize the deadline accounting, must be called by the monitored task.
+ * @return: 0 if success.
+ */
+int ed_deadline_init(ed_deadline_t* deadline);
+
+/**
+ * @brief: Account a finished tick and feed the watchdog.
+ * @param:
+ *      - uint32_t start : CPU cycle count when the tick was woken up.
+ *      - uint32_t end   : CPU cycle count at the end of the tick.
+ * @return: the mode for the next tick.
+ */
+ed_deadline_mode_t ed_deadline_tick(ed_deadline_t* deadline, uint32_t start, uint32_t end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
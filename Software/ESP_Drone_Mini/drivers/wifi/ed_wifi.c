@@ -4,6 +4,8 @@
 #include "esp_check.h"
 #include <string.h>
 
+#include "ed_sync.h"
+
 static const char* tag = "ed_WiFi";
 
 typedef enum {
@@ -12,10 +14,8 @@ typedef enum {
     ED_WIFI_AS_AP,
 } ed_wifi_mode_t;
 
-static ed_wifi_mode_t wifi_mode = ED_WIFI_DISABLED;
-static int wifi_mode_seq_lock = 0;
-static bool ed_wifi_sta_connected = false;
-static int ed_wifi_sta_seq_lock = 0;
+static ed_sync_int_t wifi_mode = ED_SYNC_INT_INIT(ED_WIFI_DISABLED);
+static ed_sync_flag_t ed_wifi_sta_connected = ED_SYNC_FLAG_INIT(false);
 
 static void wifi_event(void *arg, esp_event_base_t eventBase, int32_t eventID, void *eventData) {
     ip_event_got_ip_t *ip = eventData;
@@ -27,20 +27,15 @@ static void wifi_event(void *arg, esp_event_base_t eventBase, int32_t eventID, v
                 retry_times = 0;
                 esp_wifi_connect();
 
-                // change sta status with seq lock.
-                ed_wifi_sta_seq_lock ++;
-                ed_wifi_sta_connected = true;
-                ed_wifi_sta_seq_lock ++;
-                
+                // change sta status.
+                ed_sync_flag_set(&ed_wifi_sta_connected, true);
                 break;
                 
             case WIFI_EVENT_STA_DISCONNECTED:
                 retry_times ++;
                 
-                // change sta status with seq lock.
-                ed_wifi_sta_seq_lock ++;
-                ed_wifi_sta_connected = false;
-                ed_wifi_sta_seq_lock ++;
+                // change sta status.
+                ed_sync_flag_set(&ed_wifi_sta_connected, false);
 
                 if(retry_times <= 5)
                 {
@@ -73,16 +68,14 @@ int ed_wifi_sta_connect(const char *ssid, const char *passwd)
     esp_err_t esp_ret = ESP_OK;
     int ret = 0;
 
-    if(wifi_mode != ED_WIFI_DISABLED)
+    if(ed_sync_int_get(&wifi_mode) != ED_WIFI_DISABLED)
     {
         // TODO: switch wifi mode to sta.
         return -1;
     }
 
-    // change sta status with seq lock.
-    ed_wifi_sta_seq_lock ++;
-    ed_wifi_sta_connected = false;
-    ed_wifi_sta_seq_lock ++;
+    // change sta status.
+    ed_sync_flag_set(&ed_wifi_sta_connected, false);
 
     esp_event_loop_handle_t wifi_handler;
     esp_event_loop_handle_t ip_handler;
@@ -114,10 +107,8 @@ int ed_wifi_sta_connect(const char *ssid, const char *passwd)
     esp_wifi_set_mode(WIFI_MODE_STA);
     esp_wifi_start();
 
-    // change wifi_mode with seq lock.
-    wifi_mode_seq_lock ++;
-    wifi_mode = ED_WIFI_AS_STA;
-    wifi_mode_seq_lock ++;
+    // change wifi_mode.
+    ed_sync_int_set(&wifi_mode, ED_WIFI_AS_STA);
 
     return ret;
 }
@@ -129,36 +120,12 @@ int ed_wifi_sta_disconnect(void)
 
 ed_wifi_mode_t ed_wifi_get_status(void)
 {
-    // read wifi_mode with seq lock.
-    int wifi_mode_seq_lock_old = 0;
-    ed_wifi_mode_t current_mode;
-
-    // waiting to enter the critical zone..
-    while(wifi_mode_seq_lock %2);
-
-    do {
-        if(wifi_mode_seq_lock_old != wifi_mode_seq_lock)
-            wifi_mode_seq_lock_old = wifi_mode_seq_lock;
-        current_mode = wifi_mode;
-    } while(wifi_mode_seq_lock_old != wifi_mode_seq_lock);
-    return current_mode;
+    return ed_sync_int_get(&wifi_mode);
 }
 
 bool ed_wifi_get_sta_status(void)
 {
-    // read wifi_mode with seq lock.
-    int ed_wifi_sta_seq_lock_old = 0;
-    bool sta_status;
-
-    // waiting to enter the critical zone..
-    while(ed_wifi_sta_seq_lock %2);
-
-    do {
-        if(ed_wifi_sta_seq_lock_old != ed_wifi_sta_seq_lock)
-            ed_wifi_sta_seq_lock_old = ed_wifi_sta_seq_lock;
-        sta_status = ed_wifi_sta_connected;
-    } while(ed_wifi_sta_seq_lock_old != ed_wifi_sta_seq_lock);
-    return sta_status;
+    return ed_sync_flag_get(&ed_wifi_sta_connected);
 }
 
 /**
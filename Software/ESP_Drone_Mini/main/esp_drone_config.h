@@ -2,18 +2,37 @@
 #define __ESP_DRONE_CONFIG_H__
 
 #include "esp_drone_private_config.h"
+#include "esp_drone_pid_config.h"
 
 /******************************* driver configs *******************************/
 #define ED_MOTOR_MIN_RPS                        (1)
+// consecutive imu failures before the motors are cut.
+#define ED_IMU_MAX_FAILED_TIMES                 (10)
+// in the degraded mode, the attitude loop runs once every n ticks.
+#define ED_DEGRADED_ATTITUDE_DIVIDER            (4)
+// dynamic notch on the raw gyro, see oh_dyn_notch_t. Off until it is modelled in ed_sim: a loaded notch
+// lags the loops by up to 6.5 deg at 5 Hz(center 15 Hz, q 3), see tools/dyn_notch/ed_dyn_notch_bench.
+#define ED_DYN_NOTCH_ENABLE                     (0)
+#define ED_DYN_NOTCH                            { .fft_size = 128, .axes = 3, .peaks = 1, .min_hz = 15, .max_hz = 45, .q = 3, .threshold = 4 }
+// relay autotune of the angular velocity pids, see oh_autotune_t. amplitude is in the pid output unit(rps).
+#define ED_AUTOTUNE                             { .amplitude = 60, .hysteresis = 2, .settle_cycles = 2, .cycles = 4, .max_ticks = 3000, .rule = OH_AUTOTUNE_RULE_SOME_OVERSHOOT }
+// chirp identification of the angular velocity loops, see oh_sysid_t. The gyro filter is taken from ED_GYRO_FILTER_STAGES.
+#define ED_SYSID                                { .amplitude = 40, .f0_hz = 0.5, .f1_hz = 20, .duration = 20, .tau_min = 0.005, .tau_max = 0.15, .max_delay = 4 }
+// quantization steps of the telemetry channels in the compact mode, in the order of telemetry_task:
+// pitch, roll, yaw(deg), gx, gy, gz(deg/s), roll rate integral, its output, roll rate target, roll angle integral output.
+#define ED_TELEMETRY_STEPS                      { 0.01, 0.01, 0.01, 0.05, 0.05, 0.05, 0.01, 0.01, 0.05, 0.01 }
 
 
 
 
 /******************************************************************************/
 #include "ed_drivers.h"
-#include "oh_quadrotor_pid.h"
+#include "ed_deadline.h"
+#include "ed_blackbox.h"
 typedef struct {
     ed_drivers_config_t drivers;
+    ed_deadline_t       deadline;
+    ed_blackbox_config_t blackbox;
     oh_quad_pid_t       pid_param;
 } ed_drv_t;
 
@@ -33,6 +52,7 @@ typedef struct {
                                 .k = 203.77, \
                                 .c = -136.57, \
                                 .min_rps = 1, \
+                                .max_rps = ED_MOTOR_MAX_RPS, \
                             }, \
                             .m2 = { \
                                 .gpio_num = GPIO_NUM_6, \
@@ -41,6 +61,7 @@ typedef struct {
                                 .k = 216.21, \
                                 .c = -127.61, \
                                 .min_rps = 1, \
+                                .max_rps = ED_MOTOR_MAX_RPS, \
                             }, \
                             .m3 = { \
                                 .gpio_num = GPIO_NUM_4, \
@@ -49,6 +70,7 @@ typedef struct {
                                 .k = 190.7, \
                                 .c = -114.13, \
                                 .min_rps = 1, \
+                                .max_rps = ED_MOTOR_MAX_RPS, \
                             }, \
                             .m4 = { \
                                 .gpio_num = GPIO_NUM_7, \
@@ -57,70 +79,57 @@ typedef struct {
                                 .k = 196.37, \
                                 .c = -120.08, \
                                 .min_rps = 1, \
+                                .max_rps = ED_MOTOR_MAX_RPS, \
                             }, \
                             .tcp_port = 8080, \
-                        }, \
-                        .pid_param = { \
-                            .veloc_pitch = { \
-                                .target = 0, \
-                                .proportion = 1.5, \
-                                .integration = 0.1, \
-                                .differention = 2.56, \
-                                .max_abs_output = 1000, \
-                                .configs.limitIntegration = PID_FUNC_ENABLE, \
-                                .configs.autoResetIntegration = PID_FUNC_DISABLE, \
-                                .max_abs_int_output = 400, \
+                            .control_task = { \
+                                .core = 1, \
+                                .priority = 20, \
+                                .stack_size = 4096, \
+                            }, \
+                            .telemetry_task = { \
+                                .core = 0, \
+                                .priority = 3, \
+                                .stack_size = 4096, \
                             }, \
-                            .veloc_roll = { \
-                                .target = 0, \
-                                .proportion = 1.5, \
-                                .integration = 0.1, \
-                                .differention = 2.56, \
-                                .max_abs_output = 1000, \
-                                .configs.limitIntegration = PID_FUNC_ENABLE, \
-                                .configs.autoResetIntegration = PID_FUNC_DISABLE, \
-                                .max_abs_int_output = 400, \
+                            .analysis_task = { \
+                                .core = 0, \
+                                .priority = 2, \
+                                .stack_size = 4096, \
                             }, \
-                            .veloc_yaw = { \
-                                .target = 0, \
-                                .proportion = 0, \
-                                .integration = 0, \
-                                .differention = 0, \
-                                .max_abs_output = 1000, \
-                                .configs.limitIntegration = PID_FUNC_ENABLE, \
-                                .configs.autoResetIntegration = PID_FUNC_DISABLE, \
-                                .max_abs_int_output = 250, \
+                            .debugger_listener_task = { \
+                                .core = 0, \
+                                .priority = 5, \
+                                .stack_size = 4096, \
                             }, \
-                            .angle_pitch = { \
-                                .target = 0, \
-                                .proportion = 0.5, \
-                                .integration = 0.003, \
-                                .differention = 0, \
-                                .max_abs_output = 30, \
-                                .configs.limitIntegration = PID_FUNC_ENABLE, \
-                                .configs.autoResetIntegration = PID_FUNC_DISABLE, \
-                                .max_abs_int_output = 3.15, \
+                            .debugger_sender_task = { \
+                                .core = 0, \
+                                .priority = 4, \
+                                .stack_size = 4096, \
                             }, \
-                            .angle_roll = { \
-                                .target = 0, \
-                                .proportion = 0.5, \
-                                .integration = 0.003, \
-                                .differention = 0, \
-                                .max_abs_output = 30, \
-                                .configs.limitIntegration = PID_FUNC_ENABLE, \
-                                .configs.autoResetIntegration = PID_FUNC_DISABLE, \
-                                .max_abs_int_output = 3.15, \
+                            .cache_stress_task = { \
+                                .core = 0, \
+                                .priority = 1, \
+                                .stack_size = 2048, \
                             }, \
-                            .angle_yaw = { \
-                                .target = 0, \
-                                .proportion = 0, \
-                                .integration = 0, \
-                                .differention = 0, \
-                                .max_abs_output = 1000, \
-                                .configs.limitIntegration = PID_FUNC_ENABLE, \
-                                .max_abs_int_output = 250, \
+                        }, \
+                        .deadline = { \
+                            .budget_us = 4000, \
+                            .window = 100, \
+                            .enter_overruns = 10, \
+                            .exit_windows = 3, \
+                            .subscribe_wdt = true, \
+                        }, \
+                        .blackbox = { \
+                            .partition_label = "blackbox", \
+                            .erase_ahead_s = 240, \
+                            .writer_task = { \
+                                .core = 0, \
+                                .priority = 1, \
+                                .stack_size = 3072, \
                             }, \
                         }, \
+                        .pid_param = ESP_DRONE_PID_PARAM, \
 }
 
 #endif
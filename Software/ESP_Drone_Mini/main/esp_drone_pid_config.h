@@ -0,0 +1,100 @@
+#ifndef __ESP_DRONE_PID_CONFIG_H__
+#define __ESP_DRONE_PID_CONFIG_H__
+
+/**
+ * @note: Control configs of the drone. This header has no platform dependencies and is
+ *          shared with the host tools, which also print new ESP_DRONE_PID_PARAM blocks.
+ */
+
+/******************************* control configs ******************************/
+// rps of the full thrust, it must be reachable by every motor: rps(duty = 100) = c + k * ln(100).
+#define ED_MOTOR_MAX_RPS                        (760)
+// gyro and D-term filters running at imu_freq, up to OH_FILTER_MAX_STAGES of { type, center_hz, q }.
+// Off by default: the gains below are tuned without them, and at 100 Hz a 40 Hz gyro + 25 Hz D-term
+// low-pass costs most of the margins(ed_sweep: gain margin 3.22x -> 1.14x, delay margin 1 -> 0 ticks).
+// Retune the gains before enabling them, e.g. { { OH_BIQUAD_LOWPASS, 40, 0.7071f }, }.
+#define ED_GYRO_FILTER_STAGES                   { }
+#define ED_DTERM_FILTER_STAGES                  { }
+
+
+
+
+/******************************************************************************/
+#include "oh_quadrotor_pid.h"
+
+#define ESP_DRONE_PID_PARAM { \
+        .veloc_pitch = { \
+            .target = 0, \
+            .proportion = 1.5, \
+            .integration = 0.1, \
+            .differention = 2.56, \
+            .max_abs_output = 1000, \
+            .configs.limitIntegration = PID_FUNC_ENABLE, \
+            .configs.autoResetIntegration = PID_FUNC_DISABLE, \
+            .max_abs_int_output = 400, \
+        }, \
+        .veloc_roll = { \
+            .target = 0, \
+            .proportion = 1.5, \
+            .integration = 0.1, \
+            .differention = 2.56, \
+            .max_abs_output = 1000, \
+            .configs.limitIntegration = PID_FUNC_ENABLE, \
+            .configs.autoResetIntegration = PID_FUNC_DISABLE, \
+            .max_abs_int_output = 400, \
+        }, \
+        .veloc_yaw = { \
+            .target = 0, \
+            .proportion = 0, \
+            .integration = 0, \
+            .differention = 0, \
+            .max_abs_output = 1000, \
+            .configs.limitIntegration = PID_FUNC_ENABLE, \
+            .configs.autoResetIntegration = PID_FUNC_DISABLE, \
+            .max_abs_int_output = 250, \
+        }, \
+        .angle_pitch = { \
+            .target = 0, \
+            .proportion = 0.5, \
+            .integration = 0.003, \
+            .differention = 0, \
+            .max_abs_output = 30, \
+            .configs.limitIntegration = PID_FUNC_ENABLE, \
+            .configs.autoResetIntegration = PID_FUNC_DISABLE, \
+            .max_abs_int_output = 3.15, \
+        }, \
+        .angle_roll = { \
+            .target = 0, \
+            .proportion = 0.5, \
+            .integration = 0.003, \
+            .differention = 0, \
+            .max_abs_output = 30, \
+            .configs.limitIntegration = PID_FUNC_ENABLE, \
+            .configs.autoResetIntegration = PID_FUNC_DISABLE, \
+            .max_abs_int_output = 3.15, \
+        }, \
+        .angle_yaw = { \
+            .target = 0, \
+            .proportion = 0, \
+            .integration = 0, \
+            .differention = 0, \
+            .max_abs_output = 1000, \
+            .configs.limitIntegration = PID_FUNC_ENABLE, \
+            .max_abs_int_output = 250, \
+        }, \
+        .mixer = { \
+            .geometry = OH_MIXER_QUAD_X, \
+            .airmode = 1, \
+            .output_min = 0, \
+            .output_max = 1, \
+        }, \
+        .schedule = { \
+            .points = 0, \
+            .thrust_min = 0.1, \
+            .thrust_max = 0.9, \
+        }, \
+        .torque_scale = 1.0f / ED_MOTOR_MAX_RPS, \
+        .attitude_mode = OH_QUAD_ATTITUDE_EULER, \
+}
+
+#endif
@@ -1,19 +1,34 @@
 #include "esp_drone_config.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_attr.h"
 #include "esp_check.h"
-#include "esp_task_wdt.h"
+#include "esp_partition.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "ed_blackbox.h"
+#include "ed_deadline.h"
 #include "ed_drivers.h"
 #include "ed_debugger.h"
 #include "ed_imu.h"
+#include "ed_nvs_flash.h"
+#include "ed_param.h"
+#include "ed_param_block.h"
+#include "ed_profiler.h"
+#include "ed_sync.h"
+#include "ed_task.h"
+#include "oh_autotune.h"
+#include "oh_dyn_notch.h"
+#include "oh_filter.h"
+#include "oh_quat.h"
 #include "oh_quadrotor_pid.h"
+#include "oh_sysid.h"
 
 static const char* tag = "app";
 
@@ -21,21 +36,131 @@ static const char* tag = "app";
 static TaskHandle_t motion_control_task_handle = NULL;
 static const UBaseType_t imu_ready_index = 0;
 
-// sensor data.
-static float pitch = 0, roll = 0, yaw = 0;
-static float ax = 0, ay = 0, az = 0;
-static float gx = 0, gy = 0, gz = 0;
-
 // open hover
 static oh_drv_status_t oh_status = { 0 };
 static oh_drv_quadrotor_output_t oh_output = { 0 };
 
+// gyro filter, axes are x, y, z.
+static oh_filter_chain_t gyro_filter;
+
+// dynamic notch, raw gyro goes to the analysis task and notches come back, both through lock-free queues.
+#if(ED_DYN_NOTCH_ENABLE)
+static oh_dyn_notch_t dyn_notch = ED_DYN_NOTCH;
+static oh_filter_chain_t dyn_notch_filter;
+static float gyro_samples_buffer[64][3];
+static ed_spsc_queue_t gyro_samples_queue;
+static oh_dyn_notch_result_t dyn_notch_results_buffer[2];
+static ed_spsc_queue_t dyn_notch_results_queue;
+#endif
+
+// copy of oh_status for telemetry, written by motion control only.
+static oh_drv_status_t status_snapshot = { 0 };
+static ed_seqlock_t status_snapshot_lock = ED_SEQLOCK_INIT;
+
 // drv
 static ed_drv_t drv = ESP_DRONE;
 
+// set by motion control under sustained overload, telemetry is suspended meanwhile.
+static ed_sync_flag_t control_degraded = ED_SYNC_FLAG_INIT(false);
+
+// timing probes of the control loop.
+static ed_profiler_probe_t probe_period = ED_PROFILER_PROBE_INIT("tick.period");
+static ed_profiler_probe_t probe_tick = ED_PROFILER_PROBE_INIT("tick.total");
+// imu: attitude from the DMP, accel and gyro. filter: gyro filters. sync: telemetry snapshot and gain switch.
+static ed_profiler_probe_t probe_imu = ED_PROFILER_PROBE_INIT("imu");
+static ed_profiler_probe_t probe_filter = ED_PROFILER_PROBE_INIT("filter");
+static ed_profiler_probe_t probe_sync = ED_PROFILER_PROBE_INIT("sync");
+static ed_profiler_probe_t probe_control = ED_PROFILER_PROBE_INIT("control");
+static ed_profiler_probe_t probe_output = ED_PROFILER_PROBE_INIT("output");
+
+// heap allocations of the control task since it started to run, it is 0 in a healthy build. Write 0 to reset.
+static int32_t control_heap_allocs = 0;
+
+// tuning: the debugger writes pid_shadow, and a full copy is published to the control task through pid_block.
+static oh_quad_pid_t pid_shadow;
+static oh_quad_pid_t pid_buffers[2];
+static ed_param_block_t pid_block;
+
+// tuning experiments, written by the debugger like the gains and published to the control task through tuning_block.
+typedef struct {
+    uint8_t autotune_start;
+    uint8_t autotune_axis;
+    uint8_t autotune_rule;
+    float autotune_amplitude;
+    float autotune_hysteresis;
+    uint8_t sysid_start;
+    uint8_t sysid_axis;
+    float sysid_amplitude;
+} tuning_request_t;
+static tuning_request_t tuning_shadow;
+static tuning_request_t tuning_buffers[2];
+static ed_param_block_t tuning_block;
+
+// relay autotune, started by writing 1 to tune.start in flight. The control task owns autotune until it
+// sets autotune_finished with the tuned gains, then the telemetry task takes them into pid_shadow, saves
+// them and clears tune.start.
+static oh_autotune_t autotune = ED_AUTOTUNE;
+static oh_quad_rate_gains_t autotune_gains;
+static oh_quad_gain_schedule_t autotune_schedule;
+static float autotune_angle_gains[2];
+static ed_sync_flag_t autotune_finished = ED_SYNC_FLAG_INIT(false);
+static float autotune_ku = 0, autotune_tu = 0;
+
+// chirp identification, started by writing 1 to sysid.start in flight. The control task owns sysid until it
+// sets sysid_finished, then the telemetry task copies the results and clears sysid.start.
+static oh_sysid_t sysid = ED_SYSID;
+static ed_sync_flag_t sysid_finished = ED_SYNC_FLAG_INIT(false);
+static float sysid_gain = 0, sysid_tau = 0, sysid_delay = 0, sysid_fit = 0;
+
+// flight recorder, records are staged while the motors run. Write 1 to bb.clear to erase the partition.
+static uint8_t blackbox_clear = 0;
+
+// encoding of the telemetry, see ed_debugger_tlm_mode_t.
+static uint8_t telemetry_mode = ED_DEBUGGER_TLM_JUSTFLOAT;
+
+#if CONFIG_ED_CACHE_STRESS
+// sweep the blackbox partition through the flash cache, to measure the control pipeline under flash load.
+static uint8_t cache_stress = 0;
+#endif
+
+// NVS keys of the angular velocity gains(oh_quad_rate_gains_t) and of the angle proportions(pitch, roll)
+// set by the autotune, loaded at boot.
+static const char* rate_gains_key = "rate_gains";
+static const char* angle_gains_key = "angle_gains";
+
 // temp for debug
 static float base_rps = 0;
 
+// static functions of the tick, GCC may inline or clone them under other names so they are not mapped
+// by main/linker.lf but placed here.
+#if CONFIG_ED_CONTROL_IN_IRAM
+#define ED_CONTROL_ATTR IRAM_ATTR
+#else
+#define ED_CONTROL_ATTR
+#endif
+
+// register the tunable fields of an oh_pos_pid_t.
+#define ED_REGISTER_PID_PARAMS(prefix, pid) do { \
+        ed_param_register_float(prefix ".p", &((pid).proportion), 0, 1000); \
+        ed_param_register_float(prefix ".i", &((pid).integration), 0, 1000); \
+        ed_param_register_float(prefix ".d", &((pid).differention), 0, 1000); \
+        ed_param_register_float(prefix ".int_max", &((pid).max_abs_int_output), 0, 1000); \
+        ed_param_register_float(prefix ".target", &((pid).target), -1000, 1000); \
+    } while(0)
+
+// register the gains of a point of the gain schedule.
+#define ED_REGISTER_SCHEDULE_PARAMS(prefix, gains) do { \
+        ed_param_register_float(prefix ".veloc_roll.p", &((gains).veloc_roll.proportion), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_roll.i", &((gains).veloc_roll.integration), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_roll.d", &((gains).veloc_roll.differention), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_pitch.p", &((gains).veloc_pitch.proportion), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_pitch.i", &((gains).veloc_pitch.integration), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_pitch.d", &((gains).veloc_pitch.differention), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_yaw.p", &((gains).veloc_yaw.proportion), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_yaw.i", &((gains).veloc_yaw.integration), 0, 1000); \
+        ed_param_register_float(prefix ".veloc_yaw.d", &((gains).veloc_yaw.differention), 0, 1000); \
+    } while(0)
+
 void IRAM_ATTR imu_int_handler(void *args)
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
@@ -43,97 +168,573 @@ void IRAM_ATTR imu_int_handler(void *args)
 }
 
 
+static ED_CONTROL_ATTR void store_rate_gains(oh_quad_rate_gains_t *gains, const oh_quad_pid_t *pid)
+{
+    gains->veloc_pitch = (oh_pid_gains_t){ pid->veloc_pitch.proportion, pid->veloc_pitch.integration, pid->veloc_pitch.differention };
+    gains->veloc_roll = (oh_pid_gains_t){ pid->veloc_roll.proportion, pid->veloc_roll.integration, pid->veloc_roll.differention };
+    gains->veloc_yaw = (oh_pid_gains_t){ pid->veloc_yaw.proportion, pid->veloc_yaw.integration, pid->veloc_yaw.differention };
+}
+
+static void load_rate_gains(oh_quad_pid_t *pid, const oh_quad_rate_gains_t *gains)
+{
+    pid->veloc_pitch.proportion = gains->veloc_pitch.proportion;
+    pid->veloc_pitch.integration = gains->veloc_pitch.integration;
+    pid->veloc_pitch.differention = gains->veloc_pitch.differention;
+    pid->veloc_roll.proportion = gains->veloc_roll.proportion;
+    pid->veloc_roll.integration = gains->veloc_roll.integration;
+    pid->veloc_roll.differention = gains->veloc_roll.differention;
+    pid->veloc_yaw.proportion = gains->veloc_yaw.proportion;
+    pid->veloc_yaw.integration = gains->veloc_yaw.integration;
+    pid->veloc_yaw.differention = gains->veloc_yaw.differention;
+}
+
+// take the result of a finished autotune into the tuning params and save it, after autotune_finished is set.
+static void finish_autotune(void)
+{
+    bool done = autotune.state == OH_AUTOTUNE_DONE;
+    if(done)
+        ESP_LOGI(tag, "autotune: ku %.4f, tu %.3fs, p %.4f, i %.4f, d %.4f.",
+            autotune.ku, autotune.tu, autotune.proportion, autotune.integration, autotune.differention);
+    else
+        ESP_LOGW(tag, "autotune failed.");
+
+    // the control task has applied the gains, keep the shadow in sync so that later writes do not revert them.
+    // The debugger writes the shadow too, so it is updated and published as one batch under the param lock.
+    ed_param_lock();
+    if(done)
+    {
+        autotune_ku = autotune.ku;
+        autotune_tu = autotune.tu;
+        load_rate_gains(&pid_shadow, &autotune_gains);
+        pid_shadow.schedule = autotune_schedule;
+        pid_shadow.angle_pitch.proportion = autotune_angle_gains[0];
+        pid_shadow.angle_roll.proportion = autotune_angle_gains[1];
+    }
+    tuning_shadow.autotune_start = 0;
+    // the control task starts a new autotune on the next 0 to 1 of tune.start only.
+    ed_sync_flag_set(&autotune_finished, false);
+    if(ed_param_commit())
+        ESP_LOGW(tag, "tuned gains are published with the next write.");
+    ed_param_unlock();
+
+    if(done && (ed_nvs_flash_save_blob(rate_gains_key, &autotune_gains, sizeof(autotune_gains))
+        || ed_nvs_flash_save_blob(angle_gains_key, autotune_angle_gains, sizeof(autotune_angle_gains))))
+        ESP_LOGE(tag, "tuned gains are not saved.");
+}
+
+// take the result of a finished identification into its params, after sysid_finished is set.
+static void finish_sysid(void)
+{
+    if(sysid.state == OH_SYSID_DONE)
+        ESP_LOGI(tag, "sysid: gain %.4f, tau %.4fs, delay %.4fs, fit %.3f.", sysid.gain, sysid.tau, sysid.delay, sysid.fit);
+    else
+        ESP_LOGW(tag, "sysid failed.");
+
+    ed_param_lock();
+    if(sysid.state == OH_SYSID_DONE)
+    {
+        sysid_gain = sysid.gain;
+        sysid_tau = sysid.tau;
+        sysid_delay = sysid.delay;
+        sysid_fit = sysid.fit;
+    }
+    tuning_shadow.sysid_start = 0;
+    ed_sync_flag_set(&sysid_finished, false);
+    if(ed_param_commit())
+        ESP_LOGW(tag, "sysid.start is cleared with the next write.");
+    ed_param_unlock();
+}
+
+// stage a blackbox record of this tick.
+static ED_CONTROL_ATTR void record_blackbox(uint32_t tick, uint32_t tick_cycles, bool imu_valid, bool armed, ed_deadline_mode_t mode)
+{
+    ed_bb_record_t record = {
+        .tick = tick,
+        .gyro = {
+            ed_bb_fixed16(oh_status.gx, ED_BB_GYRO_SCALE),
+            ed_bb_fixed16(oh_status.gy, ED_BB_GYRO_SCALE),
+            ed_bb_fixed16(oh_status.gz, ED_BB_GYRO_SCALE),
+        },
+        .target = {
+            ed_bb_fixed16(drv.pid_param.veloc_pitch.target, ED_BB_GYRO_SCALE),
+            ed_bb_fixed16(drv.pid_param.veloc_roll.target, ED_BB_GYRO_SCALE),
+            ed_bb_fixed16(drv.pid_param.veloc_yaw.target, ED_BB_GYRO_SCALE),
+        },
+        .motor = {
+            ed_bb_unorm16(oh_output.m1),
+            ed_bb_unorm16(oh_output.m2),
+            ed_bb_unorm16(oh_output.m3),
+            ed_bb_unorm16(oh_output.m4),
+        },
+        .loop = ed_blackbox_loop_units(tick_cycles),
+        .flags = (imu_valid ? ED_BB_FLAG_IMU_VALID : 0) | (armed ? ED_BB_FLAG_ARMED : 0)
+            | (mode == ED_DEADLINE_DEGRADED ? ED_BB_FLAG_DEGRADED : 0)
+            | (drv.pid_param.autotune ? ED_BB_FLAG_AUTOTUNE : 0) | (drv.pid_param.sysid ? ED_BB_FLAG_SYSID : 0),
+    };
+    // the quaternion is logged as is, the decoder converts it to Euler angles.
+    if(drv.pid_param.attitude_mode == OH_QUAD_ATTITUDE_QUAT)
+    {
+        const float q[4] = { oh_status.q0, oh_status.q1, oh_status.q2, oh_status.q3 };
+        ed_bb_quat_pack(q, record.angle);
+        record.flags |= ED_BB_FLAG_QUAT;
+    } else {
+        record.angle[0] = ed_bb_fixed16(oh_status.pitch, ED_BB_ANGLE_SCALE);
+        record.angle[1] = ed_bb_fixed16(oh_status.roll, ED_BB_ANGLE_SCALE);
+        record.angle[2] = ed_bb_fixed16(oh_status.yaw, ED_BB_ANGLE_SCALE);
+    }
+    ed_blackbox_log(&record);
+}
+
+static int publish_pid_params(void *arg)
+{
+    // both blocks are free before either is published, so a commit is applied whole or not at all.
+    if(ed_param_block_wait(&pid_block, pdMS_TO_TICKS(100))
+        || ed_param_block_wait(&tuning_block, pdMS_TO_TICKS(100)))
+    {
+        ESP_LOGW(tag, "pid params are not consumed by motion control, publish later.");
+        return -1;
+    }
+    ed_param_block_publish(&pid_block, &pid_shadow, 0);
+    ed_param_block_publish(&tuning_block, &tuning_shadow, 0);
+    return 0;
+}
+
 void motion_control_task(void *pvParameters)
 {
     // Count the number of consecutive failures of imu.
     int imu_eular_failed_times = 0;
+    uint32_t last_tick_start = ed_profiler_now();
+    ed_deadline_mode_t mode = ED_DEADLINE_NORMAL;
+    int attitude_divider = 0;
+    uint32_t tick = 0;
+    bool was_armed = false;
+    // the last tuning request, and the experiments requested or running in this task.
+    tuning_request_t tuning = { 0 };
+    bool autotune_requested = false, autotune_running = false;
+    bool sysid_requested = false, sysid_running = false;
+
+    if(ed_deadline_init(&(drv.deadline)))
+        ESP_LOGE(tag, "motion control is not guarded by the task watchdog.");
+    ed_profiler_heap_watch();
+    uint32_t heap_allocs = ed_profiler_heap_allocs();
 
     for( ;; )
     {
         // waiting for imu ready, its frequence is 100hz.
         ulTaskNotifyTakeIndexed(imu_ready_index, pdTRUE, pdMS_TO_TICKS(10)); //pdMS_TO_TICKS(10) or portMAX_DELAY
+
+        uint32_t tick_start = ed_profiler_now();
+        ed_profiler_record(&probe_period, tick_start - last_tick_start);
+        last_tick_start = tick_start;
+        uint32_t stage_start = tick_start;
         
-        // get eular angle.
-        if(ed_imu_get_eular(&pitch, &roll, &yaw) == 0)
-            imu_eular_failed_times = 0;
+        // get attitude, the quaternion controller skips the eular conversion.
+        int imu_ret;
+        if(drv.pid_param.attitude_mode == OH_QUAD_ATTITUDE_QUAT)
+            imu_ret = ed_imu_get_quat(&oh_status.q0, &oh_status.q1, &oh_status.q2, &oh_status.q3);
         else
-            imu_eular_failed_times ++;
+            imu_ret = ed_imu_get_eular(&oh_status.pitch, &oh_status.roll, &oh_status.yaw);
+        if(imu_ret == 0)
+        {
+            if(imu_eular_failed_times >= ED_IMU_MAX_FAILED_TIMES)
+                ESP_LOGI(tag, "imu recovered.");
+            imu_eular_failed_times = 0;
+        } else if(++ imu_eular_failed_times == ED_IMU_MAX_FAILED_TIMES) {
+            ESP_LOGE(tag, "imu failed %d times, motors are cut.", imu_eular_failed_times);
+        }
         
         // get accel and gyro
-        ed_imu_get_accel(&ax, &ay, &az);
-        ed_imu_get_gyro(&gx, &gy, &gz);
+        ed_imu_get_accel(&oh_status.ax, &oh_status.ay, &oh_status.az);
+        ed_imu_get_gyro(&oh_status.gx, &oh_status.gy, &oh_status.gz);
+        stage_start = ed_profiler_record_since(&probe_imu, stage_start);
+
+        // filter gyro.
+        float gyro[3] = { oh_status.gx, oh_status.gy, oh_status.gz };
+#if(ED_DYN_NOTCH_ENABLE)
+        static oh_dyn_notch_result_t dyn_notch_result;
+        ed_spsc_queue_push(&gyro_samples_queue, gyro);
+        if(ed_spsc_queue_pop(&dyn_notch_results_queue, &dyn_notch_result))
+            oh_dyn_notch_load(&dyn_notch_filter, &dyn_notch_result);
+        oh_filter_chain_apply(&dyn_notch_filter, gyro);
+#endif
+        oh_filter_chain_apply(&gyro_filter, gyro);
+        oh_status.gx = gyro[0];
+        oh_status.gy = gyro[1];
+        oh_status.gz = gyro[2];
+        stage_start = ed_profiler_record_since(&probe_filter, stage_start);
 
-        // copy sensor data
-        oh_status.pitch = pitch;
-        oh_status.roll = roll;
-        oh_status.yaw = yaw;
-        oh_status.gx = gx;
-        oh_status.gy = gy;
-        oh_status.gz = gz;
+        // publish sensor data to telemetry.
+        ed_seqlock_write(&status_snapshot_lock, &status_snapshot, &oh_status, sizeof(oh_status));
 
-        // control realize.
-        oh_quad_pid_control_realize(&oh_status, &(drv.pid_param), &oh_output);
+        // switch to the newest gain set at the tick boundary.
+        const oh_quad_pid_t *gains = ed_param_block_acquire(&pid_block);
+        if(gains)
+            oh_quad_pid_load_gains(&(drv.pid_param), gains);
+        // an experiment is requested by a 0 to 1 of its start, and kept until it can be started.
+        const tuning_request_t *request = ed_param_block_acquire(&tuning_block);
+        if(request)
+        {
+            autotune_requested |= request->autotune_start && !tuning.autotune_start;
+            sysid_requested |= request->sysid_start && !tuning.sysid_start;
+            tuning = *request;
+        }
+        stage_start = ed_profiler_record_since(&probe_sync, stage_start);
+
+        // control realize, the attitude loop is decimated in the degraded mode.
+        bool imu_valid = imu_eular_failed_times < ED_IMU_MAX_FAILED_TIMES;
+        if(autotune_requested && !autotune_running && !ed_sync_flag_get(&autotune_finished))
+        {
+            // the relay only identifies the loop in flight.
+            autotune_requested = false;
+            autotune_running = true;
+            autotune.rule = (oh_autotune_rule_t)tuning.autotune_rule;
+            autotune.amplitude = tuning.autotune_amplitude;
+            autotune.hysteresis = tuning.autotune_hysteresis;
+            if(!imu_valid || base_rps <= 1 || drv.pid_param.sysid
+                || oh_quad_pid_autotune_start(&(drv.pid_param), &autotune, tuning.autotune_axis))
+                autotune.state = OH_AUTOTUNE_FAILED;
+        }
+        if(sysid_requested && !sysid_running && !ed_sync_flag_get(&sysid_finished))
+        {
+            // the chirp is only injected in flight, and not together with the relay.
+            sysid_requested = false;
+            sysid_running = true;
+            sysid.amplitude = tuning.sysid_amplitude;
+            if(!imu_valid || base_rps <= 1 || drv.pid_param.autotune
+                || oh_quad_pid_sysid_start(&(drv.pid_param), &sysid, tuning.sysid_axis))
+                sysid.state = OH_SYSID_FAILED;
+        }
+        if(imu_valid)
+        {
+            if(mode == ED_DEADLINE_NORMAL || attitude_divider == 0)
+                oh_quad_pid_attitude_realize(&oh_status, &(drv.pid_param));
+            // the mixer works in thrust space, thrust = (rps / max_rps)^2.
+            float throttle = base_rps / ED_MOTOR_MAX_RPS;
+            oh_quad_pid_rate_realize(&oh_status, &(drv.pid_param), throttle * throttle, &oh_output);
+            attitude_divider = (attitude_divider + 1) % ED_DEGRADED_ATTITUDE_DIVIDER;
+        } else {
+            if(drv.pid_param.autotune)
+                oh_autotune_stop(drv.pid_param.autotune);
+            if(drv.pid_param.sysid)
+                oh_sysid_stop(drv.pid_param.sysid);
+            drv.pid_param.autotune = NULL;
+            drv.pid_param.sysid = NULL;
+        }
+        // the tuning ended(or failed to start), the result is handed to the telemetry task.
+        if(autotune_running && drv.pid_param.autotune == NULL)
+        {
+            autotune_running = false;
+            store_rate_gains(&autotune_gains, &(drv.pid_param));
+            autotune_schedule = drv.pid_param.schedule;
+            autotune_angle_gains[0] = drv.pid_param.angle_pitch.proportion;
+            autotune_angle_gains[1] = drv.pid_param.angle_roll.proportion;
+            ed_sync_flag_set(&autotune_finished, true);
+        }
+        if(sysid_running && drv.pid_param.sysid == NULL)
+        {
+            sysid_running = false;
+            ed_sync_flag_set(&sysid_finished, true);
+        }
+        stage_start = ed_profiler_record_since(&probe_control, stage_start);
 
         // perform output.
-        if(base_rps > 1)
+        bool armed = imu_valid && base_rps > 1;
+        if(armed != was_armed)
+            ed_blackbox_set_armed(armed);
+        if(armed)
         {
-            ed_motor_set_rps(&(drv.drivers.m1), oh_output.m1 + base_rps);
-            ed_motor_set_rps(&(drv.drivers.m2), oh_output.m2 + base_rps);
-            ed_motor_set_rps(&(drv.drivers.m3), oh_output.m3 + base_rps);
-            ed_motor_set_rps(&(drv.drivers.m4), oh_output.m4 + base_rps);
+            ed_motor_set_thrust(&(drv.drivers.m1), oh_output.m1);
+            ed_motor_set_thrust(&(drv.drivers.m2), oh_output.m2);
+            ed_motor_set_thrust(&(drv.drivers.m3), oh_output.m3);
+            ed_motor_set_thrust(&(drv.drivers.m4), oh_output.m4);
         } else {
             ed_motor_set_rps(&(drv.drivers.m1), 0);
             ed_motor_set_rps(&(drv.drivers.m2), 0);
             ed_motor_set_rps(&(drv.drivers.m3), 0);
             ed_motor_set_rps(&(drv.drivers.m4), 0);
         }
+        stage_start = ed_profiler_record_since(&probe_output, stage_start);
+        ed_profiler_record(&probe_tick, stage_start - tick_start);
+
+        // the tick which stops the motors is recorded too, then the staged records are handed over.
+        if(armed || was_armed)
+            record_blackbox(tick, stage_start - tick_start, imu_valid, armed, mode);
+        if(was_armed && !armed)
+            ed_blackbox_flush();
+        was_armed = armed;
+        tick ++;
+
+        // the control path runs without the heap, see heap.allocs.
+        uint32_t allocs = ed_profiler_heap_allocs();
+        control_heap_allocs += allocs - heap_allocs;
+        heap_allocs = allocs;
+
+        // deadline accounting and watchdog feeding.
+        ed_deadline_mode_t next_mode = ed_deadline_tick(&(drv.deadline), tick_start, stage_start);
+        if(next_mode != mode)
+        {
+            mode = next_mode;
+            attitude_divider = 0;
+            ed_sync_flag_set(&control_degraded, mode == ED_DEADLINE_DEGRADED);
+        }
     }
     vTaskDelete( NULL );
 }
 
-void app_main(void)
+void telemetry_task(void *pvParameters)
 {
-    // init all drivers.
-    ed_drivers_init(&(drv.drivers)); 
-
-    // start motion control
-    xTaskCreate(
-        motion_control_task,
-        "motion control",
-        2048,
-        NULL,
-        5,       // uxPriority = 5
-        &motion_control_task_handle
-    );
-
-    // bind parameters to debugger.
-    ed_debugger_bind_float(0, &base_rps);
-    // veloc_roll
-    ed_debugger_bind_float(1, &(drv.pid_param.veloc_roll.proportion));
-    ed_debugger_bind_float(2, &(drv.pid_param.veloc_roll.integration));
-    ed_debugger_bind_float(3, &(drv.pid_param.veloc_roll.differention));
-    ed_debugger_bind_float(4, &(drv.pid_param.veloc_roll.max_abs_int_output));
-    ed_debugger_bind_float(5, &(drv.pid_param.veloc_roll.target));
-    // angle_roll
-    ed_debugger_bind_float(6, &(drv.pid_param.angle_roll.proportion));
-    ed_debugger_bind_float(7, &(drv.pid_param.angle_roll.integration));
-    ed_debugger_bind_float(8, &(drv.pid_param.angle_roll.differention));
-    ed_debugger_bind_float(9, &(drv.pid_param.angle_roll.max_abs_int_output));
-    ed_debugger_bind_float(10, &(drv.pid_param.angle_roll.target));
-
-
-    while(1)
+    for( ;; )
     {
+        // leave the cpu time to the control pipeline under overload.
+        if(ed_sync_flag_get(&control_degraded))
+        {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        if(ed_sync_flag_get(&autotune_finished))
+            finish_autotune();
+        if(ed_sync_flag_get(&sysid_finished))
+            finish_sysid();
+
+        // the erase of the whole partition would stall the control loop, it is refused in flight.
+        if(blackbox_clear)
+        {
+            if(ed_blackbox_clear())
+                ESP_LOGW(tag, "bb.clear is refused, armed or no blackbox.");
+            blackbox_clear = 0;
+        }
+        ed_debugger_set_tlm_mode(telemetry_mode);
+
+        oh_drv_status_t status;
+        ed_seqlock_read(&status_snapshot_lock, &status, &status_snapshot, sizeof(status));
+
+        // eular angles are only needed for display in the quaternion mode.
+        if(drv.pid_param.attitude_mode == OH_QUAD_ATTITUDE_QUAT)
+        {
+            oh_quat_t q = { .w = status.q0, .x = status.q1, .y = status.q2, .z = status.q3 };
+            oh_quat_to_eular(q, &status.pitch, &status.roll, &status.yaw);
+        }
+
         float veloc_int_out = drv.pid_param.veloc_roll._sumError * drv.pid_param.veloc_roll.integration;
         float speed_int_out = drv.pid_param.angle_roll._sumError * drv.pid_param.angle_roll.integration;
 
         // report sensor data.
-        ed_debugger_send_float(pitch, roll, yaw, gx, gy, gz, drv.pid_param.veloc_roll._sumError, veloc_int_out, drv.pid_param.veloc_roll.target, speed_int_out);
+        ed_debugger_send_float(status.pitch, status.roll, status.yaw, status.gx, status.gy, status.gz, drv.pid_param.veloc_roll._sumError, veloc_int_out, drv.pid_param.veloc_roll.target, speed_int_out);
 
         vTaskDelay(pdMS_TO_TICKS(10));
     }
+    vTaskDelete( NULL );
+}
+
+#if(ED_DYN_NOTCH_ENABLE)
+void analysis_task(void *pvParameters)
+{
+    static oh_dyn_notch_result_t result;
+    float sample[3];
+
+    for( ;; )
+    {
+        while(ed_spsc_queue_pop(&gyro_samples_queue, sample))
+        {
+            if(oh_dyn_notch_push(&dyn_notch, sample))
+            {
+                oh_dyn_notch_analyze(&dyn_notch, &result);
+                if(!ed_spsc_queue_push(&dyn_notch_results_queue, &result))
+                    ESP_LOGW(tag, "dynamic notch result is dropped.");
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    vTaskDelete( NULL );
+}
+#endif
 
-//err:
-    while(1) vTaskDelay(pdMS_TO_TICKS(100));
+#if CONFIG_ED_CACHE_STRESS
+/**
+ * @brief: Read the blackbox partition through the flash cache while cache_stress is set.
+ * @note: it evicts the cache and keeps the flash bus busy as Wi-Fi and NVS do under load, the effect on
+ *          the control pipeline shows in tick.total and tick.period, see CONFIG_ED_CONTROL_IN_IRAM.
+ */
+void cache_stress_task(void *pvParameters)
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, drv.blackbox.partition_label);
+    const void *mapped = NULL;
+    esp_partition_mmap_handle_t handle;
+    if(partition == NULL || esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &handle) != ESP_OK)
+    {
+        ESP_LOGE(tag, "cache stress can not map the partition.");
+        vTaskDelete( NULL );
+    }
 
-}
\ No newline at end of file
+    const volatile uint32_t *words = mapped;
+    uint32_t offset = 0;
+    for( ;; )
+    {
+        if(!cache_stress)
+        {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        // a word of each cache line in 64KB, then the idle task of core 0 gets a tick.
+        uint32_t end = offset + 0x10000 < partition->size ? offset + 0x10000 : partition->size;
+        for( ; offset < end; offset += 32)
+            (void)words[offset / 4];
+        if(offset >= partition->size)
+            offset = 0;
+        vTaskDelay(1);
+    }
+    vTaskDelete( NULL );
+}
+#endif
+
+void app_main(void)
+{
+    // init all drivers.
+    ed_drivers_init(&(drv.drivers)); 
+
+    // quantization of the telemetry channels in the compact mode.
+    static const float telemetry_steps[] = ED_TELEMETRY_STEPS;
+    ed_debugger_set_tlm_steps(sizeof(telemetry_steps) / sizeof(telemetry_steps[0]), telemetry_steps);
+
+    // init filters, an invalid configuration leaves the signal unfiltered.
+    static const oh_biquad_config_t gyro_filter_stages[] = ED_GYRO_FILTER_STAGES;
+    static const oh_biquad_config_t dterm_filter_stages[] = ED_DTERM_FILTER_STAGES;
+    if(oh_filter_chain_init(&gyro_filter, 3, drv.drivers.imu_freq, gyro_filter_stages, sizeof(gyro_filter_stages) / sizeof(gyro_filter_stages[0])))
+        ESP_LOGE(tag, "invalid gyro filter configs.");
+    if(oh_filter_chain_init(&(drv.pid_param.dterm_filter), 3, drv.drivers.imu_freq, dterm_filter_stages, sizeof(dterm_filter_stages) / sizeof(dterm_filter_stages[0])))
+        ESP_LOGE(tag, "invalid D-term filter configs.");
+
+#if(ED_DYN_NOTCH_ENABLE)
+    ed_spsc_queue_init(&gyro_samples_queue, gyro_samples_buffer, sizeof(gyro_samples_buffer[0]), 64);
+    ed_spsc_queue_init(&dyn_notch_results_queue, dyn_notch_results_buffer, sizeof(dyn_notch_results_buffer[0]), 2);
+    oh_filter_chain_init(&dyn_notch_filter, 3, drv.drivers.imu_freq, NULL, 0);
+    if(oh_dyn_notch_init(&dyn_notch, drv.drivers.imu_freq) == 0)
+        ed_task_create(analysis_task, "analysis", NULL, &(drv.drivers.analysis_task), NULL);
+    else
+        ESP_LOGE(tag, "invalid dynamic notch configs.");
+#endif
+
+    // init the mixer.
+    if(oh_quad_pid_init(&(drv.pid_param)))
+        ESP_LOGE(tag, "invalid mixer configs.");
+
+    // gains of the last autotune override the configured ones.
+    oh_quad_rate_gains_t saved_gains;
+    if(ed_nvs_flash_load_blob(rate_gains_key, &saved_gains, sizeof(saved_gains)) == 0)
+    {
+        load_rate_gains(&(drv.pid_param), &saved_gains);
+        ESP_LOGI(tag, "angular velocity gains are loaded from nvs.");
+    }
+    float saved_angle_gains[2];
+    if(ed_nvs_flash_load_blob(angle_gains_key, saved_angle_gains, sizeof(saved_angle_gains)) == 0)
+    {
+        drv.pid_param.angle_pitch.proportion = saved_angle_gains[0];
+        drv.pid_param.angle_roll.proportion = saved_angle_gains[1];
+        ESP_LOGI(tag, "angle gains are loaded from nvs.");
+    }
+
+    // start the gain schedule from the constant gains.
+    oh_quad_pid_schedule_from_gains(&(drv.pid_param));
+    autotune.sample_hz = drv.drivers.imu_freq;
+
+    // the identification models the gyro filter of the control task.
+    memcpy(sysid.filter, gyro_filter_stages, sizeof(gyro_filter_stages));
+    sysid.filter_stages = sizeof(gyro_filter_stages) / sizeof(gyro_filter_stages[0]);
+    sysid.sample_hz = drv.drivers.imu_freq;
+
+    // init the double-buffered tuning params.
+    pid_shadow = drv.pid_param;
+    ed_param_block_init(&pid_block, &pid_buffers[0], &pid_buffers[1], sizeof(oh_quad_pid_t), &pid_shadow);
+    tuning_shadow = (tuning_request_t){
+        .autotune_axis = OH_QUAD_AXIS_ROLL,
+        .autotune_rule = OH_AUTOTUNE_RULE_SOME_OVERSHOOT,
+        .autotune_amplitude = autotune.amplitude,
+        .autotune_hysteresis = autotune.hysteresis,
+        .sysid_axis = OH_QUAD_AXIS_ROLL,
+        .sysid_amplitude = sysid.amplitude,
+    };
+    ed_param_block_init(&tuning_block, &tuning_buffers[0], &tuning_buffers[1], sizeof(tuning_request_t), &tuning_shadow);
+
+    // register timing probes, dump them with ED_DBG_CMD_PROFILE.
+    ed_profiler_register(&probe_period);
+    ed_profiler_register(&probe_tick);
+    ed_profiler_register(&probe_imu);
+    ed_profiler_register(&probe_filter);
+    ed_profiler_register(&probe_sync);
+    ed_profiler_register(&probe_control);
+    ed_profiler_register(&probe_output);
+
+    // start the flight recorder before motion control, which feeds it.
+    drv.blackbox.sample_hz = drv.drivers.imu_freq;
+    if(ed_blackbox_init(&(drv.blackbox)))
+        ESP_LOGE(tag, "blackbox is disabled.");
+
+    // motion control is released by the imu, its deadline is measured from the expected release.
+    drv.deadline.period_us = 1000000 / drv.drivers.imu_freq;
+
+    // start motion control, it owns a core with a high priority.
+    ed_task_create(motion_control_task, "motion control", NULL, &(drv.drivers.control_task), &motion_control_task_handle);
+
+    // register parameters to debugger.
+    // NOTE: the registration order keeps ids 0~10 compatible with the legacy VOFA+ bindings.
+    ed_param_register_float("base_rps", &base_rps, 0, 1000);
+    ED_REGISTER_PID_PARAMS("veloc_roll", pid_shadow.veloc_roll);
+    ED_REGISTER_PID_PARAMS("angle_roll", pid_shadow.angle_roll);
+    ED_REGISTER_PID_PARAMS("veloc_pitch", pid_shadow.veloc_pitch);
+    ED_REGISTER_PID_PARAMS("angle_pitch", pid_shadow.angle_pitch);
+    ED_REGISTER_PID_PARAMS("veloc_yaw", pid_shadow.veloc_yaw);
+    ED_REGISTER_PID_PARAMS("angle_yaw", pid_shadow.angle_yaw);
+
+    // gain schedule of angular velocity pids, it overrides their gains when sched.points >= 2.
+    ed_param_register_uint8("sched.points", &(pid_shadow.schedule.points), 0, OH_QUAD_SCHEDULE_MAX_POINTS);
+    // the points are in normalized thrust (rps / max_rps)^2, the collective of oh_quad_pid_rate_realize.
+    ed_param_register_float("sched.thrust_min", &(pid_shadow.schedule.thrust_min), 0, 1);
+    ed_param_register_float("sched.thrust_max", &(pid_shadow.schedule.thrust_max), 0, 1);
+    ED_REGISTER_SCHEDULE_PARAMS("sched.0", pid_shadow.schedule.gains[0]);
+    ED_REGISTER_SCHEDULE_PARAMS("sched.1", pid_shadow.schedule.gains[1]);
+    ED_REGISTER_SCHEDULE_PARAMS("sched.2", pid_shadow.schedule.gains[2]);
+    ED_REGISTER_SCHEDULE_PARAMS("sched.3", pid_shadow.schedule.gains[3]);
+    ED_REGISTER_SCHEDULE_PARAMS("sched.4", pid_shadow.schedule.gains[4]);
+    ed_param_set_commit_callback(publish_pid_params, NULL);
+
+    // deadline counters, write 0 to reset.
+    ed_param_register_int32("deadline.overruns", &(drv.deadline.overruns), 0, 0);
+    ed_param_register_int32("deadline.degraded", &(drv.deadline.degraded_times), 0, 0);
+    ed_param_register_int32("deadline.lateness", &(drv.deadline.max_lateness_us), 0, 0);
+    ed_param_register_int32("heap.allocs", &control_heap_allocs, 0, 0);
+
+    // relay autotune, the axis is OH_QUAD_AXIS_* and the rule is oh_autotune_rule_t. ku and tu are results.
+    ed_param_register_uint8("tune.axis", &(tuning_shadow.autotune_axis), OH_QUAD_AXIS_PITCH, OH_QUAD_AXIS_YAW);
+    ed_param_register_uint8("tune.rule", &(tuning_shadow.autotune_rule), OH_AUTOTUNE_RULE_CLASSIC, OH_AUTOTUNE_RULE_NO_OVERSHOOT);
+    ed_param_register_float("tune.amp", &(tuning_shadow.autotune_amplitude), 0, 1000);
+    ed_param_register_float("tune.hyst", &(tuning_shadow.autotune_hysteresis), 0, 100);
+    ed_param_register_float("tune.ku", &autotune_ku, 0, 0);
+    ed_param_register_float("tune.tu", &autotune_tu, 0, 0);
+    ed_param_register_uint8("tune.start", &(tuning_shadow.autotune_start), 0, 1);
+
+    // chirp identification, the axis is OH_QUAD_AXIS_*. gain, tau, delay and fit are results, see oh_sysid_t.
+    ed_param_register_uint8("sysid.axis", &(tuning_shadow.sysid_axis), OH_QUAD_AXIS_PITCH, OH_QUAD_AXIS_YAW);
+    ed_param_register_float("sysid.amp", &(tuning_shadow.sysid_amplitude), 0, 1000);
+    ed_param_register_float("sysid.gain", &sysid_gain, 0, 0);
+    ed_param_register_float("sysid.tau", &sysid_tau, 0, 0);
+    ed_param_register_float("sysid.delay", &sysid_delay, 0, 0);
+    ed_param_register_float("sysid.fit", &sysid_fit, 0, 0);
+    ed_param_register_uint8("sysid.start", &(tuning_shadow.sysid_start), 0, 1);
+
+    // flight recorder.
+    ed_param_register_uint8("bb.clear", &blackbox_clear, 0, 1);
+
+    // telemetry, 0 for JustFloat and 1 for the compact frames.
+    ed_param_register_uint8("tlm.mode", &telemetry_mode, ED_DEBUGGER_TLM_JUSTFLOAT, ED_DEBUGGER_TLM_COMPACT);
+
+#if CONFIG_ED_CACHE_STRESS
+    // flash cache stress, compare the tick probes with 0 and 1.
+    ed_param_register_uint8("prof.stress", &cache_stress, 0, 1);
+    ed_task_create(cache_stress_task, "cache stress", NULL, &(drv.drivers.cache_stress_task), NULL);
+#endif
+
+    // start telemetry, it shares the other core with Wi-Fi and the debugger.
+    ed_task_create(telemetry_task, "telemetry", NULL, &(drv.drivers.telemetry_task), NULL);
+}
@@ -0,0 +1,200 @@
+/**
+ * @note: Check of the quaternion attitude loop of oh_quadrotor_pid.c(OH_QUAD_ATTITUDE_QUAT) over the attitude sphere.
+ *          The angle pids are pure gains of 1, so the angular velocity targets are the attitude errors in degree.
+ *          Setpoints cover pitch -90~90 including the gimbal lock, roll and yaw -180~180, and the attitude is
+ *          the setpoint turned back by a known rotation, so the expected targets are exact:
+ *              - tilt: a rotation about a horizontal body axis up to 180(upside down to the setpoint), the roll
+ *                and pitch targets are 2 sin(angle / 2) along the axis and the yaw target is 0. Upside down
+ *                the axis is free, the tilt target is still 2 rad and horizontal.
+ *              - heading: a rotation about the body z axis, only the yaw target moves, and the yaw wrap of
+ *                the Euler setpoint(179 against -179) takes the short way.
+ *              - euler: away from the gimbal lock(|pitch| and |roll| up to 45), small errors give the targets
+ *                of the Euler path(OH_QUAD_ATTITUDE_EULER) mapped to body rates.
+ *          The process fails if any check fails.
+ *
+ *          usage: ed_attitude_check
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "oh_quadrotor_pid.h"
+
+#define RAD_TO_DEG                      (57.29577951308232)
+#define DEG_TO_RAD                      (0.017453292519943295)
+
+// float pipeline against the double reference, in degree.
+#define CHECK_TOLERANCE                 (0.02)
+// second order terms of the Euler comparison, relative to the error.
+#define CHECK_EULER_TOLERANCE           (0.02)
+#define CHECK_EULER_ERROR               (0.5)
+
+static int failures = 0;
+static int checks = 0;
+
+static void expect(int ok, const char* what, const float sp[3], double angle, const double got[3], const double want[3])
+{
+    checks ++;
+    if(ok)
+        return;
+    failures ++;
+    printf("FAIL: %s, setpoint pitch %.0f roll %.0f yaw %.0f, angle %.1f: roll %.4f pitch %.4f yaw %.4f, expected %.4f %.4f %.4f.\n",
+        what, sp[0], sp[1], sp[2], angle, got[0], got[1], got[2], want[0], want[1], want[2]);
+}
+
+// angular velocity targets { roll, pitch, yaw } of an attitude against the Euler setpoint { pitch, roll, yaw }.
+static void targets(oh_quad_attitude_mode_t mode, const float sp[3], oh_quat_t q, double out[3])
+{
+    oh_quad_pid_t pid = { .attitude_mode = mode };
+    oh_pos_pid_t* angles[] = { &pid.angle_pitch, &pid.angle_roll, &pid.angle_yaw };
+    for(int i = 0; i < 3; i++)
+    {
+        angles[i]->proportion = 1;
+        angles[i]->max_abs_output = 1e6f;
+        angles[i]->target = sp[i];
+    }
+
+    oh_drv_status_t status = { .q0 = q.w, .q1 = q.x, .q2 = q.y, .q3 = q.z };
+    oh_quat_to_eular(q, &status.pitch, &status.roll, &status.yaw);
+    oh_quad_pid_attitude_realize(&status, &pid);
+    out[0] = pid.veloc_roll.target;
+    out[1] = pid.veloc_pitch.target;
+    out[2] = pid.veloc_yaw.target;
+}
+
+// the setpoint turned back by angle about the body axis, the attitude loop has to turn it forward.
+static oh_quat_t turned_back(oh_quat_t sp, const double axis[3], double angle)
+{
+    double s = sin(-angle * DEG_TO_RAD / 2);
+    oh_quat_t r = { .w = cos(-angle * DEG_TO_RAD / 2), .x = axis[0] * s, .y = axis[1] * s, .z = axis[2] * s };
+    return oh_quat_mul(sp, r);
+}
+
+static int all_finite(const double v[3])
+{
+    return isfinite(v[0]) && isfinite(v[1]) && isfinite(v[2]);
+}
+
+static void check_tilt(const float sp[3], oh_quat_t sp_quat)
+{
+    static const double angles[] = { 1, 30, 90, 150, 179, 180 };
+    for(int dir = 0; dir < 360; dir += 45)
+    {
+        double axis[3] = { cos(dir * DEG_TO_RAD), sin(dir * DEG_TO_RAD), 0 };
+        for(size_t i = 0; i < sizeof(angles) / sizeof(angles[0]); i++)
+        {
+            double got[3];
+            targets(OH_QUAD_ATTITUDE_QUAT, sp, turned_back(sp_quat, axis, angles[i]), got);
+            double size = 2 * sin(angles[i] * DEG_TO_RAD / 2) * RAD_TO_DEG;
+            double want[3] = { size * axis[0], size * axis[1], 0 };
+            if(angles[i] == 180)
+            {
+                // upside down, the axis is free but horizontal.
+                double tilt = sqrt(got[0] * got[0] + got[1] * got[1]);
+                expect(all_finite(got) && fabs(tilt - size) < CHECK_TOLERANCE, "upside down tilt", sp, angles[i], got, want);
+                continue;
+            }
+            int ok = all_finite(got);
+            for(int j = 0; j < 3; j++)
+                ok = ok && fabs(got[j] - want[j]) < CHECK_TOLERANCE;
+            expect(ok, "tilt", sp, angles[i], got, want);
+        }
+    }
+}
+
+static void check_heading(const float sp[3], oh_quat_t sp_quat)
+{
+    static const double angles[] = { -179, -150, -90, -30, -1, 1, 30, 90, 150, 179 };
+    static const double axis[3] = { 0, 0, 1 };
+    for(size_t i = 0; i < sizeof(angles) / sizeof(angles[0]); i++)
+    {
+        double got[3];
+        targets(OH_QUAD_ATTITUDE_QUAT, sp, turned_back(sp_quat, axis, angles[i]), got);
+        double want[3] = { 0, 0, 2 * sin(angles[i] * DEG_TO_RAD / 2) * RAD_TO_DEG };
+        int ok = all_finite(got);
+        for(int j = 0; j < 3; j++)
+            ok = ok && fabs(got[j] - want[j]) < CHECK_TOLERANCE;
+        expect(ok, "heading", sp, angles[i], got, want);
+    }
+}
+
+// 179 against -179 is 2 the short way, at any tilt of the setpoint.
+static void check_yaw_wrap(void)
+{
+    for(int pitch = -60; pitch <= 60; pitch += 30)
+    {
+        for(int roll = -60; roll <= 60; roll += 30)
+        {
+            for(int side = -1; side <= 1; side += 2)
+            {
+                float sp[3] = { pitch, roll, 179 * side };
+                double got[3];
+                targets(OH_QUAD_ATTITUDE_QUAT, sp, oh_quat_from_eular(pitch, roll, -179 * side), got);
+
+                // the heading error around the world z axis, seen in body.
+                double size = 2 * sin(-2 * side * DEG_TO_RAD / 2) * RAD_TO_DEG;
+                double p = pitch * DEG_TO_RAD, r = roll * DEG_TO_RAD;
+                double want[3] = { -sin(p) * size, sin(r) * cos(p) * size, cos(r) * cos(p) * size };
+                int ok = all_finite(got);
+                for(int j = 0; j < 3; j++)
+                    ok = ok && fabs(got[j] - want[j]) < CHECK_TOLERANCE + CHECK_EULER_TOLERANCE * fabs(size);
+                expect(ok, "yaw wrap", sp, -2 * side, got, want);
+            }
+        }
+    }
+}
+
+// small errors against the Euler path, its targets are Euler rates and are mapped to body rates.
+static void check_euler(const float sp[3])
+{
+    for(int i = 0; i < 4; i++)
+    {
+        double d_roll = (i & 1) ? CHECK_EULER_ERROR : -CHECK_EULER_ERROR;
+        double d_pitch = (i & 2) ? CHECK_EULER_ERROR : -CHECK_EULER_ERROR;
+        oh_quat_t q = oh_quat_from_eular(sp[0] - d_pitch, sp[1] - d_roll, sp[2]);
+
+        double euler[3], got[3];
+        targets(OH_QUAD_ATTITUDE_EULER, sp, q, euler);
+        targets(OH_QUAD_ATTITUDE_QUAT, sp, q, got);
+        double r = sp[1] * DEG_TO_RAD;
+        double want[3] = { euler[0], cos(r) * euler[1], -sin(r) * euler[1] };
+        int ok = all_finite(got) && fabs(euler[0] - d_roll) < CHECK_TOLERANCE && fabs(euler[1] - d_pitch) < CHECK_TOLERANCE;
+        for(int j = 0; j < 3; j++)
+            ok = ok && fabs(got[j] - want[j]) < CHECK_TOLERANCE + CHECK_EULER_TOLERANCE * CHECK_EULER_ERROR;
+        expect(ok, "euler", sp, CHECK_EULER_ERROR, got, want);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    while((opt = getopt(argc, argv, "h")) != -1)
+        goto usage;
+    if(optind != argc)
+        goto usage;
+
+    for(int pitch = -90; pitch <= 90; pitch += 15)
+    {
+        for(int roll = -180; roll <= 180; roll += 45)
+        {
+            for(int yaw = -180; yaw <= 180; yaw += 45)
+            {
+                float sp[3] = { pitch, roll, yaw };
+                oh_quat_t sp_quat = oh_quat_from_eular(sp[0], sp[1], sp[2]);
+                check_tilt(sp, sp_quat);
+                check_heading(sp, sp_quat);
+                if(abs(pitch) <= 45 && abs(roll) <= 45)
+                    check_euler(sp);
+            }
+        }
+    }
+    check_yaw_wrap();
+
+    printf("checks: %d attitudes, %d failures.\n", checks, failures);
+    return failures ? 1 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+/**
+ * @note: Host run of the relay autotune of OpenHover against the simulator.
+ *          The simulated drone hovers with ESP_DRONE_PID_PARAM, then the pitch, roll and yaw
+ *          angular velocity pids are tuned one after another exactly as on board(see
+ *          `oh_quad_pid_autotune_start`), and the standard maneuver of ed_sim is flown with
+ *          the initial and the tuned gains.
+ *          The process fails if an axis is not tuned(2), or if the tuned gains do not cut the iae of the
+ *          maneuver by AUTOTUNE_MIN_IMPROVEMENT or diverge(3).
+ *
+ *          usage: ed_autotune [-u rule] [-A amplitude] [-H hysteresis] [-c cycles] [-l latency] [-r random seed]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "esp_drone_pid_config.h"
+#include "ed_sim.h"
+#include "oh_autotune.h"
+
+// time limit of an axis and the hover in between, s.
+#define AUTOTUNE_AXIS_SECONDS           (30)
+#define AUTOTUNE_HOVER_SECONDS          (1)
+// the tuned iae must be below this share of the initial one.
+#define AUTOTUNE_MIN_IMPROVEMENT        (0.5f)
+
+static const char* axis_names[] = { "veloc_pitch", "veloc_roll", "veloc_yaw" };
+static const char* state_names[] = { "idle", "running", "done", "failed" };
+
+static void hover(ed_sim_flight_t* flight, float seconds)
+{
+    int ticks = (int)(seconds / flight->sim.params.dt);
+    for(int i = 0; i < ticks; i++)
+        ed_sim_flight_tick(flight, NULL);
+}
+
+static void print_result(const char* name, const ed_sim_result_t* result)
+{
+    printf("  %-8s iae %8.3f deg*s, overshoot %6.1f%%, disturbance peak %6.2f deg, saturation %5.1f%%%s\n",
+        name, result->iae, result->overshoot, result->disturbance_peak, result->saturation * 100,
+        result->diverged ? ", diverged" : "");
+}
+
+int main(int argc, char** argv)
+{
+    oh_autotune_t at = {
+        .amplitude = 60,
+        .hysteresis = 2,
+        .settle_cycles = 2,
+        .cycles = 4,
+        .rule = OH_AUTOTUNE_RULE_SOME_OVERSHOOT,
+    };
+    ed_sim_params_t params;
+    ed_sim_default_params(&params);
+
+    int opt;
+    while((opt = getopt(argc, argv, "u:A:H:c:l:r:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'u': at.rule = (oh_autotune_rule_t)atoi(optarg); break;
+        case 'A': at.amplitude = atof(optarg); break;
+        case 'H': at.hysteresis = atof(optarg); break;
+        case 'c': at.cycles = atoi(optarg); break;
+        case 'l': params.latency = atoi(optarg); break;
+        case 'r': params.seed = strtoull(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-u rule] [-A amplitude] [-H hysteresis] [-c cycles] [-l latency] [-r random seed]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    at.sample_hz = 1.0f / params.dt;
+    at.max_ticks = (uint32_t)(AUTOTUNE_AXIS_SECONDS * at.sample_hz);
+
+    const oh_quad_pid_t initial = ESP_DRONE_PID_PARAM;
+    ed_sim_flight_t flight;
+    ed_sim_flight_init(&flight, &params, &initial);
+    hover(&flight, AUTOTUNE_HOVER_SECONDS);
+
+    float elapsed = AUTOTUNE_HOVER_SECONDS;
+    int failed = 0;
+    for(int axis = OH_QUAD_AXIS_PITCH; axis <= OH_QUAD_AXIS_YAW; axis++)
+    {
+        if(oh_quad_pid_autotune_start(&flight.pid, &at, axis))
+        {
+            fprintf(stderr, "invalid autotune configs\n");
+            return 1;
+        }
+
+        int ticks = 0;
+        while(flight.pid.autotune)
+        {
+            ed_sim_flight_tick(&flight, NULL);
+            ticks ++;
+        }
+        elapsed += ticks * params.dt;
+
+        printf("%-12s %-6s after %5.2f s", axis_names[axis], state_names[at.state], ticks * params.dt);
+        if(at.state == OH_AUTOTUNE_DONE)
+            printf(": Ku %.4g, Tu %.3f s -> P %.4g, I %.4g, D %.4g", at.ku, at.tu, at.proportion, at.integration, at.differention);
+        if(at.state == OH_AUTOTUNE_DONE && axis != OH_QUAD_AXIS_YAW)
+            printf(", angle P %.3g", axis == OH_QUAD_AXIS_PITCH ? flight.pid.angle_pitch.proportion : flight.pid.angle_roll.proportion);
+        printf("\n");
+        failed += at.state != OH_AUTOTUNE_DONE;
+
+        hover(&flight, AUTOTUNE_HOVER_SECONDS);
+        elapsed += AUTOTUNE_HOVER_SECONDS;
+    }
+    printf("tuned in %.1f s of flight\n", elapsed);
+
+    // the tuned gains from a fresh hover.
+    oh_quad_pid_t tuned = initial;
+    oh_quad_pid_load_gains(&tuned, &flight.pid);
+
+    ed_sim_result_t before, after;
+    ed_sim_fly(&params, &initial, 10, &before);
+    ed_sim_fly(&params, &tuned, 10, &after);
+    printf("standard maneuver:\n");
+    print_result("initial", &before);
+    print_result("tuned", &after);
+    if(failed)
+        return 2;
+    if(after.diverged || !(after.iae <= AUTOTUNE_MIN_IMPROVEMENT * before.iae))
+    {
+        printf("FAIL: the tuned iae is not below %.0f%% of the initial one.\n", AUTOTUNE_MIN_IMPROVEMENT * 100);
+        return 3;
+    }
+    return 0;
+}
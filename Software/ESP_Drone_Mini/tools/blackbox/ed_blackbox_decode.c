@@ -0,0 +1,143 @@
+/**
+ * @note: Decoder of a blackbox partition dump, see drivers/blackbox/ed_blackbox_format.h.
+ *          Dump the partition with `parttool.py read_partition --partition-name blackbox --output blackbox.bin`.
+ *          Records are printed as CSV in physical units, oldest first. With -l, only the sessions
+ *          are listed. Quaternions logged in the quaternion attitude mode are printed as Euler angles.
+ *
+ *          usage: ed_blackbox_decode [-l] [-s session] blackbox.bin
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ed_blackbox_log.h"
+#include "ed_flash_emu.h"
+#include "oh_quat.h"
+
+typedef struct {
+    uint32_t session;
+    uint32_t sectors;
+    uint32_t records;
+    uint32_t first_tick;
+    uint32_t last_tick;
+    uint32_t dropped;
+    uint16_t sample_hz;
+} session_summary_t;
+
+// pitch, roll, yaw of a record in deg.
+static void record_angle(const ed_bb_record_t* r, float angle[3])
+{
+    if(r->flags & ED_BB_FLAG_QUAT)
+    {
+        float q[4];
+        ed_bb_quat_unpack(r->angle, q);
+        oh_quat_to_eular((oh_quat_t){ .w = q[0], .x = q[1], .y = q[2], .z = q[3] }, &angle[0], &angle[1], &angle[2]);
+        return;
+    }
+    for(int i = 0; i < 3; i++)
+        angle[i] = (float)r->angle[i] / ED_BB_ANGLE_SCALE;
+}
+
+static void print_record(const ed_bb_sector_header_t* header, const ed_bb_record_t* r)
+{
+    float angle[3];
+    record_angle(r, angle);
+    printf("%lu,%lu,%.3f,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f,%.1f,%.1f,%.1f,%.4f,%.4f,%.4f,%.4f,%d,0x%02x\n",
+        (unsigned long)header->session, (unsigned long)r->tick, header->sample_hz ? (double)r->tick / header->sample_hz : 0.0,
+        (double)r->gyro[0] / ED_BB_GYRO_SCALE, (double)r->gyro[1] / ED_BB_GYRO_SCALE, (double)r->gyro[2] / ED_BB_GYRO_SCALE,
+        (double)angle[0], (double)angle[1], (double)angle[2],
+        (double)r->target[0] / ED_BB_GYRO_SCALE, (double)r->target[1] / ED_BB_GYRO_SCALE, (double)r->target[2] / ED_BB_GYRO_SCALE,
+        (double)r->motor[0] / ED_BB_MOTOR_SCALE, (double)r->motor[1] / ED_BB_MOTOR_SCALE,
+        (double)r->motor[2] / ED_BB_MOTOR_SCALE, (double)r->motor[3] / ED_BB_MOTOR_SCALE,
+        r->loop * ED_BB_LOOP_UNIT_US, r->flags);
+}
+
+int main(int argc, char** argv)
+{
+    int list = 0;
+    long session = -1;
+
+    int opt;
+    while((opt = getopt(argc, argv, "ls:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'l': list = 1; break;
+        case 's': session = strtol(optarg, NULL, 0); break;
+        default:
+            goto usage;
+        }
+    }
+    if(optind != argc - 1)
+        goto usage;
+
+    ed_flash_emu_t emu;
+    if(ed_flash_emu_load(&emu, argv[optind]))
+    {
+        fprintf(stderr, "can not read %s.\n", argv[optind]);
+        return 1;
+    }
+    ed_bb_flash_t flash = ed_flash_emu_bind(&emu);
+    uint32_t total = flash.size / ED_BB_SECTOR_SIZE;
+    uint32_t* sectors = malloc(total * sizeof(uint32_t));
+    session_summary_t* summaries = calloc(total, sizeof(session_summary_t));
+    if(sectors == NULL || summaries == NULL)
+        return 1;
+
+    int n = ed_bb_ring_order(&flash, sectors);
+    int sessions = 0;
+    static ed_bb_record_t records[ED_BB_RECORDS_PER_SECTOR];
+    ed_bb_sector_header_t header;
+
+    if(!list)
+        printf("session,tick,time,gx,gy,gz,pitch,roll,yaw,target_pitch,target_roll,target_yaw,m1,m2,m3,m4,loop_us,flags\n");
+    for(int i = 0; i < n; i++)
+    {
+        ed_bb_read_header(&flash, sectors[i], &header);
+        int count = ed_bb_read_records(&flash, sectors[i], records);
+        if(count < 0)
+            continue;
+
+        // sessions are contiguous in the ring.
+        if(sessions == 0 || summaries[sessions - 1].session != header.session)
+        {
+            summaries[sessions] = (session_summary_t){
+                .session = header.session,
+                .first_tick = count ? records[0].tick : 0,
+                .sample_hz = header.sample_hz,
+            };
+            sessions ++;
+        }
+        session_summary_t* summary = &summaries[sessions - 1];
+        summary->sectors ++;
+        summary->records += count;
+        for(int j = 0; j < count; j++)
+        {
+            summary->last_tick = records[j].tick;
+            summary->dropped += (records[j].flags & ED_BB_FLAG_DROPPED) != 0;
+            if(!list && (session < 0 || session == header.session))
+                print_record(&header, &records[j]);
+        }
+    }
+
+    if(list)
+    {
+        printf("%-8s %8s %8s %10s %10s %10s %8s\n", "session", "sectors", "records", "first", "last", "seconds", "drops");
+        for(int i = 0; i < sessions; i++)
+        {
+            session_summary_t* s = &summaries[i];
+            printf("%-8lu %8lu %8lu %10lu %10lu %10.2f %8lu\n", (unsigned long)s->session, (unsigned long)s->sectors,
+                (unsigned long)s->records, (unsigned long)s->first_tick, (unsigned long)s->last_tick,
+                s->sample_hz ? (double)(s->last_tick - s->first_tick + 1) / s->sample_hz : 0.0, (unsigned long)s->dropped);
+        }
+    }
+
+    free(sectors);
+    free(summaries);
+    ed_flash_emu_deinit(&emu);
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-l] [-s session] blackbox.bin\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+/**
+ * @note: Host run of the blackbox writer on an emulated partition.
+ *          Several boots fly the simulator and log every tick through ed_bb_log_t, as the writer task of
+ *          ed_blackbox.c: the sectors are erased ahead before the flight(-e sectors, all by default), the
+ *          flight appends the staging batches within the erased run and discards the rest, and the last
+ *          batch is written after the disarming. With -c, every boot but the last one ends with a power
+ *          cut in the middle of a flash write.
+ *          The ring is then decoded and checked: no erase in flight, no write over programmed bits, ticks
+ *          without gaps inside a session but after ED_BB_FLAG_DROPPED, the newest session complete up to
+ *          the erased run, and at most one erase of a sector per lap of the ring.
+ *          The image can be saved for ed_blackbox_decode.
+ *
+ *          usage: ed_blackbox_emu [-k partition KB] [-b boots] [-t seconds per boot] [-e sectors erased ahead] [-c] [-r random seed] [-o image]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "esp_drone_pid_config.h"
+#include "ed_blackbox_log.h"
+#include "ed_flash_emu.h"
+#include "ed_sim.h"
+
+// records handed to the writer at once, as ED_BLACKBOX_STAGE_RECORDS of ed_blackbox.h.
+#define EMU_STAGE_RECORDS               (64)
+
+static void make_record(const ed_sim_flight_t* flight, uint32_t tick, ed_bb_record_t* record)
+{
+    const oh_drv_status_t* s = &flight->status;
+    const oh_quad_pid_t* pid = &flight->pid;
+    *record = (ed_bb_record_t){
+        .tick = tick,
+        .gyro = { ed_bb_fixed16(s->gx, ED_BB_GYRO_SCALE), ed_bb_fixed16(s->gy, ED_BB_GYRO_SCALE), ed_bb_fixed16(s->gz, ED_BB_GYRO_SCALE) },
+        .angle = { ed_bb_fixed16(s->pitch, ED_BB_ANGLE_SCALE), ed_bb_fixed16(s->roll, ED_BB_ANGLE_SCALE), ed_bb_fixed16(s->yaw, ED_BB_ANGLE_SCALE) },
+        .target = {
+            ed_bb_fixed16(pid->veloc_pitch.target, ED_BB_GYRO_SCALE),
+            ed_bb_fixed16(pid->veloc_roll.target, ED_BB_GYRO_SCALE),
+            ed_bb_fixed16(pid->veloc_yaw.target, ED_BB_GYRO_SCALE),
+        },
+        .motor = {
+            ed_bb_unorm16(flight->output.m1), ed_bb_unorm16(flight->output.m2),
+            ed_bb_unorm16(flight->output.m3), ed_bb_unorm16(flight->output.m4),
+        },
+        .loop = 20,
+        .flags = ED_BB_FLAG_IMU_VALID | ED_BB_FLAG_ARMED,
+    };
+}
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t logged;
+    uint32_t flight_erases;
+} boot_result_t;
+
+// fly a boot with the sectors erased ahead, until the power cut if any.
+static boot_result_t fly_boot(ed_flash_emu_t* emu, const ed_sim_params_t* params, uint32_t ticks, uint32_t ahead, int power_cut, uint64_t* rng)
+{
+    boot_result_t result = { 0 };
+    ed_bb_log_t log = { .flash = ed_flash_emu_bind(emu), .sample_hz = (uint16_t)lroundf(1.0f / params->dt) };
+    if(ed_bb_log_open(&log))
+        return result;
+
+    // disarmed, then nothing is erased until the last batch.
+    while(log.erased < ahead && log.erased < log.flash.size / ED_BB_SECTOR_SIZE - 1)
+    {
+        if(ed_bb_log_prepare(&log, ahead))
+            break;
+    }
+    uint32_t erases = log.erases;
+    int discarding = 0;
+
+    // the cut falls in a random write of this boot.
+    if(power_cut)
+        emu->cut_after = 1 + (int64_t)(ed_sim_randu(rng) * ticks * ED_BB_RECORD_SIZE);
+
+    const oh_quad_pid_t pid = ESP_DRONE_PID_PARAM;
+    static ed_sim_flight_t flight;
+    ed_sim_flight_init(&flight, params, &pid);
+
+    ed_bb_record_t stage[EMU_STAGE_RECORDS];
+    uint32_t staged = 0, tick;
+    for(tick = 0; tick < ticks; tick++)
+    {
+        // slow angle sweeps, so that the records are not constant.
+        float t = tick * params->dt;
+        flight.pid.angle_roll.target = 10 * sinf(0.7f * t);
+        flight.pid.angle_pitch.target = 10 * sinf(0.45f * t);
+        ed_sim_flight_tick(&flight, NULL);
+
+        make_record(&flight, tick, &stage[staged++]);
+        if(staged == EMU_STAGE_RECORDS)
+        {
+            uint32_t room = ed_bb_log_room(&log);
+            discarding |= staged > room;
+            ed_bb_log_append(&log, stage, staged > room ? room : staged);
+            staged = 0;
+        }
+        if(power_cut && emu->cut_after == 0)
+            break;
+    }
+    result.flight_erases = log.erases - erases;
+    if(!power_cut && staged > 0)
+    {
+        if(discarding)
+            stage[0].flags |= ED_BB_FLAG_DROPPED;
+        ed_bb_log_append(&log, stage, staged);
+    }
+
+    emu->cut_after = -1;
+    result.ticks = tick;
+    result.logged = log.records;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t kb = 64;
+    int boots = 4;
+    float seconds = 20;
+    uint32_t ahead = UINT32_MAX;
+    int power_cut = 0;
+    const char* output = NULL;
+    ed_sim_params_t params;
+    ed_sim_default_params(&params);
+
+    int opt;
+    while((opt = getopt(argc, argv, "k:b:t:e:cr:o:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'k': kb = strtoul(optarg, NULL, 0); break;
+        case 'b': boots = atoi(optarg); break;
+        case 't': seconds = atof(optarg); break;
+        case 'e': ahead = strtoul(optarg, NULL, 0); break;
+        case 'c': power_cut = 1; break;
+        case 'r': params.seed = strtoull(optarg, NULL, 0); break;
+        case 'o': output = optarg; break;
+        default:
+            goto usage;
+        }
+    }
+    if(boots < 1 || !(seconds > 0))
+        goto usage;
+
+    ed_flash_emu_t emu;
+    if(ed_flash_emu_init(&emu, kb * 1024 - (kb * 1024) % ED_BB_SECTOR_SIZE))
+    {
+        fprintf(stderr, "invalid partition size.\n");
+        return 1;
+    }
+    ed_bb_flash_t flash = ed_flash_emu_bind(&emu);
+    uint32_t total = flash.size / ED_BB_SECTOR_SIZE;
+
+    uint64_t rng = params.seed ^ 0x9E3779B97F4A7C15ull;
+    boot_result_t last = { 0 };
+    uint32_t flight_erases = 0;
+    for(int boot = 0; boot < boots; boot++)
+    {
+        int cut = power_cut && boot < boots - 1;
+        params.seed ++;
+        last = fly_boot(&emu, &params, (uint32_t)(seconds / params.dt), ahead, cut, &rng);
+        flight_erases += last.flight_erases;
+        printf("boot %d: %lu ticks, %lu logged%s\n", boot, (unsigned long)last.ticks, (unsigned long)last.logged, cut ? ", power cut" : "");
+    }
+
+    // decode and check the ring.
+    uint32_t* sectors = malloc(total * sizeof(uint32_t));
+    if(sectors == NULL)
+        return 1;
+    int n = ed_bb_ring_order(&flash, sectors);
+    static ed_bb_record_t records[ED_BB_RECORDS_PER_SECTOR];
+    ed_bb_sector_header_t header;
+    int failures = 0, sessions = 0;
+    uint32_t session = 0, expected_tick = 0, session_records = 0, session_first = 0, sequences = 0;
+    for(int i = 0; i < n; i++)
+    {
+        ed_bb_read_header(&flash, sectors[i], &header);
+        sequences = header.sequence + 1;
+        int count = ed_bb_read_records(&flash, sectors[i], records);
+        if(sessions == 0 || header.session != session)
+        {
+            session = header.session;
+            session_first = count ? records[0].tick : 0;
+            expected_tick = session_first;
+            session_records = 0;
+            sessions ++;
+        }
+        for(int j = 0; j < count; j++)
+        {
+            if(records[j].tick != expected_tick && !(records[j].flags & ED_BB_FLAG_DROPPED))
+            {
+                printf("session %lu: tick %lu follows %lu.\n", (unsigned long)session, (unsigned long)records[j].tick, (unsigned long)expected_tick - 1);
+                failures ++;
+            }
+            expected_tick = records[j].tick + 1;
+            session_records ++;
+        }
+    }
+
+    // the newest session holds everything written, it never laps the erased run.
+    if(session_first != 0 || session_records != last.logged)
+    {
+        printf("newest session: %lu records from tick %lu, %lu expected.\n",
+            (unsigned long)session_records, (unsigned long)session_first, (unsigned long)last.logged);
+        failures ++;
+    }
+    if(flight_erases)
+    {
+        printf("%lu erases in flight.\n", (unsigned long)flight_erases);
+        failures ++;
+    }
+    if(emu.violations)
+    {
+        printf("%lu writes over programmed bits.\n", (unsigned long)emu.violations);
+        failures ++;
+    }
+
+    uint32_t min_erases = UINT32_MAX, max_erases = 0;
+    for(uint32_t i = 0; i < total; i++)
+    {
+        if(emu.erase_counts[i] < min_erases)
+            min_erases = emu.erase_counts[i];
+        if(emu.erase_counts[i] > max_erases)
+            max_erases = emu.erase_counts[i];
+    }
+    // blank sectors are not erased, so a sector is erased at most once per lap, plus a retry after a torn header.
+    uint32_t laps = (sequences + total - 1) / total;
+    if(max_erases > laps + (power_cut ? 1 : 0))
+    {
+        printf("uneven wear, %lu erases of a sector in %lu laps.\n", (unsigned long)max_erases, (unsigned long)laps);
+        failures ++;
+    }
+
+    printf("\n%lu sectors, %d valid, %d sessions, erases per sector %lu~%lu: %s\n", (unsigned long)total, n, sessions,
+        (unsigned long)min_erases, (unsigned long)max_erases, failures ? "FAILED" : "ok");
+    if(output && ed_flash_emu_save(&emu, output))
+    {
+        fprintf(stderr, "can not write %s.\n", output);
+        failures ++;
+    }
+
+    free(sectors);
+    ed_flash_emu_deinit(&emu);
+    return failures ? 2 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-k partition KB] [-b boots] [-t seconds per boot] [-e sectors erased ahead] [-c] [-r random seed] [-o image]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
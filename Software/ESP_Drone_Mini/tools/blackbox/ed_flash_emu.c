@@ -0,0 +1,176 @@
+#include "ed_flash_emu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int __ed_flash_emu_read(void* ctx, uint32_t offset, void* data, uint32_t size)
+{
+    ed_flash_emu_t* emu = ctx;
+    if(offset > emu->size || size > emu->size - offset)
+        return -1;
+    memcpy(data, emu->data + offset, size);
+    return 0;
+}
+
+static int __ed_flash_emu_write(void* ctx, uint32_t offset, const void* data, uint32_t size)
+{
+    ed_flash_emu_t* emu = ctx;
+    if(offset > emu->size || size > emu->size - offset || emu->cut_after == 0)
+        return -1;
+
+    // a power cut tears the write.
+    uint32_t n = size;
+    if(emu->cut_after > 0 && emu->cut_after < size)
+        n = (uint32_t)emu->cut_after;
+
+    const uint8_t* bytes = data;
+    for(uint32_t i = 0; i < n; i++)
+    {
+        if(bytes[i] & ~emu->data[offset + i])
+            emu->violations ++;
+        emu->data[offset + i] &= bytes[i];
+    }
+    if(emu->cut_after > 0)
+        emu->cut_after -= n;
+    return n == size ? 0 : -1;
+}
+
+static int __ed_flash_emu_erase(void* ctx, uint32_t offset, uint32_t size)
+{
+    ed_flash_emu_t* emu = ctx;
+    if(offset % ED_BB_SECTOR_SIZE || size % ED_BB_SECTOR_SIZE || offset > emu->size
+        || size > emu->size - offset || emu->cut_after == 0)
+        return -1;
+
+    memset(emu->data + offset, 0xFF, size);
+    for(uint32_t sector = offset / ED_BB_SECTOR_SIZE; sector < (offset + size) / ED_BB_SECTOR_SIZE; sector++)
+        emu->erase_counts[sector] ++;
+    return 0;
+}
+
+/**
+ * @brief: Create an erased emulator of size bytes, a multiple of ED_BB_SECTOR_SIZE.
+ * @return: 0 if success.
+ */
+int ed_flash_emu_init(ed_flash_emu_t* emu, uint32_t size)
+{
+    memset(emu, 0x00, sizeof(ed_flash_emu_t));
+    if(size == 0 || size % ED_BB_SECTOR_SIZE)
+        return -1;
+
+    emu->data = malloc(size);
+    emu->erase_counts = calloc(size / ED_BB_SECTOR_SIZE, sizeof(uint32_t));
+    if(emu->data == NULL || emu->erase_counts == NULL)
+    {
+        ed_flash_emu_deinit(emu);
+        return -1;
+    }
+    memset(emu->data, 0xFF, size);
+    emu->size = size;
+    emu->cut_after = -1;
+    return 0;
+}
+
+void ed_flash_emu_deinit(ed_flash_emu_t* emu)
+{
+    free(emu->data);
+    free(emu->erase_counts);
+    emu->data = NULL;
+    emu->erase_counts = NULL;
+}
+
+/**
+ * @brief: Get the ed_bb_flash_t which accesses emu.
+ */
+ed_bb_flash_t ed_flash_emu_bind(ed_flash_emu_t* emu)
+{
+    return (ed_bb_flash_t){
+        .read = __ed_flash_emu_read,
+        .write = __ed_flash_emu_write,
+        .erase = __ed_flash_emu_erase,
+        .ctx = emu,
+        .size = emu->size,
+    };
+}
+
+/**
+ * @brief: Save the content, the same format as a partition dump.
+ * @return: 0 if success.
+ */
+int ed_flash_emu_save(const ed_flash_emu_t* emu, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if(file == NULL)
+        return -1;
+    size_t written = fwrite(emu->data, 1, emu->size, file);
+    return (fclose(file) == 0 && written == emu->size) ? 0 : -1;
+}
+
+/**
+ * @brief: Wrap a partition dump(read only), the size is rounded down to sectors.
+ * @return: 0 if success.
+ */
+int ed_flash_emu_load(ed_flash_emu_t* emu, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if(file == NULL)
+        return -1;
+
+    int ret = -1;
+    long size = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    if(size >= ED_BB_SECTOR_SIZE && fseek(file, 0, SEEK_SET) == 0
+        && ed_flash_emu_init(emu, (uint32_t)(size - size % ED_BB_SECTOR_SIZE)) == 0)
+    {
+        ret = fread(emu->data, 1, emu->size, file) == emu->size ? 0 : -1;
+        // no more writes.
+        emu->cut_after = 0;
+    }
+    fclose(file);
+    return ret;
+}
+
+/**
+ * @brief: Valid sectors of the ring, oldest first.
+ * @param:
+ *      - uint32_t* sectors : room for size / ED_BB_SECTOR_SIZE indexes.
+ * @return: number of valid sectors.
+ */
+int ed_bb_ring_order(const ed_bb_flash_t* flash, uint32_t* sectors)
+{
+    uint32_t total = flash->size / ED_BB_SECTOR_SIZE;
+    uint32_t* sequences = malloc(total * sizeof(uint32_t));
+    if(sequences == NULL)
+        return 0;
+
+    // sequences are compared with wrap-around, relative to the newest one.
+    int n = 0;
+    uint32_t newest = 0;
+    ed_bb_sector_header_t header;
+    for(uint32_t sector = 0; sector < total; sector++)
+    {
+        if(!ed_bb_read_header(flash, sector, &header))
+            continue;
+        if(n == 0 || (int32_t)(header.sequence - newest) > 0)
+            newest = header.sequence;
+        sectors[n] = sector;
+        sequences[n] = header.sequence;
+        n ++;
+    }
+
+    // insertion sort by age, the ring is short.
+    for(int i = 1; i < n; i++)
+    {
+        uint32_t sector = sectors[i], sequence = sequences[i];
+        int j = i - 1;
+        for( ; j >= 0 && (int32_t)(sequences[j] - newest) > (int32_t)(sequence - newest); j--)
+        {
+            sectors[j + 1] = sectors[j];
+            sequences[j + 1] = sequences[j];
+        }
+        sectors[j + 1] = sector;
+        sequences[j + 1] = sequence;
+    }
+    free(sequences);
+    return n;
+}
@@ -0,0 +1,67 @@
+#ifndef __ED_FLASH_EMU_H__
+#define __ED_FLASH_EMU_H__
+
+#include <stdint.h>
+
+#include "ed_blackbox_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief: NOR flash emulator of a partition, in RAM.
+ * @param:
+ *      @status(read only):
+ *          uint32_t* erase_counts : erases of each sector.
+ *          uint32_t violations    : writes which tried to set a cleared bit, the flash would keep it cleared.
+ *      @configs:
+ *          int64_t cut_after      : bytes to write before a power cut, negative for none. The write which
+ *                                   crosses it is torn, then every operation fails until it is reset.
+ */
+typedef struct {
+    uint8_t* data;
+    uint32_t size;
+    uint32_t* erase_counts;
+    uint32_t violations;
+    int64_t cut_after;
+} ed_flash_emu_t;
+
+/**
+ * @brief: Create an erased emulator of size bytes, a multiple of ED_BB_SECTOR_SIZE.
+ * @return: 0 if success.
+ */
+int ed_flash_emu_init(ed_flash_emu_t* emu, uint32_t size);
+
+void ed_flash_emu_deinit(ed_flash_emu_t* emu);
+
+/**
+ * @brief: Get the ed_bb_flash_t which accesses emu.
+ */
+ed_bb_flash_t ed_flash_emu_bind(ed_flash_emu_t* emu);
+
+/**
+ * @brief: Save the content, the same format as a partition dump.
+ * @return: 0 if success.
+ */
+int ed_flash_emu_save(const ed_flash_emu_t* emu, const char* path);
+
+/**
+ * @brief: Wrap a partition dump(read only), the size is rounded down to sectors.
+ * @return: 0 if success.
+ */
+int ed_flash_emu_load(ed_flash_emu_t* emu, const char* path);
+
+/**
+ * @brief: Valid sectors of the ring, oldest first.
+ * @param:
+ *      - uint32_t* sectors : room for size / ED_BB_SECTOR_SIZE indexes.
+ * @return: number of valid sectors.
+ */
+int ed_bb_ring_order(const ed_bb_flash_t* flash, uint32_t* sectors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,261 @@
+/**
+ * @note: Telemetry capture of ed_debugger.
+ *          Connects to the debugger port of the drone(or reads a stream from stdin with `-`), splits the
+ *          JustFloat stream in place in a receive buffer and appends every packet as a row of a columnar
+ *          capture file, see ed_capture_file.h. The connection is retried until SIGINT/SIGTERM or the
+ *          end of -t, the file is flushed every second so hours of capture survive a crash.
+ *          The number of channels is taken from the first packet unless -n is given, packets with
+ *          another number of channels are counted and dropped.
+ *          Compact telemetry can be captured through `ed_tlm_decode - | ed_capture -o out.edc -`.
+ *          With -d, a capture file is printed as CSV instead.
+ *
+ *          usage: ed_capture [-p port] [-n channels] [-b block rows] [-t seconds] [-o output] host|-
+ *                 ed_capture -d capture
+ */
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "ed_capture_file.h"
+#include "ed_justfloat.h"
+
+#define CAPTURE_BUFFER_SIZE             (1 << 20)
+#define CAPTURE_FLUSH_NS                (1000000000ll)
+
+typedef struct {
+    ed_cap_writer_t writer;
+    const char* output;
+    uint32_t channels;
+    uint32_t block_rows;
+    uint64_t bytes;
+    uint64_t packets;
+    uint64_t dropped;
+    uint64_t connections;
+} capture_t;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static int64_t now_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int connect_to(const char* host, const char* port)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* result;
+    if(getaddrinfo(host, port, &hints, &result))
+        return -1;
+
+    int fd = -1;
+    for(struct addrinfo* ai = result; ai && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if(fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen))
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+/**
+ * @brief: Split the complete packets of data into rows.
+ * @return: bytes consumed, the rest is a partial packet.
+ */
+static size_t parse(capture_t* capture, const uint8_t* data, size_t len, int64_t time_ns)
+{
+    size_t words = len / 4, word = 0;
+    while(word < words)
+    {
+        size_t tail = word + ed_justfloat_find_tail(data + 4 * word, words - word);
+        if(tail == words)
+        {
+            // a packet never exceeds ED_CAP_MAX_CHANNELS, skip garbage without a tail.
+            if(words - word > ED_CAP_MAX_CHANNELS)
+            {
+                capture->dropped ++;
+                word = words - ED_CAP_MAX_CHANNELS;
+            }
+            break;
+        }
+
+        uint32_t n = tail - word;
+        if(capture->channels == 0 && n >= 1 && n <= ED_CAP_MAX_CHANNELS)
+        {
+            if(ed_cap_writer_open(&capture->writer, capture->output, n, capture->block_rows))
+            {
+                fprintf(stderr, "can not write %s.\n", capture->output);
+                stop = 1;
+                return len;
+            }
+            capture->channels = n;
+        }
+
+        // the packet is appended straight from the receive buffer.
+        if(n == capture->channels)
+        {
+            ed_cap_writer_append(&capture->writer, time_ns, (const float*)(data + 4 * word));
+            capture->packets ++;
+        } else {
+            capture->dropped ++;
+        }
+        word = tail + 1;
+    }
+    return 4 * word;
+}
+
+static int dump(const char* path)
+{
+    ed_cap_reader_t reader;
+    if(ed_cap_reader_open(&reader, path))
+    {
+        fprintf(stderr, "can not read %s.\n", path);
+        return 1;
+    }
+
+    printf("time_ns");
+    for(uint32_t i = 0; i < reader.channels; i++)
+        printf(",ch%lu", (unsigned long)i);
+    printf("\n");
+
+    const float* columns[ED_CAP_MAX_CHANNELS];
+    const int64_t* time;
+    for(uint64_t block = 0; block < reader.blocks; block++)
+    {
+        uint32_t rows = ed_cap_reader_block(&reader, block, &time, columns);
+        for(uint32_t row = 0; row < rows; row++)
+        {
+            printf("%lld", (long long)time[row]);
+            for(uint32_t i = 0; i < reader.channels; i++)
+                printf(",%g", columns[i][row]);
+            printf("\n");
+        }
+    }
+    ed_cap_reader_close(&reader);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* port = "8080";
+    static capture_t capture = { .output = "capture.edc", .block_rows = ED_CAP_DEFAULT_BLOCK_ROWS, .writer._fd = -1 };
+    double seconds = 0;
+
+    int opt;
+    while((opt = getopt(argc, argv, "p:n:b:t:o:d:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'p': port = optarg; break;
+        case 'n': capture.channels = strtoul(optarg, NULL, 0); break;
+        case 'b': capture.block_rows = strtoul(optarg, NULL, 0); break;
+        case 't': seconds = atof(optarg); break;
+        case 'o': capture.output = optarg; break;
+        case 'd': return dump(optarg);
+        default:
+            goto usage;
+        }
+    }
+    if(optind != argc - 1 || capture.channels > ED_CAP_MAX_CHANNELS)
+        goto usage;
+
+    // no SA_RESTART, so that a blocking call returns on the signal.
+    struct sigaction action = { .sa_handler = on_signal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // the writer is opened by the first packet when the channels are unknown.
+    if(capture.channels && ed_cap_writer_open(&capture.writer, capture.output, capture.channels, capture.block_rows))
+    {
+        fprintf(stderr, "can not write %s.\n", capture.output);
+        return 1;
+    }
+
+    static uint8_t buffer[CAPTURE_BUFFER_SIZE];
+    const char* host = argv[optind];
+    int from_stdin = !strcmp(host, "-");
+    int64_t start = now_ns(CLOCK_MONOTONIC), last_flush = start;
+    while(!stop)
+    {
+        int fd = from_stdin ? STDIN_FILENO : connect_to(host, port);
+        if(fd < 0)
+        {
+            fprintf(stderr, "can not connect to %s:%s, retry.\n", host, port);
+            sleep(1);
+            if(seconds > 0 && now_ns(CLOCK_MONOTONIC) - start >= seconds * 1e9)
+                stop = 1;
+            continue;
+        }
+        capture.connections ++;
+
+        // a new stream starts aligned.
+        size_t len = 0;
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        while(!stop)
+        {
+            int64_t now = now_ns(CLOCK_MONOTONIC);
+            if(seconds > 0 && now - start >= seconds * 1e9)
+                stop = 1;
+            if(now - last_flush >= CAPTURE_FLUSH_NS)
+            {
+                ed_cap_writer_flush(&capture.writer);
+                last_flush = now;
+            }
+
+            if(poll(&pfd, 1, 200) <= 0)
+                continue;
+            ssize_t n = read(fd, buffer + len, sizeof(buffer) - len);
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                break;
+
+            capture.bytes += n;
+            len += n;
+            size_t used = parse(&capture, buffer, len, now_ns(CLOCK_REALTIME));
+            memmove(buffer, buffer + used, len - used);
+            len -= used;
+        }
+
+        if(from_stdin)
+            break;
+        close(fd);
+        if(!stop)
+            fprintf(stderr, "connection closed, reconnect.\n");
+    }
+
+    double elapsed = (now_ns(CLOCK_MONOTONIC) - start) / 1e9;
+    fprintf(stderr, "%llu packets of %lu channels, %llu dropped, %llu bytes in %.2f s(%.2f MB/s), %llu connections.\n",
+        (unsigned long long)capture.packets, (unsigned long)capture.channels, (unsigned long long)capture.dropped,
+        (unsigned long long)capture.bytes, elapsed, capture.bytes / elapsed / 1e6, (unsigned long long)capture.connections);
+    if(capture.channels && ed_cap_writer_close(&capture.writer))
+    {
+        fprintf(stderr, "can not write %s.\n", capture.output);
+        return 1;
+    }
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-p port] [-n channels] [-b block rows] [-t seconds] [-o output] host|-\n"
+        "       %s -d capture\n", argv[0], argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#include "ed_capture_file.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int __ed_cap_pwrite(int fd, const void* data, size_t size, off_t offset)
+{
+    const uint8_t* bytes = data;
+    while(size)
+    {
+        ssize_t n = pwrite(fd, bytes, size, offset);
+        if(n <= 0)
+            return -1;
+        bytes += n;
+        size -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+size_t ed_cap_block_size(uint32_t channels, uint32_t block_rows)
+{
+    return sizeof(ed_cap_block_header_t) + (size_t)block_rows * (sizeof(int64_t) + channels * sizeof(float));
+}
+
+/**
+ * @brief: Create a capture file.
+ * @param:
+ *      - uint32_t block_rows : rows per block, even.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_open(ed_cap_writer_t* writer, const char* path, uint32_t channels, uint32_t block_rows)
+{
+    memset(writer, 0x00, sizeof(ed_cap_writer_t));
+    writer->_fd = -1;
+    if(channels < 1 || channels > ED_CAP_MAX_CHANNELS || block_rows < 2 || block_rows % 2)
+        return -1;
+
+    writer->_channels = channels;
+    writer->_block_rows = block_rows;
+    writer->_block_size = ed_cap_block_size(channels, block_rows);
+    writer->_block = calloc(1, writer->_block_size);
+    if(writer->_block == NULL)
+        return -1;
+
+    writer->_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ed_cap_header_t header = { .channels = channels, .block_rows = block_rows };
+    memcpy(header.magic, ED_CAP_MAGIC, sizeof(header.magic));
+    if(writer->_fd < 0 || __ed_cap_pwrite(writer->_fd, &header, sizeof(header), 0))
+    {
+        ed_cap_writer_close(writer);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief: Append a row of writer->_channels values.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_append(ed_cap_writer_t* writer, int64_t time_ns, const float* values)
+{
+    // columns of the block, the time column follows the block header.
+    uint8_t* columns = writer->_block + sizeof(ed_cap_block_header_t);
+    uint32_t row = writer->_block_fill;
+    memcpy(columns + row * sizeof(int64_t), &time_ns, sizeof(int64_t));
+    columns += (size_t)writer->_block_rows * sizeof(int64_t);
+    for(uint32_t i = 0; i < writer->_channels; i++)
+        memcpy(columns + ((size_t)i * writer->_block_rows + row) * sizeof(float), &values[i], sizeof(float));
+
+    writer->rows ++;
+    if(++ writer->_block_fill < writer->_block_rows)
+        return 0;
+
+    // the block is full, start the next one.
+    int ret = ed_cap_writer_flush(writer);
+    writer->_block_index ++;
+    writer->_block_fill = 0;
+    return ret;
+}
+
+/**
+ * @brief: Write the current block, including its partial rows.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_flush(ed_cap_writer_t* writer)
+{
+    if(writer->_block_fill == 0)
+        return 0;
+
+    ed_cap_block_header_t* header = (ed_cap_block_header_t*)writer->_block;
+    header->rows = writer->_block_fill;
+    header->first_row = writer->_block_index * writer->_block_rows;
+    return __ed_cap_pwrite(writer->_fd, writer->_block, writer->_block_size,
+        sizeof(ed_cap_header_t) + writer->_block_index * writer->_block_size);
+}
+
+/**
+ * @brief: Flush and close.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_close(ed_cap_writer_t* writer)
+{
+    int ret = 0;
+    if(writer->_fd >= 0)
+    {
+        ret = ed_cap_writer_flush(writer);
+        if(close(writer->_fd))
+            ret = -1;
+    }
+    free(writer->_block);
+    writer->_block = NULL;
+    writer->_fd = -1;
+    return ret;
+}
+
+/**
+ * @brief: Map a capture file.
+ * @return: 0 if success.
+ */
+int ed_cap_reader_open(ed_cap_reader_t* reader, const char* path)
+{
+    memset(reader, 0x00, sizeof(ed_cap_reader_t));
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return -1;
+
+    struct stat st;
+    if(fstat(fd, &st) || st.st_size < (off_t)sizeof(ed_cap_header_t))
+    {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+        return -1;
+    reader->_data = data;
+    reader->_size = st.st_size;
+
+    const ed_cap_header_t* header = data;
+    if(memcmp(header->magic, ED_CAP_MAGIC, sizeof(header->magic)) || header->channels < 1
+        || header->channels > ED_CAP_MAX_CHANNELS || header->block_rows < 2 || header->block_rows % 2)
+    {
+        ed_cap_reader_close(reader);
+        return -1;
+    }
+    reader->channels = header->channels;
+    reader->block_rows = header->block_rows;
+    reader->_block_size = ed_cap_block_size(header->channels, header->block_rows);
+    reader->blocks = (reader->_size - sizeof(ed_cap_header_t)) / reader->_block_size;
+    for(uint64_t block = 0; block < reader->blocks; block++)
+        reader->rows += ed_cap_reader_block(reader, block, NULL, NULL);
+    return 0;
+}
+
+void ed_cap_reader_close(ed_cap_reader_t* reader)
+{
+    if(reader->_data)
+        munmap((void*)reader->_data, reader->_size);
+    reader->_data = NULL;
+}
+
+/**
+ * @brief: Get the columns of a block.
+ * @param:
+ *      - const int64_t** time  : the time column.
+ *      - const float** columns : room for reader->channels columns.
+ * @return: valid rows of the block.
+ */
+uint32_t ed_cap_reader_block(const ed_cap_reader_t* reader, uint64_t block, const int64_t** time, const float** columns)
+{
+    if(block >= reader->blocks)
+        return 0;
+
+    const uint8_t* data = reader->_data + sizeof(ed_cap_header_t) + block * reader->_block_size;
+    const ed_cap_block_header_t* header = (const ed_cap_block_header_t*)data;
+    data += sizeof(ed_cap_block_header_t);
+    if(time)
+        *time = (const int64_t*)data;
+    data += (size_t)reader->block_rows * sizeof(int64_t);
+    for(uint32_t i = 0; columns && i < reader->channels; i++)
+        columns[i] = (const float*)(data + (size_t)i * reader->block_rows * sizeof(float));
+    return header->rows < reader->block_rows ? header->rows : reader->block_rows;
+}
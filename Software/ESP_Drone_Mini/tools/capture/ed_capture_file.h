@@ -0,0 +1,128 @@
+#ifndef __ED_CAPTURE_FILE_H__
+#define __ED_CAPTURE_FILE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @note: Columnar capture file of the telemetry, designed to be mmap-ed.
+ *          All fields are little-endian:
+ *              | ed_cap_header_t | block 0 | block 1 | ... |
+ *          Every block has the same size, so block k is at sizeof(ed_cap_header_t) + k * block size:
+ *              | ed_cap_block_header_t | int64 time[block_rows] | float channel 0[block_rows] | ... |
+ *          time is CLOCK_REALTIME in ns at the reception of the row. rows of the block header tells the
+ *          valid rows, only the last block may be partial. block_rows is even, so that the columns are
+ *          aligned to their types.
+ */
+
+#define ED_CAP_MAGIC                    "EDCAPT01"
+#define ED_CAP_MAX_CHANNELS             (64)
+#define ED_CAP_DEFAULT_BLOCK_ROWS       (4096)
+
+typedef struct {
+    char magic[8];
+    uint32_t channels;
+    uint32_t block_rows;
+    uint8_t reserved[48];
+} ed_cap_header_t;
+
+typedef struct {
+    uint32_t rows;
+    uint32_t reserved;
+    uint64_t first_row;
+} ed_cap_block_header_t;
+
+_Static_assert(sizeof(ed_cap_header_t) == 64, "unexpected padding in ed_cap_header_t");
+_Static_assert(sizeof(ed_cap_block_header_t) == 16, "unexpected padding in ed_cap_block_header_t");
+
+/**
+ * @brief: Writer of a capture file.
+ * @param:
+ *      @status(read only):
+ *          uint64_t rows     : rows appended.
+ * @note: the current block is rewritten in place by `ed_cap_writer_flush`, so an interrupted capture
+ *          only loses the rows since the last flush.
+ */
+typedef struct {
+    // status
+    uint64_t rows;
+
+    // private realizations.
+    int _fd;
+    uint32_t _channels;
+    uint32_t _block_rows;
+    uint32_t _block_fill;
+    uint64_t _block_index;
+    uint8_t* _block;
+    size_t _block_size;
+} ed_cap_writer_t;
+
+/**
+ * @brief: Reader of a capture file, mapped in memory.
+ */
+typedef struct {
+    uint32_t channels;
+    uint32_t block_rows;
+    uint64_t blocks;
+    uint64_t rows;
+
+    // private realizations.
+    const uint8_t* _data;
+    size_t _size;
+    size_t _block_size;
+} ed_cap_reader_t;
+
+size_t ed_cap_block_size(uint32_t channels, uint32_t block_rows);
+
+/**
+ * @brief: Create a capture file.
+ * @param:
+ *      - uint32_t block_rows : rows per block, even.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_open(ed_cap_writer_t* writer, const char* path, uint32_t channels, uint32_t block_rows);
+
+/**
+ * @brief: Append a row of writer->_channels values.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_append(ed_cap_writer_t* writer, int64_t time_ns, const float* values);
+
+/**
+ * @brief: Write the current block, including its partial rows.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_flush(ed_cap_writer_t* writer);
+
+/**
+ * @brief: Flush and close.
+ * @return: 0 if success.
+ */
+int ed_cap_writer_close(ed_cap_writer_t* writer);
+
+/**
+ * @brief: Map a capture file.
+ * @return: 0 if success.
+ */
+int ed_cap_reader_open(ed_cap_reader_t* reader, const char* path);
+
+void ed_cap_reader_close(ed_cap_reader_t* reader);
+
+/**
+ * @brief: Get the columns of a block.
+ * @param:
+ *      - const int64_t** time  : the time column.
+ *      - const float** columns : room for reader->channels columns.
+ * @return: valid rows of the block.
+ */
+uint32_t ed_cap_reader_block(const ed_cap_reader_t* reader, uint64_t block, const int64_t** time, const float** columns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
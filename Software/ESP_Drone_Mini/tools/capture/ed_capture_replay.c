@@ -0,0 +1,226 @@
+/**
+ * @note: Stand-in of the ed_debugger telemetry, to run ed_capture(or "VOFA+") without the drone.
+ *          Listens on the debugger port and sends JustFloat packets to one client at a time: the rows
+ *          of a capture file, in a loop with -l, or -s channels of synthetic sine waves without a file.
+ *          Capture files are replayed with their recorded timing, -r sets a fixed rate in packets per
+ *          second instead, and -r 0 sends as fast as the socket accepts, to benchmark the receiver.
+ *          The client is disconnected after -t seconds or at the end of the file.
+ *
+ *          usage: ed_capture_replay [-p port] [-r rate] [-s channels] [-t seconds] [-l] [capture]
+ */
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "ed_capture_file.h"
+#include "ed_justfloat.h"
+
+#define REPLAY_BATCH_SIZE               (64 * 1024)
+#define REPLAY_PERIOD_NS                (1000000ll)
+
+typedef struct {
+    ed_cap_reader_t reader;
+    int has_file;
+    int loop;
+    uint32_t channels;
+    uint64_t row;
+} replay_source_t;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+/**
+ * @brief: Get the next row.
+ * @param:
+ *      - int64_t* time_ns : recorded time of the row, row * 10 ms for the synthetic source.
+ * @return: 0 if success, -1 at the end of the file.
+ */
+static int next_row(replay_source_t* source, float* values, int64_t* time_ns)
+{
+    if(!source->has_file)
+    {
+        double t = source->row * 0.01;
+        for(uint32_t i = 0; i < source->channels; i++)
+            values[i] = (float)(10 * sin(2 * M_PI * (0.2 + 0.1 * i) * t) + 0.01 * i);
+        *time_ns = source->row * 10000000ll;
+        source->row ++;
+        return 0;
+    }
+
+    const ed_cap_reader_t* reader = &source->reader;
+    if(source->row >= reader->blocks * reader->block_rows)
+    {
+        if(!source->loop || reader->rows == 0)
+            return -1;
+        source->row = 0;
+    }
+
+    // skip the unused rows of a partial block.
+    const float* columns[ED_CAP_MAX_CHANNELS];
+    const int64_t* time;
+    uint64_t block = source->row / reader->block_rows;
+    uint32_t rows = ed_cap_reader_block(reader, block, &time, columns);
+    uint32_t row = source->row % reader->block_rows;
+    if(row >= rows)
+    {
+        source->row = (block + 1) * reader->block_rows;
+        return next_row(source, values, time_ns);
+    }
+
+    for(uint32_t i = 0; i < reader->channels; i++)
+        values[i] = columns[i][row];
+    *time_ns = time[row];
+    source->row ++;
+    return 0;
+}
+
+static int send_all(int fd, const uint8_t* data, size_t size)
+{
+    while(size)
+    {
+        ssize_t n = send(fd, data, size, 0);
+        if(n <= 0)
+            return -1;
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/**
+ * @brief: Serve a client until it leaves, the source ends or the time is up.
+ * @return: packets sent.
+ */
+static uint64_t serve(int fd, replay_source_t* source, double rate, double seconds)
+{
+    static uint8_t batch[REPLAY_BATCH_SIZE];
+    const uint32_t tail = ED_JUSTFLOAT_TAIL;
+    size_t packet_size = 4 * (source->channels + 1), len = 0;
+    float values[ED_CAP_MAX_CHANNELS];
+    int64_t start = now_ns(), base = 0, last_time = 0, row_time = 0;
+    uint64_t packets = 0;
+    int ended = 0, pending = 0;
+
+    while(!ended && (seconds <= 0 || now_ns() - start < seconds * 1e9))
+    {
+        // packets due by now, all of them in the unpaced mode.
+        int64_t elapsed = now_ns() - start;
+        while(len + packet_size <= sizeof(batch))
+        {
+            if(!pending)
+            {
+                if(next_row(source, values, &row_time))
+                {
+                    ended = 1;
+                    break;
+                }
+                // the recorded time restarts when the file loops, the replay time goes on.
+                if(packets == 0)
+                    base = row_time;
+                else if(row_time < last_time)
+                    base -= last_time - row_time + REPLAY_PERIOD_NS;
+                last_time = row_time;
+            }
+
+            int64_t due = rate > 0 ? (int64_t)(packets / rate * 1e9) : rate == 0 ? 0 : row_time - base;
+            pending = due > elapsed;
+            if(pending)
+                break;
+
+            memcpy(batch + len, values, 4 * source->channels);
+            memcpy(batch + len + 4 * source->channels, &tail, 4);
+            len += packet_size;
+            packets ++;
+        }
+
+        if(len && send_all(fd, batch, len))
+            break;
+        len = 0;
+        if(rate != 0 && !ended)
+        {
+            struct timespec period = { .tv_nsec = REPLAY_PERIOD_NS };
+            nanosleep(&period, NULL);
+        }
+    }
+    return packets;
+}
+
+int main(int argc, char** argv)
+{
+    int port = 8080;
+    double rate = -1, seconds = 0;
+    static replay_source_t source = { 0 };
+
+    int opt;
+    while((opt = getopt(argc, argv, "p:r:s:t:lh")) != -1)
+    {
+        switch(opt)
+        {
+        case 'p': port = atoi(optarg); break;
+        case 'r': rate = atof(optarg); break;
+        case 's': source.channels = strtoul(optarg, NULL, 0); break;
+        case 't': seconds = atof(optarg); break;
+        case 'l': source.loop = 1; break;
+        default:
+            goto usage;
+        }
+    }
+
+    if(optind == argc - 1)
+    {
+        if(ed_cap_reader_open(&source.reader, argv[optind]))
+        {
+            fprintf(stderr, "can not read %s.\n", argv[optind]);
+            return 1;
+        }
+        source.has_file = 1;
+        source.channels = source.reader.channels;
+    } else if(optind != argc || source.channels < 1 || source.channels > ED_CAP_MAX_CHANNELS) {
+        goto usage;
+    } else if(rate < 0) {
+        // the synthetic source has no recorded timing, run at the rate of the telemetry task.
+        rate = 100;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if(server < 0 || bind(server, (struct sockaddr*)&addr, sizeof(addr)) || listen(server, 1))
+    {
+        fprintf(stderr, "can not listen on port %d.\n", port);
+        return 1;
+    }
+    fprintf(stderr, "listening on port %d, %lu channels.\n", port, (unsigned long)source.channels);
+
+    for( ; ; )
+    {
+        int fd = accept(server, NULL, NULL);
+        if(fd < 0)
+            continue;
+
+        int64_t start = now_ns();
+        source.row = 0;
+        uint64_t packets = serve(fd, &source, rate, seconds);
+        double elapsed = (now_ns() - start) / 1e9;
+        fprintf(stderr, "%llu packets in %.2f s(%.0f packets/s, %.2f MB/s).\n", (unsigned long long)packets, elapsed,
+            packets / elapsed, packets * 4.0 * (source.channels + 1) / elapsed / 1e6);
+        close(fd);
+    }
+
+usage:
+    fprintf(stderr, "usage: %s [-p port] [-r rate] [-s channels] [-t seconds] [-l] [capture]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
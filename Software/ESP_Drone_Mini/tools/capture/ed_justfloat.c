@@ -0,0 +1,37 @@
+#include "ed_justfloat.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief: Find the first tail in the aligned words of data.
+ * @param:
+ *      - size_t words : length of data in 4 bytes words.
+ * @return: index of the word, or words if there is none.
+ * @note: the words are compared 4 at once with SSE2 when it is available.
+ */
+size_t ed_justfloat_find_tail(const uint8_t* data, size_t words)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i tail = _mm_set1_epi32((int)ED_JUSTFLOAT_TAIL);
+    for( ; i + 4 <= words; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + 4 * i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(v, tail));
+        if(mask)
+            return i + __builtin_ctz(mask) / 4;
+    }
+#endif
+    for( ; i < words; i++)
+    {
+        uint32_t word;
+        memcpy(&word, data + 4 * i, 4);
+        if(word == ED_JUSTFLOAT_TAIL)
+            return i;
+    }
+    return words;
+}
@@ -0,0 +1,30 @@
+#ifndef __ED_JUSTFLOAT_H__
+#define __ED_JUSTFLOAT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @note: JustFloat packets of "VOFA+": n little-endian floats followed by the tail { 0x00, 0x00, 0x80, 0x7f },
+ *          a NaN which no sensor value takes. Packets are 4-byte aligned from the start of the stream.
+ */
+#define ED_JUSTFLOAT_TAIL               (0x7F800000u)
+
+/**
+ * @brief: Find the first tail in the aligned words of data.
+ * @param:
+ *      - size_t words : length of data in 4 bytes words.
+ * @return: index of the word, or words if there is none.
+ * @note: the words are compared 4 at once with SSE2 when it is available.
+ */
+size_t ed_justfloat_find_tail(const uint8_t* data, size_t words);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,424 @@
+/**
+ * @note: Fuzzer and benchmark of the request parser of ed_debugger(ed_debugger_parser.c).
+ *          The fuzzer runs -f rounds, each of them on two streams, fed in chunks of random sizes:
+ *              - a stream of valid frames, frames with a bad checksum or length, legacy packets and garbage,
+ *                which has to give exactly the generated frames and packets.
+ *              - random bytes, which have to give the same reports as when fed at once.
+ *          The benchmark feeds -b MB of small requests, then of SET frames full of items, in reads of 1460
+ *          bytes, to the parser and to the buffer parser it replaced(recv into the rest of a one frame
+ *          buffer, then rescan and memmove).
+ *          Build with -fsanitize=address,undefined to catch the out of bounds accesses as well.
+ *
+ *          usage: ed_dbg_parser_check [-f rounds] [-b MB] [-s seed]
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ed_debugger_parser.h"
+
+#define CHECK_STREAM_SIZE               (256 * 1024)
+#define CHECK_MAX_EVENTS                (16384)
+#define CHECK_READ_SIZE                 (1460)
+
+// a report of the parser, payloads are hashed.
+typedef struct {
+    uint8_t type;                   // 0 for a frame, 1 for a legacy packet.
+    uint8_t cmd;
+    int len;
+    uint32_t hash;
+} check_event_t;
+
+typedef struct {
+    check_event_t events[CHECK_MAX_EVENTS];
+    int count;
+} check_trace_t;
+
+static uint64_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+static uint32_t hash(const uint8_t* data, int len)
+{
+    uint32_t h = 2166136261u;
+    for(int i = 0; i < len; i++)
+        h = (h ^ data[i]) * 16777619u;
+    return h;
+}
+
+static void trace_add(check_trace_t* trace, uint8_t type, uint8_t cmd, const uint8_t* data, int len)
+{
+    if(trace->count < CHECK_MAX_EVENTS)
+        trace->events[trace->count++] = (check_event_t){ .type = type, .cmd = cmd, .len = len, .hash = hash(data, len) };
+}
+
+static void on_frame(void* ctx, uint8_t cmd, const uint8_t* payload, int len)
+{
+    trace_add(ctx, 0, cmd, payload, len);
+}
+
+static void on_legacy(void* ctx, int32_t id, const uint8_t value[4])
+{
+    uint8_t raw[8];
+    memcpy(raw, &id, 4);
+    memcpy(raw + 4, value, 4);
+    trace_add(ctx, 1, 0, raw, 8);
+}
+
+static uint8_t checksum(const uint8_t* data, int len)
+{
+    uint8_t sum = 0;
+    for(int i = 0; i < len; i++)
+        sum += data[i];
+    return sum;
+}
+
+static int pack_frame(uint8_t* frame, uint8_t cmd, const uint8_t* payload, int len)
+{
+    frame[0] = ED_DBG_SYNC0;
+    frame[1] = ED_DBG_SYNC1;
+    frame[2] = cmd;
+    frame[3] = len & 0xff;
+    frame[4] = len >> 8;
+    memcpy(frame + ED_DBG_HEADER_SIZE, payload, len);
+    frame[ED_DBG_HEADER_SIZE + len] = checksum(frame + 2, len + 3);
+    return len + ED_DBG_FRAME_OVERHEAD;
+}
+
+static void feed_chunks(ed_dbg_parser_t* parser, const uint8_t* data, size_t size)
+{
+    size_t offset = 0;
+    while(offset < size)
+    {
+        // mostly short reads, some of them of a single byte.
+        size_t n = rng() % 4 ? 1 + rng() % 64 : 1 + rng() % 4096;
+        if(n > size - offset)
+            n = size - offset;
+        ed_dbg_parser_feed(parser, data + offset, n);
+        offset += n;
+    }
+}
+
+static bool same_traces(const check_trace_t* a, const check_trace_t* b)
+{
+    return a->count == b->count && !memcmp(a->events, b->events, a->count * sizeof(check_event_t));
+}
+
+/**
+ * @brief: Random byte other than the sync byte and the last byte of the tail, which start frames and end packets.
+ */
+static uint8_t plain_byte(void)
+{
+    uint8_t byte;
+    do {
+        byte = rng();
+    } while(byte == ED_DBG_SYNC0 || byte == 0x7f);
+    return byte;
+}
+
+/**
+ * @brief: Generate a stream of frames, legacy packets and garbage.
+ * @return: size of the stream, the expected reports are in expected.
+ * @note: a 0x7f is only in the tails and beyond the 13th byte of the frames, so that no legacy packet is
+ *          found where none was generated.
+ */
+static size_t generate_stream(uint8_t* stream, size_t capacity, check_trace_t* expected, uint32_t* dropped)
+{
+    static uint8_t payload[ED_DBG_MAX_PAYLOAD];
+    size_t size = 0;
+    expected->count = 0;
+    *dropped = 0;
+
+    while(size + ED_DBG_MAX_FRAME + 64 < capacity && expected->count < CHECK_MAX_EVENTS - 1)
+    {
+        uint32_t kind = rng() % 8;
+        if(kind < 4)
+        {
+            // 1. a frame, mostly short, with a bad checksum sometimes.
+            uint8_t* frame = stream + size;
+            uint8_t cmd;
+            int len, frame_size;
+            bool bad;
+            do {
+                cmd = rng() % 2 ? plain_byte() : ED_DBG_CMD_SET;
+                len = rng() % 8 ? rng() % 32 : rng() % (ED_DBG_MAX_PAYLOAD + 1);
+                for(int i = 0; i < len; i++)
+                    payload[i] = rng();
+                frame_size = pack_frame(frame, cmd, payload, len);
+                bad = rng() % 16 == 0;
+                if(bad)
+                    frame[frame_size - 1] ++;
+            } while(memchr(frame, 0x7f, frame_size < ED_DBG_LEGACY_PACKET_SIZE ? frame_size : ED_DBG_LEGACY_PACKET_SIZE));
+            size += frame_size;
+            if(bad)
+                (*dropped) ++;
+            else
+                trace_add(expected, 0, cmd, payload, len);
+        } else if(kind < 6) {
+            // 2. a legacy packet.
+            uint8_t* packet = stream + size;
+            for(int i = 0; i < 9; i++)
+                packet[i] = plain_byte();
+            packet[4] = '=';
+            memcpy(packet + 9, "\x00\x00\x80\x7f", 4);
+            size += ED_DBG_LEGACY_PACKET_SIZE;
+
+            uint8_t raw[8];
+            memcpy(raw, packet, 4);
+            memcpy(raw + 4, packet + 5, 4);
+            trace_add(expected, 1, 0, raw, 8);
+        } else if(kind < 7) {
+            // 3. a header with a length above the limit, it is dropped at its length.
+            uint8_t* header = stream + size;
+            header[0] = ED_DBG_SYNC0;
+            header[1] = ED_DBG_SYNC1;
+            header[2] = plain_byte();
+            header[3] = plain_byte();
+            header[4] = 0x04 + rng() % 0x70;
+            if(header[4] == 0x04 && header[3] == 0x00)
+                header[3] = 0x01;
+            size += ED_DBG_HEADER_SIZE;
+            (*dropped) ++;
+        } else {
+            // 4. garbage.
+            int len = rng() % 48;
+            for(int i = 0; i < len; i++)
+                stream[size++] = plain_byte();
+        }
+    }
+    return size;
+}
+
+static int fuzz(int rounds)
+{
+    static uint8_t stream[CHECK_STREAM_SIZE];
+    static check_trace_t expected, once, chunked;
+    static ed_dbg_parser_t parser;
+    uint64_t frames = 0, packets = 0, bytes = 0;
+
+    for(int round = 0; round < rounds; round++)
+    {
+        // 1. generated stream.
+        uint32_t dropped;
+        size_t size = generate_stream(stream, sizeof(stream), &expected, &dropped);
+        parser = (ed_dbg_parser_t){ .on_frame = on_frame, .on_legacy = on_legacy, .ctx = &chunked };
+        chunked.count = 0;
+        feed_chunks(&parser, stream, size);
+        if(!same_traces(&expected, &chunked) || parser.dropped != dropped)
+        {
+            fprintf(stderr, "round %d: %d reports, %d expected, %lu dropped, %lu expected.\n", round, chunked.count,
+                expected.count, (unsigned long)parser.dropped, (unsigned long)dropped);
+            for(int i = 0; i < expected.count && i < chunked.count; i++)
+            {
+                if(memcmp(&expected.events[i], &chunked.events[i], sizeof(check_event_t)))
+                {
+                    fprintf(stderr, "first difference at report %d.\n", i);
+                    break;
+                }
+            }
+            return -1;
+        }
+        frames += parser.frames;
+        packets += parser.legacy;
+        bytes += size;
+
+        // 2. random bytes, with some sync bytes and tails.
+        for(size_t i = 0; i < sizeof(stream); i++)
+        {
+            uint32_t r = rng() % 64;
+            stream[i] = r == 0 ? ED_DBG_SYNC0 : r == 1 ? ED_DBG_SYNC1 : r == 2 ? 0x7f : r == 3 ? '=' : r < 12 ? 0x00 : (uint8_t)rng();
+        }
+        parser = (ed_dbg_parser_t){ .on_frame = on_frame, .on_legacy = on_legacy, .ctx = &once };
+        once.count = 0;
+        ed_dbg_parser_feed(&parser, stream, sizeof(stream));
+        parser = (ed_dbg_parser_t){ .on_frame = on_frame, .on_legacy = on_legacy, .ctx = &chunked };
+        chunked.count = 0;
+        feed_chunks(&parser, stream, sizeof(stream));
+        if(!same_traces(&once, &chunked))
+        {
+            fprintf(stderr, "round %d: random bytes give %d reports in chunks, %d at once.\n", round, chunked.count, once.count);
+            return -1;
+        }
+        bytes += sizeof(stream);
+    }
+    printf("fuzz: %d rounds, %.1f MB, %llu frames and %llu legacy packets matched.\n", rounds, bytes / 1e6,
+        (unsigned long long)frames, (unsigned long long)packets);
+    return 0;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static uint64_t bench_count = 0;
+
+static void on_bench_frame(void* ctx, uint8_t cmd, const uint8_t* payload, int len)
+{
+    (void)ctx;
+    (void)cmd;
+    bench_count += len ? payload[0] + 1 : 1;
+}
+
+static void on_bench_legacy(void* ctx, int32_t id, const uint8_t value[4])
+{
+    (void)ctx;
+    bench_count += id + value[0] + 1;
+}
+
+/**
+ * @brief: The parser of ed_debugger before the state machine, as the baseline of the benchmark.
+ * @note: it reports through the callbacks of the parser as well, so that neither of them is inlined.
+ */
+static int baseline_parse(const ed_dbg_parser_t* callbacks, uint8_t* data, int len)
+{
+    int offset = 0;
+    while(offset < len)
+    {
+        int remain = len - offset;
+        if(data[offset] == ED_DBG_SYNC0)
+        {
+            if(remain < ED_DBG_HEADER_SIZE)
+                break;
+            int payload_len = data[offset + 3] | (data[offset + 4] << 8);
+            if(data[offset + 1] == ED_DBG_SYNC1 && payload_len <= ED_DBG_MAX_PAYLOAD)
+            {
+                if(remain < payload_len + ED_DBG_FRAME_OVERHEAD)
+                    break;
+                if(checksum(data + offset + 2, payload_len + 3) == data[offset + ED_DBG_HEADER_SIZE + payload_len])
+                {
+                    callbacks->on_frame(NULL, data[offset + 2], data + offset + ED_DBG_HEADER_SIZE, payload_len);
+                    offset += payload_len + ED_DBG_FRAME_OVERHEAD;
+                    continue;
+                }
+            }
+        }
+        if(remain < ED_DBG_LEGACY_PACKET_SIZE)
+            break;
+        if(data[offset + 4] == '=' && !memcmp(data + offset + 9, "\x00\x00\x80\x7f", 4))
+        {
+            int32_t id;
+            memcpy(&id, data + offset, 4);
+            callbacks->on_legacy(NULL, id, data + offset + 5);
+            offset += ED_DBG_LEGACY_PACKET_SIZE;
+            continue;
+        }
+        offset ++;
+    }
+    if(len - offset > 0)
+        memmove(data, data + offset, len - offset);
+    return len - offset;
+}
+
+/**
+ * @param:
+ *      - bool batched : SET of whole frames of items instead of the requests of a ground station.
+ */
+static int bench(double megabytes, bool batched)
+{
+    size_t size = (size_t)(megabytes * 1e6);
+    uint8_t* stream = malloc(size + ED_DBG_MAX_FRAME);
+    if(stream == NULL)
+        return -1;
+
+    // requests of a ground station: SET and GET of a few items, LIST, some legacy packets.
+    static uint8_t payload[ED_DBG_MAX_PAYLOAD];
+    size_t len = 0;
+    while(len < size)
+    {
+        uint32_t kind = rng() % 8;
+        for(int i = 0; i < 64; i++)
+            payload[i] = rng();
+        if(batched)
+            len += pack_frame(stream + len, ED_DBG_CMD_SET, payload, ED_DBG_MAX_PAYLOAD / ED_DBG_SET_REQ_ITEM_SIZE * ED_DBG_SET_REQ_ITEM_SIZE);
+        else if(kind < 5)
+            len += pack_frame(stream + len, ED_DBG_CMD_SET, payload, ED_DBG_SET_REQ_ITEM_SIZE * (1 + rng() % 4));
+        else if(kind < 6)
+            len += pack_frame(stream + len, ED_DBG_CMD_GET, payload, ED_DBG_GET_REQ_ITEM_SIZE * (1 + rng() % 8));
+        else if(kind < 7)
+            len += pack_frame(stream + len, ED_DBG_CMD_LIST, payload, 2);
+        else
+        {
+            memcpy(stream + len, "\x01\x00\x00\x00=\xC3\xF5\x48\x40\x00\x00\x80\x7f", ED_DBG_LEGACY_PACKET_SIZE);
+            len += ED_DBG_LEGACY_PACKET_SIZE;
+        }
+    }
+
+    // 1. state machine, fed in reads of a TCP segment.
+    static ed_dbg_parser_t parser;
+    parser = (ed_dbg_parser_t){ .on_frame = on_bench_frame, .on_legacy = on_bench_legacy };
+    bench_count = 0;
+    int64_t start = now_ns();
+    for(size_t offset = 0; offset < len; offset += CHECK_READ_SIZE)
+        ed_dbg_parser_feed(&parser, stream + offset, len - offset < CHECK_READ_SIZE ? len - offset : CHECK_READ_SIZE);
+    double parser_s = (now_ns() - start) / 1e9;
+    uint64_t parser_count = bench_count;
+
+    // 2. baseline, each read goes to the rest of its buffer.
+    static uint8_t buffer[ED_DBG_MAX_FRAME];
+    int buffered = 0;
+    bench_count = 0;
+    start = now_ns();
+    for(size_t offset = 0; offset < len; )
+    {
+        size_t n = ED_DBG_MAX_FRAME - buffered;
+        if(n > CHECK_READ_SIZE)
+            n = CHECK_READ_SIZE;
+        if(n > len - offset)
+            n = len - offset;
+        memcpy(buffer + buffered, stream + offset, n);
+        offset += n;
+        buffered = baseline_parse(&parser, buffer, buffered + n);
+    }
+    double baseline_s = (now_ns() - start) / 1e9;
+
+    uint64_t requests = parser.frames + parser.legacy;
+    printf("bench(%s): %.1f MB, %llu requests.\n", batched ? "batched SET" : "small requests", len / 1e6, (unsigned long long)requests);
+    printf("  state machine: %8.1f MB/s, %6.2f M requests/s.\n", len / parser_s / 1e6, requests / parser_s / 1e6);
+    printf("  buffer parser: %8.1f MB/s, %6.2f M requests/s%s.\n", len / baseline_s / 1e6, requests / baseline_s / 1e6,
+        bench_count == parser_count ? "" : ", REPORTS DIFFER");
+    free(stream);
+    return bench_count == parser_count ? 0 : -1;
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = 200;
+    double megabytes = 64;
+
+    int opt;
+    while((opt = getopt(argc, argv, "f:b:s:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'f': rounds = atoi(optarg); break;
+        case 'b': megabytes = atof(optarg); break;
+        case 's': rng_state = strtoull(optarg, NULL, 0) | 1; break;
+        default:
+            goto usage;
+        }
+    }
+    if(optind != argc || rounds < 0 || megabytes < 0)
+        goto usage;
+
+    if(rounds && fuzz(rounds))
+        return 1;
+    if(megabytes > 0 && (bench(megabytes, false) || bench(megabytes, true)))
+        return 1;
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-f rounds] [-b MB] [-s seed]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+/**
+ * @note: Cost of the dynamic notch of OpenHover(oh_dyn_notch.c) against its FFT size.
+ *          For every fft_size from 16 to OH_DYN_NOTCH_MAX_FFT_SIZE, gyro samples with a vibration tone and noise
+ *          are pushed at the sample rate, and the tool reports:
+ *              - the frequency resolution and the window length, the delay before a new peak is tracked.
+ *              - the cost of oh_dyn_notch_analyze and its CPU load in the analysis task at the sample rate.
+ *              - the cost of the control loop side per tick: oh_dyn_notch_push in the analysis task, then
+ *                oh_dyn_notch_load and oh_filter_chain_apply of one notch in the control task.
+ *              - the error of the tracked center on the tone.
+ *          Then the phase lag of a notch of the firmware q at low frequencies, which the angular velocity loops
+ *          lose when a notch is loaded, is reported for the band edges.
+ *          The band and q are the ones of ED_DYN_NOTCH. Costs are host costs, the firmware is not measured here.
+ *          The process fails if the tone is not tracked within a bin by a size with at least BENCH_MIN_BAND_BINS bins in the band.
+ *
+ *          usage: ed_dyn_notch_bench [-s sample hz] [-f tone hz] [-n analyses]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "oh_dyn_notch.h"
+
+#ifndef M_PI
+#define M_PI                            (3.14159265358979323846)
+#endif
+
+// ED_DYN_NOTCH of esp_drone_config.h.
+#define BENCH_MIN_HZ                    (15)
+#define BENCH_MAX_HZ                    (45)
+#define BENCH_Q                         (3)
+#define BENCH_THRESHOLD                 (4)
+#define BENCH_ANALYSES                  (2000)
+#define BENCH_MIN_BAND_BINS             (8)
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// a tone of 20 deg/s on all axes with uniform noise of +-2 deg/s.
+static void gyro_sample(float sample[3], long n, double sample_hz, double tone_hz, unsigned int* seed)
+{
+    double tone = 20 * sin(2 * M_PI * tone_hz * n / sample_hz);
+    for(int axis = 0; axis < 3; axis++)
+        sample[axis] = (float)(tone * (axis + 1) / 3 + 4.0 * rand_r(seed) / RAND_MAX - 2);
+}
+
+// phase of a biquad at hz in degrees, negative is a lag.
+static double phase_deg(const oh_biquad_t* biquad, double hz, double sample_hz)
+{
+    double w = 2 * M_PI * hz / sample_hz;
+    double nr = biquad->b0 + biquad->b1 * cos(w) + biquad->b2 * cos(2 * w);
+    double ni = -biquad->b1 * sin(w) - biquad->b2 * sin(2 * w);
+    double dr = 1 + biquad->a1 * cos(w) + biquad->a2 * cos(2 * w);
+    double di = -biquad->a1 * sin(w) - biquad->a2 * sin(2 * w);
+    return (atan2(ni, nr) - atan2(di, dr)) * 180 / M_PI;
+}
+
+static int bench_fft_size(int fft_size, double sample_hz, double tone_hz, int analyses)
+{
+    static oh_dyn_notch_t dn;
+    static oh_filter_chain_t chain;
+    oh_dyn_notch_result_t result;
+    memset(&dn, 0x00, sizeof(dn));
+    dn.fft_size = fft_size;
+    dn.axes = 3;
+    dn.peaks = 1;
+    dn.min_hz = BENCH_MIN_HZ;
+    dn.max_hz = BENCH_MAX_HZ;
+    dn.q = BENCH_Q;
+    dn.threshold = BENCH_THRESHOLD;
+    if(oh_dyn_notch_init(&dn, sample_hz))
+    {
+        printf("  %5d  invalid configs at %.0f Hz.\n", fft_size, sample_hz);
+        return 1;
+    }
+    oh_filter_chain_init(&chain, 3, sample_hz, NULL, 0);
+
+    unsigned int seed = 1;
+    long n = 0;
+    double push_s = 0, analyze_s = 0, error_hz = 0;
+    int tracked = 0;
+    float sample[3] = { 0 };
+    static float window[OH_DYN_NOTCH_MAX_FFT_SIZE][3];
+    for(int i = 0; i < analyses; i++)
+    {
+        for(int j = 0; j < fft_size; j++)
+            gyro_sample(window[j], n++, sample_hz, tone_hz, &seed);
+
+        double start = now_s();
+        for(int j = 0; j < fft_size; j++)
+            oh_dyn_notch_push(&dn, window[j]);
+        double mid = now_s();
+        oh_dyn_notch_analyze(&dn, &result);
+        analyze_s += now_s() - mid;
+        push_s += mid - start;
+
+        if(result.peaks)
+        {
+            tracked ++;
+            error_hz = fmax(error_hz, fabs(result.center_hz[0] - tone_hz));
+        }
+    }
+    double push_ns = push_s / n * 1e9;
+
+    // control task side of a tick: load the last result and filter a sample.
+    const long ticks = 1000000;
+    double start = now_s();
+    for(long i = 0; i < ticks; i++)
+    {
+        if((i & 0xff) == 0)
+            oh_dyn_notch_load(&chain, &result);
+        sample[0] = (float)(i & 0xff);
+        oh_filter_chain_apply(&chain, sample);
+    }
+    double tick_ns = (now_s() - start) / ticks * 1e9;
+
+    double window_s = fft_size / sample_hz;
+    double analyze_us = analyze_s / analyses * 1e6;
+    double resolution = sample_hz / fft_size;
+    // with a few bins in the band, the tone does not stand threshold times above the mean, it is not checked.
+    int checked = floor(BENCH_MAX_HZ / resolution) - ceil(BENCH_MIN_HZ / resolution) >= BENCH_MIN_BAND_BINS;
+    printf("  %5d  %7.2f  %7.0f  %10.2f  %8.5f%%  %7.1f  %7.1f  %5.1f%%  %7.2f%s\n", fft_size, resolution, window_s * 1e3,
+           analyze_us, analyze_us / (window_s * 1e6) * 100, push_ns, tick_ns, 100.0 * tracked / analyses, error_hz,
+           checked ? "" : "  (coarse, not checked)");
+    return !checked || (tracked == analyses && error_hz <= resolution) ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    double sample_hz = 100, tone_hz = 30;
+    int analyses = BENCH_ANALYSES;
+    int opt;
+    while((opt = getopt(argc, argv, "s:f:n:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 's':
+            sample_hz = atof(optarg);
+            break;
+        case 'f':
+            tone_hz = atof(optarg);
+            break;
+        case 'n':
+            analyses = atoi(optarg);
+            break;
+        default:
+            goto usage;
+        }
+    }
+    if(!(sample_hz > 2 * BENCH_MAX_HZ) || !(tone_hz > BENCH_MIN_HZ) || !(tone_hz < BENCH_MAX_HZ) || analyses <= 0)
+        goto usage;
+
+    int failures = 0;
+    printf("dynamic notch at %.0f Hz, band %d ~ %d Hz, q %d, tone %.1f Hz, %d analyses per size.\n",
+           sample_hz, BENCH_MIN_HZ, BENCH_MAX_HZ, BENCH_Q, tone_hz, analyses);
+    printf("  %5s  %7s  %7s  %10s  %9s  %7s  %7s  %6s  %7s\n", "fft", "res Hz", "win ms", "analyze us", "cpu",
+           "push ns", "tick ns", "found", "err Hz");
+    for(int fft_size = 16; fft_size <= OH_DYN_NOTCH_MAX_FFT_SIZE; fft_size <<= 1)
+        failures += bench_fft_size(fft_size, sample_hz, tone_hz, analyses);
+
+    printf("phase lag of a notch of q %d, added to the loops when it is loaded:\n", BENCH_Q);
+    printf("  %9s  %8s  %8s  %8s\n", "center Hz", "at 2 Hz", "at 5 Hz", "at 10 Hz");
+    static const double centers[] = { BENCH_MIN_HZ, (BENCH_MIN_HZ + BENCH_MAX_HZ) / 2.0, BENCH_MAX_HZ };
+    for(size_t i = 0; i < sizeof(centers) / sizeof(centers[0]); i++)
+    {
+        oh_biquad_t notch;
+        oh_biquad_config_t config = { .type = OH_BIQUAD_NOTCH, .center_hz = centers[i], .q = BENCH_Q };
+        oh_biquad_init(&notch, sample_hz, &config);
+        printf("  %9.1f  %8.2f  %8.2f  %8.2f\n", centers[i], -phase_deg(&notch, 2, sample_hz),
+               -phase_deg(&notch, 5, sample_hz), -phase_deg(&notch, 10, sample_hz));
+    }
+    return failures ? 1 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-s sample hz] [-f tone hz] [-n analyses]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+/**
+ * @note: Check and benchmark of the biquad filters of OpenHover(oh_filter.c), the gyro and D-term filters
+ *          and the notches of the firmware.
+ *              - coefficients: every section of the table is compared with the RBJ cookbook in double.
+ *              - response: |H| of the sections at DC, at the center and at Nyquist is compared with the
+ *                analytic values, and sines are run through oh_biquad_apply to compare the measured gain
+ *                with |H| of the coefficients.
+ *              - edge cases: invalid configurations are rejected and leave the chain a passthrough,
+ *                a chain of 0 stages is exact and a NaN sample does not stay in the states.
+ *          Then the cost of oh_filter_chain_apply is measured for 0 to OH_FILTER_MAX_STAGES stages on 3 axes,
+ *          in ns per call and per stage(and in TSC cycles on x86). The firmware costs are not measured here.
+ *          The process fails if any check fails.
+ *
+ *          usage: ed_filter_check [-n bench samples]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CHECK_HAS_TSC                   (1)
+#else
+#define CHECK_HAS_TSC                   (0)
+#endif
+
+#include "oh_filter.h"
+
+#ifndef M_PI
+#define M_PI                            (3.14159265358979323846)
+#endif
+
+#define CHECK_COEF_TOLERANCE            (2e-6)
+#define CHECK_GAIN_TOLERANCE            (1e-3)
+#define CHECK_MEASURED_TOLERANCE        (5e-3)
+#define CHECK_SINE_SETTLE               (2000)
+#define CHECK_SINE_SAMPLES              (4000)
+#define CHECK_BENCH_SAMPLES             (2000000)
+
+typedef struct {
+    float sample_hz;
+    oh_biquad_config_t config;
+} check_case_t;
+
+// the firmware filters at 100 Hz and 1 kHz imu_freq, and the notches of the dynamic notch.
+static const check_case_t cases[] = {
+    { 100,  { OH_BIQUAD_LOWPASS, 40, 0.7071f } },
+    { 100,  { OH_BIQUAD_LOWPASS, 25, 0.7071f } },
+    { 100,  { OH_BIQUAD_LOWPASS, 10, 0.7071f } },
+    { 100,  { OH_BIQUAD_LOWPASS, 49, 0.5f } },
+    { 1000, { OH_BIQUAD_LOWPASS, 80, 0.7071f } },
+    { 1000, { OH_BIQUAD_LOWPASS, 250, 1.0f } },
+    { 100,  { OH_BIQUAD_NOTCH, 20, 3.0f } },
+    { 100,  { OH_BIQUAD_NOTCH, 45, 5.0f } },
+    { 1000, { OH_BIQUAD_NOTCH, 150, 5.0f } },
+    { 1000, { OH_BIQUAD_NOTCH, 5, 0.5f } },
+};
+#define CHECK_CASES                     (sizeof(cases) / sizeof(cases[0]))
+
+static int failures = 0;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void expect(int ok, const char* what, const check_case_t* c, double got, double want)
+{
+    if(ok)
+        return;
+    failures ++;
+    if(c)
+        printf("FAIL: %s of %s %.1f Hz q %.4f at %.0f Hz: %.9g, expected %.9g.\n", what,
+               c->config.type == OH_BIQUAD_LOWPASS ? "lowpass" : "notch", c->config.center_hz, c->config.q,
+               c->sample_hz, got, want);
+    else
+        printf("FAIL: %s: %.9g, expected %.9g.\n", what, got, want);
+}
+
+static void reference(const check_case_t* c, double coef[5])
+{
+    double omega = 2 * M_PI * c->config.center_hz / c->sample_hz;
+    double cs = cos(omega);
+    double alpha = sin(omega) / (2 * c->config.q);
+    double a0 = 1 + alpha;
+    if(c->config.type == OH_BIQUAD_LOWPASS)
+    {
+        coef[0] = (1 - cs) / 2 / a0;
+        coef[1] = (1 - cs) / a0;
+    } else {
+        coef[0] = 1 / a0;
+        coef[1] = -2 * cs / a0;
+    }
+    coef[2] = coef[0];
+    coef[3] = -2 * cs / a0;
+    coef[4] = (1 - alpha) / a0;
+}
+
+// |H(e^jw)| of the coefficients, in double.
+static double gain(const oh_biquad_t* biquad, double hz, double sample_hz)
+{
+    double w = 2 * M_PI * hz / sample_hz;
+    double nr = biquad->b0 + biquad->b1 * cos(w) + biquad->b2 * cos(2 * w);
+    double ni = -biquad->b1 * sin(w) - biquad->b2 * sin(2 * w);
+    double dr = 1 + biquad->a1 * cos(w) + biquad->a2 * cos(2 * w);
+    double di = -biquad->a1 * sin(w) - biquad->a2 * sin(2 * w);
+    return sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+// gain of a sine at hz through oh_biquad_apply, projected on sin and cos over whole periods.
+static double measured_gain(const oh_biquad_config_t* config, double hz, double sample_hz)
+{
+    oh_biquad_t biquad;
+    oh_biquad_init(&biquad, sample_hz, config);
+    double s = 0, k = 0;
+    for(int n = 0; n < CHECK_SINE_SETTLE + CHECK_SINE_SAMPLES; n++)
+    {
+        double phase = 2 * M_PI * hz * n / sample_hz;
+        double y = oh_biquad_apply(&biquad, 0, (float)sin(phase));
+        if(n < CHECK_SINE_SETTLE)
+            continue;
+        s += y * sin(phase);
+        k += y * cos(phase);
+    }
+    return 2.0 / CHECK_SINE_SAMPLES * sqrt(s * s + k * k);
+}
+
+static void check_coefficients(void)
+{
+    for(size_t i = 0; i < CHECK_CASES; i++)
+    {
+        const check_case_t* c = &cases[i];
+        oh_biquad_t biquad;
+        double coef[5];
+        int ret = oh_biquad_init(&biquad, c->sample_hz, &c->config);
+        expect(ret == 0, "init", c, ret, 0);
+        reference(c, coef);
+        const float got[5] = { biquad.b0, biquad.b1, biquad.b2, biquad.a1, biquad.a2 };
+        static const char* names[5] = { "b0", "b1", "b2", "a1", "a2" };
+        for(int j = 0; j < 5; j++)
+            expect(fabs(got[j] - coef[j]) <= CHECK_COEF_TOLERANCE * fmax(1, fabs(coef[j])), names[j], c, got[j], coef[j]);
+    }
+}
+
+static void check_response(void)
+{
+    for(size_t i = 0; i < CHECK_CASES; i++)
+    {
+        const check_case_t* c = &cases[i];
+        oh_biquad_t biquad;
+        oh_biquad_init(&biquad, c->sample_hz, &c->config);
+        double nyquist = c->sample_hz / 2;
+
+        expect(fabs(gain(&biquad, 0, c->sample_hz) - 1) <= CHECK_GAIN_TOLERANCE, "gain at DC", c, gain(&biquad, 0, c->sample_hz), 1);
+        if(c->config.type == OH_BIQUAD_LOWPASS)
+        {
+            // |H(center)| of a RBJ low-pass is q, -3.01 dB for a Butterworth.
+            expect(fabs(gain(&biquad, c->config.center_hz, c->sample_hz) - c->config.q) <= CHECK_GAIN_TOLERANCE,
+                   "gain at cutoff", c, gain(&biquad, c->config.center_hz, c->sample_hz), c->config.q);
+            expect(gain(&biquad, nyquist, c->sample_hz) <= CHECK_GAIN_TOLERANCE, "gain at nyquist", c, gain(&biquad, nyquist, c->sample_hz), 0);
+        } else {
+            expect(gain(&biquad, c->config.center_hz, c->sample_hz) <= CHECK_GAIN_TOLERANCE, "gain at center", c, gain(&biquad, c->config.center_hz, c->sample_hz), 0);
+            expect(fabs(gain(&biquad, nyquist, c->sample_hz) - 1) <= CHECK_GAIN_TOLERANCE, "gain at nyquist", c, gain(&biquad, nyquist, c->sample_hz), 1);
+        }
+
+        // whole periods in CHECK_SINE_SAMPLES: hz = m * sample_hz / CHECK_SINE_SAMPLES.
+        static const double fractions[] = { 0.02, 0.1, 0.2, 0.3, 0.45 };
+        for(size_t j = 0; j < sizeof(fractions) / sizeof(fractions[0]); j++)
+        {
+            double hz = round(fractions[j] * CHECK_SINE_SAMPLES) * c->sample_hz / CHECK_SINE_SAMPLES;
+            double want = gain(&biquad, hz, c->sample_hz);
+            double got = measured_gain(&c->config, hz, c->sample_hz);
+            expect(fabs(got - want) <= CHECK_MEASURED_TOLERANCE * fmax(1, want), "measured gain", c, got, want);
+        }
+    }
+}
+
+static void check_edge_cases(void)
+{
+    static const check_case_t invalid[] = {
+        { 100, { OH_BIQUAD_LOWPASS, 0, 0.7071f } },
+        { 100, { OH_BIQUAD_LOWPASS, 50, 0.7071f } },
+        { 100, { OH_BIQUAD_LOWPASS, 60, 0.7071f } },
+        { 100, { OH_BIQUAD_NOTCH, 20, 0 } },
+        { 100, { OH_BIQUAD_NOTCH, NAN, 3 } },
+        { 0,   { OH_BIQUAD_LOWPASS, 20, 0.7071f } },
+        { 100, { (oh_biquad_type_t)7, 20, 0.7071f } },
+    };
+    for(size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        oh_biquad_t biquad;
+        int ret = oh_biquad_init(&biquad, invalid[i].sample_hz, &invalid[i].config);
+        expect(ret == -1, "invalid configuration accepted", &invalid[i], ret, -1);
+    }
+
+    // a chain with an invalid stage is a passthrough.
+    oh_filter_chain_t chain;
+    const oh_biquad_config_t stages[2] = { cases[0].config, invalid[1].config };
+    int ret = oh_filter_chain_init(&chain, 3, 100, stages, 2);
+    expect(ret == -1 && chain.stages == 0, "chain with an invalid stage", NULL, chain.stages, 0);
+    ret = oh_filter_chain_init(&chain, 3, 100, stages, OH_FILTER_MAX_STAGES + 1);
+    expect(ret == -1 && chain.stages == 0, "chain with too many stages", NULL, chain.stages, 0);
+
+    // 0 stages is the default of the firmware, the samples must go through unchanged.
+    ret = oh_filter_chain_init(&chain, 3, 100, NULL, 0);
+    expect(ret == 0, "chain of 0 stages", NULL, ret, 0);
+    for(int n = 0; n < 1000; n++)
+    {
+        float x[3] = { n * 0.37f, -n * 1e-7f, 1e30f / (n + 1) }, y[3];
+        memcpy(y, x, sizeof(y));
+        oh_filter_chain_apply(&chain, y);
+        if(memcmp(x, y, sizeof(x)) || oh_filter_chain_apply_axis(&chain, 1, x[1]) != x[1])
+        {
+            expect(0, "chain of 0 stages changed a sample", NULL, y[0], x[0]);
+            break;
+        }
+    }
+
+    // a NaN sample is passed through once, then the section filters again from clean states.
+    oh_biquad_t biquad;
+    oh_biquad_init(&biquad, cases[0].sample_hz, &cases[0].config);
+    for(int n = 0; n < 100; n++)
+        oh_biquad_apply(&biquad, 0, 1);
+    oh_biquad_apply(&biquad, 0, NAN);
+    float y = 0;
+    for(int n = 0; n < 200; n++)
+        y = oh_biquad_apply(&biquad, 0, 1);
+    expect(fabsf(y - 1) <= CHECK_GAIN_TOLERANCE, "step response after a NaN sample", &cases[0], y, 1);
+}
+
+static void bench(long samples)
+{
+    oh_biquad_config_t configs[OH_FILTER_MAX_STAGES];
+    for(int i = 0; i < OH_FILTER_MAX_STAGES; i++)
+        configs[i] = cases[i % 3].config;
+
+    double base_ns = 0;
+    printf("bench: oh_filter_chain_apply on 3 axes at 100 Hz, %ld samples.\n", samples);
+    printf("  stages   ns/call  ns/stage%s\n", CHECK_HAS_TSC ? "  tsc/call tsc/stage" : "");
+    for(int stages = 0; stages <= OH_FILTER_MAX_STAGES; stages++)
+    {
+        static oh_filter_chain_t chain;
+        volatile float sink = 0;
+        float x[3] = { 0 };
+        oh_filter_chain_init(&chain, 3, 100, configs, stages);
+
+        double start = now_s();
+#if CHECK_HAS_TSC
+        unsigned long long tsc = __rdtsc();
+#endif
+        for(long n = 0; n < samples; n++)
+        {
+            x[0] = (float)(n & 0xff);
+            x[1] = -x[0];
+            x[2] = x[0] * 0.5f;
+            oh_filter_chain_apply(&chain, x);
+            sink += x[2];
+        }
+#if CHECK_HAS_TSC
+        double tsc_per_call = (double)(__rdtsc() - tsc) / samples;
+#endif
+        double ns = (now_s() - start) / samples * 1e9;
+        (void)sink;
+        if(stages == 0)
+            base_ns = ns;
+#if CHECK_HAS_TSC
+        static double base_tsc = 0;
+        if(stages == 0)
+            base_tsc = tsc_per_call;
+        printf("  %6d  %8.2f  %8.2f  %8.1f  %8.1f\n", stages, ns, stages ? (ns - base_ns) / stages : 0,
+               tsc_per_call, stages ? (tsc_per_call - base_tsc) / stages : 0);
+#else
+        printf("  %6d  %8.2f  %8.2f\n", stages, ns, stages ? (ns - base_ns) / stages : 0);
+#endif
+    }
+}
+
+int main(int argc, char** argv)
+{
+    long samples = CHECK_BENCH_SAMPLES;
+    int opt;
+    while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            samples = atol(optarg);
+            break;
+        default:
+            goto usage;
+        }
+    }
+    if(samples <= 0)
+        goto usage;
+
+    check_coefficients();
+    check_response();
+    check_edge_cases();
+    printf("checks: %zu sections, %d failures.\n", CHECK_CASES, failures);
+    bench(samples);
+    return failures ? 1 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-n bench samples]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
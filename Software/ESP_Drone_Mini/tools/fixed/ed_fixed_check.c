@@ -0,0 +1,466 @@
+/**
+ * @note: Check and benchmark of the fixed-point control math of OpenHover(oh_pid_q.c, oh_mixer_mix_q).
+ *              - bit-exact: the Q31 position and incremental pids and the Q31 mixer are compared bit for bit
+ *                with a reference model in 128 bits integers, which follows the documented rounding
+ *                (products to nearest, airmode scale toward zero) and saturations.
+ *                Inputs are random, with a share of extreme values to hit every saturation.
+ *              - float: the same pids and mixers are run next to the float path(oh_pos_pid_calc, oh_inc_pid_calc,
+ *                oh_mixer_mix) with the rate gains of the firmware, the largest difference must stay below
+ *                CHECK_FLOAT_TOLERANCE of the full scale.
+ *          Then the cost of every float function and its fixed-point counterpart is measured side by side,
+ *          with inputs in range and with saturating inputs, in ns per call(and in TSC cycles on x86).
+ *          The firmware costs are not measured here.
+ *          The process fails if any check fails.
+ *
+ *          usage: ed_fixed_check [-n random vectors] [-b bench calls] [-r random seed]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CHECK_HAS_TSC                   (1)
+#else
+#define CHECK_HAS_TSC                   (0)
+#endif
+
+#ifndef __SIZEOF_INT128__
+#error "the reference model needs 128 bits integers."
+#endif
+
+#include "oh_mixer.h"
+#include "oh_pid.h"
+#include "oh_pid_q.h"
+
+#define CHECK_VECTORS                   (1000000)
+#define CHECK_BENCH_CALLS               (2000000)
+#define CHECK_FLOAT_STEPS               (100000)
+#define CHECK_FLOAT_TOLERANCE           (1e-4)
+// full scale of the rate loop signals(deg/s and pid output) in the float comparison.
+#define CHECK_FULL_SCALE                (4096.0f)
+
+typedef __int128 wide_t;
+
+static int failures = 0;
+static uint64_t rng_state = 1;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng(void)
+{
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+// a Q31 value, 1 in 8 is an extreme value.
+static oh_q31_t random_q31(void)
+{
+    static const oh_q31_t extremes[] = { OH_Q31_MIN, OH_Q31_MIN + 1, -1, 0, 1, OH_Q31_MAX - 1, OH_Q31_MAX, 1 << 30 };
+    uint64_t r = rng();
+    if((r & 7) == 0)
+        return extremes[(r >> 3) % (sizeof(extremes) / sizeof(extremes[0]))];
+    return (oh_q31_t)(uint32_t)(r >> 32);
+}
+
+static oh_q15_t random_q15(void)
+{
+    static const oh_q15_t extremes[] = { OH_Q15_MIN, -1, 0, 1, OH_Q15_MAX };
+    uint64_t r = rng();
+    if((r & 7) == 0)
+        return extremes[(r >> 3) % (sizeof(extremes) / sizeof(extremes[0]))];
+    return (oh_q15_t)(uint16_t)(r >> 48);
+}
+
+/******************************* reference model ******************************/
+static wide_t ref_sat(wide_t x)
+{
+    return x > OH_Q31_MAX ? OH_Q31_MAX : (x < OH_Q31_MIN ? OH_Q31_MIN : x);
+}
+
+static wide_t ref_clamp(wide_t x, wide_t max_abs)
+{
+    return x > max_abs ? max_abs : (x < -max_abs ? -max_abs : x);
+}
+
+// x * gain * 2^shift / 2^15 rounded to nearest, halves up.
+static wide_t ref_mul(wide_t x, wide_t gain, int shift)
+{
+    wide_t n = x * gain * ((wide_t)1 << shift) * 2 + ((wide_t)1 << 15);
+    wide_t d = (wide_t)1 << 16;
+    wide_t q = n / d;
+    if(n % d != 0 && n < 0)
+        q -= 1;
+    return ref_sat(q);
+}
+
+static wide_t ref_pos_pid(oh_pos_pid_q_t* pid, wide_t* int_output, wide_t* last_error, wide_t point)
+{
+    wide_t error = ref_sat(pid->target - point);
+    wide_t diff = ref_sat(error - *last_error);
+    *int_output = ref_sat(*int_output + ref_mul(error, pid->integration, pid->gain_shift));
+    if(pid->limit_integration)
+        *int_output = ref_clamp(*int_output, pid->max_abs_int_output);
+    *last_error = error;
+    wide_t sum = ref_mul(error, pid->proportion, pid->gain_shift) + *int_output + ref_mul(diff, pid->differention, pid->gain_shift);
+    return ref_clamp(ref_sat(sum), pid->max_abs_output);
+}
+
+static wide_t ref_inc_pid(oh_inc_pid_q_t* pid, wide_t* previous_error, wide_t* last_error, wide_t point)
+{
+    wide_t error = ref_sat(pid->target - point);
+    wide_t sum = ref_mul(ref_sat(error - *last_error), pid->proportion, pid->gain_shift) +
+                 ref_mul(error, pid->integration, pid->gain_shift) +
+                 ref_mul(ref_sat(error + *previous_error - 2 * *last_error), pid->differention, pid->gain_shift);
+    *previous_error = *last_error;
+    *last_error = error;
+    return ref_clamp(ref_sat(sum), pid->max_abs_output);
+}
+
+static void ref_mix(const oh_mixer_t* mixer, wide_t throttle, wide_t roll, wide_t pitch, wide_t yaw, wide_t* outputs)
+{
+    int n = oh_mixer_motors(mixer);
+    wide_t lo = mixer->_output_min_q, hi = mixer->_output_max_q;
+    wide_t mix_min = 0, mix_max = 0;
+    for(int i = 0; i < n; i++)
+    {
+        outputs[i] = ref_sat(ref_mul(roll, mixer->_roll_q[i], 0) + ref_mul(pitch, mixer->_pitch_q[i], 0) + ref_mul(yaw, mixer->_yaw_q[i], 0));
+        mix_min = outputs[i] < mix_min ? outputs[i] : mix_min;
+        mix_max = outputs[i] > mix_max ? outputs[i] : mix_max;
+    }
+    if(!mixer->airmode)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            wide_t output = throttle + outputs[i];
+            outputs[i] = output < lo ? lo : (output > hi ? hi : output);
+        }
+        return;
+    }
+
+    // C division of 128 bits integers rounds toward zero as documented.
+    wide_t range = hi - lo, span = mix_max - mix_min;
+    if(span > range)
+    {
+        for(int i = 0; i < n; i++)
+            outputs[i] = outputs[i] * range / span;
+        mix_min = mix_min * range / span;
+        mix_max = mix_max * range / span;
+    }
+    wide_t base = throttle;
+    if(base < lo - mix_min)
+        base = lo - mix_min;
+    else if(base > hi - mix_max)
+        base = hi - mix_max;
+    for(int i = 0; i < n; i++)
+        outputs[i] = ref_sat(base + outputs[i]);
+}
+
+/******************************* bit-exact checks *****************************/
+static void expect_equal(const char* what, long vector, wide_t got, wide_t want)
+{
+    if(got == want)
+        return;
+    if(failures++ < 10)
+        printf("FAIL: %s, vector %ld: %lld, expected %lld.\n", what, vector, (long long)got, (long long)want);
+}
+
+static void check_mul(long vectors)
+{
+    for(long v = 0; v < vectors; v++)
+    {
+        oh_q31_t x = random_q31();
+        oh_q15_t gain = random_q15();
+        uint8_t shift = rng() % 16;
+        expect_equal("oh_q31_mul_q15", v, oh_q31_mul_q15(x, gain, shift), ref_mul(x, gain, shift));
+    }
+}
+
+static void check_pids(long vectors)
+{
+    // a new pid every 64 vectors, so the states walk through their saturations.
+    oh_pos_pid_q_t pos = { 0 };
+    oh_inc_pid_q_t inc = { 0 };
+    wide_t pos_int = 0, pos_error = 0, inc_previous = 0, inc_last = 0;
+    for(long v = 0; v < vectors; v++)
+    {
+        if(v % 64 == 0)
+        {
+            uint8_t shift = rng() % 16;
+            pos = (oh_pos_pid_q_t){
+                .target = random_q31(), .proportion = random_q15(), .integration = random_q15(), .differention = random_q15(),
+                .gain_shift = shift, .limit_integration = rng() & 1,
+                .max_abs_output = random_q31() & OH_Q31_MAX, .max_abs_int_output = random_q31() & OH_Q31_MAX,
+            };
+            inc = (oh_inc_pid_q_t){
+                .target = random_q31(), .proportion = random_q15(), .integration = random_q15(), .differention = random_q15(),
+                .gain_shift = shift, .max_abs_output = random_q31() & OH_Q31_MAX,
+            };
+            pos_int = pos_error = inc_previous = inc_last = 0;
+        }
+        oh_q31_t point = random_q31();
+        expect_equal("oh_pos_pid_q_calc", v, oh_pos_pid_q_calc(&pos, point), ref_pos_pid(&pos, &pos_int, &pos_error, point));
+        expect_equal("oh_inc_pid_q_calc", v, oh_inc_pid_q_calc(&inc, point), ref_inc_pid(&inc, &inc_previous, &inc_last, point));
+    }
+}
+
+static void check_mixers(long vectors)
+{
+    static const oh_mixer_geometry_t geometries[] = { OH_MIXER_QUAD_X, OH_MIXER_HEX_X, OH_MIXER_OCTO_X };
+    for(long v = 0; v < vectors; v++)
+    {
+        oh_mixer_t mixer = {
+            .geometry = geometries[v % 3], .airmode = (v / 3) & 1,
+            .output_min = 0, .output_max = 100, .full_scale = 100,
+        };
+        // a random output range one vector in 4, inside [-full_scale, full_scale].
+        if(v % 4 == 0)
+        {
+            float a = ((int32_t)(rng() >> 32)) / 2147483648.0f * 100, b = ((int32_t)(rng() >> 32)) / 2147483648.0f * 100;
+            mixer.output_min = fminf(a, b);
+            mixer.output_max = fmaxf(a, b) + 1e-3f;
+        }
+        if(oh_mixer_init(&mixer))
+            continue;
+
+        oh_q31_t throttle = random_q31(), roll = random_q31(), pitch = random_q31(), yaw = random_q31();
+        oh_q31_t outputs[OH_MIXER_MAX_MOTORS];
+        wide_t want[OH_MIXER_MAX_MOTORS];
+        oh_mixer_mix_q(&mixer, throttle, roll, pitch, yaw, outputs);
+        ref_mix(&mixer, throttle, roll, pitch, yaw, want);
+        for(int i = 0; i < oh_mixer_motors(&mixer); i++)
+        {
+            expect_equal("oh_mixer_mix_q", v, outputs[i], want[i]);
+            if(outputs[i] < mixer._output_min_q || outputs[i] > mixer._output_max_q)
+                expect_equal("oh_mixer_mix_q out of range", v, outputs[i], mixer._output_min_q);
+        }
+    }
+}
+
+/******************************* float comparison *****************************/
+static oh_q31_t to_q(float x)
+{
+    return oh_q31_from_float(x, CHECK_FULL_SCALE);
+}
+
+static float to_f(oh_q31_t x)
+{
+    return oh_q31_to_float(x, CHECK_FULL_SCALE);
+}
+
+static void expect_close(const char* what, double max_error)
+{
+    printf("float: %-18s largest difference %.3g of full scale.\n", what, max_error);
+    if(!(max_error <= CHECK_FLOAT_TOLERANCE))
+    {
+        failures ++;
+        printf("FAIL: %s differs from the float path by more than %g of full scale.\n", what, CHECK_FLOAT_TOLERANCE);
+    }
+}
+
+// a gyro of the rate loop: random walk with steps, in deg/s.
+static float gyro_step(float gyro)
+{
+    float next = gyro + ((int32_t)(rng() >> 32)) / 2147483648.0f * 20;
+    if(rng() % 200 == 0)
+        next = ((int32_t)(rng() >> 32)) / 2147483648.0f * 300;
+    return fmaxf(-500, fminf(500, next));
+}
+
+static void check_float(void)
+{
+    // gains of ESP_DRONE_PID_PARAM(veloc_roll), 2.56 needs a gain shift of 2.
+    const float p = 1.5f, i = 0.1f, d = 2.56f;
+    const uint8_t shift = 2;
+    oh_pos_pid_t pos = { .target = 0, .proportion = p, .integration = i, .differention = d, .max_abs_output = 1000,
+                         .configs.limitIntegration = PID_FUNC_ENABLE, .max_abs_int_output = 400 };
+    oh_pos_pid_q_t pos_q = { .target = 0, .proportion = oh_q15_from_float(p, shift), .integration = oh_q15_from_float(i, shift),
+                             .differention = oh_q15_from_float(d, shift), .gain_shift = shift, .limit_integration = 1,
+                             .max_abs_output = to_q(1000), .max_abs_int_output = to_q(400) };
+    oh_inc_pid_t inc = { .target = 0, .proportion = p, .integration = i, .differention = d, .max_abs_output = 1000 };
+    oh_inc_pid_q_t inc_q = { .target = 0, .proportion = pos_q.proportion, .integration = pos_q.integration,
+                             .differention = pos_q.differention, .gain_shift = shift, .max_abs_output = to_q(1000) };
+
+    // the gains themselves are quantized, the float path runs with the quantized gains.
+    pos.proportion = inc.proportion = ldexpf(pos_q.proportion, shift - 15);
+    pos.integration = inc.integration = ldexpf(pos_q.integration, shift - 15);
+    pos.differention = inc.differention = ldexpf(pos_q.differention, shift - 15);
+
+    double pos_error = 0, inc_error = 0;
+    float gyro = 0;
+    for(int n = 0; n < CHECK_FLOAT_STEPS; n++)
+    {
+        gyro = gyro_step(gyro);
+        if(n % 500 == 0)
+            pos.target = inc.target = ((int32_t)(rng() >> 32)) / 2147483648.0f * 200;
+        pos_q.target = inc_q.target = to_q(pos.target);
+        pos_error = fmax(pos_error, fabs(to_f(oh_pos_pid_q_calc(&pos_q, to_q(gyro))) - oh_pos_pid_calc(&pos, gyro)));
+        inc_error = fmax(inc_error, fabs(to_f(oh_inc_pid_q_calc(&inc_q, to_q(gyro))) - oh_inc_pid_calc(&inc, gyro)));
+    }
+    expect_close("oh_pos_pid_q_calc", pos_error / CHECK_FULL_SCALE);
+    expect_close("oh_inc_pid_q_calc", inc_error / CHECK_FULL_SCALE);
+
+    static const oh_mixer_geometry_t geometries[] = { OH_MIXER_QUAD_X, OH_MIXER_HEX_X, OH_MIXER_OCTO_X };
+    double mix_error = 0;
+    for(int g = 0; g < 3; g++)
+    {
+        for(int airmode = 0; airmode <= 1; airmode++)
+        {
+            oh_mixer_t mixer = { .geometry = geometries[g], .airmode = airmode, .output_min = 0, .output_max = 760, .full_scale = CHECK_FULL_SCALE };
+            oh_mixer_init(&mixer);
+            for(int n = 0; n < CHECK_FLOAT_STEPS / 6; n++)
+            {
+                float in[4];
+                for(int k = 0; k < 4; k++)
+                    in[k] = ((int32_t)(rng() >> 32)) / 2147483648.0f * 1000;
+                float outputs[OH_MIXER_MAX_MOTORS];
+                oh_q31_t outputs_q[OH_MIXER_MAX_MOTORS];
+                oh_mixer_mix(&mixer, in[0], in[1], in[2], in[3], outputs);
+                oh_mixer_mix_q(&mixer, to_q(in[0]), to_q(in[1]), to_q(in[2]), to_q(in[3]), outputs_q);
+                for(int k = 0; k < oh_mixer_motors(&mixer); k++)
+                    mix_error = fmax(mix_error, fabs(to_f(outputs_q[k]) - outputs[k]));
+            }
+        }
+    }
+    expect_close("oh_mixer_mix_q", mix_error / CHECK_FULL_SCALE);
+}
+
+/******************************* benchmark ************************************/
+typedef struct {
+    double ns;
+    double tsc;
+} bench_cost_t;
+
+static volatile float float_sink;
+static volatile oh_q31_t q_sink;
+
+#if CHECK_HAS_TSC
+#define BENCH_TSC()                     ((double)__rdtsc())
+#else
+#define BENCH_TSC()                     (0.0)
+#endif
+
+// runs body calls times over the inputs table, in a loop the compiler can not remove.
+#define BENCH(cost, calls, body) do { \
+        double _start = now_s(), _tsc = BENCH_TSC(); \
+        for(long n = 0; n < (calls); n++) { body; } \
+        (cost).tsc = (BENCH_TSC() - _tsc) / (calls); \
+        (cost).ns = (now_s() - _start) / (calls) * 1e9; \
+    } while(0)
+
+#define BENCH_INPUTS                    (1024)
+
+static void bench_print(const char* name, const char* inputs, bench_cost_t f, bench_cost_t q)
+{
+#if CHECK_HAS_TSC
+    printf("  %-10s %-10s %9.2f %9.2f %9.1f %9.1f\n", name, inputs, f.ns, q.ns, f.tsc, q.tsc);
+#else
+    printf("  %-10s %-10s %9.2f %9.2f\n", name, inputs, f.ns, q.ns);
+#endif
+}
+
+static void bench(long calls)
+{
+    static float in_f[2][BENCH_INPUTS];
+    static oh_q31_t in_q[2][BENCH_INPUTS];
+    static const char* names[2] = { "in range", "saturated" };
+    for(int k = 0; k < BENCH_INPUTS; k++)
+    {
+        in_f[0][k] = ((int32_t)(rng() >> 32)) / 2147483648.0f * 300;
+        in_f[1][k] = (k & 1) ? 1e6f : -1e6f;
+        in_q[0][k] = to_q(in_f[0][k]);
+        in_q[1][k] = (k & 1) ? OH_Q31_MAX : OH_Q31_MIN;
+    }
+
+    printf("bench: float path against the fixed-point path, %ld calls.\n", calls);
+#if CHECK_HAS_TSC
+    printf("  %-10s %-10s %9s %9s %9s %9s\n", "function", "inputs", "float ns", "q31 ns", "float tsc", "q31 tsc");
+#else
+    printf("  %-10s %-10s %9s %9s\n", "function", "inputs", "float ns", "q31 ns");
+#endif
+    for(int set = 0; set < 2; set++)
+    {
+        bench_cost_t f, q;
+        oh_pos_pid_t pos = { .proportion = 1.5f, .integration = 0.1f, .differention = 2.56f, .max_abs_output = 1000,
+                             .configs.limitIntegration = PID_FUNC_ENABLE, .max_abs_int_output = 400 };
+        oh_pos_pid_q_t pos_q = { .proportion = oh_q15_from_float(1.5f, 2), .integration = oh_q15_from_float(0.1f, 2),
+                                 .differention = oh_q15_from_float(2.56f, 2), .gain_shift = 2, .limit_integration = 1,
+                                 .max_abs_output = to_q(1000), .max_abs_int_output = to_q(400) };
+        BENCH(f, calls, float_sink = oh_pos_pid_calc(&pos, in_f[set][n % BENCH_INPUTS]));
+        BENCH(q, calls, q_sink = oh_pos_pid_q_calc(&pos_q, in_q[set][n % BENCH_INPUTS]));
+        bench_print("pos pid", names[set], f, q);
+
+        oh_inc_pid_t inc = { .proportion = 1.5f, .integration = 0.1f, .differention = 2.56f, .max_abs_output = 1000 };
+        oh_inc_pid_q_t inc_q = { .proportion = pos_q.proportion, .integration = pos_q.integration, .differention = pos_q.differention,
+                                 .gain_shift = 2, .max_abs_output = to_q(1000) };
+        BENCH(f, calls, float_sink = oh_inc_pid_calc(&inc, in_f[set][n % BENCH_INPUTS]));
+        BENCH(q, calls, q_sink = oh_inc_pid_q_calc(&inc_q, in_q[set][n % BENCH_INPUTS]));
+        bench_print("inc pid", names[set], f, q);
+
+        oh_mixer_t mixer = { .geometry = OH_MIXER_QUAD_X, .airmode = 1, .output_min = 0, .output_max = 760, .full_scale = CHECK_FULL_SCALE };
+        oh_mixer_init(&mixer);
+        float outputs[OH_MIXER_MAX_MOTORS];
+        oh_q31_t outputs_q[OH_MIXER_MAX_MOTORS];
+        BENCH(f, calls, {
+            const float* x = &in_f[set][n % (BENCH_INPUTS - 3)];
+            oh_mixer_mix(&mixer, x[0], x[1], x[2], x[3], outputs);
+            float_sink = outputs[0];
+        });
+        BENCH(q, calls, {
+            const oh_q31_t* x = &in_q[set][n % (BENCH_INPUTS - 3)];
+            oh_mixer_mix_q(&mixer, x[0], x[1], x[2], x[3], outputs_q);
+            q_sink = outputs_q[0];
+        });
+        bench_print("quad mix", names[set], f, q);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    long vectors = CHECK_VECTORS, calls = CHECK_BENCH_CALLS;
+    int opt;
+    while((opt = getopt(argc, argv, "n:b:r:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n':
+            vectors = atol(optarg);
+            break;
+        case 'b':
+            calls = atol(optarg);
+            break;
+        case 'r':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        default:
+            goto usage;
+        }
+    }
+    if(vectors <= 0 || calls <= 0)
+        goto usage;
+
+    check_mul(vectors);
+    check_pids(vectors);
+    check_mixers(vectors);
+    printf("bit-exact: %ld vectors of oh_q31_mul_q15, the pids and the mixers.\n", vectors);
+    check_float();
+    printf("checks: %d failures.\n", failures);
+    bench(calls);
+    return failures ? 1 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-n random vectors] [-b bench calls] [-r random seed]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
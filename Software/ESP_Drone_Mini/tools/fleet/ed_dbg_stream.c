@@ -0,0 +1,103 @@
+#include "ed_dbg_stream.h"
+
+#include <string.h>
+
+#include "ed_justfloat.h"
+
+uint8_t ed_dbg_checksum(const uint8_t* data, int len)
+{
+    uint8_t sum = 0;
+    for(int i = 0; i < len; i++)
+        sum += data[i];
+    return sum;
+}
+
+/**
+ * @brief: Pack a frame.
+ * @param:
+ *      - uint8_t* frame : room for len + ED_DBG_FRAME_OVERHEAD bytes.
+ * @return: size of the frame.
+ */
+int ed_dbg_pack_frame(uint8_t* frame, uint8_t cmd, const void* payload, uint16_t len)
+{
+    frame[0] = ED_DBG_SYNC0;
+    frame[1] = ED_DBG_SYNC1;
+    frame[2] = cmd;
+    frame[3] = len & 0xff;
+    frame[4] = len >> 8;
+    if(len)
+        memmove(frame + ED_DBG_HEADER_SIZE, payload, len);
+    frame[ED_DBG_HEADER_SIZE + len] = ed_dbg_checksum(frame + 2, len + 3);
+    return len + ED_DBG_FRAME_OVERHEAD;
+}
+
+/**
+ * @brief: Parse the buffer from a boundary.
+ * @return: bytes consumed, 0 if more data is needed.
+ */
+static int __ed_dbg_stream_next(ed_dbg_stream_t* stream, const uint8_t* data, int len)
+{
+    // 1. a frame.
+    if(len >= 2 && data[0] == ED_DBG_SYNC0 && data[1] == ED_DBG_SYNC1)
+    {
+        if(len < ED_DBG_HEADER_SIZE)
+            return 0;
+        int payload_len = data[3] | (data[4] << 8);
+        if(payload_len <= ED_DBG_MAX_PAYLOAD)
+        {
+            if(len < payload_len + ED_DBG_FRAME_OVERHEAD)
+                return 0;
+            if(ed_dbg_checksum(data + 2, payload_len + 3) == data[ED_DBG_HEADER_SIZE + payload_len])
+            {
+                if(stream->on_frame)
+                    stream->on_frame(stream->ctx, data[2], data + ED_DBG_HEADER_SIZE, payload_len);
+                return payload_len + ED_DBG_FRAME_OVERHEAD;
+            }
+        }
+    } else if(len == 1 && data[0] == ED_DBG_SYNC0) {
+        return 0;
+    }
+
+    // 2. a JustFloat packet.
+    size_t words = len / 4;
+    if(words > ED_DBG_STREAM_MAX_FLOATS + 1)
+        words = ED_DBG_STREAM_MAX_FLOATS + 1;
+    size_t tail = ed_justfloat_find_tail(data, words);
+    if(tail < words)
+    {
+        float values[ED_DBG_STREAM_MAX_FLOATS];
+        memcpy(values, data, 4 * tail);
+        if(tail && stream->on_floats)
+            stream->on_floats(stream->ctx, values, (int)tail);
+        return 4 * (int)(tail + 1);
+    }
+    if(words <= ED_DBG_STREAM_MAX_FLOATS)
+        return 0;
+
+    // 3. neither, resync.
+    stream->skipped ++;
+    return 1;
+}
+
+/**
+ * @brief: Append received bytes and report the complete packets and frames.
+ */
+void ed_dbg_stream_feed(ed_dbg_stream_t* stream, const uint8_t* data, int len)
+{
+    while(len > 0)
+    {
+        int n = (int)sizeof(stream->_buffer) - stream->_len;
+        if(n > len)
+            n = len;
+        memcpy(stream->_buffer + stream->_len, data, n);
+        stream->_len += n;
+        data += n;
+        len -= n;
+
+        int offset = 0, used;
+        while(offset < stream->_len && (used = __ed_dbg_stream_next(stream, stream->_buffer + offset, stream->_len - offset)) > 0)
+            offset += used;
+        memmove(stream->_buffer, stream->_buffer + offset, stream->_len - offset);
+        stream->_len -= offset;
+    }
+}
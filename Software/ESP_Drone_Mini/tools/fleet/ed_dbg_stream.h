@@ -0,0 +1,60 @@
+#ifndef __ED_DBG_STREAM_H__
+#define __ED_DBG_STREAM_H__
+
+#include <stdint.h>
+
+#include "ed_debugger_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// longest JustFloat packet accepted, in floats.
+#define ED_DBG_STREAM_MAX_FLOATS        (64)
+
+/**
+ * @brief: Splitter of a debugger byte stream into JustFloat packets and binary frames.
+ * @param:
+ *      @configs:
+ *          on_floats  : called for every JustFloat packet, without the tail.
+ *          on_frame   : called for every frame with a valid checksum, in both directions.
+ *          ctx        : first argument of the callbacks.
+ *      @status(read only):
+ *          uint32_t skipped : bytes skipped to resync.
+ * @note: frames and packets follow each other at boundaries, a frame is recognized by its sync bytes and
+ *          checksum, anything else is scanned for the JustFloat tail.
+ */
+typedef struct {
+    // configs
+    void (*on_floats)(void* ctx, const float* values, int n);
+    void (*on_frame)(void* ctx, uint8_t cmd, const uint8_t* payload, int len);
+    void* ctx;
+
+    // status
+    uint32_t skipped;
+
+    // private realizations.
+    int _len;
+    uint8_t _buffer[2 * ED_DBG_MAX_FRAME];
+} ed_dbg_stream_t;
+
+/**
+ * @brief: Append received bytes and report the complete packets and frames.
+ */
+void ed_dbg_stream_feed(ed_dbg_stream_t* stream, const uint8_t* data, int len);
+
+/**
+ * @brief: Pack a frame.
+ * @param:
+ *      - uint8_t* frame : room for len + ED_DBG_FRAME_OVERHEAD bytes.
+ * @return: size of the frame.
+ */
+int ed_dbg_pack_frame(uint8_t* frame, uint8_t cmd, const void* payload, uint16_t len);
+
+uint8_t ed_dbg_checksum(const uint8_t* data, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,762 @@
+/**
+ * @note: Ground station aggregator of a fleet of drones.
+ *          Keeps a connection to the ed_debugger port of every drone in one epoll loop(non-blocking
+ *          connects, retried every second), and speaks the binary protocol of ed_debugger_protocol.h:
+ *              - the parameter table of every drone is read with ED_DBG_CMD_LIST after it connects.
+ *              - writes(-w name=value at start, or `set name value` on stdin) and reads(`get name`) are
+ *                fanned out to every drone which has the parameter, the replies and round-trip times
+ *                are summarized when all drones answered or after 2 seconds.
+ *              - JustFloat and compact(ED_DBG_CMD_TELEMETRY) telemetry are both accepted.
+ *          The telemetry is time-aligned on the reception clock of this host: every -a ms a row holding
+ *          the newest sample of each drone is written to the CSV of -o, with the channels of -s.
+ *          With -L, channel 0 is taken as the send time of ed_fleet_sim and the latency is measured.
+ *          `stats` on stdin prints the counters, they are also printed at the end.
+ *
+ *          usage: ed_fleet [-n drones -p base port | host[:port] ...] [-a align ms] [-o csv] [-s ch,ch,...]
+ *                          [-w name=value]... [-t seconds] [-L]
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#include "ed_dbg_stream.h"
+#include "ed_param.h"
+#include "ed_tlm_codec.h"
+
+#define FLEET_MAX_DRONES                (1024)
+#define FLEET_MAX_CHANNELS              (ED_DBG_STREAM_MAX_FLOATS)
+#define FLEET_MAX_OPS                   (64)
+#define FLEET_OUT_BUFFER_SIZE           (8192)
+#define FLEET_OP_TIMEOUT_NS             (2000000000ll)
+#define FLEET_RECONNECT_NS              (1000000000ll)
+#define FLEET_LIST_WAIT_NS              (3000000000ll)
+// latency histogram of -L, 10 us bins up to 1 s.
+#define FLEET_LATENCY_BIN_US            (10)
+#define FLEET_LATENCY_BINS              (100000)
+#define FLEET_TIME_WRAP_US              (1 << 24)
+
+// epoll data of the non-drone descriptors.
+#define FLEET_EVENT_TIMER               (UINT64_MAX)
+#define FLEET_EVENT_STDIN               (UINT64_MAX - 1)
+
+typedef struct {
+    char name[ED_PARAM_MAX_NAME_LEN + 1];
+    uint16_t id;
+    uint8_t type;
+} fleet_param_t;
+
+typedef struct {
+    int index;
+    char host[128];
+    char port[16];
+    int fd;
+    bool connecting;
+    int64_t retry_ns;
+    uint32_t connections;
+
+    ed_dbg_stream_t stream;
+    ed_tlm_decoder_t tlm;
+
+    // newest sample.
+    float values[FLEET_MAX_CHANNELS];
+    int channels;
+    uint64_t packets;
+    uint64_t bytes;
+
+    // parameter table.
+    fleet_param_t params[ED_PARAM_MAX_NUM];
+    int param_count;
+    bool listed;
+
+    // reply to the active operation.
+    bool targeted;
+    bool replied;
+    int8_t status;
+    float value;
+    int64_t rtt_ns;
+
+    int out_len;
+    uint8_t out[FLEET_OUT_BUFFER_SIZE];
+} fleet_drone_t;
+
+typedef struct {
+    char name[ED_PARAM_MAX_NAME_LEN + 1];
+    bool is_set;
+    float value;
+} fleet_op_t;
+
+typedef struct {
+    fleet_drone_t* drones;
+    int count;
+    int epoll_fd;
+
+    // queued operations, ops[0] is active when op_active.
+    fleet_op_t ops[FLEET_MAX_OPS];
+    int op_count;
+    bool op_active;
+    int64_t op_start_ns;
+
+    // aligned output.
+    FILE* output;
+    int selected[FLEET_MAX_CHANNELS];
+    int selected_count;
+    int64_t start_ns;
+
+    bool latency;
+    uint32_t* latency_bins;
+    uint64_t latency_samples;
+    int64_t latency_max_us;
+} fleet_t;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static void drone_watch(fleet_t* fleet, fleet_drone_t* drone, int op)
+{
+    struct epoll_event event = {
+        .events = EPOLLIN | ((drone->connecting || drone->out_len) ? EPOLLOUT : 0),
+        .data.u64 = drone->index,
+    };
+    epoll_ctl(fleet->epoll_fd, op, drone->fd, &event);
+}
+
+static void drone_disconnect(fleet_t* fleet, fleet_drone_t* drone)
+{
+    if(drone->fd < 0)
+        return;
+    if(!drone->connecting)
+        fprintf(stderr, "drone %d(%s:%s) disconnected.\n", drone->index, drone->host, drone->port);
+    epoll_ctl(fleet->epoll_fd, EPOLL_CTL_DEL, drone->fd, NULL);
+    close(drone->fd);
+    drone->fd = -1;
+    drone->connecting = false;
+    drone->listed = false;
+    drone->channels = 0;
+    drone->out_len = 0;
+    drone->retry_ns = now_ns() + FLEET_RECONNECT_NS;
+}
+
+static void drone_flush(fleet_t* fleet, fleet_drone_t* drone)
+{
+    if(drone->connecting || drone->out_len == 0)
+        return;
+
+    ssize_t n = send(drone->fd, drone->out, drone->out_len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        drone_disconnect(fleet, drone);
+        return;
+    }
+    if(n > 0)
+    {
+        memmove(drone->out, drone->out + n, drone->out_len - n);
+        drone->out_len -= n;
+    }
+    drone_watch(fleet, drone, EPOLL_CTL_MOD);
+}
+
+static void drone_request(fleet_t* fleet, fleet_drone_t* drone, uint8_t cmd, const uint8_t* payload, uint16_t len)
+{
+    if(drone->out_len + len + ED_DBG_FRAME_OVERHEAD > FLEET_OUT_BUFFER_SIZE)
+    {
+        fprintf(stderr, "drone %d does not read its requests.\n", drone->index);
+        drone_disconnect(fleet, drone);
+        return;
+    }
+    drone->out_len += ed_dbg_pack_frame(drone->out + drone->out_len, cmd, payload, len);
+    drone_flush(fleet, drone);
+}
+
+static void drone_list_from(fleet_t* fleet, fleet_drone_t* drone, uint16_t id)
+{
+    uint8_t payload[2] = { id & 0xff, id >> 8 };
+    drone_request(fleet, drone, ED_DBG_CMD_LIST, payload, 2);
+}
+
+static void drone_connect(fleet_t* fleet, fleet_drone_t* drone)
+{
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* result;
+    drone->retry_ns = now_ns() + FLEET_RECONNECT_NS;
+    if(getaddrinfo(drone->host, drone->port, &hints, &result))
+        return;
+
+    drone->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if(drone->fd >= 0)
+    {
+        int nodelay = 1;
+        setsockopt(drone->fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        if(connect(drone->fd, result->ai_addr, result->ai_addrlen) == 0 || errno == EINPROGRESS)
+        {
+            drone->connecting = true;
+            drone_watch(fleet, drone, EPOLL_CTL_ADD);
+        } else {
+            close(drone->fd);
+            drone->fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+}
+
+static void drone_connected(fleet_t* fleet, fleet_drone_t* drone)
+{
+    drone->connecting = false;
+    drone->connections ++;
+    drone->stream._len = 0;
+    drone->param_count = 0;
+    ed_tlm_decoder_reset(&drone->tlm);
+    drone_watch(fleet, drone, EPOLL_CTL_MOD);
+    drone_list_from(fleet, drone, 0);
+}
+
+static const fleet_param_t* drone_find_param(const fleet_drone_t* drone, const char* name)
+{
+    for(int i = 0; i < drone->param_count; i++)
+    {
+        if(!strcmp(drone->params[i].name, name))
+            return &drone->params[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Send the queued operation to every listed drone which has the parameter.
+ */
+static void fleet_start_op(fleet_t* fleet)
+{
+    const fleet_op_t* op = &fleet->ops[0];
+    fleet->op_active = true;
+    fleet->op_start_ns = now_ns();
+
+    for(int i = 0; i < fleet->count; i++)
+    {
+        fleet_drone_t* drone = &fleet->drones[i];
+        const fleet_param_t* param = drone->listed ? drone_find_param(drone, op->name) : NULL;
+        drone->targeted = param != NULL;
+        drone->replied = false;
+        if(param == NULL)
+            continue;
+
+        uint8_t payload[ED_DBG_SET_REQ_ITEM_SIZE] = { param->id & 0xff, param->id >> 8 };
+        if(op->is_set)
+        {
+            if(param->type == ED_PARAM_FLOAT)
+            {
+                memcpy(payload + 2, &op->value, 4);
+            } else {
+                int32_t value = (int32_t)lroundf(op->value);
+                memcpy(payload + 2, &value, 4);
+            }
+        }
+        drone_request(fleet, drone, op->is_set ? ED_DBG_CMD_SET : ED_DBG_CMD_GET, payload,
+            op->is_set ? ED_DBG_SET_REQ_ITEM_SIZE : ED_DBG_GET_REQ_ITEM_SIZE);
+    }
+}
+
+static int compare_int64(const void* a, const void* b)
+{
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief: Summarize the active operation when all drones replied or it timed out, and start the next one.
+ */
+static void fleet_check_op(fleet_t* fleet, bool force)
+{
+    if(!fleet->op_active)
+        return;
+
+    int targets = 0, replies = 0, ok = 0;
+    for(int i = 0; i < fleet->count; i++)
+    {
+        targets += fleet->drones[i].targeted;
+        replies += fleet->drones[i].replied;
+    }
+    if(replies < targets && !force && now_ns() - fleet->op_start_ns < FLEET_OP_TIMEOUT_NS)
+        return;
+
+    const fleet_op_t* op = &fleet->ops[0];
+    int64_t rtts[FLEET_MAX_DRONES];
+    int n = 0;
+    float min = INFINITY, max = -INFINITY;
+    for(int i = 0; i < fleet->count; i++)
+    {
+        const fleet_drone_t* drone = &fleet->drones[i];
+        if(!drone->replied)
+        {
+            if(drone->targeted)
+                printf("  drone %d: no reply.\n", i);
+            continue;
+        }
+        rtts[n++] = drone->rtt_ns;
+        if(drone->status == ED_PARAM_OK)
+            ok ++;
+        else
+            printf("  drone %d: status %d.\n", i, drone->status);
+        min = fminf(min, drone->value);
+        max = fmaxf(max, drone->value);
+    }
+    qsort(rtts, n, sizeof(int64_t), compare_int64);
+    if(op->is_set)
+        printf("set %s = %g: ", op->name, op->value);
+    else
+        printf("get %s: ", op->name);
+    printf("%d/%d drones ok, %d without it", ok, targets, fleet->count - targets);
+    if(n)
+        printf(", value %g~%g, rtt p50 %.2f ms, max %.2f ms", min, max, rtts[n / 2] / 1e6, rtts[n - 1] / 1e6);
+    printf(".\n");
+    fflush(stdout);
+
+    fleet->op_active = false;
+    memmove(&fleet->ops[0], &fleet->ops[1], (fleet->op_count - 1) * sizeof(fleet_op_t));
+    fleet->op_count --;
+}
+
+static void fleet_queue_op(fleet_t* fleet, const char* name, bool is_set, float value)
+{
+    if(fleet->op_count >= FLEET_MAX_OPS)
+    {
+        fprintf(stderr, "too many queued operations.\n");
+        return;
+    }
+    fleet_op_t* op = &fleet->ops[fleet->op_count++];
+    snprintf(op->name, sizeof(op->name), "%s", name);
+    op->is_set = is_set;
+    op->value = value;
+}
+
+static void on_values(fleet_t* fleet, fleet_drone_t* drone, const float* values, int n)
+{
+    if(n > FLEET_MAX_CHANNELS)
+        n = FLEET_MAX_CHANNELS;
+    memcpy(drone->values, values, n * sizeof(float));
+    drone->channels = n;
+    drone->packets ++;
+
+    if(fleet->latency)
+    {
+        int64_t now_us = now_ns() / 1000;
+        int64_t latency = ((now_us - (int64_t)values[0]) % FLEET_TIME_WRAP_US + FLEET_TIME_WRAP_US) % FLEET_TIME_WRAP_US;
+        int64_t bin = latency / FLEET_LATENCY_BIN_US;
+        fleet->latency_bins[bin < FLEET_LATENCY_BINS ? bin : FLEET_LATENCY_BINS - 1] ++;
+        fleet->latency_samples ++;
+        if(latency > fleet->latency_max_us)
+            fleet->latency_max_us = latency;
+    }
+}
+
+typedef struct {
+    fleet_t* fleet;
+    fleet_drone_t* drone;
+} fleet_stream_ctx_t;
+
+static void on_floats(void* ctx, const float* values, int n)
+{
+    fleet_stream_ctx_t* c = ctx;
+    on_values(c->fleet, c->drone, values, n);
+}
+
+static void on_frame(void* ctx, uint8_t cmd, const uint8_t* payload, int len)
+{
+    fleet_stream_ctx_t* c = ctx;
+    fleet_t* fleet = c->fleet;
+    fleet_drone_t* drone = c->drone;
+
+    switch(cmd)
+    {
+    case ED_DBG_CMD_TELEMETRY:
+    {
+        float values[ED_TLM_MAX_CHANNELS];
+        int n = ed_tlm_decode(&drone->tlm, payload, len, values);
+        if(n > 0)
+            on_values(fleet, drone, values, n);
+        break;
+    }
+
+    case ED_DBG_CMD_LIST | ED_DBG_CMD_RESPONSE:
+    {
+        if(len < 2)
+            break;
+        int total = payload[0] | (payload[1] << 8), offset = 2, last = -1;
+        while(offset + ED_DBG_LIST_ENTRY_FIXED_SIZE <= len)
+        {
+            const uint8_t* entry = payload + offset;
+            int name_len = entry[15];
+            if(offset + ED_DBG_LIST_ENTRY_FIXED_SIZE + name_len > len)
+                break;
+            last = entry[0] | (entry[1] << 8);
+            if(drone->param_count < ED_PARAM_MAX_NUM && name_len && name_len <= ED_PARAM_MAX_NAME_LEN)
+            {
+                fleet_param_t* param = &drone->params[drone->param_count++];
+                param->id = last;
+                param->type = entry[2];
+                memcpy(param->name, entry + 16, name_len);
+                param->name[name_len] = '\0';
+            }
+            offset += ED_DBG_LIST_ENTRY_FIXED_SIZE + name_len;
+        }
+        if(last >= 0 && last + 1 < total)
+            drone_list_from(fleet, drone, last + 1);
+        else
+            drone->listed = true;
+        break;
+    }
+
+    case ED_DBG_CMD_GET | ED_DBG_CMD_RESPONSE:
+    case ED_DBG_CMD_SET | ED_DBG_CMD_RESPONSE:
+    {
+        const fleet_param_t* param;
+        if(!fleet->op_active || !drone->targeted || drone->replied || len < ED_DBG_RSP_ITEM_SIZE
+            || (param = drone_find_param(drone, fleet->ops[0].name)) == NULL)
+            break;
+        drone->replied = true;
+        drone->rtt_ns = now_ns() - fleet->op_start_ns;
+        drone->status = (int8_t)payload[2];
+        if(param->type == ED_PARAM_FLOAT)
+        {
+            memcpy(&drone->value, payload + 3, 4);
+        } else {
+            int32_t value;
+            memcpy(&value, payload + 3, 4);
+            drone->value = value;
+        }
+        fleet_check_op(fleet, false);
+        break;
+    }
+
+    case ED_DBG_CMD_ERROR | ED_DBG_CMD_RESPONSE:
+        fprintf(stderr, "drone %d: command 0x%02x failed with %d.\n", drone->index, len > 0 ? payload[0] : 0, len > 1 ? (int8_t)payload[1] : 0);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void on_drone_event(fleet_t* fleet, fleet_drone_t* drone, uint32_t events)
+{
+    if(drone->fd < 0)
+        return;
+
+    if(drone->connecting)
+    {
+        int error = 0;
+        socklen_t size = sizeof(error);
+        if((events & (EPOLLERR | EPOLLHUP)) || getsockopt(drone->fd, SOL_SOCKET, SO_ERROR, &error, &size) || error)
+        {
+            drone_disconnect(fleet, drone);
+            return;
+        }
+        if(events & EPOLLOUT)
+            drone_connected(fleet, drone);
+        return;
+    }
+
+    if(events & EPOLLOUT)
+        drone_flush(fleet, drone);
+    if(events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+    {
+        static uint8_t buffer[65536];
+        ssize_t n = recv(drone->fd, buffer, sizeof(buffer), 0);
+        if(n > 0)
+        {
+            drone->bytes += n;
+            ed_dbg_stream_feed(&drone->stream, buffer, n);
+        } else if(n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            drone_disconnect(fleet, drone);
+        }
+    }
+}
+
+static void write_aligned_row(fleet_t* fleet)
+{
+    fprintf(fleet->output, "%.3f", (now_ns() - fleet->start_ns) / 1e9);
+    for(int i = 0; i < fleet->count; i++)
+    {
+        const fleet_drone_t* drone = &fleet->drones[i];
+        for(int j = 0; j < fleet->selected_count; j++)
+        {
+            int channel = fleet->selected[j];
+            if(channel < drone->channels)
+                fprintf(fleet->output, ",%g", drone->values[channel]);
+            else
+                fputc(',', fleet->output);
+        }
+    }
+    fputc('\n', fleet->output);
+}
+
+static void print_stats(fleet_t* fleet)
+{
+    uint64_t packets = 0, bytes = 0, min = UINT64_MAX, max = 0;
+    int connected = 0;
+    uint32_t connections = 0;
+    for(int i = 0; i < fleet->count; i++)
+    {
+        const fleet_drone_t* drone = &fleet->drones[i];
+        connected += drone->fd >= 0 && !drone->connecting;
+        connections += drone->connections;
+        packets += drone->packets;
+        bytes += drone->bytes;
+        min = drone->packets < min ? drone->packets : min;
+        max = drone->packets > max ? drone->packets : max;
+    }
+    double seconds = (now_ns() - fleet->start_ns) / 1e9;
+    printf("%d/%d drones connected(%lu connections), %llu packets(%llu~%llu per drone) in %.2f s, %.0f packets/s, %.2f MB/s.\n",
+        connected, fleet->count, (unsigned long)connections, (unsigned long long)packets, (unsigned long long)min,
+        (unsigned long long)max, seconds, packets / seconds, bytes / seconds / 1e6);
+
+    if(fleet->latency && fleet->latency_samples)
+    {
+        const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+        uint64_t seen = 0;
+        int q = 0;
+        printf("latency:");
+        for(int bin = 0; bin < FLEET_LATENCY_BINS && q < 4; bin++)
+        {
+            seen += fleet->latency_bins[bin];
+            while(q < 4 && seen >= quantiles[q] * fleet->latency_samples)
+                printf(" p%g %.2f ms", quantiles[q++] * 100, (bin + 1) * FLEET_LATENCY_BIN_US / 1e3);
+        }
+        printf(", max %.2f ms.\n", fleet->latency_max_us / 1e3);
+    }
+    fflush(stdout);
+}
+
+static void on_stdin(fleet_t* fleet)
+{
+    static char line[256];
+    static int len = 0;
+    ssize_t n = read(STDIN_FILENO, line + len, sizeof(line) - 1 - len);
+    if(n <= 0)
+    {
+        epoll_ctl(fleet->epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, NULL);
+        return;
+    }
+    len += n;
+
+    char* end;
+    while((end = memchr(line, '\n', len)) != NULL)
+    {
+        *end = '\0';
+        char name[ED_PARAM_MAX_NAME_LEN + 1];
+        float value;
+        if(sscanf(line, "set %31s %f", name, &value) == 2)
+            fleet_queue_op(fleet, name, true, value);
+        else if(sscanf(line, "get %31s", name) == 1)
+            fleet_queue_op(fleet, name, false, 0);
+        else if(!strncmp(line, "stats", 5))
+            print_stats(fleet);
+        else if(line[0])
+            fprintf(stderr, "commands: set <name> <value>, get <name>, stats\n");
+
+        int used = end - line + 1;
+        memmove(line, line + used, len - used);
+        len -= used;
+    }
+    if(len == sizeof(line) - 1)
+        len = 0;
+}
+
+static int parse_selection(fleet_t* fleet, const char* list)
+{
+    fleet->selected_count = 0;
+    while(*list && fleet->selected_count < FLEET_MAX_CHANNELS)
+    {
+        char* end;
+        long channel = strtol(list, &end, 0);
+        if(end == list || channel < 0 || channel >= FLEET_MAX_CHANNELS)
+            return -1;
+        fleet->selected[fleet->selected_count++] = channel;
+        list = *end == ',' ? end + 1 : end;
+    }
+    return fleet->selected_count ? 0 : -1;
+}
+
+int main(int argc, char** argv)
+{
+    static fleet_t fleet;
+    int count = 0, base_port = 9000, align_ms = 10;
+    double seconds = 0;
+    const char* output = NULL;
+    for(int i = 0; i < 10; i++)
+        fleet.selected[i] = i;
+    fleet.selected_count = 10;
+
+    int opt;
+    while((opt = getopt(argc, argv, "n:p:a:o:s:w:t:Lh")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n': count = atoi(optarg); break;
+        case 'p': base_port = atoi(optarg); break;
+        case 'a': align_ms = atoi(optarg); break;
+        case 'o': output = optarg; break;
+        case 's':
+            if(parse_selection(&fleet, optarg))
+                goto usage;
+            break;
+        case 'w':
+        {
+            char name[ED_PARAM_MAX_NAME_LEN + 1];
+            float value;
+            if(sscanf(optarg, "%31[^=]=%f", name, &value) != 2)
+                goto usage;
+            fleet_queue_op(&fleet, name, true, value);
+            break;
+        }
+        case 't': seconds = atof(optarg); break;
+        case 'L': fleet.latency = true; break;
+        default:
+            goto usage;
+        }
+    }
+    if(optind < argc)
+        count = argc - optind;
+    if(count < 1 || count > FLEET_MAX_DRONES || align_ms < 1)
+        goto usage;
+
+    fleet.count = count;
+    fleet.drones = calloc(count, sizeof(fleet_drone_t));
+    fleet.latency_bins = calloc(FLEET_LATENCY_BINS, sizeof(uint32_t));
+    fleet.epoll_fd = epoll_create1(0);
+    if(fleet.drones == NULL || fleet.latency_bins == NULL || fleet.epoll_fd < 0)
+        return 1;
+
+    static fleet_stream_ctx_t contexts[FLEET_MAX_DRONES];
+    for(int i = 0; i < count; i++)
+    {
+        fleet_drone_t* drone = &fleet.drones[i];
+        drone->index = i;
+        drone->fd = -1;
+        if(optind < argc)
+        {
+            // host[:port], the port of the debugger by default.
+            snprintf(drone->host, sizeof(drone->host), "%s", argv[optind + i]);
+            char* colon = strrchr(drone->host, ':');
+            snprintf(drone->port, sizeof(drone->port), "%s", colon ? colon + 1 : "8080");
+            if(colon)
+                *colon = '\0';
+        } else {
+            snprintf(drone->host, sizeof(drone->host), "127.0.0.1");
+            snprintf(drone->port, sizeof(drone->port), "%d", base_port + i);
+        }
+        contexts[i] = (fleet_stream_ctx_t){ .fleet = &fleet, .drone = drone };
+        drone->stream = (ed_dbg_stream_t){ .on_floats = on_floats, .on_frame = on_frame, .ctx = &contexts[i] };
+    }
+
+    if(output)
+    {
+        fleet.output = fopen(output, "w");
+        if(fleet.output == NULL)
+        {
+            fprintf(stderr, "can not write %s.\n", output);
+            return 1;
+        }
+        fprintf(fleet.output, "time");
+        for(int i = 0; i < count; i++)
+            for(int j = 0; j < fleet.selected_count; j++)
+                fprintf(fleet.output, ",d%d.ch%d", i, fleet.selected[j]);
+        fputc('\n', fleet.output);
+    }
+
+    struct sigaction action = { .sa_handler = on_signal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // the alignment period also drives the reconnections and the timeouts.
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    struct itimerspec spec = { .it_interval = { align_ms / 1000, align_ms % 1000 * 1000000l }, .it_value = { 0, 1 } };
+    timerfd_settime(timer, 0, &spec, NULL);
+    struct epoll_event event = { .events = EPOLLIN, .data.u64 = FLEET_EVENT_TIMER };
+    epoll_ctl(fleet.epoll_fd, EPOLL_CTL_ADD, timer, &event);
+    event.data.u64 = FLEET_EVENT_STDIN;
+    epoll_ctl(fleet.epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &event);
+
+    fleet.start_ns = now_ns();
+    for(int i = 0; i < count; i++)
+        drone_connect(&fleet, &fleet.drones[i]);
+
+    static struct epoll_event events[256];
+    while(!stop)
+    {
+        int n = epoll_wait(fleet.epoll_fd, events, 256, 1000);
+        for(int e = 0; e < n; e++)
+        {
+            uint64_t id = events[e].data.u64;
+            if(id == FLEET_EVENT_STDIN)
+            {
+                on_stdin(&fleet);
+            } else if(id == FLEET_EVENT_TIMER) {
+                uint64_t expirations;
+                if(read(timer, &expirations, sizeof(expirations)) != sizeof(expirations))
+                    continue;
+                if(fleet.output)
+                    write_aligned_row(&fleet);
+
+                int64_t now = now_ns();
+                bool waiting = false;
+                for(int i = 0; i < count; i++)
+                {
+                    fleet_drone_t* drone = &fleet.drones[i];
+                    if(drone->fd < 0 && now >= drone->retry_ns)
+                        drone_connect(&fleet, drone);
+                    waiting |= drone->fd < 0 || !drone->listed;
+                }
+                fleet_check_op(&fleet, false);
+                // the first operation waits a while for the tables of all the drones.
+                if(!fleet.op_active && fleet.op_count && (!waiting || now - fleet.start_ns > FLEET_LIST_WAIT_NS))
+                    fleet_start_op(&fleet);
+                if(seconds > 0 && now - fleet.start_ns >= seconds * 1e9)
+                    stop = 1;
+            } else {
+                on_drone_event(&fleet, &fleet.drones[id], events[e].events);
+            }
+        }
+    }
+
+    fleet_check_op(&fleet, true);
+    print_stats(&fleet);
+    if(fleet.output)
+        fclose(fleet.output);
+    for(int i = 0; i < count; i++)
+    {
+        if(fleet.drones[i].fd >= 0)
+            close(fleet.drones[i].fd);
+    }
+    free(fleet.drones);
+    free(fleet.latency_bins);
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-n drones -p base port | host[:port] ...] [-a align ms] [-o csv] [-s ch,ch,...]\n"
+        "          [-w name=value]... [-t seconds] [-L]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
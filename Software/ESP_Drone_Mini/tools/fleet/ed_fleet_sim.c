@@ -0,0 +1,385 @@
+/**
+ * @note: Simulated fleet of ed_debugger servers, to run ed_fleet without drones.
+ *          Drone i listens on port base + i, all of them in one epoll loop. A connected drone sends
+ *          JustFloat telemetry at -r Hz and answers ED_DBG_CMD_LIST/GET/SET on a small parameter table
+ *          of its own. ED_DBG_CMD_PROFILE returns two probes measured on the host, in the cycles of a
+ *          240MHz core: tick.period is the interval between two telemetry packets of the drone and
+ *          tick.total the time spent sending one, so that ed_profile can be run without drones. Channel 0 of the telemetry is the send time in us(CLOCK_MONOTONIC modulo 2^24),
+ *          so that ed_fleet -L can measure the latency on the same host. A telemetry packet which the
+ *          socket does not accept is dropped and counted, as the firmware does.
+ *
+ *          usage: ed_fleet_sim [-n drones] [-p base port] [-r rate] [-c channels]
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#include "ed_dbg_stream.h"
+
+#define SIM_MAX_DRONES                  (1024)
+#define SIM_MAX_CHANNELS                (32)
+#define SIM_TIME_WRAP_US                (1 << 24)
+#define SIM_CYCLES_PER_US               (240)
+#define SIM_HIST_BINS                   (128)
+
+static const char* param_names[] = {
+    "base_rps", "veloc_roll.P", "veloc_roll.I", "veloc_roll.D", "veloc_pitch.P", "veloc_pitch.I", "veloc_pitch.D", "tlm.mode",
+};
+#define SIM_PARAMS                      ((int)(sizeof(param_names) / sizeof(param_names[0])))
+
+// a probe in the layout of ed_profiler_probe_t.
+typedef struct {
+    const char* name;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[SIM_HIST_BINS];
+} sim_probe_t;
+
+typedef struct {
+    int index;
+    int server;
+    int client;
+    ed_dbg_stream_t stream;
+    float params[SIM_PARAMS];
+    uint64_t packets;
+    uint64_t dropped;
+    uint64_t requests;
+    int64_t last_send_us;
+    sim_probe_t probes[2];
+} sim_drone_t;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void probe_reset(sim_probe_t* probe)
+{
+    const char* name = probe->name;
+    memset(probe, 0x00, sizeof(*probe));
+    probe->name = name;
+    probe->min = UINT32_MAX;
+}
+
+// the binning of ed_profiler: 4 bins per octave.
+static void probe_record(sim_probe_t* probe, uint32_t cycles)
+{
+    int bin = cycles;
+    if(cycles >= 4)
+    {
+        int msb = 31 - __builtin_clz(cycles);
+        bin = (msb << 2) | ((cycles >> (msb - 2)) & 3);
+    }
+    probe->count ++;
+    probe->sum += cycles;
+    probe->min = cycles < probe->min ? cycles : probe->min;
+    probe->max = cycles > probe->max ? cycles : probe->max;
+    probe->hist[bin] ++;
+}
+
+static int put_probe(uint8_t* payload, int offset, int index, const sim_probe_t* probe)
+{
+    int name_len = strlen(probe->name);
+    uint8_t* entry = payload + offset;
+    entry[0] = index;
+    entry[1] = name_len;
+    memcpy(entry + 2, probe->name, name_len);
+    entry += 2 + name_len;
+    memcpy(entry, &probe->count, 4);
+    memcpy(entry + 4, &probe->min, 4);
+    memcpy(entry + 8, &probe->max, 4);
+    memcpy(entry + 12, &probe->sum, 8);
+    int bins = 0;
+    for(int b = 0; b < SIM_HIST_BINS; b++)
+    {
+        if(probe->hist[b] == 0)
+            continue;
+        entry[21 + bins * 5] = b;
+        memcpy(entry + 22 + bins * 5, &probe->hist[b], 4);
+        bins ++;
+    }
+    entry[20] = bins;
+    return offset + 2 + name_len + 21 + bins * 5;
+}
+
+static void send_frame(sim_drone_t* drone, uint8_t cmd, const uint8_t* payload, uint16_t len)
+{
+    static uint8_t frame[ED_DBG_MAX_FRAME];
+    int size = ed_dbg_pack_frame(frame, cmd, payload, len);
+    // responses are small, a full socket means the client is gone.
+    if(send(drone->client, frame, size, MSG_NOSIGNAL) != size)
+        shutdown(drone->client, SHUT_RDWR);
+}
+
+static int put_item(uint8_t* payload, int offset, const sim_drone_t* drone, int id, int8_t status)
+{
+    payload[offset] = id & 0xff;
+    payload[offset + 1] = id >> 8;
+    payload[offset + 2] = (uint8_t)status;
+    float value = (id >= 0 && id < SIM_PARAMS) ? drone->params[id] : 0;
+    memcpy(payload + offset + 3, &value, 4);
+    return offset + ED_DBG_RSP_ITEM_SIZE;
+}
+
+static void on_frame(void* ctx, uint8_t cmd, const uint8_t* payload, int len)
+{
+    sim_drone_t* drone = ctx;
+    static uint8_t tx[ED_DBG_MAX_PAYLOAD];
+    int tx_len = 0;
+    drone->requests ++;
+
+    switch(cmd)
+    {
+    case ED_DBG_CMD_LIST:
+    {
+        if(len != 2)
+            break;
+        tx[0] = SIM_PARAMS;
+        tx[1] = 0;
+        tx_len = 2;
+        for(int id = payload[0] | (payload[1] << 8); id < SIM_PARAMS; id++)
+        {
+            int name_len = strlen(param_names[id]);
+            uint8_t* entry = tx + tx_len;
+            float min = -1000, max = 1000;
+            entry[0] = id;
+            entry[1] = 0;
+            entry[2] = 0;   // ED_PARAM_FLOAT.
+            memcpy(entry + 3, &min, 4);
+            memcpy(entry + 7, &max, 4);
+            memcpy(entry + 11, &drone->params[id], 4);
+            entry[15] = name_len;
+            memcpy(entry + 16, param_names[id], name_len);
+            tx_len += ED_DBG_LIST_ENTRY_FIXED_SIZE + name_len;
+        }
+        send_frame(drone, cmd | ED_DBG_CMD_RESPONSE, tx, tx_len);
+        break;
+    }
+
+    case ED_DBG_CMD_GET:
+        for(int offset = 0; offset + ED_DBG_GET_REQ_ITEM_SIZE <= len; offset += ED_DBG_GET_REQ_ITEM_SIZE)
+        {
+            int id = payload[offset] | (payload[offset + 1] << 8);
+            tx_len = put_item(tx, tx_len, drone, id, id < SIM_PARAMS ? 0 : -1);
+        }
+        send_frame(drone, cmd | ED_DBG_CMD_RESPONSE, tx, tx_len);
+        break;
+
+    case ED_DBG_CMD_SET:
+        for(int offset = 0; offset + ED_DBG_SET_REQ_ITEM_SIZE <= len; offset += ED_DBG_SET_REQ_ITEM_SIZE)
+        {
+            int id = payload[offset] | (payload[offset + 1] << 8);
+            if(id < SIM_PARAMS)
+                memcpy(&drone->params[id], payload + offset + 2, 4);
+            tx_len = put_item(tx, tx_len, drone, id, id < SIM_PARAMS ? 0 : -1);
+        }
+        send_frame(drone, cmd | ED_DBG_CMD_RESPONSE, tx, tx_len);
+        break;
+
+    case ED_DBG_CMD_PROFILE:
+    {
+        if(len != 2)
+            break;
+        uint16_t cycles_per_us = SIM_CYCLES_PER_US;
+        memcpy(tx, &cycles_per_us, 2);
+        tx[2] = 2;
+        tx_len = 3;
+        for(int i = payload[1]; i < 2; i++)
+            tx_len = put_probe(tx, tx_len, i, &drone->probes[i]);
+        send_frame(drone, cmd | ED_DBG_CMD_RESPONSE, tx, tx_len);
+        if(payload[0] & ED_DBG_PROFILE_FLAG_RESET)
+        {
+            probe_reset(&drone->probes[0]);
+            probe_reset(&drone->probes[1]);
+            drone->last_send_us = 0;
+        }
+        break;
+    }
+
+    default:
+        tx[0] = cmd;
+        tx[1] = (uint8_t)ED_DBG_ERR_UNKNOWN_CMD;
+        send_frame(drone, ED_DBG_CMD_ERROR | ED_DBG_CMD_RESPONSE, tx, 2);
+        break;
+    }
+}
+
+static void send_telemetry(sim_drone_t* drone, int channels, uint64_t tick, double rate)
+{
+    float packet[SIM_MAX_CHANNELS + 1];
+    double t = tick / rate;
+    int64_t start_us = now_us();
+    if(drone->last_send_us)
+        probe_record(&drone->probes[0], (uint32_t)((start_us - drone->last_send_us) * SIM_CYCLES_PER_US));
+    drone->last_send_us = start_us;
+    packet[0] = (float)(start_us % SIM_TIME_WRAP_US);
+    for(int i = 1; i < channels; i++)
+        packet[i] = (float)(10 * sin(2 * M_PI * 0.5 * t + 0.1 * drone->index + i) + drone->params[0] * 0.01);
+    const uint32_t tail = 0x7F800000u;
+    memcpy(&packet[channels], &tail, 4);
+
+    // the telemetry never blocks, a partial packet would break the stream so the client is dropped.
+    ssize_t size = 4 * (channels + 1);
+    ssize_t n = send(drone->client, packet, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    probe_record(&drone->probes[1], (uint32_t)((now_us() - start_us) * SIM_CYCLES_PER_US));
+    if(n == size)
+        drone->packets ++;
+    else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        drone->dropped ++;
+    else
+        shutdown(drone->client, SHUT_RDWR);
+}
+
+int main(int argc, char** argv)
+{
+    int drones = 8, base_port = 9000, channels = 10;
+    double rate = 100;
+
+    int opt;
+    while((opt = getopt(argc, argv, "n:p:r:c:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n': drones = atoi(optarg); break;
+        case 'p': base_port = atoi(optarg); break;
+        case 'r': rate = atof(optarg); break;
+        case 'c': channels = atoi(optarg); break;
+        default:
+            goto usage;
+        }
+    }
+    if(drones < 1 || drones > SIM_MAX_DRONES || channels < 1 || channels > SIM_MAX_CHANNELS || !(rate > 0))
+        goto usage;
+
+    struct sigaction action = { .sa_handler = on_signal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    int epoll_fd = epoll_create1(0);
+    sim_drone_t* fleet = calloc(drones, sizeof(sim_drone_t));
+    if(epoll_fd < 0 || fleet == NULL)
+        return 1;
+
+    // epoll data: -1 for the timer, index for a server, drones + index for a client.
+    for(int i = 0; i < drones; i++)
+    {
+        sim_drone_t* drone = &fleet[i];
+        drone->index = i;
+        drone->client = -1;
+        drone->stream = (ed_dbg_stream_t){ .on_frame = on_frame, .ctx = drone };
+        drone->params[0] = 300 + i;
+        drone->probes[0].name = "tick.period";
+        drone->probes[1].name = "tick.total";
+        probe_reset(&drone->probes[0]);
+        probe_reset(&drone->probes[1]);
+
+        drone->server = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int reuse = 1;
+        setsockopt(drone->server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(base_port + i), .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+        if(drone->server < 0 || bind(drone->server, (struct sockaddr*)&addr, sizeof(addr)) || listen(drone->server, 1))
+        {
+            fprintf(stderr, "can not listen on port %d.\n", base_port + i);
+            return 1;
+        }
+        struct epoll_event event = { .events = EPOLLIN, .data.u64 = i };
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, drone->server, &event);
+    }
+
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    long period_ns = (long)(1e9 / rate);
+    struct itimerspec spec = { .it_interval = { period_ns / 1000000000, period_ns % 1000000000 }, .it_value = { 0, 1 } };
+    timerfd_settime(timer, 0, &spec, NULL);
+    struct epoll_event timer_event = { .events = EPOLLIN, .data.u64 = UINT64_MAX };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer, &timer_event);
+    fprintf(stderr, "%d drones on ports %d~%d, %d channels at %.0f Hz.\n", drones, base_port, base_port + drones - 1, channels, rate);
+
+    uint64_t tick = 0;
+    struct epoll_event events[64];
+    while(!stop)
+    {
+        int n = epoll_wait(epoll_fd, events, 64, 500);
+        for(int e = 0; e < n; e++)
+        {
+            uint64_t id = events[e].data.u64;
+            if(id == UINT64_MAX)
+            {
+                uint64_t expirations;
+                if(read(timer, &expirations, sizeof(expirations)) != sizeof(expirations))
+                    continue;
+                // a late wake up sends only the newest sample, as the firmware sender does.
+                tick += expirations;
+                for(int i = 0; i < drones; i++)
+                {
+                    if(fleet[i].client >= 0)
+                        send_telemetry(&fleet[i], channels, tick, rate);
+                }
+            } else if(id < (uint64_t)drones) {
+                // a new client replaces the previous one.
+                sim_drone_t* drone = &fleet[id];
+                int client = accept4(drone->server, NULL, NULL, SOCK_NONBLOCK);
+                if(client < 0)
+                    continue;
+                if(drone->client >= 0)
+                    close(drone->client);
+                int nodelay = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+                drone->client = client;
+                drone->stream._len = 0;
+                struct epoll_event event = { .events = EPOLLIN, .data.u64 = drones + id };
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client, &event);
+            } else {
+                sim_drone_t* drone = &fleet[id - drones];
+                uint8_t buffer[4096];
+                ssize_t len = recv(drone->client, buffer, sizeof(buffer), 0);
+                if(len > 0)
+                {
+                    ed_dbg_stream_feed(&drone->stream, buffer, len);
+                } else if(len == 0 || (errno != EAGAIN && errno != EINTR)) {
+                    close(drone->client);
+                    drone->client = -1;
+                }
+            }
+        }
+    }
+
+    uint64_t packets = 0, dropped = 0, requests = 0;
+    for(int i = 0; i < drones; i++)
+    {
+        packets += fleet[i].packets;
+        dropped += fleet[i].dropped;
+        requests += fleet[i].requests;
+    }
+    fprintf(stderr, "%llu packets sent, %llu dropped, %llu requests served.\n",
+        (unsigned long long)packets, (unsigned long long)dropped, (unsigned long long)requests);
+    free(fleet);
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-n drones] [-p base port] [-r rate] [-c channels]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
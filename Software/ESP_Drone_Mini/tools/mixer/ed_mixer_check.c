@@ -0,0 +1,147 @@
+/**
+ * @note: Check of the geometry presets of the OpenHover mixer(oh_mixer.c).
+ *          Every motor of every preset is placed at its angle clockwise from the nose, as documented in
+ *          oh_mixer.h, and its factors are checked:
+ *              - signs: roll follows the offset across the roll axis and pitch the offset along it, with the
+ *                signs of the quad table. Each hex and octo motor is also compared with the quad motor of
+ *                its quadrant, so the presets agree with the layout of oh_quadrotor_pid.h.
+ *              - yaw: anti-clockwise motors take -0.5 and clockwise motors +0.5, even hex and octo motors
+ *                spin anti-clockwise, as M1 of the quad.
+ *              - balance: the farthest motor of each axis takes 0.5, and each column sums to 0 so that a
+ *                correction does not move the collective thrust.
+ *          The matrices are printed, the process fails if any check fails.
+ *
+ *          usage: ed_mixer_check
+ */
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "oh_mixer.h"
+
+#ifndef M_PI
+#define M_PI                            (3.14159265358979323846)
+#endif
+
+#define CHECK_TOLERANCE                 (1e-5)
+
+typedef struct {
+    const char* name;
+    oh_mixer_geometry_t geometry;
+    int motors;
+} check_preset_t;
+
+static const check_preset_t presets[] = {
+    { "OH_MIXER_QUAD_X", OH_MIXER_QUAD_X, 4 },
+    { "OH_MIXER_HEX_X", OH_MIXER_HEX_X, 6 },
+    { "OH_MIXER_OCTO_X", OH_MIXER_OCTO_X, 8 },
+};
+
+// the quad of oh_quadrotor_pid.h clockwise from the nose: M1, M3, M2, M4. M1 and M2 spin anti-clockwise.
+static const double quad_angle[] = { 45, 225, 135, 315 };
+static const int quad_anti_clockwise[] = { 1, 1, 0, 0 };
+
+static int failures = 0;
+
+static int sign(double x)
+{
+    return x > CHECK_TOLERANCE ? 1 : (x < -CHECK_TOLERANCE ? -1 : 0);
+}
+
+static void expect(int ok, const char* preset, int motor, const char* what, double got, double want)
+{
+    if(ok)
+        return;
+    failures ++;
+    printf("FAIL: %s motor %d %s: %.6f, expected %.6f.\n", preset, motor, what, got, want);
+}
+
+static double motor_angle(const check_preset_t* preset, int i)
+{
+    if(preset->geometry == OH_MIXER_QUAD_X)
+        return quad_angle[i];
+    return (i + 0.5) * 360.0 / preset->motors;
+}
+
+static int motor_anti_clockwise(const check_preset_t* preset, int i)
+{
+    if(preset->geometry == OH_MIXER_QUAD_X)
+        return quad_anti_clockwise[i];
+    return i % 2 == 0;
+}
+
+// the quad motor whose quadrant holds the angle, -1 on an axis.
+static int quad_motor_of(double angle)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        if(fabs(angle - quad_angle[i]) < 45 - CHECK_TOLERANCE)
+            return i;
+    }
+    return -1;
+}
+
+static void check_preset(const check_preset_t* preset, const oh_mixer_t* quad)
+{
+    oh_mixer_t mixer = { .geometry = preset->geometry, .output_min = 0, .output_max = 1 };
+    if(oh_mixer_init(&mixer) || oh_mixer_motors(&mixer) != preset->motors)
+    {
+        failures ++;
+        printf("FAIL: %s is not initialized with %d motors.\n", preset->name, preset->motors);
+        return;
+    }
+
+    printf("%s:\n  %5s  %7s  %7s  %7s  %7s\n", preset->name, "motor", "angle", "roll", "pitch", "yaw");
+    double sum_roll = 0, sum_pitch = 0, sum_yaw = 0, max_roll = 0, max_pitch = 0;
+    for(int i = 0; i < preset->motors; i++)
+    {
+        double angle = motor_angle(preset, i);
+        double roll = mixer._roll[i], pitch = mixer._pitch[i], yaw = mixer._yaw[i];
+        printf("  %5d  %7.1f  %7.4f  %7.4f  %7.4f\n", i, angle, roll, pitch, yaw);
+
+        // the offset across the roll axis and along it, in units of the arm.
+        double across = sin(angle * M_PI / 180), along = cos(angle * M_PI / 180);
+        expect(sign(roll) == sign(across), preset->name, i, "roll sign", roll, across);
+        expect(sign(pitch) == sign(-along), preset->name, i, "pitch sign", pitch, -along);
+        double want_yaw = motor_anti_clockwise(preset, i) ? -0.5 : 0.5;
+        expect(fabs(yaw - want_yaw) < CHECK_TOLERANCE, preset->name, i, "yaw", yaw, want_yaw);
+
+        int q = quad_motor_of(angle);
+        if(q >= 0 && preset->geometry != OH_MIXER_QUAD_X)
+        {
+            expect(sign(roll) == sign(quad->_roll[q]), preset->name, i, "roll sign of its quad motor", roll, quad->_roll[q]);
+            expect(sign(pitch) == sign(quad->_pitch[q]), preset->name, i, "pitch sign of its quad motor", pitch, quad->_pitch[q]);
+        }
+
+        sum_roll += roll;
+        sum_pitch += pitch;
+        sum_yaw += yaw;
+        max_roll = fmax(max_roll, fabs(roll));
+        max_pitch = fmax(max_pitch, fabs(pitch));
+    }
+    expect(fabs(max_roll - 0.5) < CHECK_TOLERANCE, preset->name, -1, "max |roll|", max_roll, 0.5);
+    expect(fabs(max_pitch - 0.5) < CHECK_TOLERANCE, preset->name, -1, "max |pitch|", max_pitch, 0.5);
+    expect(fabs(sum_roll) < CHECK_TOLERANCE, preset->name, -1, "sum of roll", sum_roll, 0);
+    expect(fabs(sum_pitch) < CHECK_TOLERANCE, preset->name, -1, "sum of pitch", sum_pitch, 0);
+    expect(fabs(sum_yaw) < CHECK_TOLERANCE, preset->name, -1, "sum of yaw", sum_yaw, 0);
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    while((opt = getopt(argc, argv, "h")) != -1)
+        goto usage;
+    if(optind != argc)
+        goto usage;
+
+    oh_mixer_t quad = { .geometry = OH_MIXER_QUAD_X, .output_min = 0, .output_max = 1 };
+    oh_mixer_init(&quad);
+    for(size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++)
+        check_preset(&presets[i], &quad);
+    printf("checks: %zu presets, %d failures.\n", sizeof(presets) / sizeof(presets[0]), failures);
+    return failures ? 1 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+#include "ed_pool.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct {
+    ed_pool_func_t func;
+    void* arg;
+} ed_pool_task_t;
+
+// growable ring, the owner works at the bottom and thieves at the top.
+typedef struct {
+    pthread_mutex_t lock;
+    ed_pool_task_t* tasks;
+    size_t capacity;
+    size_t top;
+    size_t bottom;
+} ed_pool_deque_t;
+
+typedef struct {
+    ed_pool_t* pool;
+    int index;
+    pthread_t thread;
+    ed_pool_deque_t deque;
+} ed_pool_worker_t;
+
+struct ed_pool {
+    int threads;
+    ed_pool_worker_t* workers;
+    int next;
+
+    // pending counts submitted tasks not finished yet, queued counts tasks not taken by a worker yet.
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t idle_cond;
+    size_t pending;
+    size_t queued;
+    bool stop;
+};
+
+static int __ed_pool_deque_push(ed_pool_deque_t* deque, ed_pool_task_t task)
+{
+    pthread_mutex_lock(&deque->lock);
+    if(deque->bottom - deque->top == deque->capacity)
+    {
+        size_t capacity = deque->capacity ? deque->capacity * 2 : 64;
+        ed_pool_task_t* tasks = malloc(capacity * sizeof(ed_pool_task_t));
+        if(tasks == NULL)
+        {
+            pthread_mutex_unlock(&deque->lock);
+            return -1;
+        }
+        for(size_t i = deque->top; i < deque->bottom; i++)
+            tasks[i - deque->top] = deque->tasks[i % deque->capacity];
+        free(deque->tasks);
+        deque->bottom -= deque->top;
+        deque->top = 0;
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+    }
+    deque->tasks[deque->bottom % deque->capacity] = task;
+    deque->bottom ++;
+    pthread_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+static bool __ed_pool_deque_take(ed_pool_deque_t* deque, ed_pool_task_t* task, bool steal)
+{
+    bool found = false;
+    pthread_mutex_lock(&deque->lock);
+    if(deque->bottom != deque->top)
+    {
+        if(steal)
+            *task = deque->tasks[deque->top ++ % deque->capacity];
+        else
+            *task = deque->tasks[-- deque->bottom % deque->capacity];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool __ed_pool_find_task(ed_pool_worker_t* worker, ed_pool_task_t* task)
+{
+    ed_pool_t* pool = worker->pool;
+    if(__ed_pool_deque_take(&worker->deque, task, false))
+        return true;
+
+    for(int i = 1; i < pool->threads; i++)
+    {
+        ed_pool_worker_t* victim = &pool->workers[(worker->index + i) % pool->threads];
+        if(__ed_pool_deque_take(&victim->deque, task, true))
+            return true;
+    }
+    return false;
+}
+
+static void* __ed_pool_worker_main(void* arg)
+{
+    ed_pool_worker_t* worker = arg;
+    ed_pool_t* pool = worker->pool;
+    ed_pool_task_t task;
+
+    for( ;; )
+    {
+        pthread_mutex_lock(&pool->lock);
+        while(pool->queued == 0 && !pool->stop)
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        if(pool->queued == 0 && pool->stop)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        if(!__ed_pool_find_task(worker, &task))
+            continue;
+
+        pthread_mutex_lock(&pool->lock);
+        pool->queued --;
+        pthread_mutex_unlock(&pool->lock);
+
+        task.func(task.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        if(-- pool->pending == 0)
+            pthread_cond_broadcast(&pool->idle_cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Create a work-stealing thread pool.
+ * @param:
+ *      - int threads : number of workers, 0 for the number of online cores.
+ * @return: the pool, or NULL if failed.
+ * @note: each worker owns a deque, it pops its newest task and steals the oldest
+ *          task of another worker when its own deque is empty.
+ */
+ed_pool_t* ed_pool_create(int threads)
+{
+    if(threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads <= 0)
+        threads = 1;
+
+    ed_pool_t* pool = calloc(1, sizeof(ed_pool_t));
+    if(pool == NULL)
+        return NULL;
+    pool->workers = calloc(threads, sizeof(ed_pool_worker_t));
+    if(pool->workers == NULL)
+    {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+    for(int i = 0; i < threads; i++)
+    {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pthread_mutex_init(&pool->workers[i].deque.lock, NULL);
+    }
+
+    for(int i = 0; i < threads; i++)
+    {
+        if(pthread_create(&pool->workers[i].thread, NULL, __ed_pool_worker_main, &pool->workers[i]))
+        {
+            pool->threads = i;
+            ed_pool_destroy(pool);
+            return NULL;
+        }
+        pool->threads = i + 1;
+    }
+    return pool;
+}
+
+/**
+ * @brief: Get the number of workers.
+ */
+int ed_pool_threads(ed_pool_t* pool)
+{
+    return pool->threads;
+}
+
+/**
+ * @brief: Submit a task, tasks are spread over the workers round-robin.
+ * @return: 0 if success.
+ */
+int ed_pool_submit(ed_pool_t* pool, ed_pool_func_t func, void* arg)
+{
+    ed_pool_task_t task = { .func = func, .arg = arg };
+
+    // counted before the push, so queued never falls below the tasks in deques.
+    pthread_mutex_lock(&pool->lock);
+    int index = pool->next;
+    pool->next = (pool->next + 1) % pool->threads;
+    pool->pending ++;
+    pool->queued ++;
+    pthread_mutex_unlock(&pool->lock);
+
+    int ret = __ed_pool_deque_push(&pool->workers[index].deque, task);
+
+    pthread_mutex_lock(&pool->lock);
+    if(ret)
+    {
+        pool->queued --;
+        if(-- pool->pending == 0)
+            pthread_cond_broadcast(&pool->idle_cond);
+    } else {
+        pthread_cond_signal(&pool->work_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return ret;
+}
+
+/**
+ * @brief: Wait until all submitted tasks are finished.
+ */
+void ed_pool_wait(ed_pool_t* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while(pool->pending)
+        pthread_cond_wait(&pool->idle_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief: Wait for the submitted tasks, stop the workers and free the pool.
+ */
+void ed_pool_destroy(ed_pool_t* pool)
+{
+    ed_pool_wait(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(int i = 0; i < pool->threads; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    for(int i = 0; i < pool->threads; i++)
+    {
+        pthread_mutex_destroy(&pool->workers[i].deque.lock);
+        free(pool->workers[i].deque.tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->idle_cond);
+    free(pool->workers);
+    free(pool);
+}
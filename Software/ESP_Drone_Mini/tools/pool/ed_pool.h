@@ -0,0 +1,49 @@
+#ifndef __ED_POOL_H__
+#define __ED_POOL_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*ed_pool_func_t)(void* arg);
+
+typedef struct ed_pool ed_pool_t;
+
+/**
+ * @brief: Create a work-stealing thread pool.
+ * @param:
+ *      - int threads : number of workers, 0 for the number of online cores.
+ * @return: the pool, or NULL if failed.
+ * @note: each worker owns a deque, it pops its newest task and steals the oldest
+ *          task of another worker when its own deque is empty.
+ */
+ed_pool_t* ed_pool_create(int threads);
+
+/**
+ * @brief: Get the number of workers.
+ */
+int ed_pool_threads(ed_pool_t* pool);
+
+/**
+ * @brief: Submit a task, tasks are spread over the workers round-robin.
+ * @return: 0 if success.
+ */
+int ed_pool_submit(ed_pool_t* pool, ed_pool_func_t func, void* arg);
+
+/**
+ * @brief: Wait until all submitted tasks are finished.
+ */
+void ed_pool_wait(ed_pool_t* pool);
+
+/**
+ * @brief: Wait for the submitted tasks, stop the workers and free the pool.
+ */
+void ed_pool_destroy(ed_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,352 @@
+/**
+ * @note: Dump of the timing probes of ed_profiler through ED_DBG_CMD_PROFILE.
+ *          Prints count, min, average, percentiles and max of every probe in microseconds. The percentiles
+ *          are interpolated in the histogram bins(4 per octave), so they are exact to about 20%.
+ *          With -w, the probes are reset first and dumped after that many seconds, so that a dump covers a
+ *          known window(a flight phase, a stress, a configuration). With -H, the histograms are printed too.
+ *          -o saves the summary as CSV, and -c compares with such a file, e.g. the loop jitter(tick.period)
+ *          before and after a change of the task layout:
+ *              ed_profile -w 60 -o before.csv drone
+ *              (flash the change)
+ *              ed_profile -w 60 -c before.csv drone
+ *
+ *          usage: ed_profile [-p port] [-w seconds] [-H] [-o csv] [-c baseline csv] host
+ */
+#include <errno.h>
+#include <netdb.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "ed_dbg_stream.h"
+
+#define PROFILE_MAX_PROBES              (64)
+#define PROFILE_HIST_BINS               (128)
+#define PROFILE_TIMEOUT_S               (2)
+
+typedef struct {
+    char name[32];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROFILE_HIST_BINS];
+} profile_probe_t;
+
+typedef struct {
+    profile_probe_t probes[PROFILE_MAX_PROBES];
+    int total;
+    int received;
+    uint16_t cycles_per_us;
+    bool responded;
+} profile_t;
+
+// percentiles of the summary.
+static const double percentiles[] = { 0.5, 0.99, 0.999 };
+#define PROFILE_PERCENTILES             ((int)(sizeof(percentiles) / sizeof(percentiles[0])))
+
+static int connect_to(const char* host, const char* port)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* result;
+    if(getaddrinfo(host, port, &hints, &result))
+        return -1;
+
+    int fd = -1;
+    for(struct addrinfo* ai = result; ai && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if(fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen))
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+/**
+ * @brief: Bounds of histogram bin b in cycles, see ED_DBG_CMD_PROFILE.
+ */
+static void bin_bounds(int b, double* low, double* high)
+{
+    if(b < 8)
+    {
+        *low = b;
+        *high = b + 1;
+        return;
+    }
+    *low = (double)((4 + b % 4) << (b / 4 - 2));
+    *high = (double)((5 + b % 4) << (b / 4 - 2));
+}
+
+/**
+ * @brief: Get the p quantile of probe in cycles, interpolated in its bin and clamped to [min, max].
+ */
+static double probe_percentile(const profile_probe_t* probe, double p)
+{
+    double rank = p * probe->count, seen = 0;
+    for(int b = 0; b < PROFILE_HIST_BINS; b++)
+    {
+        if(probe->hist[b] == 0 || seen + probe->hist[b] < rank)
+        {
+            seen += probe->hist[b];
+            continue;
+        }
+        double low, high;
+        bin_bounds(b, &low, &high);
+        double value = low + (high - low) * (rank - seen) / probe->hist[b];
+        if(value < probe->min)
+            value = probe->min;
+        if(value > probe->max)
+            value = probe->max;
+        return value;
+    }
+    return probe->max;
+}
+
+static void on_frame(void* ctx, uint8_t cmd, const uint8_t* payload, int len)
+{
+    profile_t* profile = ctx;
+    if(cmd != (ED_DBG_CMD_PROFILE | ED_DBG_CMD_RESPONSE) || len < 3)
+        return;
+
+    memcpy(&profile->cycles_per_us, payload, 2);
+    profile->total = payload[2] < PROFILE_MAX_PROBES ? payload[2] : PROFILE_MAX_PROBES;
+    profile->responded = true;
+
+    // index | name_len | name | count | min | max | sum | nbins | nbins * (bin | count)
+    int offset = 3;
+    while(offset + 2 <= len)
+    {
+        int index = payload[offset], name_len = payload[offset + 1];
+        if(offset + 2 + name_len + 21 > len)
+            break;
+        const uint8_t* entry = payload + offset + 2 + name_len;
+        int bins = entry[20];
+        if(offset + 2 + name_len + 21 + bins * 5 > len)
+            break;
+
+        if(index < PROFILE_MAX_PROBES)
+        {
+            profile_probe_t* probe = &profile->probes[index];
+            memset(probe, 0x00, sizeof(*probe));
+            memcpy(probe->name, payload + offset + 2, name_len < 31 ? name_len : 31);
+            memcpy(&probe->count, entry, 4);
+            memcpy(&probe->min, entry + 4, 4);
+            memcpy(&probe->max, entry + 8, 4);
+            memcpy(&probe->sum, entry + 12, 8);
+            for(int i = 0; i < bins; i++)
+            {
+                int b = entry[21 + i * 5];
+                if(b < PROFILE_HIST_BINS)
+                    memcpy(&probe->hist[b], entry + 21 + i * 5 + 1, 4);
+            }
+            if(index + 1 > profile->received)
+                profile->received = index + 1;
+        }
+        offset += 2 + name_len + 21 + bins * 5;
+    }
+}
+
+/**
+ * @brief: Send a PROFILE request and wait for its response, the telemetry in between is skipped.
+ * @return: 0 if success.
+ */
+static int request(int fd, ed_dbg_stream_t* stream, profile_t* profile, uint8_t flags, uint8_t start)
+{
+    uint8_t frame[ED_DBG_MAX_FRAME], payload[2] = { flags, start };
+    int size = ed_dbg_pack_frame(frame, ED_DBG_CMD_PROFILE, payload, 2);
+    if(send(fd, frame, size, 0) != size)
+        return -1;
+
+    profile->responded = false;
+    uint8_t buffer[4096];
+    while(!profile->responded)
+    {
+        ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+        if(len <= 0)
+            return -1;
+        ed_dbg_stream_feed(stream, buffer, len);
+    }
+    return 0;
+}
+
+static void print_histogram(const profile_probe_t* probe, double cycles_per_us)
+{
+    uint32_t peak = 0;
+    for(int b = 0; b < PROFILE_HIST_BINS; b++)
+        peak = probe->hist[b] > peak ? probe->hist[b] : peak;
+    for(int b = 0; b < PROFILE_HIST_BINS; b++)
+    {
+        if(probe->hist[b] == 0)
+            continue;
+        double low, high;
+        bin_bounds(b, &low, &high);
+        int bar = (int)(50.0 * probe->hist[b] / peak + 0.5);
+        printf("    %10.2f ~ %10.2f us %10u %.*s\n", low / cycles_per_us, high / cycles_per_us, probe->hist[b],
+            bar > 0 ? bar : 1, "##################################################");
+    }
+}
+
+/**
+ * @brief: Print the summary of every probe, with the change from the baseline if there is one.
+ */
+static void print_summary(const profile_t* profile, FILE* csv, FILE* baseline, bool histograms)
+{
+    double cycles_per_us = profile->cycles_per_us ? profile->cycles_per_us : 1;
+    printf("%-16s %10s %10s %10s %10s %10s %10s %10s\n", "probe(us)", "count", "min", "avg", "p50", "p99", "p99.9", "max");
+    if(csv)
+        fprintf(csv, "probe,count,min_us,avg_us,p50_us,p99_us,p999_us,max_us\n");
+
+    for(int i = 0; i < profile->received; i++)
+    {
+        const profile_probe_t* probe = &profile->probes[i];
+        if(probe->count == 0)
+        {
+            printf("%-16s %10s\n", probe->name, "-");
+            continue;
+        }
+        double values[3 + PROFILE_PERCENTILES];
+        values[0] = probe->min / cycles_per_us;
+        values[1] = (double)probe->sum / probe->count / cycles_per_us;
+        for(int p = 0; p < PROFILE_PERCENTILES; p++)
+            values[2 + p] = probe_percentile(probe, percentiles[p]) / cycles_per_us;
+        values[2 + PROFILE_PERCENTILES] = probe->max / cycles_per_us;
+
+        printf("%-16s %10u", probe->name, probe->count);
+        for(int v = 0; v < 3 + PROFILE_PERCENTILES; v++)
+            printf(" %10.2f", values[v]);
+        printf("\n");
+        if(csv)
+        {
+            fprintf(csv, "%s,%u", probe->name, probe->count);
+            for(int v = 0; v < 3 + PROFILE_PERCENTILES; v++)
+                fprintf(csv, ",%.3f", values[v]);
+            fprintf(csv, "\n");
+        }
+
+        // the baseline row of the same probe, relative changes below the current row.
+        if(baseline)
+        {
+            char line[256], name[32];
+            double before[3 + PROFILE_PERCENTILES];
+            unsigned count;
+            rewind(baseline);
+            while(fgets(line, sizeof(line), baseline))
+            {
+                if(sscanf(line, "%31[^,],%u,%lf,%lf,%lf,%lf,%lf,%lf", name, &count, &before[0], &before[1],
+                        &before[2], &before[3], &before[4], &before[5]) != 8 || strcmp(name, probe->name))
+                    continue;
+                printf("%-16s %10u", "  baseline", count);
+                for(int v = 0; v < 3 + PROFILE_PERCENTILES; v++)
+                    printf(" %10.2f", before[v]);
+                printf("\n%-16s %10s", "  change", "");
+                for(int v = 0; v < 3 + PROFILE_PERCENTILES; v++)
+                {
+                    if(before[v] > 0)
+                        printf(" %+9.1f%%", 100 * (values[v] - before[v]) / before[v]);
+                    else
+                        printf(" %10s", "-");
+                }
+                printf("\n");
+                break;
+            }
+        }
+        if(histograms)
+            print_histogram(probe, cycles_per_us);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* port = "8080";
+    const char* output = NULL;
+    const char* baseline_path = NULL;
+    double window = 0;
+    bool histograms = false;
+
+    int opt;
+    while((opt = getopt(argc, argv, "p:w:Ho:c:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'p': port = optarg; break;
+        case 'w': window = atof(optarg); break;
+        case 'H': histograms = true; break;
+        case 'o': output = optarg; break;
+        case 'c': baseline_path = optarg; break;
+        default:
+            goto usage;
+        }
+    }
+    if(optind != argc - 1 || window < 0)
+        goto usage;
+
+    FILE* baseline = NULL;
+    if(baseline_path && (baseline = fopen(baseline_path, "r")) == NULL)
+    {
+        fprintf(stderr, "can not open %s.\n", baseline_path);
+        return 1;
+    }
+
+    int fd = connect_to(argv[optind], port);
+    if(fd < 0)
+    {
+        fprintf(stderr, "can not connect to %s:%s.\n", argv[optind], port);
+        return 1;
+    }
+    struct timeval timeout = { .tv_sec = PROFILE_TIMEOUT_S };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    static profile_t profile;
+    static ed_dbg_stream_t stream;
+    stream = (ed_dbg_stream_t){ .on_frame = on_frame, .ctx = &profile };
+
+    // the reset request also returns the probes, they are dropped.
+    if(window > 0)
+    {
+        if(request(fd, &stream, &profile, ED_DBG_PROFILE_FLAG_RESET, 0))
+            goto no_response;
+        fprintf(stderr, "probes are reset, dump in %.0f s.\n", window);
+        struct timespec wait = { (time_t)window, (long)((window - (time_t)window) * 1e9) };
+        nanosleep(&wait, NULL);
+        profile.received = 0;
+    }
+
+    // a response holds the probes which fit in a frame, the rest is requested from the next index.
+    int received;
+    do {
+        received = profile.received;
+        if(request(fd, &stream, &profile, 0, profile.received))
+            goto no_response;
+    } while(profile.received < profile.total && profile.received > received);
+    close(fd);
+
+    FILE* csv = output ? fopen(output, "w") : NULL;
+    if(output && csv == NULL)
+    {
+        fprintf(stderr, "can not create %s.\n", output);
+        return 1;
+    }
+    print_summary(&profile, csv, baseline, histograms);
+    if(csv)
+        fclose(csv);
+    if(baseline)
+        fclose(baseline);
+    return 0;
+
+no_response:
+    fprintf(stderr, "no response to ED_DBG_CMD_PROFILE(%s).\n", errno ? strerror(errno) : "closed");
+    return 1;
+
+usage:
+    fprintf(stderr, "usage: %s [-p port] [-w seconds] [-H] [-o csv] [-c baseline csv] host\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
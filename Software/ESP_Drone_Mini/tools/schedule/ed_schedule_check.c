@@ -0,0 +1,143 @@
+/**
+ * @note: Check of the gain schedule of oh_quadrotor_pid.c.
+ *          Every point holds distinct gains, `oh_quad_pid_rate_realize` runs at a sweep of collective thrusts and
+ *          the gains of the angular velocity pids are compared with a reference interpolation:
+ *              - inside: linear between the two points around the thrust, exact on the points.
+ *              - outside: below thrust_min the first point, above thrust_max the last one, NaN the first one.
+ *              - disabled: points < 2, points > OH_QUAD_SCHEDULE_MAX_POINTS or thrust_max <= thrust_min
+ *                leave the gains of the pids as they are.
+ *          The process fails if any check fails.
+ *
+ *          usage: ed_schedule_check
+ */
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "oh_quadrotor_pid.h"
+
+#define CHECK_TOLERANCE                 (1e-4)
+#define CHECK_THRUST_MIN                (0.2)
+#define CHECK_THRUST_MAX                (0.6)
+
+static int failures = 0;
+static int checks = 0;
+
+// a gain of the point, distinct for every point, axis and term.
+static float point_gain(int point, int axis, int term)
+{
+    return (point + 1) * 10.0f + axis * 3 + term + 0.5f * (point % 2);
+}
+
+// the gain left in the pids when the schedule is disabled.
+static float own_gain(int axis, int term)
+{
+    return 100.0f + axis * 3 + term;
+}
+
+static oh_pos_pid_t* rate_pid(oh_quad_pid_t* pid, int axis)
+{
+    oh_pos_pid_t* pids[] = { &pid->veloc_pitch, &pid->veloc_roll, &pid->veloc_yaw };
+    return pids[axis];
+}
+
+static oh_pid_gains_t* schedule_gains(oh_quad_pid_t* pid, int point, int axis)
+{
+    oh_pid_gains_t* gains[] = { &pid->schedule.gains[point].veloc_pitch, &pid->schedule.gains[point].veloc_roll, &pid->schedule.gains[point].veloc_yaw };
+    return gains[axis];
+}
+
+static void init_pid(oh_quad_pid_t* pid, int points, float thrust_min, float thrust_max)
+{
+    *pid = (oh_quad_pid_t){
+        .mixer = { .geometry = OH_MIXER_QUAD_X, .output_min = 0, .output_max = 1 },
+        .schedule = { .points = points, .thrust_min = thrust_min, .thrust_max = thrust_max },
+    };
+    oh_quad_pid_init(pid);
+    for(int axis = 0; axis < 3; axis++)
+    {
+        oh_pos_pid_t* rate = rate_pid(pid, axis);
+        rate->proportion = own_gain(axis, 0);
+        rate->integration = own_gain(axis, 1);
+        rate->differention = own_gain(axis, 2);
+        rate->max_abs_output = 1e6f;
+        for(int i = 0; i < OH_QUAD_SCHEDULE_MAX_POINTS; i++)
+        {
+            oh_pid_gains_t* gains = schedule_gains(pid, i, axis);
+            gains->proportion = point_gain(i, axis, 0);
+            gains->integration = point_gain(i, axis, 1);
+            gains->differention = point_gain(i, axis, 2);
+        }
+    }
+}
+
+// reference interpolation, the gains of the pids when the schedule is disabled.
+static double reference_gain(int points, double thrust_min, double thrust_max, double thrust, int axis, int term)
+{
+    if(points < 2 || points > OH_QUAD_SCHEDULE_MAX_POINTS || !(thrust_max > thrust_min))
+        return own_gain(axis, term);
+    double pos = (thrust - thrust_min) / (thrust_max - thrust_min) * (points - 1);
+    if(!(pos > 0))
+        return point_gain(0, axis, term);
+    if(pos >= points - 1)
+        return point_gain(points - 1, axis, term);
+    int index = (int)floor(pos);
+    double frac = pos - index;
+    return point_gain(index, axis, term) * (1 - frac) + point_gain(index + 1, axis, term) * frac;
+}
+
+static void check_thrust(int points, float thrust_min, float thrust_max, float thrust)
+{
+    oh_quad_pid_t pid;
+    init_pid(&pid, points, thrust_min, thrust_max);
+    oh_drv_status_t status = { 0 };
+    oh_drv_quadrotor_output_t output;
+    oh_quad_pid_rate_realize(&status, &pid, thrust, &output);
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const oh_pos_pid_t* rate = rate_pid(&pid, axis);
+        const float got[] = { rate->proportion, rate->integration, rate->differention };
+        for(int term = 0; term < 3; term++)
+        {
+            double want = reference_gain(points, thrust_min, thrust_max, thrust, axis, term);
+            checks ++;
+            if(fabs(got[term] - want) < CHECK_TOLERANCE)
+                continue;
+            failures ++;
+            printf("FAIL: %d points %.2f~%.2f, thrust %.3f, axis %d term %d: %.5f, expected %.5f.\n",
+                points, thrust_min, thrust_max, thrust, axis, term, got[term], want);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    while((opt = getopt(argc, argv, "h")) != -1)
+        goto usage;
+    if(optind != argc)
+        goto usage;
+
+    // inside, on the points, below and above the range.
+    for(int points = 0; points <= OH_QUAD_SCHEDULE_MAX_POINTS + 1; points++)
+    {
+        for(int i = -10; i <= 50; i++)
+            check_thrust(points, CHECK_THRUST_MIN, CHECK_THRUST_MAX, i * 0.02f);
+        check_thrust(points, CHECK_THRUST_MIN, CHECK_THRUST_MAX, NAN);
+    }
+
+    // an empty or reversed range disables the schedule.
+    for(int i = 0; i <= 10; i++)
+    {
+        check_thrust(3, CHECK_THRUST_MIN, CHECK_THRUST_MIN, i * 0.1f);
+        check_thrust(3, CHECK_THRUST_MAX, CHECK_THRUST_MIN, i * 0.1f);
+    }
+
+    printf("checks: %d gains, %d failures.\n", checks, failures);
+    return failures ? 1 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
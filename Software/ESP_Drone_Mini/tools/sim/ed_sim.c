@@ -0,0 +1,380 @@
+#include "ed_sim.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "esp_drone_pid_config.h"
+
+#define ED_SIM_RAD_TO_DEG               (57.29577951308232f)
+#define ED_SIM_DEG_TO_RAD               (0.017453292519943295f)
+#define ED_SIM_GRAVITY                  (9.81f)
+
+// position(x, y) of motors and their spin, +1 for clockwise(reaction torque +z).
+static const float motor_x[ED_SIM_MOTORS] = {  1, -1, -1,  1 };
+static const float motor_y[ED_SIM_MOTORS] = {  1, -1,  1, -1 };
+static const float motor_spin[ED_SIM_MOTORS] = { -1, -1,  1,  1 };
+
+static uint64_t __ed_sim_rand_u64(uint64_t* state)
+{
+    // splitmix64
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief: Uniform random number in [0, 1) of the simulation rng.
+ */
+float ed_sim_randu(uint64_t* state)
+{
+    return (__ed_sim_rand_u64(state) >> 40) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief: Normal distributed random number of the simulation rng.
+ */
+float ed_sim_randn(uint64_t* state)
+{
+    // Box-Muller, u1 in (0, 1].
+    double u1 = ((__ed_sim_rand_u64(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    double u2 = (__ed_sim_rand_u64(state) >> 11) * (1.0 / 9007199254740992.0);
+    return (float)(sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2));
+}
+
+/**
+ * @brief: Fill params with the nominal ESP_Drone_Mini airframe.
+ */
+void ed_sim_default_params(ed_sim_params_t* params)
+{
+    // motor curves of esp_drone_config.h.
+    static const ed_sim_motor_curve_t curves[ED_SIM_MOTORS] = {
+        { 203.77, -136.57 },
+        { 216.21, -127.61 },
+        { 190.7, -114.13 },
+        { 196.37, -120.08 },
+    };
+
+    memset(params, 0x00, sizeof(ed_sim_params_t));
+    params->dt = 0.01f;
+    params->substeps = 10;
+    params->latency = 1;
+
+    params->mass = 0.035f;
+    params->arm = 0.033f;
+    params->inertia[0] = 1.6e-5f;
+    params->inertia[1] = 1.6e-5f;
+    params->inertia[2] = 2.9e-5f;
+    params->kt = 0.2f / (ED_MOTOR_MAX_RPS * ED_MOTOR_MAX_RPS);
+    params->kq = 0.006f;
+    params->motor_tau = 0.03f;
+    params->max_rps = ED_MOTOR_MAX_RPS;
+    params->min_rps = 1;
+    for(int i = 0; i < ED_SIM_MOTORS; i++)
+    {
+        params->curve[i] = curves[i];
+        params->calibration[i] = curves[i];
+    }
+
+    params->gyro_noise = 0.5f;
+    params->attitude_noise = 0.1f;
+    params->seed = 1;
+}
+
+/**
+ * @brief: Reset the simulation to a level hover.
+ */
+void ed_sim_init(ed_sim_t* sim, const ed_sim_params_t* params)
+{
+    memset(sim, 0x00, sizeof(ed_sim_t));
+    sim->params = *params;
+    if(sim->params.latency < 0)
+        sim->params.latency = 0;
+    if(sim->params.latency > ED_SIM_MAX_LATENCY)
+        sim->params.latency = ED_SIM_MAX_LATENCY;
+    if(sim->params.substeps < 1)
+        sim->params.substeps = 1;
+
+    sim->q.w = 1;
+    sim->rng = params->seed;
+
+    float hover_rps = params->max_rps * sqrtf(ed_sim_hover_throttle(params));
+    for(int i = 0; i < ED_SIM_MOTORS; i++)
+        sim->rps[i] = hover_rps;
+
+    oh_drv_status_t level = { .q0 = 1 };
+    for(int i = 0; i <= ED_SIM_MAX_LATENCY; i++)
+        sim->delay_line[i] = level;
+}
+
+/**
+ * @brief: Get the normalized thrust command of hover.
+ */
+float ed_sim_hover_throttle(const ed_sim_params_t* params)
+{
+    float thrust = params->mass * ED_SIM_GRAVITY / ED_SIM_MOTORS;
+    return thrust / (params->kt * params->max_rps * params->max_rps);
+}
+
+// thrust command -> duty with the calibration(as ed_motor_set_thrust) -> rps with the real curve.
+static float __ed_sim_motor_target(const ed_sim_params_t* params, int motor, float thrust)
+{
+    if(!(thrust > 0))
+        return 0;
+    if(thrust > 1)
+        thrust = 1;
+
+    float rps = params->max_rps * sqrtf(thrust);
+    if(rps < params->min_rps)
+        return 0;
+
+    const ed_sim_motor_curve_t* cal = &params->calibration[motor];
+    float duty = expf((rps - cal->c) / cal->k);
+    if(duty > 100)
+        duty = 100;
+
+    const ed_sim_motor_curve_t* real = &params->curve[motor];
+    rps = real->k * logf(duty) + real->c;
+    return rps > 0 ? rps : 0;
+}
+
+static void __ed_sim_record(ed_sim_t* sim)
+{
+    const ed_sim_params_t* params = &sim->params;
+    oh_drv_status_t status = { 0 };
+
+    // attitude noise as a small random rotation.
+    oh_quat_t q = sim->q;
+    if(params->attitude_noise > 0)
+    {
+        float half = 0.5f * params->attitude_noise * ED_SIM_DEG_TO_RAD;
+        oh_quat_t noise = {
+            .w = 1,
+            .x = half * ed_sim_randn(&sim->rng),
+            .y = half * ed_sim_randn(&sim->rng),
+            .z = half * ed_sim_randn(&sim->rng),
+        };
+        q = oh_quat_mul(q, noise);
+        float norm = 1.0f / sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+        q.w *= norm; q.x *= norm; q.y *= norm; q.z *= norm;
+    }
+    status.q0 = q.w;
+    status.q1 = q.x;
+    status.q2 = q.y;
+    status.q3 = q.z;
+    oh_quat_to_eular(q, &status.pitch, &status.roll, &status.yaw);
+
+    status.gx = sim->w[0] * ED_SIM_RAD_TO_DEG + params->gyro_noise * ed_sim_randn(&sim->rng);
+    status.gy = sim->w[1] * ED_SIM_RAD_TO_DEG + params->gyro_noise * ed_sim_randn(&sim->rng);
+    status.gz = sim->w[2] * ED_SIM_RAD_TO_DEG + params->gyro_noise * ed_sim_randn(&sim->rng);
+    status.az = 1;
+
+    sim->delay_index = (sim->delay_index + 1) % (ED_SIM_MAX_LATENCY + 1);
+    sim->delay_line[sim->delay_index] = status;
+}
+
+/**
+ * @brief: Advance one control period.
+ * @param:
+ *      - const float* thrust : normalized thrust commands of the motors, as `ed_motor_set_thrust`.
+ *      - const float* torque : external torque in body frame, N*m. May be NULL.
+ */
+void ed_sim_step(ed_sim_t* sim, const float* thrust, const float* torque)
+{
+    const ed_sim_params_t* params = &sim->params;
+    float h = params->dt / params->substeps;
+    float target[ED_SIM_MOTORS];
+    float lag = h / (params->motor_tau + h);
+
+    for(int i = 0; i < ED_SIM_MOTORS; i++)
+        target[i] = __ed_sim_motor_target(params, i, thrust[i]);
+
+    for(int step = 0; step < params->substeps; step++)
+    {
+        float tau[3] = { 0, 0, 0 };
+        if(torque)
+        {
+            tau[0] = torque[0];
+            tau[1] = torque[1];
+            tau[2] = torque[2];
+        }
+
+        for(int i = 0; i < ED_SIM_MOTORS; i++)
+        {
+            sim->rps[i] += (target[i] - sim->rps[i]) * lag;
+            float force = params->kt * sim->rps[i] * sim->rps[i];
+            tau[0] += motor_y[i] * params->arm * force;
+            tau[1] += - motor_x[i] * params->arm * force;
+            tau[2] += motor_spin[i] * params->kq * force;
+        }
+
+        // I * dw/dt = tau - w x (I * w)
+        const float* inertia = params->inertia;
+        float* w = sim->w;
+        float iw[3] = { inertia[0] * w[0], inertia[1] * w[1], inertia[2] * w[2] };
+        float dw[3] = {
+            (tau[0] - (w[1] * iw[2] - w[2] * iw[1])) / inertia[0],
+            (tau[1] - (w[2] * iw[0] - w[0] * iw[2])) / inertia[1],
+            (tau[2] - (w[0] * iw[1] - w[1] * iw[0])) / inertia[2],
+        };
+        w[0] += dw[0] * h;
+        w[1] += dw[1] * h;
+        w[2] += dw[2] * h;
+
+        // dq/dt = q * (0, w) / 2
+        oh_quat_t rate = { .w = 0, .x = w[0], .y = w[1], .z = w[2] };
+        oh_quat_t dq = oh_quat_mul(sim->q, rate);
+        sim->q.w += 0.5f * h * dq.w;
+        sim->q.x += 0.5f * h * dq.x;
+        sim->q.y += 0.5f * h * dq.y;
+        sim->q.z += 0.5f * h * dq.z;
+        float norm = 1.0f / sqrtf(sim->q.w * sim->q.w + sim->q.x * sim->q.x + sim->q.y * sim->q.y + sim->q.z * sim->q.z);
+        sim->q.w *= norm; sim->q.x *= norm; sim->q.y *= norm; sim->q.z *= norm;
+    }
+
+    __ed_sim_record(sim);
+}
+
+/**
+ * @brief: Get the delayed and noisy measurements, filled as the firmware fills oh_drv_status_t.
+ */
+void ed_sim_measure(ed_sim_t* sim, oh_drv_status_t* status)
+{
+    int index = sim->delay_index - sim->params.latency;
+    if(index < 0)
+        index += ED_SIM_MAX_LATENCY + 1;
+    *status = sim->delay_line[index];
+}
+
+/**
+ * @brief: Initialize a level hover with a copy of pid.
+ * @note: The gyro and D-term filters of esp_drone_pid_config.h are applied as in the firmware.
+ */
+void ed_sim_flight_init(ed_sim_flight_t* flight, const ed_sim_params_t* params, const oh_quad_pid_t* pid)
+{
+    static const oh_biquad_config_t gyro_filter_stages[] = ED_GYRO_FILTER_STAGES;
+    static const oh_biquad_config_t dterm_filter_stages[] = ED_DTERM_FILTER_STAGES;
+    float sample_hz = 1.0f / params->dt;
+
+    memset(flight, 0x00, sizeof(ed_sim_flight_t));
+    ed_sim_init(&flight->sim, params);
+    flight->pid = *pid;
+    oh_filter_chain_init(&flight->gyro_filter, 3, sample_hz, gyro_filter_stages, sizeof(gyro_filter_stages) / sizeof(gyro_filter_stages[0]));
+    oh_filter_chain_init(&flight->pid.dterm_filter, 3, sample_hz, dterm_filter_stages, sizeof(dterm_filter_stages) / sizeof(dterm_filter_stages[0]));
+    oh_quad_pid_init(&flight->pid);
+    flight->throttle = ed_sim_hover_throttle(params);
+}
+
+/**
+ * @brief: Run a control tick as motion_control_task does, then advance the simulation.
+ * @param:
+ *      - const float* torque : external torque in body frame, N*m. May be NULL.
+ */
+void ed_sim_flight_tick(ed_sim_flight_t* flight, const float* torque)
+{
+    oh_drv_status_t* status = &flight->status;
+
+    ed_sim_measure(&flight->sim, status);
+    float gyro[3] = { status->gx, status->gy, status->gz };
+    oh_filter_chain_apply(&flight->gyro_filter, gyro);
+    status->gx = gyro[0];
+    status->gy = gyro[1];
+    status->gz = gyro[2];
+    oh_quad_pid_control_realize(status, &flight->pid, flight->throttle, &flight->output);
+
+    float thrust[ED_SIM_MOTORS] = { flight->output.m1, flight->output.m2, flight->output.m3, flight->output.m4 };
+    ed_sim_step(&flight->sim, thrust, torque);
+}
+
+/**
+ * @brief: Get the true attitude of the simulation in eular angles, deg.
+ */
+void ed_sim_attitude(const ed_sim_t* sim, float* pitch, float* roll, float* yaw)
+{
+    oh_quat_to_eular(sim->q, pitch, roll, yaw);
+}
+
+/**
+ * @brief: Fly the standard maneuver with the controller of pid.
+ * @note: level hover, a roll step, a pitch step, then torque pulses on x and y.
+ */
+void ed_sim_fly(const ed_sim_params_t* params, const oh_quad_pid_t* pid, float step_deg, ed_sim_result_t* result)
+{
+    // maneuver timeline in s.
+    const float roll_step[2] = { 1, 3 };
+    const float pitch_step[2] = { 4, 6 };
+    const float pulse[2] = { 7, 7.05f };
+    const float end = 8.5f;
+    const float pulse_torque = 2e-4f;
+
+    ed_sim_flight_t flight;
+    ed_sim_flight_init(&flight, params, pid);
+    oh_quad_pid_t* ctrl = &flight.pid;
+
+    int ticks = (int)(end / params->dt);
+    int saturated = 0;
+    memset(result, 0x00, sizeof(ed_sim_result_t));
+
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        float t = tick * params->dt;
+
+        // targets of the maneuver.
+        ctrl->angle_roll.target = (t >= roll_step[0] && t < roll_step[1]) ? step_deg : 0;
+        ctrl->angle_pitch.target = (t >= pitch_step[0] && t < pitch_step[1]) ? step_deg : 0;
+        ctrl->angle_yaw.target = 0;
+
+        float torque[3] = { 0, 0, 0 };
+        if(t >= pulse[0] && t < pulse[1])
+        {
+            torque[0] = pulse_torque;
+            torque[1] = - pulse_torque;
+        }
+        ed_sim_flight_tick(&flight, torque);
+
+        const oh_drv_quadrotor_output_t* output = &flight.output;
+        float thrust[ED_SIM_MOTORS] = { output->m1, output->m2, output->m3, output->m4 };
+        for(int i = 0; i < ED_SIM_MOTORS; i++)
+        {
+            if(thrust[i] <= 0 || thrust[i] >= 1)
+            {
+                saturated ++;
+                break;
+            }
+        }
+
+        // scores on the true attitude.
+        float pitch, roll, yaw;
+        ed_sim_attitude(&flight.sim, &pitch, &roll, &yaw);
+        float roll_err = roll - ctrl->angle_roll.target;
+        float pitch_err = pitch - ctrl->angle_pitch.target;
+        result->iae += (fabsf(roll_err) + fabsf(pitch_err)) * params->dt;
+
+        if(step_deg != 0)
+        {
+            float overshoot = 0;
+            if(t >= roll_step[0] && t < roll_step[1])
+                overshoot = (roll / step_deg - 1) * 100;
+            else if(t >= pitch_step[0] && t < pitch_step[1])
+                overshoot = (pitch / step_deg - 1) * 100;
+            if(overshoot > result->overshoot)
+                result->overshoot = overshoot;
+        }
+
+        if(t >= pulse[0])
+        {
+            float tilt = fmaxf(fabsf(roll), fabsf(pitch));
+            if(tilt > result->disturbance_peak)
+                result->disturbance_peak = tilt;
+        }
+
+        if(!isfinite(roll) || !isfinite(pitch) || fabsf(roll) > 60 || fabsf(pitch) > 60)
+        {
+            result->diverged = 1;
+            // the rest of the flight counts as the worst error.
+            result->iae += (ticks - tick - 1) * params->dt * 120;
+            break;
+        }
+    }
+    result->saturation = (float)saturated / ticks;
+}
@@ -0,0 +1,183 @@
+#ifndef __ED_SIM_H__
+#define __ED_SIM_H__
+
+#include <stdint.h>
+
+#include "oh_drv.h"
+#include "oh_filter.h"
+#include "oh_quadrotor_pid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @note: Attitude simulator of the quadrotor for host tools.
+ *          Only the rotation is simulated(rigid body, first order motors, thrust = kt * rps^2),
+ *          the translation is ignored. Motors are laid out and numbered as in oh_quadrotor_pid.h,
+ *          x points right, y points forward and z points up.
+ */
+#define ED_SIM_MOTORS                   (4)
+#define ED_SIM_MAX_LATENCY              (8)
+
+// rps = k * ln(duty) + c, duty in [0, 100], the fitting of ed_motor_t.
+typedef struct {
+    float k;
+    float c;
+} ed_sim_motor_curve_t;
+
+/**
+ * @brief: Simulation parameters.
+ * @param:
+ *      float dt                    : control period in s, 1 / imu_freq.
+ *      int substeps                : physics steps per control period.
+ *      int latency                 : sensor delay in control periods, up to ED_SIM_MAX_LATENCY.
+ *      float mass                  : kg, only used for the hover throttle.
+ *      float arm                   : distance of the motors to the x and y axes, m.
+ *      float inertia[3]            : kg*m^2.
+ *      float kt                    : thrust per rps^2, N.
+ *      float kq                    : reaction torque per thrust, m.
+ *      float motor_tau             : time constant of motors, s.
+ *      float max_rps, min_rps      : the same as ed_motor_t.
+ *      ed_sim_motor_curve_t curve[]       : real curves of the motors.
+ *      ed_sim_motor_curve_t calibration[] : curves known by the controller(esp_drone_config.h).
+ *      float gyro_noise            : deg/s, standard deviation.
+ *      float attitude_noise        : deg, standard deviation of each axis.
+ *      uint64_t seed               : seed of the noises, the same seed replays the same flight.
+ */
+typedef struct {
+    float dt;
+    int substeps;
+    int latency;
+
+    float mass;
+    float arm;
+    float inertia[3];
+    float kt;
+    float kq;
+    float motor_tau;
+    float max_rps;
+    float min_rps;
+    ed_sim_motor_curve_t curve[ED_SIM_MOTORS];
+    ed_sim_motor_curve_t calibration[ED_SIM_MOTORS];
+
+    float gyro_noise;
+    float attitude_noise;
+    uint64_t seed;
+} ed_sim_params_t;
+
+typedef struct {
+    ed_sim_params_t params;
+
+    // state
+    oh_quat_t q;
+    float w[3];                         // rad/s, body frame.
+    float rps[ED_SIM_MOTORS];
+    uint64_t rng;
+
+    // measurements delayed by params.latency.
+    oh_drv_status_t delay_line[ED_SIM_MAX_LATENCY + 1];
+    int delay_index;
+} ed_sim_t;
+
+/**
+ * @brief: Closed loop of the simulation and the firmware controller.
+ * @param:
+ *      oh_quad_pid_t pid        : the controller, targets and gains may be changed between ticks.
+ *      float throttle           : collective thrust, the hover throttle after init.
+ *      oh_drv_status_t status   : filtered measurements of the last tick.
+ *      oh_drv_quadrotor_output_t output : motor thrusts of the last tick.
+ */
+typedef struct {
+    ed_sim_t sim;
+    oh_quad_pid_t pid;
+    oh_filter_chain_t gyro_filter;
+    float throttle;
+    oh_drv_status_t status;
+    oh_drv_quadrotor_output_t output;
+} ed_sim_flight_t;
+
+/**
+ * @brief: Result of a standard flight, see `ed_sim_fly`.
+ * @param:
+ *      float iae              : integral of the absolute attitude error over the flight, deg*s.
+ *      float overshoot        : max overshoot of the angle steps, % of the step.
+ *      float disturbance_peak : max tilt after the torque pulses, deg.
+ *      float saturation       : fraction of ticks with a motor at the end of its range.
+ *      int diverged           : the tilt went beyond 60 deg, the flight was stopped.
+ */
+typedef struct {
+    float iae;
+    float overshoot;
+    float disturbance_peak;
+    float saturation;
+    int diverged;
+} ed_sim_result_t;
+
+/**
+ * @brief: Fill params with the nominal ESP_Drone_Mini airframe.
+ */
+void ed_sim_default_params(ed_sim_params_t* params);
+
+/**
+ * @brief: Reset the simulation to a level hover.
+ */
+void ed_sim_init(ed_sim_t* sim, const ed_sim_params_t* params);
+
+/**
+ * @brief: Advance one control period.
+ * @param:
+ *      - const float* thrust : normalized thrust commands of the motors, as `ed_motor_set_thrust`.
+ *      - const float* torque : external torque in body frame, N*m. May be NULL.
+ */
+void ed_sim_step(ed_sim_t* sim, const float* thrust, const float* torque);
+
+/**
+ * @brief: Get the delayed and noisy measurements, filled as the firmware fills oh_drv_status_t.
+ */
+void ed_sim_measure(ed_sim_t* sim, oh_drv_status_t* status);
+
+/**
+ * @brief: Get the normalized thrust command of hover.
+ */
+float ed_sim_hover_throttle(const ed_sim_params_t* params);
+
+/**
+ * @brief: Initialize a level hover with a copy of pid.
+ * @note: The gyro and D-term filters of esp_drone_pid_config.h are applied as in the firmware.
+ */
+void ed_sim_flight_init(ed_sim_flight_t* flight, const ed_sim_params_t* params, const oh_quad_pid_t* pid);
+
+/**
+ * @brief: Run a control tick as motion_control_task does, then advance the simulation.
+ * @param:
+ *      - const float* torque : external torque in body frame, N*m. May be NULL.
+ */
+void ed_sim_flight_tick(ed_sim_flight_t* flight, const float* torque);
+
+/**
+ * @brief: Get the true attitude of the simulation in eular angles, deg.
+ */
+void ed_sim_attitude(const ed_sim_t* sim, float* pitch, float* roll, float* yaw);
+
+/**
+ * @brief: Fly the standard maneuver with the controller of pid.
+ * @note: level hover, a roll step, a pitch step, then torque pulses on x and y.
+ */
+void ed_sim_fly(const ed_sim_params_t* params, const oh_quad_pid_t* pid, float step_deg, ed_sim_result_t* result);
+
+/**
+ * @brief: Uniform random number in [0, 1) of the simulation rng.
+ */
+float ed_sim_randu(uint64_t* state);
+
+/**
+ * @brief: Normal distributed random number of the simulation rng.
+ */
+float ed_sim_randn(uint64_t* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
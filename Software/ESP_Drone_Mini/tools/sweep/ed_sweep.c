@@ -0,0 +1,407 @@
+/**
+ * @note: Monte Carlo robustness sweep of ESP_Drone.
+ *          Every run draws a perturbed airframe(real motor curves drifting from the calibration,
+ *          gyro and attitude noise, sensor latency, mass) from its own seed, flies the standard
+ *          maneuver of ed_sim and measures the margins of the gain set:
+ *              gain margin  : largest factor on the rate loop gains that still flies, up to 16.
+ *              delay margin : extra latency ticks that still fly.
+ *          A run is unstable when it diverges or a motor is at the end of its range in more than
+ *          half of the ticks(limit cycle).
+ *          Run i only depends on (random seed, i), so the report does not depend on the threads.
+ *
+ *          usage: ed_sweep [-n runs] [-j threads] [-r random seed] [-g vP,vI,vD,aP,aI] [-k curve %]
+ *                          [-w gyro noise] [-t attitude noise] [-l max latency] [-m mass %] [-a step deg] [-o csv]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_drone_pid_config.h"
+#include "ed_sim.h"
+#include "ed_pool.h"
+
+#define SWEEP_MAX_GAIN_MARGIN           (16.0f)
+#define SWEEP_GAIN_MARGIN_STEPS         (6)
+#define SWEEP_UNSTABLE_SATURATION       (0.5f)
+
+typedef struct {
+    int runs;
+    uint64_t random_seed;
+    float curve_spread;                 // relative, k and c of each motor.
+    float gyro_noise;                   // deg/s, max of the uniform draw.
+    float attitude_noise;               // deg, max of the uniform draw.
+    int max_latency;                    // ticks
+    float mass_spread;                  // relative
+    float step_deg;
+    oh_quad_pid_t pid;
+} sweep_config_t;
+
+typedef struct {
+    const sweep_config_t* config;
+    int index;
+
+    // drawn perturbations.
+    ed_sim_params_t params;
+    float curve_error;                  // max relative error of the real rps at hover.
+
+    // results.
+    ed_sim_result_t result;
+    float gain_margin;
+    int delay_margin;
+} sweep_run_t;
+
+static float uniform(uint64_t* rng, float min, float max)
+{
+    return min + (max - min) * ed_sim_randu(rng);
+}
+
+static int unstable(const ed_sim_result_t* result)
+{
+    return result->diverged || result->saturation > SWEEP_UNSTABLE_SATURATION;
+}
+
+static void scale_rate_gains(oh_quad_pid_t* pid, float factor)
+{
+    oh_pos_pid_t* loops[] = { &pid->veloc_pitch, &pid->veloc_roll, &pid->veloc_yaw };
+    for(int i = 0; i < 3; i++)
+    {
+        loops[i]->proportion *= factor;
+        loops[i]->integration *= factor;
+        loops[i]->differention *= factor;
+    }
+    for(int i = 0; i < pid->schedule.points; i++)
+    {
+        oh_pid_gains_t* gains[] = { &pid->schedule.gains[i].veloc_pitch, &pid->schedule.gains[i].veloc_roll, &pid->schedule.gains[i].veloc_yaw };
+        for(int j = 0; j < 3; j++)
+        {
+            gains[j]->proportion *= factor;
+            gains[j]->integration *= factor;
+            gains[j]->differention *= factor;
+        }
+    }
+}
+
+static int fly_unstable(const sweep_run_t* run, const ed_sim_params_t* params, float gain_factor)
+{
+    oh_quad_pid_t pid = run->config->pid;
+    ed_sim_result_t result;
+    scale_rate_gains(&pid, gain_factor);
+    ed_sim_fly(params, &pid, run->config->step_deg, &result);
+    return unstable(&result);
+}
+
+static void draw_params(sweep_run_t* run)
+{
+    const sweep_config_t* config = run->config;
+    uint64_t rng = config->random_seed * 0x2545F4914F6CDD1Dull + (uint64_t)run->index;
+    ed_sim_params_t* params = &run->params;
+
+    ed_sim_default_params(params);
+    float hover_rps = params->max_rps * sqrtf(ed_sim_hover_throttle(params));
+    run->curve_error = 0;
+    for(int i = 0; i < ED_SIM_MOTORS; i++)
+    {
+        params->curve[i].k *= 1 + uniform(&rng, - config->curve_spread, config->curve_spread);
+        params->curve[i].c *= 1 + uniform(&rng, - config->curve_spread, config->curve_spread);
+
+        // how far the commanded hover rps lands from the real one.
+        const ed_sim_motor_curve_t* cal = &params->calibration[i];
+        float duty = expf((hover_rps - cal->c) / cal->k);
+        float error = fabsf(params->curve[i].k * logf(duty) + params->curve[i].c - hover_rps) / hover_rps;
+        if(error > run->curve_error)
+            run->curve_error = error;
+    }
+    params->gyro_noise = uniform(&rng, 0, config->gyro_noise);
+    params->attitude_noise = uniform(&rng, 0, config->attitude_noise);
+    params->latency = (int)uniform(&rng, 0, config->max_latency + 1);
+    params->mass *= 1 + uniform(&rng, - config->mass_spread, config->mass_spread);
+    params->seed = rng ^ 0xD1B54A32D192ED03ull;
+}
+
+static void sweep_run(void* arg)
+{
+    sweep_run_t* run = (sweep_run_t*)arg;
+    draw_params(run);
+    ed_sim_fly(&run->params, &run->config->pid, run->config->step_deg, &run->result);
+
+    // gain margin, bisection of the factor in log space.
+    run->gain_margin = 0;
+    if(!unstable(&run->result))
+    {
+        float low = 0, high = log2f(SWEEP_MAX_GAIN_MARGIN);
+        if(!fly_unstable(run, &run->params, SWEEP_MAX_GAIN_MARGIN))
+            low = high;
+        for(int i = 0; i < SWEEP_GAIN_MARGIN_STEPS && low < high; i++)
+        {
+            float mid = 0.5f * (low + high);
+            if(fly_unstable(run, &run->params, exp2f(mid)))
+                high = mid;
+            else
+                low = mid;
+        }
+        run->gain_margin = exp2f(low);
+    }
+
+    // delay margin.
+    run->delay_margin = -1;
+    if(!unstable(&run->result))
+    {
+        ed_sim_params_t params = run->params;
+        run->delay_margin = 0;
+        while(params.latency < ED_SIM_MAX_LATENCY)
+        {
+            params.latency ++;
+            if(fly_unstable(run, &params, 1))
+                break;
+            run->delay_margin ++;
+        }
+    }
+}
+
+static int compare_float(const void* a, const void* b)
+{
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// percentile of the sorted values, nearest rank.
+static float percentile(const float* sorted, int n, float p)
+{
+    if(n == 0)
+        return NAN;
+    int index = (int)ceilf(p / 100 * n) - 1;
+    if(index < 0)
+        index = 0;
+    if(index >= n)
+        index = n - 1;
+    return sorted[index];
+}
+
+typedef float (*sweep_metric_t)(const sweep_run_t* run);
+
+static float metric_iae(const sweep_run_t* run) { return run->result.iae; }
+static float metric_overshoot(const sweep_run_t* run) { return run->result.overshoot; }
+static float metric_disturbance(const sweep_run_t* run) { return run->result.disturbance_peak; }
+static float metric_gain_margin(const sweep_run_t* run) { return run->gain_margin; }
+static float metric_delay_margin(const sweep_run_t* run) { return run->delay_margin; }
+
+static float metric_latency(const sweep_run_t* run) { return run->params.latency; }
+static float metric_curve_error(const sweep_run_t* run) { return run->curve_error * 100; }
+static float metric_gyro_noise(const sweep_run_t* run) { return run->params.gyro_noise; }
+static float metric_attitude_noise(const sweep_run_t* run) { return run->params.attitude_noise; }
+static float metric_mass(const sweep_run_t* run) { return run->params.mass * 1000; }
+
+// collect a metric of the runs with the latency, or all runs when latency < 0, sorted.
+static int collect(const sweep_run_t* runs, int n, int latency, sweep_metric_t metric, float* values)
+{
+    int count = 0;
+    for(int i = 0; i < n; i++)
+    {
+        if(latency >= 0 && runs[i].params.latency != latency)
+            continue;
+        values[count ++] = metric(&runs[i]);
+    }
+    qsort(values, count, sizeof(float), compare_float);
+    return count;
+}
+
+static void print_distribution(const char* name, const float* sorted, int n, int lower_tail)
+{
+    if(lower_tail)
+        printf("  %-22s min %8.3f  p1 %8.3f  p10 %8.3f  p50 %8.3f\n", name,
+            sorted[0], percentile(sorted, n, 1), percentile(sorted, n, 10), percentile(sorted, n, 50));
+    else
+        printf("  %-22s p50 %8.3f  p90 %8.3f  p99 %8.3f  max %8.3f\n", name,
+            percentile(sorted, n, 50), percentile(sorted, n, 90), percentile(sorted, n, 99), sorted[n - 1]);
+}
+
+static int parse_gains(const char* text, oh_quad_pid_t* pid)
+{
+    float g[5];
+    if(sscanf(text, "%f,%f,%f,%f,%f", &g[0], &g[1], &g[2], &g[3], &g[4]) != 5)
+        return -1;
+    pid->veloc_pitch.proportion = pid->veloc_roll.proportion = g[0];
+    pid->veloc_pitch.integration = pid->veloc_roll.integration = g[1];
+    pid->veloc_pitch.differention = pid->veloc_roll.differention = g[2];
+    pid->angle_pitch.proportion = pid->angle_roll.proportion = g[3];
+    pid->angle_pitch.integration = pid->angle_roll.integration = g[4];
+    pid->schedule.points = 0;
+    return 0;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-n runs] [-j threads] [-r random seed] [-g vP,vI,vD,aP,aI] [-k curve %%]\n"
+                    "          [-w gyro noise] [-t attitude noise] [-l max latency] [-m mass %%] [-a step deg] [-o csv]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    sweep_config_t config = {
+        .runs = 2000,
+        .random_seed = 1,
+        .curve_spread = 0.1f,
+        .gyro_noise = 2,
+        .attitude_noise = 0.5f,
+        .max_latency = 3,
+        .mass_spread = 0.1f,
+        .step_deg = 10,
+        .pid = ESP_DRONE_PID_PARAM,
+    };
+    int threads = 0;
+    const char* csv_path = NULL;
+
+    int opt;
+    while((opt = getopt(argc, argv, "n:j:r:g:k:w:t:l:m:a:o:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n': config.runs = atoi(optarg); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'r': config.random_seed = strtoull(optarg, NULL, 0); break;
+        case 'g':
+            if(parse_gains(optarg, &config.pid) != 0)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'k': config.curve_spread = atof(optarg) / 100; break;
+        case 'w': config.gyro_noise = atof(optarg); break;
+        case 't': config.attitude_noise = atof(optarg); break;
+        case 'l': config.max_latency = atoi(optarg); break;
+        case 'm': config.mass_spread = atof(optarg) / 100; break;
+        case 'a': config.step_deg = atof(optarg); break;
+        case 'o': csv_path = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if(config.runs < 1 || config.max_latency < 0 || config.max_latency > ED_SIM_MAX_LATENCY)
+    {
+        fprintf(stderr, "runs must be positive and max latency in [0, %d]\n", ED_SIM_MAX_LATENCY);
+        return 1;
+    }
+
+    ed_pool_t* pool = ed_pool_create(threads);
+    sweep_run_t* runs = calloc(config.runs, sizeof(sweep_run_t));
+    float* values = malloc(sizeof(float) * config.runs);
+    if(!pool || !runs || !values)
+    {
+        fprintf(stderr, "out of resources\n");
+        return 1;
+    }
+    fprintf(stderr, "sweeping %d runs with %d workers\n", config.runs, ed_pool_threads(pool));
+
+    for(int i = 0; i < config.runs; i++)
+    {
+        runs[i].config = &config;
+        runs[i].index = i;
+        ed_pool_submit(pool, sweep_run, &runs[i]);
+    }
+    ed_pool_wait(pool);
+    ed_pool_destroy(pool);
+
+    // overall.
+    int failed = 0;
+    for(int i = 0; i < config.runs; i++)
+        failed += runs[i].gain_margin == 0;
+    printf("runs: %d, unstable: %d (%.2f%%)\n", config.runs, failed, 100.0f * failed / config.runs);
+    printf("perturbations: curve +-%.0f%%, gyro noise <= %.2f deg/s, attitude noise <= %.2f deg, latency <= %d ticks, mass +-%.0f%%\n",
+        config.curve_spread * 100, config.gyro_noise, config.attitude_noise, config.max_latency, config.mass_spread * 100);
+
+    printf("\nmargins:\n");
+    int n = collect(runs, config.runs, -1, metric_gain_margin, values);
+    print_distribution("gain margin (x)", values, n, 1);
+    n = collect(runs, config.runs, -1, metric_delay_margin, values);
+    print_distribution("delay margin (ticks)", values, n, 1);
+
+    printf("\nresponse:\n");
+    n = collect(runs, config.runs, -1, metric_iae, values);
+    print_distribution("iae (deg*s)", values, n, 0);
+    n = collect(runs, config.runs, -1, metric_overshoot, values);
+    print_distribution("overshoot (%)", values, n, 0);
+    n = collect(runs, config.runs, -1, metric_disturbance, values);
+    print_distribution("disturbance peak (deg)", values, n, 0);
+
+    // the tails by sensor latency.
+    printf("\nlatency sensitivity:\n");
+    printf("  %-8s %6s %9s %10s %10s %12s %14s\n", "latency", "runs", "unstable", "iae p50", "iae p99", "dist p99", "gain margin p1");
+    for(int latency = 0; latency <= config.max_latency; latency++)
+    {
+        float iae50, iae99, dist99, margin1;
+        int count = collect(runs, config.runs, latency, metric_iae, values);
+        if(count == 0)
+            continue;
+        iae50 = percentile(values, count, 50);
+        iae99 = percentile(values, count, 99);
+        collect(runs, config.runs, latency, metric_disturbance, values);
+        dist99 = percentile(values, count, 99);
+        collect(runs, config.runs, latency, metric_gain_margin, values);
+        margin1 = percentile(values, count, 1);
+
+        int unstable_runs = 0;
+        for(int i = 0; i < config.runs; i++)
+            unstable_runs += runs[i].params.latency == latency && runs[i].gain_margin == 0;
+        printf("  %-8d %6d %8.2f%% %10.3f %10.3f %12.3f %14.3f\n", latency, count,
+            100.0f * unstable_runs / count, iae50, iae99, dist99, margin1);
+    }
+
+    // which perturbation drives the worst 5% of iae: mean in the tail vs all runs.
+    n = collect(runs, config.runs, -1, metric_iae, values);
+    float tail = percentile(values, n, 95);
+    static const struct {
+        const char* name;
+        sweep_metric_t metric;
+    } drivers[] = {
+        { "latency (ticks)", metric_latency },
+        { "curve error (%)", metric_curve_error },
+        { "gyro noise (deg/s)", metric_gyro_noise },
+        { "attitude noise (deg)", metric_attitude_noise },
+        { "mass (g)", metric_mass },
+    };
+    printf("\ntail drivers (iae >= p95 = %.3f):\n", tail);
+    for(size_t d = 0; d < sizeof(drivers) / sizeof(drivers[0]); d++)
+    {
+        double all = 0, worst = 0;
+        int worst_count = 0;
+        for(int i = 0; i < config.runs; i++)
+        {
+            float value = drivers[d].metric(&runs[i]);
+            all += value;
+            if(runs[i].result.iae >= tail)
+            {
+                worst += value;
+                worst_count ++;
+            }
+        }
+        printf("  %-22s all %8.3f  tail %8.3f\n", drivers[d].name, all / config.runs, worst / worst_count);
+    }
+
+    if(csv_path)
+    {
+        FILE* csv = fopen(csv_path, "w");
+        if(csv == NULL)
+        {
+            fprintf(stderr, "failed to open %s\n", csv_path);
+            return 1;
+        }
+        fprintf(csv, "run,latency,curve_error,gyro_noise,attitude_noise,mass,iae,overshoot,disturbance_peak,saturation,diverged,gain_margin,delay_margin\n");
+        for(int i = 0; i < config.runs; i++)
+        {
+            const sweep_run_t* run = &runs[i];
+            fprintf(csv, "%d,%d,%.4f,%.4f,%.4f,%.5f,%.4f,%.3f,%.4f,%.4f,%d,%.3f,%d\n", i,
+                run->params.latency, run->curve_error, run->params.gyro_noise, run->params.attitude_noise, run->params.mass,
+                run->result.iae, run->result.overshoot, run->result.disturbance_peak, run->result.saturation,
+                run->result.diverged, run->gain_margin, run->delay_margin);
+        }
+        fclose(csv);
+    }
+
+    free(runs);
+    free(values);
+    return 0;
+}
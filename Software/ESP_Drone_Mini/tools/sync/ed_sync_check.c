@@ -0,0 +1,387 @@
+/**
+ * @note: Stress check and benchmark of the concurrency primitives of the firmware(ed_sync.c, ed_param_block.c),
+ *          built unchanged against the host FreeRTOS stand-in of tools/sync/port.
+ *          Each check runs for -t seconds on threads playing the firmware tasks:
+ *              - seqlock: a writer publishes snapshots of 128 bytes as the control task does, -r readers copy
+ *                them. Every copy has to be consistent and no reader may see the sequence going back.
+ *                Half of the readers count the retries of their read sections.
+ *              - spsc: a producer pushes numbered items into a queue of 64, the consumer has to pop all of
+ *                them exactly once and in order.
+ *              - param block: a writer publishes numbered sets as the debugger listener does, a reader
+ *                acquires them at its ticks. Every acquired set has to be consistent, newer than the previous
+ *                one and unchanged until the next acquire. Every other set is published as main.c does for
+ *                two blocks, a wait then a publish without timeout which must not fail.
+ *          Then the uncontended cost of each operation is measured on one thread.
+ *          The process fails if any check finds an error.
+ *
+ *          usage: ed_sync_check [-t seconds] [-r readers]
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ed_param_block.h"
+#include "ed_sync.h"
+
+#define CHECK_MAX_READERS               (16)
+#define CHECK_SNAPSHOT_WORDS            (32)
+#define CHECK_QUEUE_CAPACITY            (64)
+#define CHECK_SET_WORDS                 (64)
+#define CHECK_BENCH_OPS                 (2000000)
+
+// word i of a snapshot or a set numbered n is n + i, a torn copy mixes two numbers.
+typedef struct {
+    uint32_t words[CHECK_SNAPSHOT_WORDS];
+} check_snapshot_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t check;
+    float gyro[3];
+} check_item_t;
+
+typedef struct {
+    uint32_t words[CHECK_SET_WORDS];
+} check_set_t;
+
+typedef struct {
+    int index;
+    uint64_t reads;
+    uint64_t retries;
+    uint64_t torn;
+    uint64_t backwards;
+} check_reader_t;
+
+static atomic_bool stop = false;
+
+static ed_seqlock_t snapshot_lock = ED_SEQLOCK_INIT;
+static check_snapshot_t snapshot;
+
+static ed_spsc_queue_t queue;
+static check_item_t queue_buffer[CHECK_QUEUE_CAPACITY];
+static uint64_t queue_fulls = 0;
+
+static ed_param_block_t block;
+static check_set_t set_buffers[2];
+static uint64_t publishes = 0, publish_timeouts = 0, publish_errors = 0;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool words_consistent(const uint32_t* words, int n)
+{
+    for(int i = 1; i < n; i++)
+    {
+        if(words[i] != words[0] + i)
+            return false;
+    }
+    return true;
+}
+
+static void fill_words(uint32_t* words, int n, uint32_t number)
+{
+    for(int i = 0; i < n; i++)
+        words[i] = number + i;
+}
+
+static void* seqlock_writer(void* arg)
+{
+    (void)arg;
+    check_snapshot_t next;
+    for(uint32_t number = 1; !atomic_load(&stop); number++)
+    {
+        fill_words(next.words, CHECK_SNAPSHOT_WORDS, number);
+        ed_seqlock_write(&snapshot_lock, &snapshot, &next, sizeof(next));
+    }
+    return NULL;
+}
+
+static void* seqlock_reader(void* arg)
+{
+    check_reader_t* reader = arg;
+    check_snapshot_t copy;
+    uint32_t last = 0;
+    while(!atomic_load(&stop))
+    {
+        if(reader->index % 2 == 0)
+        {
+            ed_seqlock_read(&snapshot_lock, &copy, &snapshot, sizeof(copy));
+        } else {
+            uint32_t seq;
+            for( ; ; reader->retries++)
+            {
+                seq = ed_seqlock_read_begin(&snapshot_lock);
+                memcpy(&copy, &snapshot, sizeof(copy));
+                if(!ed_seqlock_read_retry(&snapshot_lock, seq))
+                    break;
+            }
+        }
+        reader->reads ++;
+        if(!words_consistent(copy.words, CHECK_SNAPSHOT_WORDS))
+            reader->torn ++;
+        if(copy.words[0] < last)
+            reader->backwards ++;
+        last = copy.words[0];
+    }
+    return NULL;
+}
+
+static int check_seqlock(double seconds, int readers)
+{
+    pthread_t writer, threads[CHECK_MAX_READERS];
+    check_reader_t stats[CHECK_MAX_READERS] = { 0 };
+    atomic_store(&stop, false);
+    pthread_create(&writer, NULL, seqlock_writer, NULL);
+    for(int i = 0; i < readers; i++)
+    {
+        stats[i].index = i;
+        pthread_create(&threads[i], NULL, seqlock_reader, &stats[i]);
+    }
+    usleep((useconds_t)(seconds * 1e6));
+    atomic_store(&stop, true);
+    pthread_join(writer, NULL);
+
+    uint64_t reads = 0, retries = 0, counted = 0, torn = 0, backwards = 0;
+    for(int i = 0; i < readers; i++)
+    {
+        pthread_join(threads[i], NULL);
+        reads += stats[i].reads;
+        torn += stats[i].torn;
+        backwards += stats[i].backwards;
+        if(i % 2)
+        {
+            retries += stats[i].retries;
+            counted += stats[i].reads;
+        }
+    }
+    printf("seqlock: %d readers, %.2f M reads/s, %.3f retries per read, %llu torn, %llu backwards.\n",
+        readers, reads / seconds * 1e-6, counted ? (double)retries / counted : 0,
+        (unsigned long long)torn, (unsigned long long)backwards);
+    return torn || backwards ? -1 : 0;
+}
+
+static void* spsc_producer(void* arg)
+{
+    uint32_t* pushed = arg;
+    check_item_t item;
+    for(uint32_t seq = 0; !atomic_load(&stop); )
+    {
+        item = (check_item_t){ .seq = seq, .check = seq ^ 0xa5a5a5a5u, .gyro = { seq, -(float)seq, 0.5f * seq } };
+        if(ed_spsc_queue_push(&queue, &item))
+        {
+            seq ++;
+            *pushed = seq;
+        } else {
+            queue_fulls ++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static int check_spsc(double seconds)
+{
+    ed_spsc_queue_init(&queue, queue_buffer, sizeof(check_item_t), CHECK_QUEUE_CAPACITY);
+    atomic_store(&stop, false);
+    queue_fulls = 0;
+
+    pthread_t producer;
+    uint32_t pushed = 0;
+    pthread_create(&producer, NULL, spsc_producer, &pushed);
+
+    uint32_t expected = 0;
+    uint64_t errors = 0, empties = 0;
+    check_item_t item;
+    double end = now_s() + seconds;
+    bool stopped = false;
+    for( ; ; )
+    {
+        if(ed_spsc_queue_pop(&queue, &item))
+        {
+            if(item.seq != expected || item.check != (item.seq ^ 0xa5a5a5a5u) || item.gyro[1] != -(float)item.seq)
+                errors ++;
+            expected = item.seq + 1;
+            continue;
+        }
+        empties ++;
+        if(stopped)
+            break;
+        if(now_s() > end)
+        {
+            // the producer stops, then the queue is drained.
+            atomic_store(&stop, true);
+            pthread_join(producer, NULL);
+            stopped = true;
+        } else {
+            sched_yield();
+        }
+    }
+    if(expected != pushed)
+        errors ++;
+
+    printf("spsc: %.2f M items/s, %u items, %llu full, %llu empty, %llu errors.\n",
+        expected / seconds * 1e-6, expected, (unsigned long long)queue_fulls,
+        (unsigned long long)empties, (unsigned long long)errors);
+    return errors ? -1 : 0;
+}
+
+static void* block_writer(void* arg)
+{
+    (void)arg;
+    check_set_t set;
+    for(uint32_t number = 1; !atomic_load(&stop); number++)
+    {
+        fill_words(set.words, CHECK_SET_WORDS, number);
+        if(number % 2)
+        {
+            // all or none as publish_pid_params of main.c, the publish after the wait finds the block free.
+            if(ed_param_block_wait(&block, pdMS_TO_TICKS(100)))
+                publish_timeouts ++;
+            else if(ed_param_block_publish(&block, &set, 0))
+                publish_errors ++;
+            else
+                publishes ++;
+            continue;
+        }
+        if(ed_param_block_publish(&block, &set, pdMS_TO_TICKS(100)) == 0)
+            publishes ++;
+        else
+            publish_timeouts ++;
+    }
+    return NULL;
+}
+
+static int check_param_block(double seconds)
+{
+    check_set_t initial;
+    fill_words(initial.words, CHECK_SET_WORDS, 0);
+    ed_param_block_init(&block, &set_buffers[0], &set_buffers[1], sizeof(check_set_t), &initial);
+    atomic_store(&stop, false);
+    publishes = publish_timeouts = publish_errors = 0;
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, block_writer, NULL);
+
+    // the reader ticks as fast as it can, the set in use is checked at every tick.
+    const check_set_t* current = block.buffers[0];
+    uint32_t number = 0;
+    uint64_t ticks = 0, acquires = 0, errors = 0;
+    double end = now_s() + seconds;
+    while(now_s() < end)
+    {
+        const check_set_t* set = ed_param_block_acquire(&block);
+        if(set)
+        {
+            acquires ++;
+            if(set->words[0] <= number)
+                errors ++;
+            number = set->words[0];
+            current = set;
+        }
+        if(current->words[0] != number || !words_consistent(current->words, CHECK_SET_WORDS))
+            errors ++;
+        ticks ++;
+        if(ticks % 64 == 0)
+            sched_yield();
+    }
+    atomic_store(&stop, true);
+    pthread_join(writer, NULL);
+
+    errors += publish_errors;
+    printf("param block: %llu ticks, %llu published, %llu acquired, %llu timeouts, %llu errors.\n",
+        (unsigned long long)ticks, (unsigned long long)publishes, (unsigned long long)acquires,
+        (unsigned long long)publish_timeouts, (unsigned long long)errors);
+    return errors ? -1 : 0;
+}
+
+static void bench(void)
+{
+    check_snapshot_t copy, next = { 0 };
+    check_item_t item = { 0 };
+    check_set_t set = { 0 };
+    volatile uint32_t sink = 0;
+    double start;
+
+    start = now_s();
+    for(int i = 0; i < CHECK_BENCH_OPS; i++)
+    {
+        next.words[0] = i;
+        ed_seqlock_write(&snapshot_lock, &snapshot, &next, sizeof(next));
+    }
+    printf("bench: seqlock write of %zu bytes: %.1f ns.\n", sizeof(next), (now_s() - start) / CHECK_BENCH_OPS * 1e9);
+
+    start = now_s();
+    for(int i = 0; i < CHECK_BENCH_OPS; i++)
+    {
+        ed_seqlock_read(&snapshot_lock, &copy, &snapshot, sizeof(copy));
+        sink += copy.words[0];
+    }
+    printf("bench: seqlock read of %zu bytes: %.1f ns.\n", sizeof(copy), (now_s() - start) / CHECK_BENCH_OPS * 1e9);
+
+    ed_spsc_queue_init(&queue, queue_buffer, sizeof(check_item_t), CHECK_QUEUE_CAPACITY);
+    start = now_s();
+    for(int i = 0; i < CHECK_BENCH_OPS; i++)
+    {
+        item.seq = i;
+        ed_spsc_queue_push(&queue, &item);
+        ed_spsc_queue_pop(&queue, &item);
+        sink += item.seq;
+    }
+    printf("bench: spsc push + pop of %zu bytes: %.1f ns.\n", sizeof(item), (now_s() - start) / CHECK_BENCH_OPS * 1e9);
+
+    ed_param_block_init(&block, &set_buffers[0], &set_buffers[1], sizeof(check_set_t), &set);
+    start = now_s();
+    for(int i = 0; i < CHECK_BENCH_OPS; i++)
+        sink += ed_param_block_acquire(&block) != NULL;
+    printf("bench: param block acquire, nothing published: %.1f ns.\n", (now_s() - start) / CHECK_BENCH_OPS * 1e9);
+
+    start = now_s();
+    for(int i = 0; i < CHECK_BENCH_OPS / 10; i++)
+    {
+        ed_param_block_publish(&block, &set, 0);
+        sink += ed_param_block_acquire(&block) != NULL;
+    }
+    printf("bench: param block publish + acquire of %zu bytes: %.1f ns.\n", sizeof(set), (now_s() - start) / (CHECK_BENCH_OPS / 10) * 1e9);
+    (void)sink;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 1;
+    int readers = 4;
+
+    int opt;
+    while((opt = getopt(argc, argv, "t:r:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 't': seconds = atof(optarg); break;
+        case 'r': readers = atoi(optarg); break;
+        default:
+            goto usage;
+        }
+    }
+    if(optind != argc || !(seconds > 0) || readers < 1 || readers > CHECK_MAX_READERS)
+        goto usage;
+
+    int failed = 0;
+    failed |= check_seqlock(seconds, readers);
+    failed |= check_spsc(seconds);
+    failed |= check_param_block(seconds);
+    bench();
+    printf(failed ? "FAILED.\n" : "passed.\n");
+    return failed ? 1 : 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-t seconds] [-r readers]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+#ifndef __ED_HOST_FREERTOS_H__
+#define __ED_HOST_FREERTOS_H__
+
+/**
+ * @note: Host stand-in of the FreeRTOS definitions used by ed_sync and ed_param_block, so that the host tools
+ *          run them unchanged. A tick is 1ms.
+ */
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY                   ((TickType_t)0xffffffffu)
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms))
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef __ED_HOST_FREERTOS_TASK_H__
+#define __ED_HOST_FREERTOS_TASK_H__
+
+#include <sched.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    if(ticks == 0)
+        sched_yield();
+    else
+        usleep(ticks * 1000);
+}
+
+#endif
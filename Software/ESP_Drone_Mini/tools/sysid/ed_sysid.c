@@ -0,0 +1,129 @@
+/**
+ * @note: Host run of the chirp identification of OpenHover against the simulator.
+ *          The simulated drone hovers with ESP_DRONE_PID_PARAM, each angular velocity loop is
+ *          identified as on board(see `oh_quad_pid_sysid_start`), and the identified gain, motor
+ *          time constant and delay are compared with the simulated airframe. The identified
+ *          model is also printed as ed_sim_params_t fields, so that a real flight can feed the simulator.
+ *
+ *          usage: ed_sysid [-A amplitude] [-d duration] [-f f0,f1] [-l latency] [-r random seed]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_drone_pid_config.h"
+#include "ed_sim.h"
+#include "oh_sysid.h"
+
+#define SYSID_RAD_TO_DEG                (57.29577951308232f)
+#define SYSID_HOVER_SECONDS             (1)
+
+static const char* axis_names[] = { "veloc_pitch", "veloc_roll", "veloc_yaw" };
+static const char* state_names[] = { "idle", "running", "done", "failed" };
+
+// torque of a unit of the angular velocity pid output, N*m, from the mixer rows of the quad X.
+static float unit_torque(const ed_sim_params_t* params, const oh_quad_pid_t* pid, int axis)
+{
+    float force = params->kt * params->max_rps * params->max_rps * pid->torque_scale;
+    if(axis == OH_QUAD_AXIS_YAW)
+        return 4 * 0.5f * params->kq * force;
+    return 4 * 0.5f * params->arm * force;
+}
+
+static void hover(ed_sim_flight_t* flight, float seconds)
+{
+    int ticks = (int)(seconds / flight->sim.params.dt);
+    for(int i = 0; i < ticks; i++)
+        ed_sim_flight_tick(flight, NULL);
+}
+
+int main(int argc, char** argv)
+{
+    oh_sysid_t id = {
+        .amplitude = 40,
+        .f0_hz = 0.5f,
+        .f1_hz = 20,
+        .duration = 20,
+        .tau_min = 0.005f,
+        .tau_max = 0.15f,
+        .max_delay = 4,
+    };
+    // the measured rate is filtered as in the firmware.
+    static const oh_biquad_config_t gyro_filter_stages[] = ED_GYRO_FILTER_STAGES;
+    memcpy(id.filter, gyro_filter_stages, sizeof(gyro_filter_stages));
+    id.filter_stages = sizeof(gyro_filter_stages) / sizeof(gyro_filter_stages[0]);
+    ed_sim_params_t params;
+    ed_sim_default_params(&params);
+
+    int opt;
+    while((opt = getopt(argc, argv, "A:d:f:l:r:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'A': id.amplitude = atof(optarg); break;
+        case 'd': id.duration = atof(optarg); break;
+        case 'f':
+            if(sscanf(optarg, "%f,%f", &id.f0_hz, &id.f1_hz) != 2)
+                goto usage;
+            break;
+        case 'l': params.latency = atoi(optarg); break;
+        case 'r': params.seed = strtoull(optarg, NULL, 0); break;
+        default:
+            goto usage;
+        }
+    }
+    id.sample_hz = 1.0f / params.dt;
+
+    const oh_quad_pid_t initial = ESP_DRONE_PID_PARAM;
+    ed_sim_flight_t flight;
+    ed_sim_flight_init(&flight, &params, &initial);
+    hover(&flight, SYSID_HOVER_SECONDS);
+
+    float inertia[3] = { params.inertia[1], params.inertia[0], params.inertia[2] };
+    float identified_inertia[3] = { 0 };
+    float identified_tau = 0, identified_delay = 0;
+    int done = 0;
+
+    printf("%-12s %-6s %12s %12s %8s %8s %8s %8s\n", "axis", "state", "gain", "true gain", "tau", "delay", "ticks", "fit");
+    for(int axis = OH_QUAD_AXIS_PITCH; axis <= OH_QUAD_AXIS_YAW; axis++)
+    {
+        if(oh_quad_pid_sysid_start(&flight.pid, &id, axis))
+        {
+            fprintf(stderr, "invalid sysid configs\n");
+            return 1;
+        }
+        while(flight.pid.sysid)
+            ed_sim_flight_tick(&flight, NULL);
+        hover(&flight, SYSID_HOVER_SECONDS);
+
+        // angular acceleration per unit of command, deg/s^2.
+        float torque = unit_torque(&params, &initial, axis);
+        float true_gain = torque / inertia[axis] * SYSID_RAD_TO_DEG;
+        printf("%-12s %-6s %12.1f %12.1f %7.1fms %7.1fms %8.0f %8.4f\n", axis_names[axis], state_names[id.state],
+            id.gain, true_gain, id.tau * 1000, id.delay * 1000, id.delay * id.sample_hz, id.fit);
+        if(id.state != OH_SYSID_DONE)
+            continue;
+
+        identified_inertia[axis] = torque / id.gain * SYSID_RAD_TO_DEG;
+        identified_tau += id.tau;
+        identified_delay += id.delay * id.sample_hz;
+        done ++;
+    }
+    if(done == 0)
+        return 2;
+
+    // the motor lag and the delay are shared by the axes.
+    printf("\nidentified airframe (true motor_tau %.1fms, latency %d):\n", params.motor_tau * 1000, params.latency);
+    printf("    params.inertia[0] = %.4g;\n", identified_inertia[OH_QUAD_AXIS_ROLL]);
+    printf("    params.inertia[1] = %.4g;\n", identified_inertia[OH_QUAD_AXIS_PITCH]);
+    printf("    params.inertia[2] = %.4g;\n", identified_inertia[OH_QUAD_AXIS_YAW]);
+    printf("    params.motor_tau = %.4g;\n", identified_tau / done);
+    printf("    params.latency = %d;\n", (int)lroundf(identified_delay / done));
+    return done == 3 ? 0 : 2;
+
+usage:
+    fprintf(stderr, "usage: %s [-A amplitude] [-d duration] [-f f0,f1] [-l latency] [-r random seed]\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+/**
+ * @note: Converter between the compact telemetry(ED_DBG_CMD_TELEMETRY, see drivers/debugger/ed_tlm_codec.h)
+ *          and JustFloat.
+ *          The input is a capture of the debugger stream, e.g. `nc drone 8080 > capture.bin`, or `-` for
+ *          stdin. Telemetry frames are decoded to JustFloat for "VOFA+", or to CSV with -c. Other frames
+ *          and bytes are skipped.
+ *          With -e, a JustFloat stream is encoded to compact frames instead, every channel quantized
+ *          with the step of -q, to estimate the saving on a recorded stream.
+ *          The byte counts of both sides are printed to stderr.
+ *
+ *          usage: ed_tlm_decode [-c] [-e] [-q step] [-o output] capture
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ed_debugger_protocol.h"
+#include "ed_tlm_codec.h"
+
+static const uint8_t justfloat_tail[] = { 0x00, 0x00, 0x80, 0x7f };
+
+static uint8_t checksum(const uint8_t* data, int len)
+{
+    uint8_t sum = 0;
+    for(int i = 0; i < len; i++)
+        sum += data[i];
+    return sum;
+}
+
+static void write_values(FILE* output, int csv, const float* values, int n)
+{
+    if(csv)
+    {
+        for(int i = 0; i < n; i++)
+            fprintf(output, i ? ",%g" : "%g", values[i]);
+        fprintf(output, "\n");
+    } else {
+        fwrite(values, sizeof(float), n, output);
+        fwrite(justfloat_tail, 1, sizeof(justfloat_tail), output);
+    }
+}
+
+/**
+ * @brief: Decode the telemetry frames in data.
+ * @return: bytes consumed, the rest waits for more data.
+ */
+static int decode(ed_tlm_decoder_t* decoder, const uint8_t* data, int len, int csv, FILE* output, long* written)
+{
+    float values[ED_TLM_MAX_CHANNELS];
+    int offset = 0;
+    while(offset < len)
+    {
+        int remain = len - offset;
+        if(data[offset] != ED_DBG_SYNC0)
+        {
+            offset ++;
+            continue;
+        }
+        if(remain < ED_DBG_HEADER_SIZE)
+            break;
+
+        int payload_len = data[offset + 3] | (data[offset + 4] << 8);
+        if(data[offset + 1] != ED_DBG_SYNC1 || payload_len > ED_DBG_MAX_PAYLOAD)
+        {
+            offset ++;
+            continue;
+        }
+        if(remain < payload_len + ED_DBG_FRAME_OVERHEAD)
+            break;
+        if(checksum(data + offset + 2, payload_len + 3) != data[offset + ED_DBG_HEADER_SIZE + payload_len])
+        {
+            offset ++;
+            continue;
+        }
+
+        if(data[offset + 2] == ED_DBG_CMD_TELEMETRY)
+        {
+            int n = ed_tlm_decode(decoder, data + offset + ED_DBG_HEADER_SIZE, payload_len, values);
+            if(n > 0)
+            {
+                write_values(output, csv, values, n);
+                *written += (n + 1) * sizeof(float);
+            }
+        }
+        offset += payload_len + ED_DBG_FRAME_OVERHEAD;
+    }
+    return offset;
+}
+
+/**
+ * @brief: Encode the JustFloat packets in data.
+ * @return: bytes consumed, the rest waits for more data.
+ */
+static int encode(ed_tlm_encoder_t* encoder, const uint8_t* data, int len, FILE* output, long* written)
+{
+    static uint8_t frame[ED_DBG_FRAME_OVERHEAD + ED_TLM_MAX_PAYLOAD];
+    int offset = 0;
+    while(1)
+    {
+        // a packet ends at the first aligned tail.
+        int n = 0;
+        while(offset + 4 * (n + 1) <= len && memcmp(data + offset + 4 * n, justfloat_tail, 4))
+            n ++;
+        if(offset + 4 * (n + 1) > len)
+        {
+            // too long to be a packet, skip a float.
+            if(n > ED_TLM_MAX_CHANNELS)
+                offset += 4;
+            else
+                break;
+            continue;
+        }
+
+        float values[ED_TLM_MAX_CHANNELS];
+        if(n >= 1 && n <= ED_TLM_MAX_CHANNELS)
+        {
+            memcpy(values, data + offset, 4 * n);
+            int payload_len = ed_tlm_encode(encoder, values, n, frame + ED_DBG_HEADER_SIZE);
+            frame[0] = ED_DBG_SYNC0;
+            frame[1] = ED_DBG_SYNC1;
+            frame[2] = ED_DBG_CMD_TELEMETRY;
+            frame[3] = payload_len & 0xff;
+            frame[4] = payload_len >> 8;
+            frame[ED_DBG_HEADER_SIZE + payload_len] = checksum(frame + 2, payload_len + 3);
+            fwrite(frame, 1, payload_len + ED_DBG_FRAME_OVERHEAD, output);
+            *written += payload_len + ED_DBG_FRAME_OVERHEAD;
+        }
+        offset += 4 * (n + 1);
+    }
+    return offset;
+}
+
+int main(int argc, char** argv)
+{
+    int csv = 0, to_compact = 0;
+    float step = ED_TLM_DEFAULT_STEP;
+    const char* output_path = NULL;
+
+    int opt;
+    while((opt = getopt(argc, argv, "ceq:o:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'c': csv = 1; break;
+        case 'e': to_compact = 1; break;
+        case 'q': step = atof(optarg); break;
+        case 'o': output_path = optarg; break;
+        default:
+            goto usage;
+        }
+    }
+    if(optind != argc - 1 || !(step > 0) || (csv && to_compact))
+        goto usage;
+
+    FILE* input = strcmp(argv[optind], "-") ? fopen(argv[optind], "rb") : stdin;
+    if(input == NULL)
+    {
+        fprintf(stderr, "can not read %s.\n", argv[optind]);
+        return 1;
+    }
+    FILE* output = output_path ? fopen(output_path, "wb") : stdout;
+    if(output == NULL)
+    {
+        fprintf(stderr, "can not write %s.\n", output_path);
+        return 1;
+    }
+
+    static ed_tlm_encoder_t encoder;
+    static ed_tlm_decoder_t decoder;
+    for(int i = 0; i < ED_TLM_MAX_CHANNELS; i++)
+        encoder.steps[i] = step;
+    encoder.key_interval = 100;
+    ed_tlm_decoder_reset(&decoder);
+
+    static uint8_t buffer[4 * ED_DBG_MAX_FRAME];
+    int len = 0;
+    long read_bytes = 0, written = 0;
+    size_t n;
+    while((n = fread(buffer + len, 1, sizeof(buffer) - len, input)) > 0)
+    {
+        read_bytes += n;
+        len += n;
+        int used = to_compact ? encode(&encoder, buffer, len, output, &written)
+            : decode(&decoder, buffer, len, csv, output, &written);
+        memmove(buffer, buffer + used, len - used);
+        len -= used;
+    }
+
+    if(to_compact)
+        fprintf(stderr, "%ld JustFloat bytes, %ld compact bytes, ratio %.2f.\n",
+            read_bytes, written, written ? (double)read_bytes / written : 0.0);
+    else
+        fprintf(stderr, "%ld compact bytes, %ld JustFloat bytes, ratio %.2f, %lu frames, %lu skipped.\n",
+            read_bytes, written, read_bytes ? (double)written / read_bytes : 0.0,
+            (unsigned long)decoder.frames, (unsigned long)decoder.skipped);
+
+    if(input != stdin)
+        fclose(input);
+    if(output != stdout)
+        fclose(output);
+    return 0;
+
+usage:
+    fprintf(stderr, "usage: %s [-c] [-e] [-q step] [-o output] capture\n", argv[0]);
+    return opt == 'h' ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+#include "ed_cmaes.h"
+
+#include <math.h>
+#include <string.h>
+
+static uint64_t __ed_cmaes_rand_u64(uint64_t* state)
+{
+    // splitmix64
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static double __ed_cmaes_randn(uint64_t* state)
+{
+    double u1 = ((__ed_cmaes_rand_u64(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    double u2 = (__ed_cmaes_rand_u64(state) >> 11) * (1.0 / 9007199254740992.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/**
+ * @brief: Initialize the optimizer.
+ * @param:
+ *      - const double* mean : initial mean, dims values.
+ *      - double sigma       : initial step size.
+ *      - int lambda         : population size, 0 for the default 4 + 3 * ln(dims).
+ *      - uint64_t seed      : seed of the sampling.
+ * @return: 0 if success, -1 if dims or lambda is out of range.
+ */
+int ed_cmaes_init(ed_cmaes_t* es, int dims, const double* mean, double sigma, int lambda, uint64_t seed)
+{
+    if(dims < 1 || dims > ED_CMAES_MAX_DIMS)
+        return -1;
+    if(lambda == 0)
+        lambda = 4 + (int)(3 * log(dims));
+    if(lambda < 2 || lambda > ED_CMAES_MAX_LAMBDA)
+        return -1;
+
+    memset(es, 0x00, sizeof(ed_cmaes_t));
+    es->dims = dims;
+    es->lambda = lambda;
+    es->sigma = sigma;
+    es->best_cost = INFINITY;
+    es->_rng = seed;
+    memcpy(es->mean, mean, sizeof(double) * dims);
+    memcpy(es->best, mean, sizeof(double) * dims);
+    for(int i = 0; i < dims; i++)
+        es->_diag[i] = 1;
+
+    // recombination weights of the mu best candidates.
+    double sum = 0, sum_sq = 0;
+    es->_mu = lambda / 2;
+    for(int i = 0; i < es->_mu; i++)
+    {
+        es->_weights[i] = log(es->_mu + 0.5) - log(i + 1);
+        sum += es->_weights[i];
+    }
+    for(int i = 0; i < es->_mu; i++)
+    {
+        es->_weights[i] /= sum;
+        sum_sq += es->_weights[i] * es->_weights[i];
+    }
+    es->_mueff = 1 / sum_sq;
+
+    // learning rates, the rank-one and rank-mu rates are raised by (n + 2) / 3 for the diagonal.
+    double n = dims, mueff = es->_mueff;
+    es->_cs = (mueff + 2) / (n + mueff + 5);
+    es->_ds = 1 + 2 * fmax(0, sqrt((mueff - 1) / (n + 1)) - 1) + es->_cs;
+    es->_cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+    es->_c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff) * (n + 2) / 3;
+    es->_cmu = fmin(1 - es->_c1, 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff) * (n + 2) / 3);
+    es->_chi_n = sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+    return 0;
+}
+
+/**
+ * @brief: Sample a generation into candidates, lambda * dims values.
+ */
+void ed_cmaes_sample(ed_cmaes_t* es, double* candidates)
+{
+    for(int k = 0; k < es->lambda; k++)
+    {
+        for(int i = 0; i < es->dims; i++)
+            candidates[k * es->dims + i] = es->mean[i] + es->sigma * sqrt(es->_diag[i]) * __ed_cmaes_randn(&es->_rng);
+    }
+}
+
+/**
+ * @brief: Update the distribution with the costs of the sampled candidates.
+ */
+void ed_cmaes_update(ed_cmaes_t* es, const double* candidates, const double* costs)
+{
+    int n = es->dims;
+    int order[ED_CMAES_MAX_LAMBDA];
+
+    // rank the candidates, insertion sort is enough for a population.
+    for(int k = 0; k < es->lambda; k++)
+    {
+        int j = k;
+        for( ; j > 0 && costs[order[j - 1]] > costs[k]; j--)
+            order[j] = order[j - 1];
+        order[j] = k;
+    }
+    if(costs[order[0]] < es->best_cost)
+    {
+        es->best_cost = costs[order[0]];
+        memcpy(es->best, candidates + order[0] * n, sizeof(double) * n);
+    }
+
+    // weighted mean of the steps y = (x - mean) / sigma.
+    double y_w[ED_CMAES_MAX_DIMS] = { 0 };
+    double rank_mu[ED_CMAES_MAX_DIMS] = { 0 };
+    for(int k = 0; k < es->_mu; k++)
+    {
+        const double* x = candidates + order[k] * n;
+        for(int i = 0; i < n; i++)
+        {
+            double y = (x[i] - es->mean[i]) / es->sigma;
+            y_w[i] += es->_weights[k] * y;
+            rank_mu[i] += es->_weights[k] * y * y;
+        }
+    }
+
+    // evolution paths.
+    double ps_norm = 0;
+    for(int i = 0; i < n; i++)
+    {
+        es->mean[i] += es->sigma * y_w[i];
+        es->_ps[i] = (1 - es->_cs) * es->_ps[i] + sqrt(es->_cs * (2 - es->_cs) * es->_mueff) * y_w[i] / sqrt(es->_diag[i]);
+        ps_norm += es->_ps[i] * es->_ps[i];
+    }
+    ps_norm = sqrt(ps_norm);
+    es->generation ++;
+
+    double ps_decay = sqrt(1 - pow(1 - es->_cs, 2 * es->generation));
+    int hsig = ps_norm / ps_decay / es->_chi_n < 1.4 + 2.0 / (n + 1);
+
+    for(int i = 0; i < n; i++)
+    {
+        es->_pc[i] = (1 - es->_cc) * es->_pc[i] + hsig * sqrt(es->_cc * (2 - es->_cc) * es->_mueff) * y_w[i];
+        es->_diag[i] = (1 - es->_c1 - es->_cmu) * es->_diag[i]
+                     + es->_c1 * (es->_pc[i] * es->_pc[i] + (1 - hsig) * es->_cc * (2 - es->_cc) * es->_diag[i])
+                     + es->_cmu * rank_mu[i];
+    }
+
+    es->sigma *= exp(es->_cs / es->_ds * (ps_norm / es->_chi_n - 1));
+}
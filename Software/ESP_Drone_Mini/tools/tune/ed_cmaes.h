@@ -0,0 +1,66 @@
+#ifndef __ED_CMAES_H__
+#define __ED_CMAES_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ED_CMAES_MAX_DIMS               (16)
+#define ED_CMAES_MAX_LAMBDA             (64)
+
+/**
+ * @brief: Separable CMA-ES(diagonal covariance), minimizing a cost.
+ * @note: Usage:
+ *          ed_cmaes_init(), then for each generation:
+ *              ed_cmaes_sample() -> evaluate the lambda candidates -> ed_cmaes_update().
+ */
+typedef struct {
+    //configs
+    int dims;
+    int lambda;
+
+    //status
+    int generation;
+    double sigma;
+    double mean[ED_CMAES_MAX_DIMS];
+    double best[ED_CMAES_MAX_DIMS];
+    double best_cost;
+
+    //private realizations.
+    int _mu;
+    double _weights[ED_CMAES_MAX_LAMBDA];
+    double _mueff, _cs, _ds, _cc, _c1, _cmu, _chi_n;
+    double _diag[ED_CMAES_MAX_DIMS];
+    double _pc[ED_CMAES_MAX_DIMS];
+    double _ps[ED_CMAES_MAX_DIMS];
+    uint64_t _rng;
+} ed_cmaes_t;
+
+/**
+ * @brief: Initialize the optimizer.
+ * @param:
+ *      - const double* mean : initial mean, dims values.
+ *      - double sigma       : initial step size.
+ *      - int lambda         : population size, 0 for the default 4 + 3 * ln(dims).
+ *      - uint64_t seed      : seed of the sampling.
+ * @return: 0 if success, -1 if dims or lambda is out of range.
+ */
+int ed_cmaes_init(ed_cmaes_t* es, int dims, const double* mean, double sigma, int lambda, uint64_t seed);
+
+/**
+ * @brief: Sample a generation into candidates, lambda * dims values.
+ */
+void ed_cmaes_sample(ed_cmaes_t* es, double* candidates);
+
+/**
+ * @brief: Update the distribution with the costs of the sampled candidates.
+ */
+void ed_cmaes_update(ed_cmaes_t* es, const double* candidates, const double* costs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
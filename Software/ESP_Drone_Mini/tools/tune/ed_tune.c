@@ -0,0 +1,249 @@
+/**
+ * @note: Gain optimizer of ESP_Drone.
+ *          Searches the rate and angle gains of roll/pitch with CMA-ES, every candidate flies the
+ *          standard maneuver of ed_sim on several noise seeds in parallel, and the best gains are
+ *          printed as an ESP_DRONE_PID_PARAM block for esp_drone_pid_config.h.
+ *
+ *          usage: ed_tune [-g generations] [-p population] [-s seeds] [-j threads] [-r random seed] [-a step deg]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_drone_pid_config.h"
+#include "ed_sim.h"
+#include "ed_pool.h"
+#include "ed_cmaes.h"
+
+// searched in log space, roll and pitch share the gains.
+enum {
+    TUNE_VELOC_P = 0,
+    TUNE_VELOC_I,
+    TUNE_VELOC_D,
+    TUNE_ANGLE_P,
+    TUNE_ANGLE_I,
+    TUNE_DIMS,
+};
+
+static const char* dim_names[TUNE_DIMS] = { "veloc.P", "veloc.I", "veloc.D", "angle.P", "angle.I" };
+
+// weights of the cost, iae is in deg*s.
+#define TUNE_OVERSHOOT_WEIGHT           (0.02)
+#define TUNE_DISTURBANCE_WEIGHT         (0.2)
+#define TUNE_SATURATION_WEIGHT          (5.0)
+
+typedef struct {
+    oh_quad_pid_t pid;
+    ed_sim_params_t params;
+    float step_deg;
+    ed_sim_result_t result;
+} tune_run_t;
+
+static void apply_gains(oh_quad_pid_t* pid, const double* x)
+{
+    pid->veloc_pitch.proportion = pid->veloc_roll.proportion = exp(x[TUNE_VELOC_P]);
+    pid->veloc_pitch.integration = pid->veloc_roll.integration = exp(x[TUNE_VELOC_I]);
+    pid->veloc_pitch.differention = pid->veloc_roll.differention = exp(x[TUNE_VELOC_D]);
+    pid->angle_pitch.proportion = pid->angle_roll.proportion = exp(x[TUNE_ANGLE_P]);
+    pid->angle_pitch.integration = pid->angle_roll.integration = exp(x[TUNE_ANGLE_I]);
+
+    // the flat schedule follows the tuned gains.
+    pid->schedule.points = 0;
+}
+
+static double run_cost(const ed_sim_result_t* result)
+{
+    return result->iae
+         + TUNE_OVERSHOOT_WEIGHT * result->overshoot
+         + TUNE_DISTURBANCE_WEIGHT * result->disturbance_peak
+         + TUNE_SATURATION_WEIGHT * result->saturation;
+}
+
+static void run_flight(void* arg)
+{
+    tune_run_t* run = (tune_run_t*)arg;
+    ed_sim_fly(&run->params, &run->pid, run->step_deg, &run->result);
+}
+
+static void print_pid(const char* name, const oh_pos_pid_t* pid)
+{
+    printf("        .%s = { \\\n", name);
+    printf("            .target = 0, \\\n");
+    printf("            .proportion = %.4g, \\\n", pid->proportion);
+    printf("            .integration = %.4g, \\\n", pid->integration);
+    printf("            .differention = %.4g, \\\n", pid->differention);
+    printf("            .max_abs_output = %.4g, \\\n", pid->max_abs_output);
+    printf("            .configs.limitIntegration = %s, \\\n", pid->configs.limitIntegration ? "PID_FUNC_ENABLE" : "PID_FUNC_DISABLE");
+    printf("            .configs.autoResetIntegration = %s, \\\n", pid->configs.autoResetIntegration ? "PID_FUNC_ENABLE" : "PID_FUNC_DISABLE");
+    printf("            .max_abs_int_output = %.4g, \\\n", pid->max_abs_int_output);
+    printf("        }, \\\n");
+}
+
+static void print_param(const oh_quad_pid_t* pid)
+{
+    static const char* geometries[] = { "OH_MIXER_QUAD_X", "OH_MIXER_HEX_X", "OH_MIXER_OCTO_X" };
+
+    printf("#define ESP_DRONE_PID_PARAM { \\\n");
+    print_pid("veloc_pitch", &pid->veloc_pitch);
+    print_pid("veloc_roll", &pid->veloc_roll);
+    print_pid("veloc_yaw", &pid->veloc_yaw);
+    print_pid("angle_pitch", &pid->angle_pitch);
+    print_pid("angle_roll", &pid->angle_roll);
+    print_pid("angle_yaw", &pid->angle_yaw);
+    printf("        .mixer = { \\\n");
+    printf("            .geometry = %s, \\\n", geometries[pid->mixer.geometry]);
+    printf("            .airmode = %d, \\\n", pid->mixer.airmode);
+    printf("            .output_min = %.4g, \\\n", pid->mixer.output_min);
+    printf("            .output_max = %.4g, \\\n", pid->mixer.output_max);
+    printf("        }, \\\n");
+    printf("        .schedule = { \\\n");
+    printf("            .points = 0, \\\n");
+    printf("            .thrust_min = %.4g, \\\n", pid->schedule.thrust_min);
+    printf("            .thrust_max = %.4g, \\\n", pid->schedule.thrust_max);
+    printf("        }, \\\n");
+    printf("        .torque_scale = 1.0f / ED_MOTOR_MAX_RPS, \\\n");
+    printf("        .attitude_mode = %s, \\\n", pid->attitude_mode == OH_QUAD_ATTITUDE_QUAT ? "OH_QUAD_ATTITUDE_QUAT" : "OH_QUAD_ATTITUDE_EULER");
+    printf("}\n");
+}
+
+int main(int argc, char** argv)
+{
+    int generations = 40;
+    int population = 16;
+    int seeds = 4;
+    int threads = 0;
+    uint64_t random_seed = 1;
+    float step_deg = 10;
+
+    int opt;
+    while((opt = getopt(argc, argv, "g:p:s:j:r:a:h")) != -1)
+    {
+        switch(opt)
+        {
+        case 'g': generations = atoi(optarg); break;
+        case 'p': population = atoi(optarg); break;
+        case 's': seeds = atoi(optarg); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'r': random_seed = strtoull(optarg, NULL, 0); break;
+        case 'a': step_deg = atof(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-g generations] [-p population] [-s seeds] [-j threads] [-r random seed] [-a step deg]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if(generations < 1 || seeds < 1)
+    {
+        fprintf(stderr, "generations and seeds must be positive\n");
+        return 1;
+    }
+
+    const oh_quad_pid_t initial = ESP_DRONE_PID_PARAM;
+    ed_sim_params_t params;
+    ed_sim_default_params(&params);
+
+    double mean[TUNE_DIMS] = {
+        log(initial.veloc_roll.proportion),
+        log(initial.veloc_roll.integration),
+        log(initial.veloc_roll.differention),
+        log(initial.angle_roll.proportion),
+        log(initial.angle_roll.integration),
+    };
+    ed_cmaes_t es;
+    if(ed_cmaes_init(&es, TUNE_DIMS, mean, 0.5, population, random_seed) != 0)
+    {
+        fprintf(stderr, "population must be in [2, %d]\n", ED_CMAES_MAX_LAMBDA);
+        return 1;
+    }
+
+    ed_pool_t* pool = ed_pool_create(threads);
+    tune_run_t* runs = malloc(sizeof(tune_run_t) * es.lambda * seeds);
+    double* candidates = malloc(sizeof(double) * es.lambda * TUNE_DIMS);
+    double* costs = malloc(sizeof(double) * es.lambda);
+    if(!pool || !runs || !candidates || !costs)
+    {
+        fprintf(stderr, "out of resources\n");
+        return 1;
+    }
+    fprintf(stderr, "tuning with %d workers, %d candidates x %d seeds per generation\n",
+        ed_pool_threads(pool), es.lambda, seeds);
+
+    // the initial gains are scored like a candidate, so the result is never worse than them.
+    ed_cmaes_sample(&es, candidates);
+    memcpy(candidates, mean, sizeof(mean));
+
+    for(int gen = 0; gen < generations; gen++)
+    {
+        if(gen > 0)
+            ed_cmaes_sample(&es, candidates);
+
+        // the seeds of a generation are shared by its candidates, so they are compared on the same noise.
+        for(int k = 0; k < es.lambda; k++)
+        {
+            for(int s = 0; s < seeds; s++)
+            {
+                tune_run_t* run = &runs[k * seeds + s];
+                run->pid = initial;
+                apply_gains(&run->pid, candidates + k * TUNE_DIMS);
+                run->params = params;
+                run->params.seed = random_seed * 1000003u + gen * 1009u + s;
+                run->step_deg = step_deg;
+                ed_pool_submit(pool, run_flight, run);
+            }
+        }
+        ed_pool_wait(pool);
+
+        int diverged = 0;
+        for(int k = 0; k < es.lambda; k++)
+        {
+            costs[k] = 0;
+            for(int s = 0; s < seeds; s++)
+            {
+                costs[k] += run_cost(&runs[k * seeds + s].result) / seeds;
+                diverged += runs[k * seeds + s].result.diverged;
+            }
+        }
+        ed_cmaes_update(&es, candidates, costs);
+        fprintf(stderr, "generation %3d: best cost %.4f, sigma %.4f, diverged flights %d\n",
+            gen, es.best_cost, es.sigma, diverged);
+    }
+
+    // the report of the best gains on fresh seeds.
+    oh_quad_pid_t best = initial;
+    apply_gains(&best, es.best);
+    for(int s = 0; s < seeds; s++)
+    {
+        tune_run_t* run = &runs[s];
+        run->pid = best;
+        run->params = params;
+        run->params.seed = ~(uint64_t)s;
+        run->step_deg = step_deg;
+        ed_pool_submit(pool, run_flight, run);
+    }
+    ed_pool_wait(pool);
+
+    ed_sim_result_t mean_result = { 0 };
+    for(int s = 0; s < seeds; s++)
+    {
+        mean_result.iae += runs[s].result.iae / seeds;
+        mean_result.overshoot += runs[s].result.overshoot / seeds;
+        mean_result.disturbance_peak += runs[s].result.disturbance_peak / seeds;
+        mean_result.saturation += runs[s].result.saturation / seeds;
+        mean_result.diverged += runs[s].result.diverged;
+    }
+
+    fprintf(stderr, "best:");
+    for(int i = 0; i < TUNE_DIMS; i++)
+        fprintf(stderr, " %s=%.4g", dim_names[i], exp(es.best[i]));
+    fprintf(stderr, "\nvalidation: iae %.3f deg*s, overshoot %.1f%%, disturbance peak %.2f deg, saturation %.1f%%, diverged %d/%d\n",
+        mean_result.iae, mean_result.overshoot, mean_result.disturbance_peak, mean_result.saturation * 100,
+        mean_result.diverged, seeds);
+    print_param(&best);
+
+    ed_pool_destroy(pool);
+    free(runs);
+    free(candidates);
+    free(costs);
+    return 0;
+}